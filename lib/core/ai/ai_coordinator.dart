@@ -93,11 +93,16 @@ class AiCoordinator extends ChangeNotifier {
         for (final modelId in [
           'whisper-tiny',
           'whisper-base',
-          'whisper-small'
+          'whisper-base-q5_1',
+          'whisper-base-q8_0',
+          'whisper-small',
+          'whisper-small-q5_1',
+          'whisper-small-q8_0',
         ]) {
           if (_modelManager.availableModels.containsKey(modelId)) {
             final whisper = WhisperSpeechRecognition(
               modelManager: _modelManager,
+              modelId: modelId,
             );
             _speechRecognitionImpls[modelId] = whisper;
           }
@@ -181,6 +186,7 @@ class AiCoordinator extends ChangeNotifier {
       if (!_speechRecognitionImpls.containsKey(modelId)) {
         final whisper = WhisperSpeechRecognition(
           modelManager: _modelManager,
+          modelId: modelId,
         );
         await whisper.initialize();
         _speechRecognitionImpls[modelId] = whisper;
@@ -443,7 +449,11 @@ class AiCoordinator extends ChangeNotifier {
         }
 
         // Switch to lighter models if available
-        final lighterSpeechModels = ['whisper-tiny', 'whisper-base'];
+        final lighterSpeechModels = [
+          'whisper-tiny',
+          'whisper-base-q5_1',
+          'whisper-base'
+        ];
         final lighterSummaryModels = ['tinyllama-q4', 'llama-3.2-1b-q4'];
 
         for (final model in lighterSpeechModels) {
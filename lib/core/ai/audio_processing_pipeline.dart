@@ -1,4 +1,5 @@
 import 'dart:async';
+import 'dart:typed_data';
 import 'package:flutter/foundation.dart';
 
 import '../audio/audio_chunk.dart';
@@ -22,9 +23,12 @@ class AudioProcessingPipeline extends ChangeNotifier {
   bool _isInitialized = false;
   String? _lastError;
 
-  // Audio buffer management
-  final List<AudioChunk> _audioBuffer = [];
-  Timer? _processingTimer;
+  // Speech recognition is fed each chunk as it arrives, without waiting
+  // for the previous chunk's result: submission is synchronous, so audio
+  // reaches the native worker in capture order, and its queue merges or
+  // drops pushes when decoding falls behind. Results come back through the
+  // worker's callback in the same order.
+  int _pendingSpeechChunks = 0;
   Timer? _summaryTimer;
 
   // Processing results
@@ -33,9 +37,7 @@ class AudioProcessingPipeline extends ChangeNotifier {
   final Map<String, String> _speakerNames = {}; // Simple speaker name mapping
 
   // Processing configuration
-  static const Duration _speechProcessingInterval = Duration(seconds: 5);
   static const Duration _summaryInterval = Duration(seconds: 30);
-  static const int _maxBufferChunks = 300; // ~30 seconds at 100ms chunks
 
   // Quality monitoring
   final List<ProcessingQualityMetric> _qualityMetrics = [];
@@ -60,6 +62,13 @@ class AudioProcessingPipeline extends ChangeNotifier {
   String? get lastError => _lastError;
 
   List<SpeechSegment> get speechSegments => List.unmodifiable(_speechSegments);
+
+  /// Provisional transcription of the most recent audio
+  SpeechSegment? get tentativeSegment =>
+      _aiCoordinator.speechRecognition?.tentativeSegment;
+
+  /// Summary text generated so far by the running summarization, if any
+  String? get summaryDraft => _aiCoordinator.summarization?.summaryDraft.value;
   List<MeetingSummary> get summaries => List.unmodifiable(_summaries);
   Map<String, String> get speakerNames => Map.unmodifiable(_speakerNames);
 
@@ -110,7 +119,6 @@ class AudioProcessingPipeline extends ChangeNotifier {
       _isActive = true;
       _speechSegments.clear();
       _summaries.clear();
-      _audioBuffer.clear();
       _qualityMetrics.clear();
 
       // Start processing timers
@@ -134,15 +142,12 @@ class AudioProcessingPipeline extends ChangeNotifier {
     _isActive = false;
 
     // Stop timers
-    _processingTimer?.cancel();
     _summaryTimer?.cancel();
-    _processingTimer = null;
     _summaryTimer = null;
 
-    // Process remaining buffer
-    if (_audioBuffer.isNotEmpty) {
-      _processAudioBuffer();
-    }
+    // Finalize the audio still held by the speech stream; the flush is
+    // queued behind the chunks already pushed
+    _finishSpeechStream();
 
     notifyListeners();
     debugPrint('Audio processing pipeline stopped');
@@ -152,8 +157,8 @@ class AudioProcessingPipeline extends ChangeNotifier {
   void processAudioChunk(AudioChunk chunk) {
     if (!_isActive || !chunk.hasValidData) return;
 
-    // Add to buffer
-    _audioBuffer.add(chunk);
+    final samples = chunk.toFloat32Samples();
+    _streamAudioChunk(chunk, samples);
 
     // Update visualization (if available)
     try {
@@ -163,25 +168,13 @@ class AudioProcessingPipeline extends ChangeNotifier {
     }
 
     // Monitor audio quality
-    _updateQualityMetrics(chunk);
-
-    // Manage buffer size
-    if (_audioBuffer.length > _maxBufferChunks) {
-      _audioBuffer.removeAt(0);
-    }
+    _updateQualityMetrics(samples);
 
     notifyListeners();
   }
 
   /// Start processing timers
   void _startProcessingTimers() {
-    // Speech recognition timer
-    _processingTimer = Timer.periodic(_speechProcessingInterval, (timer) {
-      if (_isActive) {
-        _processAudioBuffer();
-      }
-    });
-
     // Summarization timer
     _summaryTimer = Timer.periodic(_summaryInterval, (timer) {
       if (_isActive) {
@@ -190,59 +183,69 @@ class AudioProcessingPipeline extends ChangeNotifier {
     });
   }
 
-  /// Process accumulated audio buffer
-  Future<void> _processAudioBuffer() async {
-    if (_audioBuffer.isEmpty || _aiCoordinator.speechRecognition == null) {
-      return;
-    }
+  /// Feed one captured chunk to the speech recognition stream
+  Future<void> _streamAudioChunk(
+      AudioChunk chunk, Float32List samples) async {
+    final speechRecognition = _aiCoordinator.speechRecognition;
+    if (speechRecognition == null) return;
 
+    _pendingSpeechChunks++;
     try {
-      // Extract audio data from buffer
-      final audioData = <Float32List>[];
-      DateTime? batchStartTime;
-
-      for (final chunk in _audioBuffer) {
-        if (chunk.hasValidData) {
-          audioData.add(chunk.toFloat32Samples());
-          batchStartTime ??= chunk.timestamp;
-        }
-      }
-
-      if (audioData.isEmpty) return;
-
-      // Process with speech recognition
-      final speechRecognition = _aiCoordinator.speechRecognition!;
-      final segments = await speechRecognition.processBatch(
-        audioData,
-        sampleRate: 16000,
-        startTime: batchStartTime,
+      // Pushes before the first await, so before the next chunk's
+      final segments = await speechRecognition.processStream(
+        samples,
+        sampleRate: chunk.sampleRate,
+        timestamp: chunk.timestamp,
       );
+      await _handleSpeechSegments(segments, [samples]);
+    } catch (e) {
+      _lastError = 'Error processing audio chunk: $e';
+      debugPrint(_lastError);
+    } finally {
+      _pendingSpeechChunks--;
+    }
+  }
+
+  /// Finalize the speech stream once capture has stopped
+  Future<void> _finishSpeechStream() async {
+    final speechRecognition = _aiCoordinator.speechRecognition;
+    if (speechRecognition == null) return;
 
-      if (segments.isNotEmpty) {
-        _speechSegments.addAll(segments);
+    try {
+      final segments = await speechRecognition.finishStream();
+      await _handleSpeechSegments(segments, const []);
+    } catch (e) {
+      _lastError = 'Error finishing speech stream: $e';
+      debugPrint(_lastError);
+    }
+  }
 
-        // Update speaker names (simple tracking)
-        await _updateSpeakerNames(segments, audioData);
+  /// Record newly finalized speech segments
+  Future<void> _handleSpeechSegments(
+    List<SpeechSegment> segments,
+    List<Float32List> audioData,
+  ) async {
+    if (segments.isEmpty) return;
 
-        // Update language detection
-        _updateLanguageDetection(segments);
+    _speechSegments.addAll(segments);
 
-        // Evaluate processing quality
-        _evaluateProcessingQuality(segments);
+    // Update speaker names (simple tracking)
+    await _updateSpeakerNames(segments, audioData);
 
-        // Adaptive model switching if needed
-        if (_adaptiveModelSwitching) {
-          await _evaluateModelSwitching();
-        }
+    // Update language detection
+    _updateLanguageDetection(segments);
 
-        notifyListeners();
+    // Evaluate processing quality
+    _evaluateProcessingQuality(segments);
 
-        debugPrint('Processed ${segments.length} speech segments');
-      }
-    } catch (e) {
-      _lastError = 'Error processing audio buffer: $e';
-      debugPrint(_lastError);
+    // Adaptive model switching if needed
+    if (_adaptiveModelSwitching) {
+      await _evaluateModelSwitching();
     }
+
+    notifyListeners();
+
+    debugPrint('Processed ${segments.length} speech segments');
   }
 
   /// Generate summary from recent speech segments
@@ -261,10 +264,17 @@ class AudioProcessingPipeline extends ChangeNotifier {
               .sublist(_speechSegments.length - maxSegmentsForSummary)
           : _speechSegments;
 
-      final summary = await summarization.generateIncrementalSummary(
-        _summaries,
-        segmentsToSummarize,
-      );
+      // Repaint as the summary is written rather than only once it is done
+      final MeetingSummary summary;
+      summarization.summaryDraft.addListener(notifyListeners);
+      try {
+        summary = await summarization.generateIncrementalSummary(
+          _summaries,
+          segmentsToSummarize,
+        );
+      } finally {
+        summarization.summaryDraft.removeListener(notifyListeners);
+      }
 
       if (summary.hasContent) {
         _summaries.add(summary);
@@ -320,10 +330,9 @@ class AudioProcessingPipeline extends ChangeNotifier {
     }
   }
 
-  /// Update quality metrics from audio chunk
-  void _updateQualityMetrics(AudioChunk chunk) {
+  /// Update quality metrics from a chunk's samples
+  void _updateQualityMetrics(Float32List samples) {
     // Calculate noise level
-    final samples = chunk.toFloat32Samples();
     double sum = 0.0;
     for (final sample in samples) {
       sum += sample.abs();
@@ -391,8 +400,10 @@ class AudioProcessingPipeline extends ChangeNotifier {
 
     if (currentSpeechModel == 'whisper-tiny') {
       betterModel = 'whisper-base';
-    } else if (currentSpeechModel == 'whisper-base') {
-      betterModel = 'whisper-small';
+    } else if (currentSpeechModel.startsWith('whisper-base')) {
+      // Keep the quantization the device tier picked
+      betterModel =
+          currentSpeechModel.replaceFirst('whisper-base', 'whisper-small');
     }
 
     if (betterModel != null) {
@@ -412,7 +423,7 @@ class AudioProcessingPipeline extends ChangeNotifier {
       'speechSegments': _speechSegments.length,
       'summaries': _summaries.length,
       'speakerNames': _speakerNames.length,
-      'bufferSize': _audioBuffer.length,
+      'bufferSize': _pendingSpeechChunks,
       'currentNoiseLevel': _currentNoiseLevel,
       'currentSpeechConfidence': _currentSpeechConfidence,
       'detectedLanguage': _detectedLanguage,
@@ -433,7 +444,6 @@ class AudioProcessingPipeline extends ChangeNotifier {
     _speechSegments.clear();
     _summaries.clear();
     _speakerNames.clear();
-    _audioBuffer.clear();
     _qualityMetrics.clear();
     _lowQualityCount = 0;
     _lastModelSwitch = null;
@@ -444,7 +454,6 @@ class AudioProcessingPipeline extends ChangeNotifier {
   void dispose() {
     stopProcessing();
     _visualizer.dispose();
-    _audioBuffer.clear();
     super.dispose();
   }
 }
@@ -1,6 +1,8 @@
 import 'dart:io';
 import 'package:flutter/foundation.dart';
 
+import 'model_ffi.dart';
+
 /// Device capability information for AI model selection
 class DeviceCapabilities {
   /// Available RAM in GB
@@ -9,6 +11,10 @@ class DeviceCapabilities {
   /// Number of CPU cores
   final int cpuCores;
 
+  /// Physical cores in the fastest class, without SMT siblings or
+  /// efficiency cores; what inference threads are sized from
+  final int performanceCores;
+
   /// Has GPU acceleration support
   final bool hasGpuAcceleration;
 
@@ -27,6 +33,7 @@ class DeviceCapabilities {
   const DeviceCapabilities({
     required this.availableRamGB,
     required this.cpuCores,
+    required this.performanceCores,
     required this.hasGpuAcceleration,
     required this.platform,
     required this.performanceTier,
@@ -83,6 +90,7 @@ class DeviceCapabilityDetector {
       // Get basic platform information
       final platform = Platform.operatingSystem;
       final cpuCores = await _getCpuCores();
+      final performanceCores = _getPerformanceCores(cpuCores);
       final availableRam = await _getAvailableRam();
       final hasGpu = await _detectGpuAcceleration();
 
@@ -97,6 +105,7 @@ class DeviceCapabilityDetector {
       return DeviceCapabilities(
         availableRamGB: availableRam,
         cpuCores: cpuCores,
+        performanceCores: performanceCores,
         hasGpuAcceleration: hasGpu,
         platform: platform,
         performanceTier: performanceTier,
@@ -109,6 +118,7 @@ class DeviceCapabilityDetector {
       return const DeviceCapabilities(
         availableRamGB: 4.0,
         cpuCores: 4,
+        performanceCores: 2,
         hasGpuAcceleration: false,
         platform: 'unknown',
         performanceTier: DevicePerformanceTier.low,
@@ -129,6 +139,15 @@ class DeviceCapabilityDetector {
     }
   }
 
+  /// Fast physical cores from the native topology scan, or half the
+  /// logical CPUs (assuming SMT) when the shim is unavailable
+  static int _getPerformanceCores(int cpuCores) {
+    WhisperFFI.initialize();
+    final topology = WhisperFFI.cpuTopology();
+    if (topology != null) return topology.performanceCores;
+    return (cpuCores / 2).ceil();
+  }
+
   /// Estimate available RAM in GB
   static Future<double> _getAvailableRam() async {
     try {
@@ -233,15 +252,18 @@ class DeviceCapabilityDetector {
   /// Recommend speech recognition model based on capabilities
   static String _recommendSpeechModel(
       DevicePerformanceTier tier, double ramGB) {
+    // Quantized weights halve memory and bandwidth; q8_0 is within noise
+    // of f16 accuracy, q5_1 trades a little accuracy for a third of the size
     switch (tier) {
       case DevicePerformanceTier.high:
         if (ramGB >= 16) {
           return 'whisper-small'; // Best accuracy for high-end devices
         } else {
-          return 'whisper-base';
+          return 'whisper-small-q8_0';
         }
       case DevicePerformanceTier.medium:
-        return 'whisper-base'; // Balanced accuracy/performance
+        // Real time on mid-tier laptops at half the memory of f16
+        return ramGB >= 6 ? 'whisper-small-q5_1' : 'whisper-base-q5_1';
       case DevicePerformanceTier.low:
         return 'whisper-tiny'; // Fastest inference for low-end devices
     }
@@ -299,6 +321,7 @@ class DeviceCapabilityDetector {
     return {
       'ram_gb': capabilities.availableRamGB,
       'cpu_cores': capabilities.cpuCores,
+      'performance_cores': capabilities.performanceCores,
       'has_gpu': capabilities.hasGpuAcceleration,
       'platform': capabilities.platform,
       'performance_tier': capabilities.performanceTier.toString(),
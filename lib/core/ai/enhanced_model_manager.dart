@@ -154,6 +154,7 @@ enum ModelType {
   textSummarization,
   speakerIdentification,
   languageDetection,
+  textEmbedding,
 }
 
 /// Manages AI model lifecycle - downloading, loading, and cleanup
@@ -333,6 +334,119 @@ class ModelManager extends ChangeNotifier {
     _modelChecksums['whisper-small'] =
         'f1b4fe3ddd39c09c6e0e3ddc8eaf7e6b7ecc9e44';
 
+    // Quantized Whisper variants. ggml dequantizes q5_1/q8_0 blocks inside
+    // its SIMD matmul kernels, so these run at about the speed of f16 with
+    // a third to a half of the memory
+    _availableModels['whisper-base-q5_1'] = ModelInfo(
+      id: 'whisper-base-q5_1',
+      name: 'Whisper Base (Q5_1)',
+      type: ModelType.speechRecognition,
+      sizeBytes: 57 * 1024 * 1024, // ~57MB
+      downloadUrl:
+          'https://huggingface.co/ggerganov/whisper.cpp/resolve/main/ggml-base-q5_1.bin',
+      filename: 'ggml-base-q5_1.bin',
+      description: 'Base Whisper model, 5-bit quantized, ~57MB',
+      supportedLanguages: ['en', 'vi', 'zh', 'ja', 'ko', 'fr', 'de', 'es'],
+      isQuantized: true,
+      modelFormat: ModelFormat.ggml,
+      requirements: ModelRequirements(
+        minRamMB: 128,
+        cpuOptimized: true,
+        gpuOptimized: false,
+      ),
+    );
+
+    _modelChecksums['whisper-base-q5_1'] =
+        'a3733eda680ef76256db5fc5dd9de8629e62c5e7';
+
+    _availableModels['whisper-base-q8_0'] = ModelInfo(
+      id: 'whisper-base-q8_0',
+      name: 'Whisper Base (Q8_0)',
+      type: ModelType.speechRecognition,
+      sizeBytes: 78 * 1024 * 1024, // ~78MB
+      downloadUrl:
+          'https://huggingface.co/ggerganov/whisper.cpp/resolve/main/ggml-base-q8_0.bin',
+      filename: 'ggml-base-q8_0.bin',
+      description: 'Base Whisper model, 8-bit quantized, ~78MB',
+      supportedLanguages: ['en', 'vi', 'zh', 'ja', 'ko', 'fr', 'de', 'es'],
+      isQuantized: true,
+      modelFormat: ModelFormat.ggml,
+      requirements: ModelRequirements(
+        minRamMB: 160,
+        cpuOptimized: true,
+        gpuOptimized: false,
+      ),
+    );
+
+    _modelChecksums['whisper-base-q8_0'] =
+        '7bb89bb49ed6955013b166f1b6a6c04584a20fbe';
+
+    _availableModels['whisper-small-q5_1'] = ModelInfo(
+      id: 'whisper-small-q5_1',
+      name: 'Whisper Small (Q5_1)',
+      type: ModelType.speechRecognition,
+      sizeBytes: 181 * 1024 * 1024, // ~181MB
+      downloadUrl:
+          'https://huggingface.co/ggerganov/whisper.cpp/resolve/main/ggml-small-q5_1.bin',
+      filename: 'ggml-small-q5_1.bin',
+      description: 'Small Whisper model, 5-bit quantized, ~181MB',
+      supportedLanguages: [
+        'en',
+        'vi',
+        'zh',
+        'ja',
+        'ko',
+        'fr',
+        'de',
+        'es',
+        'it',
+        'pt'
+      ],
+      isQuantized: true,
+      modelFormat: ModelFormat.ggml,
+      requirements: ModelRequirements(
+        minRamMB: 256,
+        cpuOptimized: true,
+        gpuOptimized: false,
+      ),
+    );
+
+    _modelChecksums['whisper-small-q5_1'] =
+        '6fe57ddcfdd1c6b07cdcc73aaf620810ce5fc771';
+
+    _availableModels['whisper-small-q8_0'] = ModelInfo(
+      id: 'whisper-small-q8_0',
+      name: 'Whisper Small (Q8_0)',
+      type: ModelType.speechRecognition,
+      sizeBytes: 252 * 1024 * 1024, // ~252MB
+      downloadUrl:
+          'https://huggingface.co/ggerganov/whisper.cpp/resolve/main/ggml-small-q8_0.bin',
+      filename: 'ggml-small-q8_0.bin',
+      description: 'Small Whisper model, 8-bit quantized, ~252MB',
+      supportedLanguages: [
+        'en',
+        'vi',
+        'zh',
+        'ja',
+        'ko',
+        'fr',
+        'de',
+        'es',
+        'it',
+        'pt'
+      ],
+      isQuantized: true,
+      modelFormat: ModelFormat.ggml,
+      requirements: ModelRequirements(
+        minRamMB: 320,
+        cpuOptimized: true,
+        gpuOptimized: false,
+      ),
+    );
+
+    _modelChecksums['whisper-small-q8_0'] =
+        'bcad8a2083f4e53d648d586b7dbc0cd673d8afad';
+
     // Text Summarization Models (Llama GGUF format)
     _availableModels['llama-3.2-1b-q4'] = ModelInfo(
       id: 'llama-3.2-1b-q4',
@@ -427,6 +541,27 @@ class ModelManager extends ChangeNotifier {
     _modelChecksums['tinyllama-q4'] =
         'd4e5f6789012345678901234567890abcdef1234';
 
+    // Sentence embedding model for topic tracking, run by the Llama shim
+    _availableModels['minilm-l6-q8'] = ModelInfo(
+      id: 'minilm-l6-q8',
+      name: 'all-MiniLM-L6-v2 (Q8)',
+      type: ModelType.textEmbedding,
+      sizeBytes: 25 * 1024 * 1024, // ~25MB
+      downloadUrl:
+          'https://huggingface.co/second-state/All-MiniLM-L6-v2-Embedding-GGUF/resolve/main/all-MiniLM-L6-v2-Q8_0.gguf',
+      filename: 'all-minilm-l6-v2-q8.gguf',
+      description:
+          'Compact sentence encoder for detecting topic changes in milliseconds',
+      supportedLanguages: ['en'],
+      isQuantized: true,
+      modelFormat: ModelFormat.gguf,
+      requirements: ModelRequirements(
+        minRamMB: 64,
+        cpuOptimized: true,
+        gpuOptimized: false,
+      ),
+    );
+
     // Speaker Identification Models (Hybrid Approach)
     // ECAPA-TDNN for English-optimized speaker embedding
     _availableModels['ecapa-tdnn'] = ModelInfo(
@@ -1055,32 +1190,17 @@ class ModelManager extends ChangeNotifier {
         ModelFFI.initializeAll();
       }
 
-      // Attempt to load using FFI based on model type
-      dynamic ffiModel;
-      if (model.type == ModelType.speechRecognition) {
-        ffiModel = WhisperFFI.loadModel(model.localPath!);
-        if (ffiModel == null) {
-          debugPrint('FFI loading failed, using placeholder for ${model.name}');
-        }
-      } else if (model.type == ModelType.textSummarization) {
-        ffiModel = LlamaFFI.loadModel(model.localPath!);
-        if (ffiModel == null) {
-          debugPrint('FFI loading failed, using placeholder for ${model.name}');
-        }
-      }
-
-      // Store model instance information
+      // Contexts are owned by the engines that run them
+      // (WhisperSpeechRecognition, LlamaSummarization), which load the model
+      // themselves; loading it here too would double its footprint
       _modelInstances[modelId] = {
         'path': model.localPath!,
         'type': model.type,
         'format': model.modelFormat,
         'loaded_at': DateTime.now(),
-        'ffi_handle': ffiModel, // Store FFI handle if available
-        'using_ffi': ffiModel != null,
       };
 
-      final loadMethod = ffiModel != null ? 'FFI' : 'placeholder';
-      debugPrint('Model instance loaded ($loadMethod): ${model.name}');
+      debugPrint('Model instance registered: ${model.name}');
       return true;
     } catch (e) {
       _lastError = 'Failed to load model instance: $e';
@@ -1092,18 +1212,6 @@ class ModelManager extends ChangeNotifier {
   /// Unload a model instance to free memory
   void unloadModelInstance(String modelId) {
     if (_modelInstances.containsKey(modelId)) {
-      final instance = _modelInstances[modelId]!;
-
-      // Free FFI handle if it exists
-      if (instance['ffi_handle'] != null && instance['using_ffi'] == true) {
-        final model = _loadedModels[modelId];
-        if (model?.type == ModelType.speechRecognition) {
-          WhisperFFI.freeModel(instance['ffi_handle']);
-        } else if (model?.type == ModelType.textSummarization) {
-          LlamaFFI.freeModel(instance['ffi_handle']);
-        }
-      }
-
       _modelInstances.remove(modelId);
       debugPrint('Model instance unloaded: $modelId');
     }
@@ -1,10 +1,17 @@
+import 'dart:convert';
 import 'dart:ffi';
 import 'dart:io';
+import 'dart:math' as math;
+import 'dart:typed_data';
+import 'package:crypto/crypto.dart';
 import 'package:flutter/foundation.dart';
+import 'package:path/path.dart' as path;
+import 'package:path_provider/path_provider.dart';
 
 import 'summarization_interface.dart';
 import 'speech_recognition_interface.dart';
 import 'enhanced_model_manager.dart';
+import 'model_ffi.dart';
 
 /// Native Llama implementation for text summarization
 /// Uses llama.cpp through FFI for cross-platform compatibility
@@ -12,18 +19,114 @@ class LlamaSummarization implements SummarizationInterface {
   final SummarizationConfig _config;
   final ModelManager _modelManager;
 
-  // Native library and context
-  DynamicLibrary? _llamaLib;
-  Pointer<LlamaContext>? _llamaContext;
+  // Native model and the worker thread that generates on it; null when
+  // the shim is unavailable, in which case responses are mocked
+  Pointer<NativeLlama>? _model;
+  LlamaWorker? _worker;
+
+  // Models loaded by path, shared by every instance using them, so that
+  // their generations batch together on one worker rather than each
+  // instance holding a copy of the weights and competing for the cores.
+  // The instance that loaded a model owns its session snapshot.
+  static final Map<String, _SharedLlama> _sharedModels = {};
+  _SharedLlama? _shared;
+
+  // Generations in flight across instances, which run side by side on the
+  // shared workers; Llama is active to the core scheduler while any is
+  static int _activeGenerations = 0;
+
+  // Draft for each model, one of the same family sharing its vocabulary.
+  // TinyLlama would be smaller still, but its vocabulary is Llama 2's.
+  static const Map<String, String> _draftModels = {
+    'llama-3.2-3b-q4': 'llama-3.2-1b-q4',
+  };
+
+  // Sentence encoder tracking the topic, so topic changes are told from
+  // embeddings in milliseconds instead of by asking [_model]; null when it
+  // is unavailable.
+  Pointer<NativeLlama>? _embedder;
+  static const String _embeddingModelId = 'minilm-l6-q8';
+
+  // Segments are a few dozen tokens, too few to spread over more threads
+  static const int _embeddingThreads = 2;
+
+  // Running topic: the embeddings of the segments since the last topic
+  // change, each earlier one weighing [_topicDecay] times less, so the
+  // topic follows the conversation's drift. A batch whose mean embedding
+  // is further than [_topicShiftDistance] in cosine distance starts a new
+  // topic. Without history, the last [_topicSeedSegments] seed it.
+  Float32List? _topicCentroid;
+  static const double _topicDecay = 0.9;
+  static const double _topicShiftDistance = 0.4;
+  static const int _topicSeedSegments = 8;
+
+  // Last batch judged and the verdict, so the summary update that follows
+  // the question does not fold the batch into the topic twice
+  String? _judgedBatch;
+  bool _judgedShift = false;
+
+  // Completion being generated, as it streams in, and the generation it
+  // belongs to; generations may overlap, and only the owner may touch it
+  final ValueNotifier<String?> _summaryDraft = ValueNotifier<String?>(null);
+  Object? _draftOwner;
 
   // State
   bool _isInitialized = false;
   String? _lastError;
 
-  // Context management for incremental summarization
+  // Context management for incremental summarization: the running
+  // transcript every prompt carries, one line per segment, and the tokens
+  // each line takes
   final List<String> _conversationHistory = [];
+  final List<int> _conversationTokens = [];
+  final Set<String> _transcribedSegments = {};
+  int _transcriptTokens = 0;
   static const int maxContextTokens = 4096; // Context window size
 
+  // Transcript kept in the prompt. Past it the transcript is cut down in
+  // one go, to three quarters, since any change near the front of the
+  // prompt costs a full re-evaluation: the latest lines are kept whole, up
+  // to half of it, and the most telling of the older ones fill the rest.
+  static const int _maxTranscriptTokens = 2048;
+
+  // Lines of the running transcript new lines are checked against for
+  // repeats
+  static const int _repeatContextLines = 8;
+
+  // Longest completion requested; the structured summary format fits well
+  // within it
+  static const int _maxResponseTokens = 512;
+
+  // Snapshot of the native context, so a restarted app or a model swapped
+  // back in starts with the instructions every prompt begins with already
+  // evaluated. The transcript after them is not carried over: each meeting
+  // starts its own. Snapshots hold the whole KV cache, hundreds of
+  // megabytes for the larger models, so they are taken at most this often,
+  // plus on dispose.
+  String? _sessionPath;
+  DateTime _lastSessionSave = DateTime.now();
+  static const Duration _sessionSaveInterval = Duration(minutes: 5);
+
+  // Whole-meeting summaries are built map-reduce style: the transcript is
+  // cut into chunks, each chunk is summarized, and the partial summaries
+  // are combined a few at a time until one is left. Up to
+  // [LlamaWorker.maxTasks] prompts run side by side in one analysis, so
+  // each takes at most a quarter of the context, with room for the shared
+  // instructions; two partial summaries always fit one chunk. Partial
+  // summaries are kept by prompt hash. Chunks that can no longer change are
+  // summarized in the background while the meeting goes on, so the summary
+  // at its end only has the last chunks and the combining left to do. The
+  // least recently used go beyond [_maxPartialSummaries], a few times what
+  // a long meeting needs.
+  static const int _chunkTokens = 512;
+  static const int _partialSummaryTokens = 256;
+  static const int _maxPartialSummaries = 256;
+  final Map<String, String> _partialSummaries = {};
+  Future<void>? _meetingPrepared;
+
+  // A pause this long in the conversation also ends a chunk
+  static const Duration _chunkGap = Duration(minutes: 2);
+
   LlamaSummarization({
     SummarizationConfig? config,
     required ModelManager modelManager,
@@ -36,6 +139,9 @@ class LlamaSummarization implements SummarizationInterface {
   @override
   bool get isInitialized => _isInitialized;
 
+  @override
+  ValueListenable<String?> get summaryDraft => _summaryDraft;
+
   @override
   Future<bool> initialize() async {
     if (_isInitialized) return true;
@@ -43,10 +149,9 @@ class LlamaSummarization implements SummarizationInterface {
     try {
       _lastError = null;
 
-      // Load native library
-      if (!await _loadLlamaLibrary()) {
-        _lastError = 'Failed to load Llama native library';
-        return false;
+      // A missing native library is not fatal: responses are mocked
+      if (!LlamaFFI.initialize() && kDebugMode) {
+        print('Llama shim unavailable, using mock implementation');
       }
 
       // Ensure required models are downloaded
@@ -72,34 +177,6 @@ class LlamaSummarization implements SummarizationInterface {
     }
   }
 
-  /// Load platform-specific Llama library
-  Future<bool> _loadLlamaLibrary() async {
-    try {
-      if (Platform.isWindows) {
-        _llamaLib = DynamicLibrary.open('llama.dll');
-      } else if (Platform.isMacOS) {
-        _llamaLib = DynamicLibrary.open('libllama.dylib');
-      } else if (Platform.isLinux) {
-        _llamaLib = DynamicLibrary.open('libllama.so');
-      } else if (Platform.isAndroid) {
-        _llamaLib = DynamicLibrary.open('libllama.so');
-      } else if (Platform.isIOS) {
-        _llamaLib = DynamicLibrary.process();
-      } else {
-        return false;
-      }
-
-      return _llamaLib != null;
-    } catch (e) {
-      if (kDebugMode) {
-        print('Failed to load Llama library: $e');
-        print('Using mock implementation for development');
-      }
-      // Return true to allow development with mocks
-      return true;
-    }
-  }
-
   /// Get appropriate model ID for current platform
   String _getModelIdForPlatform() {
     if (defaultTargetPlatform == TargetPlatform.android ||
@@ -112,25 +189,130 @@ class LlamaSummarization implements SummarizationInterface {
 
   /// Initialize Llama context with model
   Future<bool> _initializeLlamaContext(String modelId) async {
-    try {
-      if (_llamaLib == null) {
-        // Development mode - use mock
-        return true;
-      }
+    if (!LlamaFFI.isAvailable) {
+      // Development mode - use mock
+      return true;
+    }
+
+    final modelPath = _modelManager.loadedModels[modelId]?.localPath;
+    if (modelPath == null) return false;
+
+    final shared = _sharedModels[modelPath];
+    if (shared != null) {
+      shared.users++;
+      _useShared(shared);
+      await _loadEmbedder();
+      return true;
+    }
+
+    final model =
+        LlamaFFI.loadModel(modelPath, contextLength: maxContextTokens);
+    if (model == null) return false;
+    final worker = LlamaWorker.create();
+    if (worker == null) {
+      LlamaFFI.freeModel(model);
+      return false;
+    }
+    final loaded = _SharedLlama(modelPath, model, worker);
+    _sharedModels[modelPath] = loaded;
+    _useShared(loaded);
+    _attachDraft(modelId);
+    await _loadEmbedder();
+    await _restoreSession(modelId);
+    return true;
+  }
+
+  void _useShared(_SharedLlama shared) {
+    _shared = shared;
+    _model = shared.model;
+    _worker = shared.worker;
+  }
 
-      // final modelInfo = _modelManager.loadedModels[modelId]!;
+  /// Stop using the shared model, freeing it if no other instance uses it
+  Future<void> _releaseShared() async {
+    final shared = _shared;
+    _shared = null;
+    _model = null;
+    _worker = null;
+    if (shared == null || --shared.users > 0) return;
+
+    _sharedModels.remove(shared.path);
+    // Stops any generation still running before its model goes away
+    await shared.worker.dispose();
+    LlamaFFI.freeModel(shared.model);
+    final draft = shared.draft;
+    if (draft != null) LlamaFFI.freeModel(draft);
+  }
 
-      // Get function pointers (simplified for this implementation)
-      // In production, you'd use the actual llama.cpp API
-      // final modelPath = modelInfo.localPath!;
+  /// Load the sentence encoder, downloading it if needed; topic changes are
+  /// asked of the main model without it
+  Future<void> _loadEmbedder() async {
+    if (!_modelManager.loadedModels.containsKey(_embeddingModelId) &&
+        !await _modelManager.downloadModel(_embeddingModelId)) {
+      return;
+    }
+    final embedderPath =
+        _modelManager.loadedModels[_embeddingModelId]?.localPath;
+    if (embedderPath == null) return;
+    _embedder = LlamaFFI.loadModel(embedderPath, embeddings: true);
+  }
+
+  /// Attach the draft for [modelId] if it is downloaded; it only speeds
+  /// generation up, so it is never downloaded for this
+  void _attachDraft(String modelId) {
+    final draftPath =
+        _modelManager.loadedModels[_draftModels[modelId]]?.localPath;
+    if (draftPath == null) return;
+
+    final draft =
+        LlamaFFI.loadModel(draftPath, contextLength: maxContextTokens);
+    if (draft == null) return;
+    if (!LlamaFFI.setDraft(_model!, draft)) {
+      debugPrint('Draft model rejected: ${LlamaFFI.lastError(_model!)}');
+      LlamaFFI.freeModel(draft);
+      return;
+    }
+    _shared!.draft = draft;
+  }
 
-      return true; // Mock success for development
+  /// Restore the snapshot last saved for [modelId], in this run or an
+  /// earlier one, if any
+  Future<void> _restoreSession(String modelId) async {
+    try {
+      // Kept next to the meeting database
+      final directory = await getApplicationDocumentsDirectory();
+      _sessionPath = path.join(directory.path, 'llama_session_$modelId.kv');
     } catch (e) {
-      if (kDebugMode) {
-        print('Llama context initialization failed: $e');
-      }
-      return true; // Allow development with mocks
+      debugPrint('No directory for Llama session snapshots: $e');
+      return;
     }
+    _lastSessionSave = DateTime.now();
+    if (!await File(_sessionPath!).exists()) return;
+
+    // Whatever the next prompt shares with the restored tokens is reused
+    await _worker!.loadSession(_model!, _sessionPath!);
+  }
+
+  /// Queue a snapshot if the last one is older than [_sessionSaveInterval]
+  void _saveSessionPeriodically() {
+    if (DateTime.now().difference(_lastSessionSave) >= _sessionSaveInterval) {
+      // Runs on the worker after the current job; not awaited
+      _saveSession();
+    }
+  }
+
+  /// Queue a snapshot of the context
+  Future<bool> _saveSession() async {
+    final model = _model;
+    final worker = _worker;
+    final sessionPath = _sessionPath;
+    if (model == null || worker == null || sessionPath == null) return false;
+
+    _lastSessionSave = DateTime.now();
+    final metadata = jsonEncode({
+      'saved_at': _lastSessionSave.millisecondsSinceEpoch,
+    });
+    return worker.saveSession(model, sessionPath, metadata);
   }
 
   @override
@@ -144,19 +326,17 @@ class LlamaSummarization implements SummarizationInterface {
     }
 
     try {
-      if (_llamaLib == null || _llamaContext == null) {
+      if (_model == null) {
         // Development mode - return mock data
         return _generateMockSummary(speechSegments);
       }
 
-      // Prepare input text from speech segments
-      final inputText = _prepareSpeechText(speechSegments);
-
-      // Generate summary prompt
-      final prompt = _buildSummaryPrompt(inputText, previousSummary, context);
+      // Generate summary task
+      final task = _buildSummaryTask(speechSegments, previousSummary, context);
 
       // Process with Llama
-      final summaryText = await _processWithLlama(prompt);
+      final summaryText = await _processWithLlama(task, speechSegments,
+          grammar: _summaryGrammar);
 
       // Parse the generated summary
       return _parseSummaryResponse(summaryText, speechSegments);
@@ -176,12 +356,12 @@ class LlamaSummarization implements SummarizationInterface {
     }
 
     try {
-      // Prepare update prompt
-      final newText = _prepareSpeechText(newSegments);
-      final updatePrompt = _buildUpdatePrompt(existingSummary, newText);
+      // Prepare update task
+      final updateTask = _buildUpdateTask(existingSummary, newSegments);
 
       // Process with Llama
-      final updatedText = await _processWithLlama(updatePrompt);
+      final updatedText = await _processWithLlama(updateTask, newSegments,
+          grammar: _summaryGrammar);
 
       // Parse and merge with existing summary
       final updatedSummary = _parseSummaryResponse(updatedText, newSegments);
@@ -209,6 +389,21 @@ class LlamaSummarization implements SummarizationInterface {
     // Use the most recent summary as the base
     final latestSummary = previousSummaries.last;
 
+    if (_embedder != null) {
+      // The topic is known without the model, which then generates only
+      // the summary that is kept
+      if (_embeddingTopicShift(const [], newSegments)) {
+        return generateSummary(newSegments,
+            context: _buildContextFromHistory(previousSummaries));
+      }
+      return updateSummary(latestSummary, newSegments);
+    }
+
+    if (_model != null) {
+      return _analyzeIncrementally(
+          previousSummaries, latestSummary, newSegments);
+    }
+
     // Check if we need to create a new summary or update the existing one
     final shouldCreateNew = await detectTopicChange([], newSegments);
 
@@ -220,6 +415,248 @@ class LlamaSummarization implements SummarizationInterface {
     }
   }
 
+  /// Decide between a new summary and an update of [latestSummary] in one
+  /// native pass
+  ///
+  /// The topic change question, the update and the new-topic summary share
+  /// the instructions and transcript, so they are evaluated once and the
+  /// three answers decode side by side; the topic answer then picks which
+  /// summary is kept. Decoding both summaries in one batch costs little
+  /// more than decoding one, and far less than a second prefill.
+  Future<MeetingSummary> _analyzeIncrementally(
+    List<MeetingSummary> previousSummaries,
+    MeetingSummary latestSummary,
+    List<SpeechSegment> newSegments,
+  ) async {
+    const topicTask = 0;
+    const updateTask = 1;
+    const newTopicTask = 2;
+
+    try {
+      _appendToTranscript(newSegments);
+      final texts = await _analyzeWithLlama([
+        LlamaTask(
+            _composePrompt(_buildTopicShiftTask(latestSummary, newSegments)),
+            maxTokens: _topicChangeTokens,
+            grammar: _topicChangeGrammar),
+        LlamaTask(
+            _composePrompt(_buildUpdateTask(latestSummary, newSegments)),
+            maxTokens: _maxResponseTokens,
+            grammar: _summaryGrammar),
+        LlamaTask(
+            _composePrompt(_buildSummaryTask(newSegments, null,
+                _buildContextFromHistory(previousSummaries))),
+            maxTokens: _maxResponseTokens,
+            grammar: _summaryGrammar),
+      ], draftTask: (soFar) {
+        final topic = soFar[topicTask].toString();
+        if (topic.isEmpty) return null;
+        return topic.contains('YES') ? newTopicTask : updateTask;
+      });
+
+      if (texts[topicTask].contains('YES')) {
+        return _parseSummaryResponse(texts[newTopicTask], newSegments);
+      }
+      return _mergeSummaries(latestSummary,
+          _parseSummaryResponse(texts[updateTask], newSegments));
+    } catch (e) {
+      _lastError = 'Error generating summary: $e';
+      return _createEmptySummary();
+    }
+  }
+
+  @override
+  Future<MeetingSummary> summarizeMeeting(
+    List<SpeechSegment> speechSegments, {
+    List<MeetingSummary> summaries = const [],
+  }) async {
+    if (!_isInitialized || speechSegments.isEmpty) {
+      return _createEmptySummary();
+    }
+
+    if (_model == null) {
+      // Development mode - return mock data
+      return _generateMockSummary(speechSegments);
+    }
+
+    try {
+      // Its chunks would otherwise be summarized twice
+      await _meetingPrepared;
+      final chunks = _chunkTranscript(
+          speechSegments, [for (final s in summaries) s.startTime]);
+      if (chunks.isEmpty) return _createEmptySummary();
+      var level = await _summarizeChunks(chunks, background: false);
+      while (level.length > 1) {
+        level = await _combinePartials(level, background: false);
+      }
+      return _parseSummaryResponse(level.single.text, speechSegments);
+    } catch (e) {
+      _lastError = 'Error summarizing meeting: $e';
+      return _createEmptySummary();
+    }
+  }
+
+  @override
+  Future<void> prepareMeetingSummary(
+    List<SpeechSegment> speechSegments, {
+    List<MeetingSummary> summaries = const [],
+  }) async {
+    if (!_isInitialized || _model == null || _meetingPrepared != null) return;
+
+    final prepared = _summarizeFinishedChunks(speechSegments, summaries);
+    _meetingPrepared = prepared;
+    try {
+      await prepared;
+    } finally {
+      _meetingPrepared = null;
+    }
+  }
+
+  Future<void> _summarizeFinishedChunks(List<SpeechSegment> speechSegments,
+      List<MeetingSummary> summaries) async {
+    try {
+      final chunks = _chunkTranscript(
+          speechSegments, [for (final s in summaries) s.startTime]);
+      // The last chunk may still grow
+      if (chunks.length < 2) return;
+      await _summarizeChunks(chunks.sublist(0, chunks.length - 1),
+          background: true);
+    } catch (e) {
+      _lastError = 'Error preparing meeting summary: $e';
+    }
+  }
+
+  /// Cut [segments] into consecutive chunks of at most [_chunkTokens]
+  /// transcript tokens, also ending one at a pause or a topic change
+  ///
+  /// Chunks are cut from the start of the meeting, so all but the last
+  /// come out the same as the meeting goes on. Segments not worth their
+  /// tokens are left out.
+  List<List<SpeechSegment>> _chunkTranscript(
+      List<SpeechSegment> segments, List<DateTime> topicStarts) {
+    final lineTokens = _budgetLines(segments.map(_transcriptLine).toList());
+    final chunks = <List<SpeechSegment>>[];
+    var chunk = <SpeechSegment>[];
+    int tokens = 0;
+    for (int i = 0; i < segments.length; i++) {
+      final segment = segments[i];
+      if (lineTokens[i] == 0) continue;
+      if (chunk.isNotEmpty &&
+          (tokens + lineTokens[i] > _chunkTokens ||
+              segment.startTime.difference(chunk.last.endTime) >= _chunkGap ||
+              topicStarts.any((t) =>
+                  !t.isAfter(segment.startTime) &&
+                  t.isAfter(chunk.last.startTime)))) {
+        chunks.add(chunk);
+        chunk = <SpeechSegment>[];
+        tokens = 0;
+      }
+      chunk.add(segment);
+      tokens += lineTokens[i];
+    }
+    if (chunk.isNotEmpty) chunks.add(chunk);
+    return chunks;
+  }
+
+  /// Summarize each of [chunks] on its own transcript
+  Future<List<_PartialSummary>> _summarizeChunks(
+      List<List<SpeechSegment>> chunks,
+      {required bool background}) {
+    return _runPartials([
+      for (final chunk in chunks)
+        _PartialPrompt(
+          _composePrompt(_buildSummaryTask(chunk, null, null),
+              chunk.map(_transcriptLine)),
+          chunk.first.startTime,
+          chunk.last.endTime,
+        ),
+    ], background: background);
+  }
+
+  /// Combine consecutive [partials] into fewer, at most [_chunkTokens] of
+  /// them at a time
+  Future<List<_PartialSummary>> _combinePartials(
+      List<_PartialSummary> partials,
+      {required bool background}) async {
+    final groups = <List<_PartialSummary>>[];
+    int tokens = 0;
+    for (final partial in partials) {
+      // Every group takes at least two, so each level shrinks
+      if (groups.isEmpty ||
+          (tokens + partial.tokens > _chunkTokens &&
+              groups.last.length > 1)) {
+        groups.add([]);
+        tokens = 0;
+      }
+      groups.last.add(partial);
+      tokens += partial.tokens;
+    }
+
+    // A group of one is carried to the next level as it is
+    final prompts = [
+      for (final group in groups)
+        if (group.length > 1)
+          _PartialPrompt(
+            _composePrompt(_buildCombineTask(group), const []),
+            group.first.start,
+            group.last.end,
+          ),
+    ];
+    final combined = await _runPartials(prompts, background: background);
+    int next = 0;
+    return [
+      for (final group in groups)
+        group.length > 1 ? combined[next++] : group.single,
+    ];
+  }
+
+  /// Run [prompts] not answered before, [LlamaWorker.maxTasks] at a time;
+  /// [background] ones wait on live summary updates
+  Future<List<_PartialSummary>> _runPartials(
+      List<_PartialPrompt> prompts,
+      {required bool background}) async {
+    final keys = [
+      for (final prompt in prompts)
+        sha1.convert(utf8.encode(prompt.prompt)).toString(),
+    ];
+    final answers = <String, String>{};
+    final pending = <String, String>{};
+    for (int i = 0; i < prompts.length; i++) {
+      // Taken out and put back below, so the map stays in order of use
+      final known = _partialSummaries.remove(keys[i]) ?? answers[keys[i]];
+      if (known != null) {
+        answers[keys[i]] = known;
+      } else {
+        pending[keys[i]] = prompts[i].prompt;
+      }
+    }
+
+    final pendingKeys = pending.keys.toList();
+    for (int i = 0; i < pendingKeys.length; i += LlamaWorker.maxTasks) {
+      final batch = pendingKeys.skip(i).take(LlamaWorker.maxTasks).toList();
+      final texts = await _analyzeWithLlama([
+        for (final key in batch)
+          LlamaTask(pending[key]!,
+              maxTokens: _partialSummaryTokens, grammar: _summaryGrammar),
+      ],
+          draftTask: (_) => batch.length == 1 ? 0 : null,
+          background: background);
+      for (int j = 0; j < batch.length; j++) {
+        answers[batch[j]] = texts[j];
+      }
+    }
+
+    _partialSummaries.addAll(answers);
+    while (_partialSummaries.length > _maxPartialSummaries) {
+      _partialSummaries.remove(_partialSummaries.keys.first);
+    }
+    return [
+      for (int i = 0; i < prompts.length; i++)
+        _PartialSummary(answers[keys[i]]!, prompts[i].start, prompts[i].end,
+            _countTokens(answers[keys[i]]!)),
+    ];
+  }
+
   @override
   Future<List<ActionItem>> extractActionItems(String text) async {
     if (!_isInitialized || text.trim().isEmpty) {
@@ -227,8 +664,9 @@ class LlamaSummarization implements SummarizationInterface {
     }
 
     try {
-      final prompt = _buildActionItemPrompt(text);
-      final response = await _processWithLlama(prompt);
+      final task = _buildActionItemTask(text);
+      final response = await _processWithLlama(task, const [],
+          grammar: _actionItemGrammar);
       return _parseActionItems(response);
     } catch (e) {
       _lastError = 'Error extracting action items: $e';
@@ -253,12 +691,15 @@ class LlamaSummarization implements SummarizationInterface {
         return true; // First segment is always a new topic
       }
 
-      final previousText =
-          _prepareSpeechText(previousSegments.take(5).toList());
-      final newText = _prepareSpeechText(newSegments);
+      if (_embedder != null) {
+        return _embeddingTopicShift(previousSegments, newSegments);
+      }
 
-      final prompt = _buildTopicChangePrompt(previousText, newText);
-      final response = await _processWithLlama(prompt);
+      final previous = previousSegments.take(5).toList();
+      final task = _buildTopicChangeTask(previous, newSegments);
+      final response = await _processWithLlama(
+          task, [...previous, ...newSegments],
+          grammar: _topicChangeGrammar, maxTokens: _topicChangeTokens);
 
       return response.toLowerCase().contains('yes') ||
           response.toLowerCase().contains('true');
@@ -268,26 +709,233 @@ class LlamaSummarization implements SummarizationInterface {
     }
   }
 
-  /// Prepare speech text from segments
-  String _prepareSpeechText(List<SpeechSegment> segments) {
-    final buffer = StringBuffer();
+  /// Whether [newSegments] move away from the running topic, judged from
+  /// their embeddings, which then join the topic they belong to
+  bool _embeddingTopicShift(
+      List<SpeechSegment> previousSegments, List<SpeechSegment> newSegments) {
+    final batch = '${_segmentKey(newSegments.first)}+${newSegments.length}';
+    if (batch == _judgedBatch) return _judgedShift;
+
+    if (_topicCentroid == null) {
+      final seed = math.max(0, previousSegments.length - _topicSeedSegments);
+      for (final segment in previousSegments.skip(seed)) {
+        final embedding = _embedSegment(segment);
+        if (embedding != null) _addToTopic(embedding);
+      }
+    }
+
+    final embeddings = [
+      for (final segment in newSegments) _embedSegment(segment),
+    ].whereType<Float32List>().toList();
+    if (embeddings.isEmpty) return false;
 
-    for (final segment in segments) {
-      final speaker = segment.speakerName ?? segment.speakerId;
-      buffer.writeln('[$speaker]: ${segment.text}');
+    final centroid = _topicCentroid;
+    final mean = Float32List(embeddings.first.length);
+    for (final embedding in embeddings) {
+      for (int i = 0; i < mean.length; i++) {
+        mean[i] += embedding[i];
+      }
     }
+    final shift = centroid != null &&
+        1 - _cosineSimilarity(centroid, mean) > _topicShiftDistance;
+
+    if (shift) _topicCentroid = null;
+    embeddings.forEach(_addToTopic);
+    _judgedBatch = batch;
+    _judgedShift = shift;
+    return shift;
+  }
 
-    return buffer.toString();
+  /// Embedding of [segment]'s text, or null for none
+  Float32List? _embedSegment(SpeechSegment segment) {
+    if (segment.text.trim().isEmpty) return null;
+    return LlamaFFI.embed(_embedder!, segment.text,
+        threads: _embeddingThreads);
   }
 
-  /// Build summary generation prompt
-  String _buildSummaryPrompt(
-      String inputText, MeetingSummary? previousSummary, String? context) {
-    final buffer = StringBuffer();
+  /// Fold [embedding] into the running topic as its latest segment
+  void _addToTopic(Float32List embedding) {
+    final centroid = _topicCentroid ??= Float32List(embedding.length);
+    for (int i = 0; i < centroid.length; i++) {
+      centroid[i] = centroid[i] * _topicDecay + embedding[i];
+    }
+  }
 
-    buffer.writeln(
-        'You are an expert meeting summarizer. Please analyze the following conversation and provide a structured summary.');
+  static double _cosineSimilarity(Float32List a, Float32List b) {
+    double dot = 0, normA = 0, normB = 0;
+    for (int i = 0; i < a.length; i++) {
+      dot += a[i] * b[i];
+      normA += a[i] * a[i];
+      normB += b[i] * b[i];
+    }
+    if (normA == 0 || normB == 0) return 0;
+    return dot / math.sqrt(normA * normB);
+  }
+
+  // Instructions every prompt starts with, followed by the transcript and
+  // then the task. They never change, and the transcript only grows, so
+  // the native context keeps both evaluated between calls and each call
+  // evaluates just the lines added since the last one plus its task.
+  static const String _instructions =
+      '''You are an expert meeting assistant. Below is a meeting transcript, one line per utterance in the form [HH:MM:SS] Speaker: text, followed by a task about it.
+
+When asked for a summary, respond in the summary format:
+TOPIC: [topic]
+KEY_POINTS:
+- [point 1]
+- [point 2]
+ACTION_ITEMS:
+- [action]: [assignee]
+PARTICIPANTS: [list]
+
+When asked for action items, respond in the action item format, one line per item:
+ACTION: [description] | ASSIGNEE: [person] | PRIORITY: [high/medium/low]
+
+When asked about a topic change, respond with YES or NO.
+''';
+
+  // Grammars for the response formats above, so the native sampler can
+  // only produce text the parsers below accept, and stops once the format
+  // is complete. Lists are bounded to keep a wandering model from running
+  // to the token limit. Descriptions and assignees cannot contain the
+  // separators they are split on.
+  static const String _summaryGrammar = r'''
+root ::= "TOPIC: " text "\n" "KEY_POINTS:\n" point{1,8} "ACTION_ITEMS:\n" action{0,8} "PARTICIPANTS: " text "\n"
+point ::= "- " text "\n"
+action ::= "- " phrase ": " phrase "\n"
+text ::= [^\n]+
+phrase ::= [^:\n]+
+''';
+
+  static const String _actionItemGrammar = r'''
+root ::= item{0,10}
+item ::= "ACTION: " field " | ASSIGNEE: " field " | PRIORITY: " ("high" | "medium" | "low") "\n"
+field ::= [^|\n]+
+''';
+
+  static const String _topicChangeGrammar = 'root ::= "YES" | "NO"';
+
+  // Enough for either answer of the topic change grammar
+  static const int _topicChangeTokens = 4;
+
+  /// Full prompt for [task]: instructions, transcript, task
+  ///
+  /// The transcript is the running one unless [transcript] is given.
+  String _composePrompt(String task, [Iterable<String>? transcript]) {
+    final buffer = StringBuffer(_instructions);
+    buffer.writeln('');
+    buffer.writeln('TRANSCRIPT:');
+    for (final line in transcript ?? _conversationHistory) {
+      buffer.writeln(line);
+    }
     buffer.writeln('');
+    buffer.writeln('TASK:');
+    buffer.write(task);
+    return buffer.toString();
+  }
+
+  /// Append segments not yet in the running transcript, leaving out
+  /// those not worth their tokens
+  void _appendToTranscript(List<SpeechSegment> segments) {
+    final lines = [
+      for (final segment in segments)
+        if (_transcribedSegments.add(_segmentKey(segment)))
+          _transcriptLine(segment),
+    ];
+    if (lines.isEmpty) return;
+
+    final context =
+        math.min(_conversationHistory.length, _repeatContextLines);
+    final tokens = _budgetLines([
+      ..._conversationHistory.skip(_conversationHistory.length - context),
+      ...lines,
+    ], context: context);
+    for (int i = 0; i < lines.length; i++) {
+      if (tokens[context + i] == 0) continue;
+      _conversationHistory.add(lines[i]);
+      _conversationTokens.add(tokens[context + i]);
+      _transcriptTokens += tokens[context + i];
+    }
+
+    if (_transcriptTokens <= _maxTranscriptTokens) return;
+    int recent = _conversationHistory.length;
+    int recentTokens = 0;
+    while (recent > 0 &&
+        recentTokens + _conversationTokens[recent - 1] <=
+            _maxTranscriptTokens ~/ 2) {
+      recent--;
+      recentTokens += _conversationTokens[recent];
+    }
+    final older = _budgetLines(_conversationHistory.sublist(0, recent),
+        budget: _maxTranscriptTokens * 3 ~/ 4 - recentTokens);
+    for (int i = recent - 1; i >= 0; i--) {
+      if (older[i] != 0) continue;
+      _conversationHistory.removeAt(i);
+      _conversationTokens.removeAt(i);
+    }
+    _transcriptTokens = _conversationTokens.fold(0, (sum, n) => sum + n);
+  }
+
+  /// Tokens each of [lines] takes in a prompt, 0 for those not worth it:
+  /// repeats, backchannel and, past [budget] tokens, those saying least
+  ///
+  /// The first [context] lines are already in the prompt and only compared
+  /// against. Without the native tokenizer, tokens are estimated and only
+  /// [budget] leaves lines out, the earliest ones.
+  List<int> _budgetLines(List<String> lines,
+      {int context = 0, int budget = 0}) {
+    final model = _model;
+    final measured = model == null || lines.isEmpty
+        ? null
+        : LlamaFFI.budgetTranscript(model, lines,
+            context: context, budget: budget);
+    if (measured != null) return measured;
+
+    final tokens = [
+      for (int i = 0; i < lines.length; i++)
+        i < context ? 0 : _countTokens(lines[i]),
+    ];
+    int total = 0;
+    for (int i = lines.length - 1; i >= context && budget > 0; i--) {
+      total += tokens[i];
+      if (total > budget) tokens[i] = 0;
+    }
+    return tokens;
+  }
+
+  /// Identifies [segment] across batches
+  static String _segmentKey(SpeechSegment segment) {
+    return '${segment.startTime.microsecondsSinceEpoch}:${segment.speakerId}';
+  }
+
+  /// Transcript line for [segment]
+  static String _transcriptLine(SpeechSegment segment) {
+    final speaker = segment.speakerName ?? segment.speakerId;
+    return '[${_clock(segment.startTime)}] $speaker: ${segment.text}';
+  }
+
+  /// Tokens [text] takes in the model's vocabulary, estimated without one
+  int _countTokens(String text) {
+    final model = _model;
+    if (model == null) return (text.length / 4).ceil() + 1;
+    return LlamaFFI.tokenize(model, '$text\n').length;
+  }
+
+  static String _clock(DateTime time) {
+    String two(int n) => n.toString().padLeft(2, '0');
+    return '${two(time.hour)}:${two(time.minute)}:${two(time.second)}';
+  }
+
+  /// Transcript time range covered by [segments]
+  static String _range(List<SpeechSegment> segments) {
+    return '[${_clock(segments.first.startTime)}] to '
+        '[${_clock(segments.last.endTime)}]';
+  }
+
+  /// Build summary generation task
+  String _buildSummaryTask(List<SpeechSegment> segments,
+      MeetingSummary? previousSummary, String? context) {
+    final buffer = StringBuffer();
 
     if (context != null && context.isNotEmpty) {
       buffer.writeln('Previous context:');
@@ -302,101 +950,221 @@ class LlamaSummarization implements SummarizationInterface {
       buffer.writeln('');
     }
 
-    buffer.writeln('New conversation:');
-    buffer.writeln(inputText);
-    buffer.writeln('');
-    buffer.writeln('Please provide:');
-    buffer.writeln('1. A clear topic/title');
-    buffer.writeln('2. Key discussion points (bullet points)');
-    buffer.writeln('3. Action items with assignees (if any)');
-    buffer.writeln('4. Main participants');
-    buffer.writeln('');
-    buffer.writeln('Format your response as:');
-    buffer.writeln('TOPIC: [topic]');
-    buffer.writeln('KEY_POINTS:');
-    buffer.writeln('- [point 1]');
-    buffer.writeln('- [point 2]');
-    buffer.writeln('ACTION_ITEMS:');
-    buffer.writeln('- [action]: [assignee]');
-    buffer.writeln('PARTICIPANTS: [list]');
+    buffer.writeln(
+        'Summarize the conversation from ${_range(segments)}: its topic, key discussion points, action items with assignees (if any) and main participants.');
+    buffer.writeln('Respond in the summary format.');
 
     return buffer.toString();
   }
 
-  /// Build update prompt for existing summary
-  String _buildUpdatePrompt(MeetingSummary existingSummary, String newText) {
+  /// Build update task for existing summary
+  String _buildUpdateTask(
+      MeetingSummary existingSummary, List<SpeechSegment> newSegments) {
     final buffer = StringBuffer();
 
-    buffer.writeln(
-        'Please update the following meeting summary with new information:');
-    buffer.writeln('');
     buffer.writeln('EXISTING SUMMARY:');
     buffer.writeln('Topic: ${existingSummary.topic}');
     buffer.writeln('Key Points: ${existingSummary.keyPoints.join(", ")}');
     buffer.writeln(
         'Action Items: ${existingSummary.actionItems.map((a) => "${a.description}: ${a.assignee}").join(", ")}');
     buffer.writeln('');
-    buffer.writeln('NEW CONVERSATION:');
-    buffer.writeln(newText);
+    buffer.writeln(
+        'Update this summary with the conversation from ${_range(newSegments)}.');
+    buffer.writeln('Respond in the summary format.');
+
+    return buffer.toString();
+  }
+
+  /// Build task combining consecutive partial summaries into one
+  String _buildCombineTask(List<_PartialSummary> partials) {
+    final buffer = StringBuffer();
+
+    buffer.writeln(
+        'Summaries of consecutive parts of the conversation from [${_clock(partials.first.start)}] to [${_clock(partials.last.end)}]:');
+    for (final partial in partials) {
+      buffer.writeln('');
+      buffer.writeln(
+          'From [${_clock(partial.start)}] to [${_clock(partial.end)}]:');
+      buffer.writeln(partial.text.trim());
+    }
     buffer.writeln('');
-    buffer.writeln('Please provide the updated summary in the same format.');
+    buffer.writeln(
+        'Combine them into one summary of the whole conversation, keeping the most important key points and all action items.');
+    buffer.writeln('Respond in the summary format.');
 
     return buffer.toString();
   }
 
-  /// Build action item extraction prompt
-  String _buildActionItemPrompt(String text) {
+  /// Build action item extraction task
+  String _buildActionItemTask(String text) {
     final buffer = StringBuffer();
 
     buffer.writeln('Extract action items from the following text:');
     buffer.writeln('');
     buffer.writeln(text);
     buffer.writeln('');
-    buffer.writeln('Format each action item as:');
+    buffer.writeln('Respond in the action item format.');
+
+    return buffer.toString();
+  }
+
+  /// Build topic change task against the latest summary
+  String _buildTopicShiftTask(
+      MeetingSummary latestSummary, List<SpeechSegment> newSegments) {
+    final buffer = StringBuffer();
+
     buffer.writeln(
-        'ACTION: [description] | ASSIGNEE: [person] | PRIORITY: [high/medium/low]');
+        'The conversation up to [${_clock(latestSummary.endTime)}] was about: ${latestSummary.topic}.');
+    buffer.writeln(
+        'Is there a significant topic change in the conversation from ${_range(newSegments)}?');
+    buffer.writeln(
+        'Respond with YES if there is a significant topic change, NO if it\'s the same topic.');
 
     return buffer.toString();
   }
 
-  /// Build topic change detection prompt
-  String _buildTopicChangePrompt(String previousText, String newText) {
+  /// Build topic change detection task
+  String _buildTopicChangeTask(
+      List<SpeechSegment> previous, List<SpeechSegment> next) {
     final buffer = StringBuffer();
 
     buffer.writeln(
-        'Analyze if there is a significant topic change between these two conversation segments:');
-    buffer.writeln('');
-    buffer.writeln('PREVIOUS:');
-    buffer.writeln(previousText);
-    buffer.writeln('');
-    buffer.writeln('NEW:');
-    buffer.writeln(newText);
-    buffer.writeln('');
+        'Is there a significant topic change between the conversation from ${_range(previous)} and the conversation from ${_range(next)}?');
     buffer.writeln(
         'Respond with YES if there is a significant topic change, NO if it\'s the same topic.');
 
     return buffer.toString();
   }
 
-  /// Process text with Llama model
-  Future<String> _processWithLlama(String prompt) async {
-    if (_llamaLib == null || _llamaContext == null) {
+  /// Process [task] with Llama model, after adding [segments] to the
+  /// running transcript
+  ///
+  /// The completion streams into [summaryDraft] as it is sampled. With a
+  /// [grammar] it can only take the shape the grammar describes.
+  Future<String> _processWithLlama(String task, List<SpeechSegment> segments,
+      {String? grammar, int maxTokens = _maxResponseTokens}) async {
+    _appendToTranscript(segments);
+    final model = _model;
+    final worker = _worker;
+    if (model == null || worker == null) {
       // Mock response for development
-      return _generateMockResponse(prompt);
+      return _generateMockResponse(task);
     }
 
+    // Let the native scheduler split the cores with a running Whisper model
+    _generationStarted();
+    final response = StringBuffer();
+    final draft = _claimDraft();
     try {
-      // This would call the actual llama.cpp functions
-      // For now, return mock response
-      return _generateMockResponse(prompt);
+      await for (final piece in worker.generate(
+        model,
+        _composePrompt(task),
+        maxTokens: maxTokens,
+        temperature: _config.temperature,
+        threads: _placeOnPlan(worker),
+        grammar: grammar,
+      )) {
+        response.write(piece);
+        _updateDraft(draft, response.toString());
+      }
+      _saveSessionPeriodically();
+      return response.toString();
     } catch (e) {
       throw Exception('Llama processing failed: $e');
+    } finally {
+      _releaseDraft(draft);
+      _generationEnded();
+    }
+  }
+
+  static void _generationStarted() {
+    if (_activeGenerations++ == 0) {
+      WhisperFFI.setEngineActive(InferenceEngine.llama, true);
     }
   }
 
+  static void _generationEnded() {
+    if (--_activeGenerations == 0) {
+      WhisperFFI.setEngineActive(InferenceEngine.llama, false);
+    }
+  }
+
+  /// Pin [worker] to Llama's cores under the native plan and return the
+  /// threads to run on them
+  ///
+  /// Without the whisper shim there is no plan; 0 keeps llama.cpp's default
+  /// thread count and the worker stays where the OS puts it.
+  static int _placeOnPlan(LlamaWorker worker) {
+    if (!WhisperFFI.isAvailable) return 0;
+    worker.placeOn(WhisperFFI.engineCpus(InferenceEngine.llama));
+    return WhisperFFI.engineThreads(InferenceEngine.llama);
+  }
+
+  /// Run [tasks], full prompts over the running transcript, in one native
+  /// analysis
+  ///
+  /// [draftTask] picks, from the texts so far, which one streams into
+  /// [summaryDraft], or null for none yet. A [background] analysis makes
+  /// way for the live ones and shows no draft.
+  Future<List<String>> _analyzeWithLlama(
+    List<LlamaTask> tasks, {
+    required int? Function(List<StringBuffer> texts) draftTask,
+    bool background = false,
+  }) async {
+    final texts = [for (final _ in tasks) StringBuffer()];
+
+    _generationStarted();
+    final draft = _claimDraft(background: background);
+    try {
+      final result = await _worker!.analyze(
+        _model!,
+        tasks,
+        temperature: _config.temperature,
+        threads: _placeOnPlan(_worker!),
+        background: background,
+        onText: (task, text) {
+          texts[task].write(text);
+          final shown = draftTask(texts);
+          if (shown != null) _updateDraft(draft, texts[shown].toString());
+        },
+      );
+      _saveSessionPeriodically();
+      return result;
+    } catch (e) {
+      throw Exception('Llama analysis failed: $e');
+    } finally {
+      _releaseDraft(draft);
+      _generationEnded();
+    }
+  }
+
+  /// Hand [summaryDraft] to a generation about to start, and return the
+  /// token it updates and releases the draft with
+  ///
+  /// The latest generation takes the draft over. A [background] one, such
+  /// as summarizing the finished part of a meeting, never shows: it is not
+  /// what anyone is waiting on.
+  Object _claimDraft({bool background = false}) {
+    final owner = Object();
+    if (background) return owner;
+    _draftOwner = owner;
+    _summaryDraft.value = '';
+    return owner;
+  }
+
+  void _updateDraft(Object owner, String text) {
+    if (identical(_draftOwner, owner)) _summaryDraft.value = text;
+  }
+
+  void _releaseDraft(Object owner) {
+    if (!identical(_draftOwner, owner)) return;
+    _draftOwner = null;
+    _summaryDraft.value = null;
+  }
+
   /// Generate mock response for development
-  String _generateMockResponse(String prompt) {
-    if (prompt.contains('TOPIC:')) {
+  String _generateMockResponse(String task) {
+    if (task.contains('summary format')) {
       return '''TOPIC: Project Planning Discussion
 KEY_POINTS:
 - Discussed Q4 project timeline and milestones
@@ -407,11 +1175,11 @@ ACTION_ITEMS:
 - Review budget proposal: Sarah
 - Schedule stakeholder meeting: Mike
 PARTICIPANTS: John, Sarah, Mike''';
-    } else if (prompt.contains('ACTION:')) {
+    } else if (task.contains('action item format')) {
       return '''ACTION: Update project timeline | ASSIGNEE: John | PRIORITY: high
 ACTION: Review budget proposal | ASSIGNEE: Sarah | PRIORITY: medium
 ACTION: Schedule stakeholder meeting | ASSIGNEE: Mike | PRIORITY: low''';
-    } else if (prompt.contains('topic change')) {
+    } else if (task.contains('topic change')) {
       return 'NO';
     } else {
       return 'Mock response for development';
@@ -625,21 +1393,62 @@ ACTION: Schedule stakeholder meeting | ASSIGNEE: Mike | PRIORITY: low''';
   }
 
   @override
-  Future<void> dispose() async {
-    if (_llamaContext != null && _llamaLib != null) {
-      try {
-        // Free Llama context (placeholder for actual implementation)
-        _llamaContext = null;
-      } catch (e) {
-        // Ignore disposal errors in development
-      }
-    }
+  void clearSession() {
+    // The context keeps what it evaluated; the instructions every prompt
+    // starts with are still reused from it
+    _conversationHistory.clear();
+    _conversationTokens.clear();
+    _transcribedSegments.clear();
+    _transcriptTokens = 0;
+    _topicCentroid = null;
+    _judgedBatch = null;
+    _judgedShift = false;
+    _partialSummaries.clear();
+  }
 
-    _llamaLib = null;
+  @override
+  Future<void> dispose() async {
+    await _saveSession();
+    await _releaseShared();
+    final embedder = _embedder;
+    if (embedder != null) LlamaFFI.freeModel(embedder);
+    _embedder = null;
+
+    _draftOwner = null;
+    _summaryDraft.value = null;
     _isInitialized = false;
-    _conversationHistory.clear();
+    clearSession();
+    _sessionPath = null;
   }
 }
 
-/// FFI structs for Llama
-final class LlamaContext extends Opaque {}
+/// Prompt for one partial summary of a meeting, and the time it covers
+class _PartialPrompt {
+  final String prompt;
+  final DateTime start;
+  final DateTime end;
+
+  const _PartialPrompt(this.prompt, this.start, this.end);
+}
+
+/// Summary of part of a meeting, and the tokens it takes in a prompt
+class _PartialSummary {
+  final String text;
+  final DateTime start;
+  final DateTime end;
+  final int tokens;
+
+  const _PartialSummary(this.text, this.start, this.end, this.tokens);
+}
+
+/// A model loaded for [LlamaSummarization], with the worker generating on
+/// it and its draft
+class _SharedLlama {
+  final String path;
+  final Pointer<NativeLlama> model;
+  final LlamaWorker worker;
+  Pointer<NativeLlama>? draft;
+  int users = 1;
+
+  _SharedLlama(this.path, this.model, this.worker);
+}
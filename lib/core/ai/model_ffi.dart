@@ -1,32 +1,545 @@
+import 'dart:async';
+import 'dart:convert';
 import 'dart:ffi';
 import 'dart:io';
+import 'dart:math' as math;
+import 'dart:typed_data';
+import 'package:ffi/ffi.dart';
 import 'package:flutter/foundation.dart';
 
-/// FFI bindings for Whisper speech recognition
-/// This provides the interface for loading and using Whisper models natively
+/// Mirror of `meeting_whisper_token` in native/whisper/meeting_whisper.h
+final class NativeWhisperToken extends Struct {
+  @Int64()
+  external int startMs;
+
+  @Int64()
+  external int endMs;
+
+  @Float()
+  external double logprob;
+
+  @Int32()
+  external int textOffset;
+
+  @Int32()
+  external int textLength;
+}
+
+/// Mirror of `meeting_whisper_segment` in native/whisper/meeting_whisper.h
+final class NativeWhisperSegment extends Struct {
+  @Int64()
+  external int startMs;
+
+  @Int64()
+  external int endMs;
+
+  @Float()
+  external double noSpeechProb;
+
+  external Pointer<Utf8> text;
+
+  external Pointer<NativeWhisperToken> tokens;
+
+  @Int32()
+  external int nTokens;
+}
+
+/// Mirror of `meeting_whisper_cpu_topology` in meeting_whisper.h
+final class NativeCpuTopology extends Struct {
+  @Int32()
+  external int logicalCpus;
+
+  @Int32()
+  external int physicalCores;
+
+  @Int32()
+  external int performanceCores;
+
+  @Int32()
+  external int numaNodes;
+}
+
+/// Opaque native Whisper context handle
+final class NativeWhisper extends Opaque {}
+
+/// Opaque native streaming transcription handle
+final class NativeWhisperStream extends Opaque {}
+
+/// Opaque native batch transcription handle
+final class NativeWhisperBatch extends Opaque {}
+
+/// Opaque native inference worker handle
+final class NativeWhisperWorker extends Opaque {}
+
+/// Opaque result of a native worker job
+final class NativeWhisperResult extends Opaque {}
+
+/// Mirror of `meeting_llama_event` in native/llama/meeting_llama.h
+final class NativeLlamaEvent extends Struct {
+  @Int32()
+  external int kind;
+
+  @Int32()
+  external int nTokens;
+
+  @Int32()
+  external int task;
+
+  external Pointer<Utf8> text;
+}
+
+/// Mirror of `meeting_llama_task` in native/llama/meeting_llama.h
+final class NativeLlamaTask extends Struct {
+  external Pointer<Utf8> prompt;
+
+  @Int32()
+  external int maxTokens;
+
+  external Pointer<Utf8> grammar;
+}
+
+/// Opaque native Llama context handle
+final class NativeLlama extends Opaque {}
+
+/// Opaque native generation worker handle
+final class NativeLlamaWorker extends Opaque {}
+
+/// A text token of a segment, timed like the segment
+class WhisperToken {
+  final String text;
+  final Duration start;
+  final Duration end;
+
+  /// Log-probability the decoder gave the token
+  final double logProbability;
+
+  const WhisperToken({
+    required this.text,
+    required this.start,
+    required this.end,
+    required this.logProbability,
+  });
+
+  double get probability => math.exp(logProbability);
+}
+
+/// A transcribed segment, timed relative to the start of the audio
+class WhisperSegment {
+  final String text;
+  final Duration start;
+  final Duration end;
+  final double noSpeechProbability;
+
+  /// Text tokens in order; they spell out [text]
+  final List<WhisperToken> tokens;
+
+  const WhisperSegment({
+    required this.text,
+    required this.start,
+    required this.end,
+    required this.noSpeechProbability,
+    this.tokens = const [],
+  });
+
+  /// Geometric mean of the token probabilities, discounted by the chance
+  /// that the segment is not speech at all
+  double get confidence {
+    if (tokens.isEmpty) return 1.0 - noSpeechProbability;
+    final meanLogProbability =
+        tokens.fold<double>(0.0, (sum, t) => sum + t.logProbability) /
+            tokens.length;
+    return math.exp(meanLogProbability) * (1.0 - noSpeechProbability);
+  }
+
+  /// Where speech starts within the segment, from the token times
+  Duration get speechStart => tokens.isEmpty ? start : tokens.first.start;
+
+  /// Where speech ends within the segment, from the token times
+  Duration get speechEnd => tokens.isEmpty ? end : tokens.last.end;
+}
+
+/// Result of feeding audio to a Whisper stream
+class WhisperStreamUpdate {
+  /// Segments finalized by this call, in order
+  final List<WhisperSegment> committed;
+
+  /// Provisional text for audio that is not final yet
+  final WhisperSegment? tentative;
+
+  /// Language the stream decodes in, null while undetermined
+  final String? language;
+
+  /// Whether the audio was discarded by a full worker queue
+  final bool dropped;
+
+  const WhisperStreamUpdate({
+    required this.committed,
+    this.tentative,
+    this.language,
+    this.dropped = false,
+  });
+}
+
+/// Segments and language of a one-shot transcription
+class WhisperTranscription {
+  final List<WhisperSegment> segments;
+  final String? language;
+
+  const WhisperTranscription({required this.segments, this.language});
+}
+
+/// CPU layout as seen by the native inference scheduler
+class CpuTopology {
+  final int logicalCpus;
+  final int physicalCores;
+
+  /// Cores in the fastest class; all of them on homogeneous CPUs
+  final int performanceCores;
+  final int numaNodes;
+
+  const CpuTopology({
+    required this.logicalCpus,
+    required this.physicalCores,
+    required this.performanceCores,
+    required this.numaNodes,
+  });
+}
+
+/// Inference engines sharing the cores (MEETING_WHISPER_ENGINE_*)
+enum InferenceEngine { whisper, llama }
+
+/// What a [WhisperWorker] does when a job arrives and its queue is full
+enum WhisperQueuePolicy {
+  /// Discard the oldest queued job (MEETING_WHISPER_QUEUE_DROP_OLDEST)
+  dropOldest,
+
+  /// Append stream audio to that stream's queued push when possible, and
+  /// drop the oldest job otherwise (MEETING_WHISPER_QUEUE_MERGE)
+  merge,
+}
+
+typedef _WhisperAbiVersionNative = Int32 Function();
+typedef _WhisperAbiVersionDart = int Function();
+typedef _WhisperInitNative = Pointer<NativeWhisper> Function(
+    Pointer<Utf8>, Int32);
+typedef _WhisperInitDart = Pointer<NativeWhisper> Function(Pointer<Utf8>, int);
+typedef _WhisperFreeNative = Void Function(Pointer<NativeWhisper>);
+typedef _WhisperFreeDart = void Function(Pointer<NativeWhisper>);
+typedef _WhisperTranscribeNative = Int32 Function(Pointer<NativeWhisper>,
+    Pointer<Float>, Int32, Pointer<Utf8>, Int32, Int32, Int32);
+typedef _WhisperTranscribeDart = int Function(
+    Pointer<NativeWhisper>, Pointer<Float>, int, Pointer<Utf8>, int, int, int);
+typedef _WhisperGetSegmentNative = Int32 Function(
+    Pointer<NativeWhisper>, Int32, Pointer<NativeWhisperSegment>);
+typedef _WhisperGetSegmentDart = int Function(
+    Pointer<NativeWhisper>, int, Pointer<NativeWhisperSegment>);
+typedef _WhisperStringNative = Pointer<Utf8> Function(Pointer<NativeWhisper>);
+typedef _WhisperStringDart = Pointer<Utf8> Function(Pointer<NativeWhisper>);
+typedef _WhisperIntNative = Int32 Function(Pointer<NativeWhisper>);
+typedef _WhisperIntDart = int Function(Pointer<NativeWhisper>);
+typedef _CpuTopologyNative = Void Function(Pointer<NativeCpuTopology>);
+typedef _CpuTopologyDart = void Function(Pointer<NativeCpuTopology>);
+typedef _SchedSetActiveNative = Void Function(Int32, Int32);
+typedef _SchedSetActiveDart = void Function(int, int);
+typedef _SchedThreadsNative = Int32 Function(Int32);
+typedef _SchedThreadsDart = int Function(int);
+typedef _SchedCpusNative = Int32 Function(Int32, Pointer<Int32>, Int32);
+typedef _SchedCpusDart = int Function(int, Pointer<Int32>, int);
+typedef _StreamCreateNative = Pointer<NativeWhisperStream> Function(
+    Pointer<NativeWhisper>, Pointer<Utf8>, Int32, Int32, Int32);
+typedef _StreamCreateDart = Pointer<NativeWhisperStream> Function(
+    Pointer<NativeWhisper>, Pointer<Utf8>, int, int, int);
+typedef _StreamFreeNative = Void Function(Pointer<NativeWhisperStream>);
+typedef _StreamFreeDart = void Function(Pointer<NativeWhisperStream>);
+typedef _StreamPushNative = Int32 Function(
+    Pointer<NativeWhisperStream>, Pointer<Float>, Int32);
+typedef _StreamPushDart = int Function(
+    Pointer<NativeWhisperStream>, Pointer<Float>, int);
+typedef _StreamFlushNative = Int32 Function(Pointer<NativeWhisperStream>);
+typedef _StreamFlushDart = int Function(Pointer<NativeWhisperStream>);
+typedef _StreamGetSegmentNative = Int32 Function(
+    Pointer<NativeWhisperStream>, Int32, Pointer<NativeWhisperSegment>);
+typedef _StreamGetSegmentDart = int Function(
+    Pointer<NativeWhisperStream>, int, Pointer<NativeWhisperSegment>);
+typedef _StreamTentativeNative = Int32 Function(
+    Pointer<NativeWhisperStream>, Pointer<NativeWhisperSegment>);
+typedef _StreamTentativeDart = int Function(
+    Pointer<NativeWhisperStream>, Pointer<NativeWhisperSegment>);
+typedef _StreamLanguageNative = Pointer<Utf8> Function(
+    Pointer<NativeWhisperStream>);
+typedef _StreamLanguageDart = Pointer<Utf8> Function(
+    Pointer<NativeWhisperStream>);
+typedef _BatchCreateNative = Pointer<NativeWhisperBatch> Function(
+    Pointer<NativeWhisper>, Int32);
+typedef _BatchCreateDart = Pointer<NativeWhisperBatch> Function(
+    Pointer<NativeWhisper>, int);
+typedef _BatchFreeNative = Void Function(Pointer<NativeWhisperBatch>);
+typedef _BatchFreeDart = void Function(Pointer<NativeWhisperBatch>);
+typedef _WorkerCallbackNative = Void Function(
+    Int64, Pointer<NativeWhisperResult>);
+typedef _WorkerCreateNative = Pointer<NativeWhisperWorker> Function(
+    Int32, Int32, Pointer<NativeFunction<_WorkerCallbackNative>>);
+typedef _WorkerCreateDart = Pointer<NativeWhisperWorker> Function(
+    int, int, Pointer<NativeFunction<_WorkerCallbackNative>>);
+typedef _WorkerFreeNative = Void Function(Pointer<NativeWhisperWorker>);
+typedef _WorkerFreeDart = void Function(Pointer<NativeWhisperWorker>);
+typedef _WorkerTranscribeNative = Int64 Function(
+    Pointer<NativeWhisperWorker>,
+    Pointer<NativeWhisper>,
+    Pointer<Float>,
+    Int32,
+    Pointer<Utf8>,
+    Int32,
+    Int32,
+    Int32);
+typedef _WorkerTranscribeDart = int Function(Pointer<NativeWhisperWorker>,
+    Pointer<NativeWhisper>, Pointer<Float>, int, Pointer<Utf8>, int, int, int);
+typedef _WorkerPushNative = Int64 Function(Pointer<NativeWhisperWorker>,
+    Pointer<NativeWhisperStream>, Pointer<Float>, Int32);
+typedef _WorkerPushDart = int Function(Pointer<NativeWhisperWorker>,
+    Pointer<NativeWhisperStream>, Pointer<Float>, int);
+typedef _WorkerFlushNative = Int64 Function(
+    Pointer<NativeWhisperWorker>, Pointer<NativeWhisperStream>);
+typedef _WorkerFlushDart = int Function(
+    Pointer<NativeWhisperWorker>, Pointer<NativeWhisperStream>);
+typedef _WorkerBatchNative = Int64 Function(
+    Pointer<NativeWhisperWorker>,
+    Pointer<NativeWhisperBatch>,
+    Pointer<Float>,
+    Pointer<Int32>,
+    Int32,
+    Pointer<Utf8>,
+    Int32,
+    Int32,
+    Int32);
+typedef _WorkerBatchDart = int Function(
+    Pointer<NativeWhisperWorker>,
+    Pointer<NativeWhisperBatch>,
+    Pointer<Float>,
+    Pointer<Int32>,
+    int,
+    Pointer<Utf8>,
+    int,
+    int,
+    int);
+typedef _WorkerDetectLanguageNative = Int64 Function(
+    Pointer<NativeWhisperWorker>, Pointer<NativeWhisper>, Pointer<Float>,
+    Int32, Int32);
+typedef _WorkerDetectLanguageDart = int Function(Pointer<NativeWhisperWorker>,
+    Pointer<NativeWhisper>, Pointer<Float>, int, int);
+typedef _LanguageCountNative = Int32 Function();
+typedef _LanguageCountDart = int Function();
+typedef _LanguageCodeNative = Pointer<Utf8> Function(Int32);
+typedef _LanguageCodeDart = Pointer<Utf8> Function(int);
+typedef _ResultIntNative = Int32 Function(Pointer<NativeWhisperResult>);
+typedef _ResultIntDart = int Function(Pointer<NativeWhisperResult>);
+typedef _ResultGetSegmentNative = Int32 Function(
+    Pointer<NativeWhisperResult>, Int32, Pointer<NativeWhisperSegment>);
+typedef _ResultGetSegmentDart = int Function(
+    Pointer<NativeWhisperResult>, int, Pointer<NativeWhisperSegment>);
+typedef _ResultTentativeNative = Int32 Function(
+    Pointer<NativeWhisperResult>, Pointer<NativeWhisperSegment>);
+typedef _ResultTentativeDart = int Function(
+    Pointer<NativeWhisperResult>, Pointer<NativeWhisperSegment>);
+typedef _ResultLanguageNative = Pointer<Utf8> Function(
+    Pointer<NativeWhisperResult>);
+typedef _ResultLanguageDart = Pointer<Utf8> Function(
+    Pointer<NativeWhisperResult>);
+typedef _ResultLanguageProbsNative = Int32 Function(
+    Pointer<NativeWhisperResult>, Pointer<Float>, Int32);
+typedef _ResultLanguageProbsDart = int Function(
+    Pointer<NativeWhisperResult>, Pointer<Float>, int);
+typedef _ResultWindowNative = Pointer<NativeWhisperResult> Function(
+    Pointer<NativeWhisperResult>, Int32);
+typedef _ResultWindowDart = Pointer<NativeWhisperResult> Function(
+    Pointer<NativeWhisperResult>, int);
+typedef _ResultFreeNative = Void Function(Pointer<NativeWhisperResult>);
+typedef _ResultFreeDart = void Function(Pointer<NativeWhisperResult>);
+
+/// FFI bindings for Whisper speech recognition (libmeeting_whisper)
+///
+/// The native shim wraps whisper.cpp behind a flat, versioned C ABI; see
+/// native/whisper/meeting_whisper.h.
 class WhisperFFI {
+  /// MEETING_WHISPER_ABI_VERSION these bindings were written against
+  static const int abiVersion = 9;
+
   static DynamicLibrary? _library;
   static bool _initialized = false;
+  static bool _initializationAttempted = false;
+
+  static _WhisperInitDart? _init;
+  static _WhisperFreeDart? _free;
+  static _WhisperTranscribeDart? _transcribe;
+  static _WhisperGetSegmentDart? _getSegment;
+  static _WhisperStringDart? _language;
+  static _WhisperStringDart? _lastError;
+  static _WhisperIntDart? _modelFtype;
+  static _WhisperStringDart? _modelType;
+  static _CpuTopologyDart? _cpuTopology;
+  static _SchedSetActiveDart? _schedSetActive;
+  static _SchedThreadsDart? _schedThreads;
+  static _SchedCpusDart? _schedCpus;
+  static _StreamCreateDart? _streamCreate;
+  static _StreamFreeDart? _streamFree;
+  static _StreamPushDart? _streamPush;
+  static _StreamFlushDart? _streamFlush;
+  static _StreamGetSegmentDart? _streamGetSegment;
+  static _StreamTentativeDart? _streamTentative;
+  static _StreamLanguageDart? _streamLanguage;
+  static _BatchCreateDart? _batchCreate;
+  static _BatchFreeDart? _batchFree;
+  static _WorkerCreateDart? _workerCreate;
+  static _WorkerFreeDart? _workerFree;
+  static _WorkerTranscribeDart? _workerTranscribe;
+  static _WorkerPushDart? _workerPush;
+  static _WorkerFlushDart? _workerFlush;
+  static _WorkerBatchDart? _workerBatch;
+  static _WorkerDetectLanguageDart? _workerDetectLanguage;
+  static _ResultIntDart? _resultStatus;
+  static _ResultIntDart? _resultSegmentCount;
+  static _ResultGetSegmentDart? _resultGetSegment;
+  static _ResultTentativeDart? _resultTentative;
+  static _ResultLanguageDart? _resultLanguage;
+  static _ResultLanguageProbsDart? _resultLanguageProbs;
+  static _ResultIntDart? _resultWindowCount;
+  static _ResultWindowDart? _resultWindow;
+  static _ResultFreeDart? _resultFree;
+
+  // Native scratch buffers reused across calls
+  static Pointer<Float> _samples = nullptr;
+  static int _samplesCapacity = 0;
+  static Pointer<Int32> _counts = nullptr;
+  static int _countsCapacity = 0;
+  static Pointer<NativeWhisperSegment> _segment = nullptr;
+
+  // ISO 639-1 code of each language id
+  static List<String> _languageCodes = const [];
+
+  /// Whether the native shim is loaded
+  static bool get isAvailable => _initialized;
 
   /// Initialize the Whisper FFI library
   static bool initialize() {
     if (_initialized) return true;
+    if (_initializationAttempted) return false;
+    _initializationAttempted = true;
 
     try {
-      // Load platform-specific library
-      String libraryName;
-      if (Platform.isWindows) {
-        libraryName = 'whisper.dll';
-      } else if (Platform.isLinux) {
-        libraryName = 'libwhisper.so';
-      } else if (Platform.isMacOS) {
-        libraryName = 'libwhisper.dylib';
-      } else {
-        debugPrint('Unsupported platform for Whisper FFI');
+      _library = _openLibrary();
+      if (_library == null) return false;
+
+      final version = _library!.lookupFunction<_WhisperAbiVersionNative,
+          _WhisperAbiVersionDart>('meeting_whisper_abi_version')();
+      if (version != abiVersion) {
+        debugPrint('Whisper shim ABI $version does not match $abiVersion');
         return false;
       }
 
-      _library = DynamicLibrary.open(libraryName);
+      // Loading and decoding run for seconds, so they are not leaf calls
+      _init = _library!.lookupFunction<_WhisperInitNative, _WhisperInitDart>(
+          'meeting_whisper_init');
+      _free = _library!.lookupFunction<_WhisperFreeNative, _WhisperFreeDart>(
+          'meeting_whisper_free');
+      _transcribe = _library!.lookupFunction<_WhisperTranscribeNative,
+          _WhisperTranscribeDart>('meeting_whisper_transcribe');
+      _getSegment = _library!.lookupFunction<_WhisperGetSegmentNative,
+          _WhisperGetSegmentDart>('meeting_whisper_get_segment', isLeaf: true);
+      _language = _library!.lookupFunction<_WhisperStringNative,
+          _WhisperStringDart>('meeting_whisper_language', isLeaf: true);
+      _lastError = _library!.lookupFunction<_WhisperStringNative,
+          _WhisperStringDart>('meeting_whisper_last_error', isLeaf: true);
+      _modelFtype = _library!.lookupFunction<_WhisperIntNative,
+          _WhisperIntDart>('meeting_whisper_model_ftype', isLeaf: true);
+      _modelType = _library!.lookupFunction<_WhisperStringNative,
+          _WhisperStringDart>('meeting_whisper_model_type', isLeaf: true);
+      _cpuTopology = _library!.lookupFunction<_CpuTopologyNative,
+          _CpuTopologyDart>('meeting_whisper_cpu_topology_get');
+      _schedSetActive = _library!.lookupFunction<_SchedSetActiveNative,
+          _SchedSetActiveDart>('meeting_whisper_sched_set_active',
+          isLeaf: true);
+      _schedThreads = _library!.lookupFunction<_SchedThreadsNative,
+          _SchedThreadsDart>('meeting_whisper_sched_threads', isLeaf: true);
+      _schedCpus = _library!.lookupFunction<_SchedCpusNative, _SchedCpusDart>(
+          'meeting_whisper_sched_cpus',
+          isLeaf: true);
+      _streamCreate = _library!.lookupFunction<_StreamCreateNative,
+          _StreamCreateDart>('meeting_whisper_stream_create');
+      _streamFree = _library!.lookupFunction<_StreamFreeNative,
+          _StreamFreeDart>('meeting_whisper_stream_free');
+      _streamPush = _library!.lookupFunction<_StreamPushNative,
+          _StreamPushDart>('meeting_whisper_stream_push');
+      _streamFlush = _library!.lookupFunction<_StreamFlushNative,
+          _StreamFlushDart>('meeting_whisper_stream_flush');
+      _streamGetSegment = _library!.lookupFunction<_StreamGetSegmentNative,
+              _StreamGetSegmentDart>('meeting_whisper_stream_get_segment',
+          isLeaf: true);
+      _streamTentative = _library!.lookupFunction<_StreamTentativeNative,
+          _StreamTentativeDart>('meeting_whisper_stream_tentative',
+          isLeaf: true);
+      _streamLanguage = _library!.lookupFunction<_StreamLanguageNative,
+          _StreamLanguageDart>('meeting_whisper_stream_language', isLeaf: true);
+      _batchCreate = _library!.lookupFunction<_BatchCreateNative,
+          _BatchCreateDart>('meeting_whisper_batch_create');
+      _batchFree = _library!.lookupFunction<_BatchFreeNative,
+          _BatchFreeDart>('meeting_whisper_batch_free');
+      // Worker calls only queue work, but freeing joins the worker thread
+      _workerCreate = _library!.lookupFunction<_WorkerCreateNative,
+          _WorkerCreateDart>('meeting_whisper_worker_create');
+      _workerFree = _library!.lookupFunction<_WorkerFreeNative,
+          _WorkerFreeDart>('meeting_whisper_worker_free');
+      _workerTranscribe = _library!.lookupFunction<_WorkerTranscribeNative,
+          _WorkerTranscribeDart>('meeting_whisper_worker_transcribe',
+          isLeaf: true);
+      _workerPush = _library!.lookupFunction<_WorkerPushNative,
+          _WorkerPushDart>('meeting_whisper_worker_push', isLeaf: true);
+      _workerFlush = _library!.lookupFunction<_WorkerFlushNative,
+          _WorkerFlushDart>('meeting_whisper_worker_flush', isLeaf: true);
+      _workerBatch = _library!.lookupFunction<_WorkerBatchNative,
+              _WorkerBatchDart>('meeting_whisper_worker_transcribe_batch',
+          isLeaf: true);
+      _resultStatus = _library!.lookupFunction<_ResultIntNative,
+          _ResultIntDart>('meeting_whisper_result_status', isLeaf: true);
+      _resultSegmentCount = _library!.lookupFunction<_ResultIntNative,
+          _ResultIntDart>('meeting_whisper_result_segment_count',
+          isLeaf: true);
+      _resultGetSegment = _library!.lookupFunction<_ResultGetSegmentNative,
+              _ResultGetSegmentDart>('meeting_whisper_result_get_segment',
+          isLeaf: true);
+      _resultTentative = _library!.lookupFunction<_ResultTentativeNative,
+          _ResultTentativeDart>('meeting_whisper_result_tentative',
+          isLeaf: true);
+      _resultLanguage = _library!.lookupFunction<_ResultLanguageNative,
+          _ResultLanguageDart>('meeting_whisper_result_language',
+          isLeaf: true);
+      _resultLanguageProbs = _library!.lookupFunction<
+              _ResultLanguageProbsNative, _ResultLanguageProbsDart>(
+          'meeting_whisper_result_language_probs',
+          isLeaf: true);
+      _workerDetectLanguage = _library!.lookupFunction<
+              _WorkerDetectLanguageNative, _WorkerDetectLanguageDart>(
+          'meeting_whisper_worker_detect_language',
+          isLeaf: true);
+
+      // Language ids are fixed by the model vocabulary
+      final languageCount = _library!.lookupFunction<_LanguageCountNative,
+          _LanguageCountDart>('meeting_whisper_language_count')();
+      final languageCode = _library!.lookupFunction<_LanguageCodeNative,
+          _LanguageCodeDart>('meeting_whisper_language_code');
+      _languageCodes = List.unmodifiable([
+        for (int i = 0; i < languageCount; i++) languageCode(i).toDartString(),
+      ]);
+
+      _resultWindowCount = _library!.lookupFunction<_ResultIntNative,
+          _ResultIntDart>('meeting_whisper_result_window_count',
+          isLeaf: true);
+      _resultWindow = _library!.lookupFunction<_ResultWindowNative,
+          _ResultWindowDart>('meeting_whisper_result_window', isLeaf: true);
+      _resultFree = _library!.lookupFunction<_ResultFreeNative,
+          _ResultFreeDart>('meeting_whisper_result_free', isLeaf: true);
+
+      _segment = calloc<NativeWhisperSegment>();
+
       _initialized = true;
       debugPrint('Whisper FFI initialized successfully');
       return true;
@@ -34,126 +547,794 @@ class WhisperFFI {
       debugPrint(
           'Whisper FFI libraries not found - this is expected for development builds');
       debugPrint(
-          'To enable native inference, compile and place the native libraries in the appropriate directory');
-      debugPrint('For now, using mock implementations for development');
+          'To enable native inference, build the native/ CMake project with MEETING_NATIVE_WHISPER');
       return false;
     }
   }
 
-  /// Load a Whisper model from file
-  static Pointer<Void>? loadModel(String modelPath) {
-    if (!_initialized || _library == null) {
+  static const int _initUseGpu = 1;
+  static const int _initPrefetch = 2;
+  static const int _initAlignTokens = 4;
+
+  /// Load a Whisper model from file, or null on failure
+  ///
+  /// The file is memory-mapped for loading, but the weights are copied into
+  /// Whisper's own private buffers rather than served from the page cache;
+  /// contexts loaded from the same path reuse one loaded model. [prefetch]
+  /// faults the whole file in up front, which is faster when it is not
+  /// already in the page cache.
+  /// [alignTokens] aligns token times with DTW, which word-level consumers
+  /// such as diarization need; without it they are estimated by the decoder.
+  static Pointer<NativeWhisper>? loadModel(String modelPath,
+      {bool useGpu = false,
+      bool prefetch = false,
+      bool alignTokens = false}) {
+    if (!_initialized || _init == null) {
       debugPrint('Whisper FFI not initialized');
       return null;
     }
 
+    final pathPtr = modelPath.toNativeUtf8();
     try {
-      // TODO: Implement actual FFI calls to load Whisper model
-      // This is a placeholder that would call the native whisper_init_from_file function
-
-      debugPrint('Loading Whisper model: $modelPath');
-
-      // For now, return a dummy pointer to indicate success
-      // In actual implementation, this would be:
-      // final loadModelFunc = _library!.lookupFunction<
-      //     Pointer<Void> Function(Pointer<Utf8>),
-      //     Pointer<Void> Function(Pointer<Utf8>)>('whisper_init_from_file');
-      //
-      // final pathPtr = modelPath.toNativeUtf8();
-      // final result = loadModelFunc(pathPtr);
-      // malloc.free(pathPtr);
-      // return result;
-
-      return Pointer<Void>.fromAddress(1); // Dummy non-null pointer
-    } catch (e) {
-      debugPrint('Error loading Whisper model: $e');
-      return null;
+      final flags = (useGpu ? _initUseGpu : 0) |
+          (prefetch ? _initPrefetch : 0) |
+          (alignTokens ? _initAlignTokens : 0);
+      final model = _init!(pathPtr, flags);
+      if (model == nullptr) {
+        debugPrint('Error loading Whisper model: $modelPath');
+        return null;
+      }
+      return model;
+    } finally {
+      calloc.free(pathPtr);
     }
   }
 
-  /// Transcribe audio data
-  static String? transcribe(Pointer<Void> model, List<double> audioData) {
-    if (!_initialized || _library == null || model.address == 0) {
-      return null;
-    }
+  /// Transcribe 16 kHz mono [audio]
+  ///
+  /// [language] is an ISO 639-1 code, or null to detect it. Returns null when
+  /// decoding fails; the reason is available from [lastError].
+  static List<WhisperSegment>? transcribe(
+    Pointer<NativeWhisper> model,
+    Float32List audio, {
+    String? language,
+    bool translate = false,
+    int threads = 0,
+    int beamSize = 1,
+  }) {
+    if (!_initialized || model == nullptr) return null;
+    if (audio.isEmpty) return const [];
+
+    final samples = _ensureSampleCapacity(audio.length);
+    samples.asTypedList(audio.length).setAll(0, audio);
 
+    final languagePtr = language?.toNativeUtf8() ?? nullptr;
+    final int count;
     try {
-      // TODO: Implement actual FFI calls for transcription
-      // This would involve:
-      // 1. Converting audio data to the format expected by Whisper
-      // 2. Calling whisper_full function
-      // 3. Extracting the transcribed text
+      count = _transcribe!(model, samples, audio.length, languagePtr,
+          translate ? 1 : 0, threads, beamSize);
+    } finally {
+      if (languagePtr != nullptr) calloc.free(languagePtr);
+    }
+    if (count < 0) return null;
 
-      debugPrint('Transcribing ${audioData.length} audio samples');
+    final segments = <WhisperSegment>[];
+    for (int i = 0; i < count; i++) {
+      if (_getSegment!(model, i, _segment) == 0) break;
+      segments.add(_toWhisperSegment(_segment.ref));
+    }
+    return segments;
+  }
 
-      // Placeholder implementation - return mock transcription
-      return 'This is a placeholder transcription. FFI implementation needed.';
-    } catch (e) {
-      debugPrint('Error during transcription: $e');
-      return null;
+  /// CPU topology detected by the shim, or null when it is not loaded
+  static CpuTopology? cpuTopology() {
+    if (!_initialized) return null;
+    final topology = calloc<NativeCpuTopology>();
+    try {
+      _cpuTopology!(topology);
+      return CpuTopology(
+        logicalCpus: topology.ref.logicalCpus,
+        physicalCores: topology.ref.physicalCores,
+        performanceCores: topology.ref.performanceCores,
+        numaNodes: topology.ref.numaNodes,
+      );
+    } finally {
+      calloc.free(topology);
     }
   }
 
-  /// Free a loaded model
-  static void freeModel(Pointer<Void> model) {
-    if (!_initialized || _library == null || model.address == 0) {
-      return;
+  /// Tell the scheduler whether [engine] is running inference
+  ///
+  /// Whisper is tracked natively while a model is loaded; Llama reports
+  /// itself around generation so the two split the cores instead of
+  /// oversubscribing them.
+  static void setEngineActive(InferenceEngine engine, bool active) {
+    if (!_initialized) return;
+    _schedSetActive!(engine.index, active ? 1 : 0);
+  }
+
+  /// Threads [engine] should run inference with under the current plan
+  static int engineThreads(InferenceEngine engine) {
+    if (!_initialized) return 1;
+    return _schedThreads!(engine.index);
+  }
+
+  /// Logical CPUs [engine] should be pinned to under the current plan, or
+  /// empty where affinity is not supported
+  static List<int> engineCpus(InferenceEngine engine) {
+    if (!_initialized) return const [];
+
+    const capacity = 256;
+    final cpus = calloc<Int32>(capacity);
+    try {
+      final count = _schedCpus!(engine.index, cpus, capacity);
+      return List.of(cpus.asTypedList(count.clamp(0, capacity)));
+    } finally {
+      calloc.free(cpus);
     }
+  }
 
+  /// Start a streaming transcription on [model], or nullptr on failure
+  ///
+  /// New audio is decoded every [stepMs] over a window of at most
+  /// [windowMs] of not-yet-final audio; zero picks the native defaults.
+  /// Without a [language], each speech region's language is probed as it
+  /// starts and the region is decoded in it.
+  static Pointer<NativeWhisperStream> createStream(
+    Pointer<NativeWhisper> model, {
+    String? language,
+    int threads = 0,
+    int stepMs = 0,
+    int windowMs = 0,
+  }) {
+    if (!_initialized || model == nullptr) return nullptr;
+
+    final languagePtr = language?.toNativeUtf8() ?? nullptr;
     try {
-      // TODO: Implement actual FFI call to free model
-      // final freeFunc = _library!.lookupFunction<
-      //     Void Function(Pointer<Void>),
-      //     void Function(Pointer<Void>)>('whisper_free');
-      // freeFunc(model);
+      return _streamCreate!(model, languagePtr, threads, stepMs, windowMs);
+    } finally {
+      if (languagePtr != nullptr) calloc.free(languagePtr);
+    }
+  }
 
-      debugPrint('Freed Whisper model');
-    } catch (e) {
-      debugPrint('Error freeing model: $e');
+  /// Feed [audio] to [stream]; returns null when decoding fails
+  static WhisperStreamUpdate? pushStream(
+      Pointer<NativeWhisperStream> stream, Float32List audio) {
+    if (!_initialized || stream == nullptr) return null;
+
+    final samples = _ensureSampleCapacity(audio.length);
+    samples.asTypedList(audio.length).setAll(0, audio);
+    return _readStreamUpdate(
+        stream, _streamPush!(stream, samples, audio.length));
+  }
+
+  /// Finalize all audio buffered in [stream]
+  static WhisperStreamUpdate? flushStream(Pointer<NativeWhisperStream> stream) {
+    if (!_initialized || stream == nullptr) return null;
+    return _readStreamUpdate(stream, _streamFlush!(stream));
+  }
+
+  /// Language [stream] decodes in, or null while undetermined
+  static String? streamLanguage(Pointer<NativeWhisperStream> stream) {
+    if (!_initialized || stream == nullptr) return null;
+    final language = _streamLanguage!(stream).toDartString();
+    return language.isEmpty ? null : language;
+  }
+
+  static void freeStream(Pointer<NativeWhisperStream> stream) {
+    if (!_initialized || stream == nullptr) return;
+    _streamFree!(stream);
+  }
+
+  /// Create a batch decoder on [model], or nullptr on failure
+  ///
+  /// [lanes] windows are decoded concurrently, each on its own decoder
+  /// state; zero picks one lane per two hardware threads.
+  static Pointer<NativeWhisperBatch> createBatch(
+    Pointer<NativeWhisper> model, {
+    int lanes = 0,
+  }) {
+    if (!_initialized || model == nullptr) return nullptr;
+    return _batchCreate!(model, lanes);
+  }
+
+  static void freeBatch(Pointer<NativeWhisperBatch> batch) {
+    if (!_initialized || batch == nullptr) return;
+    _batchFree!(batch);
+  }
+
+  static WhisperStreamUpdate? _readStreamUpdate(
+      Pointer<NativeWhisperStream> stream, int count) {
+    if (count < 0) return null;
+
+    final committed = <WhisperSegment>[];
+    for (int i = 0; i < count; i++) {
+      if (_streamGetSegment!(stream, i, _segment) == 0) break;
+      committed.add(_toWhisperSegment(_segment.ref));
     }
+    final tentative = _streamTentative!(stream, _segment) != 0
+        ? _toWhisperSegment(_segment.ref)
+        : null;
+    return WhisperStreamUpdate(committed: committed, tentative: tentative);
+  }
+
+  static WhisperSegment _toWhisperSegment(NativeWhisperSegment segment) {
+    final bytes = segment.text.cast<Uint8>().asTypedList(segment.text.length);
+    final tokens = <WhisperToken>[];
+    for (int i = 0; i < segment.nTokens; i++) {
+      final token = segment.tokens[i];
+      tokens.add(WhisperToken(
+        // A token can end inside a multi-byte character
+        text: utf8.decode(
+            bytes.sublist(token.textOffset,
+                token.textOffset + token.textLength),
+            allowMalformed: true),
+        start: Duration(milliseconds: token.startMs),
+        end: Duration(milliseconds: token.endMs),
+        logProbability: token.logprob,
+      ));
+    }
+
+    return WhisperSegment(
+      text: utf8.decode(bytes, allowMalformed: true),
+      start: Duration(milliseconds: segment.startMs),
+      end: Duration(milliseconds: segment.endMs),
+      noSpeechProbability: segment.noSpeechProb,
+      tokens: tokens,
+    );
+  }
+
+  /// Language of the last transcription on [model], or null if unknown
+  static String? lastLanguage(Pointer<NativeWhisper> model) {
+    if (!_initialized || model == nullptr) return null;
+    final language = _language!(model).toDartString();
+    return language.isEmpty ? null : language;
+  }
+
+  /// Description of the last failure on [model]
+  static String lastError(Pointer<NativeWhisper> model) {
+    if (!_initialized || model == nullptr) return '';
+    return _lastError!(model).toDartString();
+  }
+
+  /// Free a loaded model
+  static void freeModel(Pointer<NativeWhisper> model) {
+    if (!_initialized || model == nullptr) return;
+    _free!(model);
   }
 
   /// Get model information
-  static Map<String, dynamic>? getModelInfo(Pointer<Void> model) {
-    if (!_initialized || _library == null || model.address == 0) {
+  static Map<String, dynamic>? getModelInfo(Pointer<NativeWhisper> model) {
+    if (!_initialized || model == nullptr) {
       return null;
     }
 
-    // TODO: Implement actual model info retrieval
     return {
       'type': 'whisper',
-      'language_support': ['en', 'es', 'fr', 'de', 'it', 'pt', 'zh'],
+      'abi_version': abiVersion,
       'sample_rate': 16000,
       'loaded': true,
+      'model_type': _modelType!(model).toDartString(),
+      'quantization': _quantizationName(_modelFtype!(model)),
     };
   }
+
+  /// Name of a ggml file type as reported by meeting_whisper_model_ftype
+  static String _quantizationName(int ftype) {
+    switch (ftype) {
+      case 0:
+        return 'f32';
+      case 1:
+        return 'f16';
+      case 7:
+        return 'q8_0';
+      case 8:
+        return 'q5_0';
+      case 9:
+        return 'q5_1';
+      default:
+        return 'ftype$ftype';
+    }
+  }
+
+  static Pointer<Float> _ensureSampleCapacity(int count) {
+    if (count > _samplesCapacity) {
+      if (_samples != nullptr) calloc.free(_samples);
+      _samplesCapacity = count;
+      _samples = calloc<Float>(_samplesCapacity);
+    }
+    return _samples;
+  }
+
+  static Pointer<Int32> _ensureCountCapacity(int count) {
+    if (count > _countsCapacity) {
+      if (_counts != nullptr) calloc.free(_counts);
+      _countsCapacity = count;
+      _counts = calloc<Int32>(_countsCapacity);
+    }
+    return _counts;
+  }
+
+  static DynamicLibrary? _openLibrary() {
+    if (Platform.isWindows) {
+      return DynamicLibrary.open('meeting_whisper.dll');
+    } else if (Platform.isMacOS) {
+      return DynamicLibrary.open('libmeeting_whisper.dylib');
+    } else if (Platform.isLinux || Platform.isAndroid) {
+      return DynamicLibrary.open('libmeeting_whisper.so');
+    } else if (Platform.isIOS) {
+      return DynamicLibrary.process();
+    }
+    debugPrint('Unsupported platform for Whisper FFI');
+    return null;
+  }
+}
+
+/// Runs Whisper jobs on a persistent native inference thread
+///
+/// Submitting a job copies its audio and returns at once; the future
+/// completes when the native thread posts the result back through a
+/// [NativeCallable.listener]. Jobs run one at a time in submission order, so
+/// a context or stream used through a worker must not also be used directly.
+class WhisperWorker {
+  final Pointer<NativeWhisperWorker> _worker;
+  final NativeCallable<_WorkerCallbackNative> _callback;
+  final Map<int, Completer<_WorkerResult?>> _jobs;
+  bool _disposed = false;
+
+  WhisperWorker._(this._worker, this._callback, this._jobs);
+
+  /// Start a worker, or null when the native shim is unavailable
+  static WhisperWorker? create({
+    int queueCapacity = 4,
+    WhisperQueuePolicy policy = WhisperQueuePolicy.merge,
+  }) {
+    if (!WhisperFFI.isAvailable) return null;
+
+    final jobs = <int, Completer<_WorkerResult?>>{};
+    final callback = NativeCallable<_WorkerCallbackNative>.listener(
+        (int id, Pointer<NativeWhisperResult> result) {
+      final parsed = _WorkerResult.read(result);
+      if (result != nullptr) WhisperFFI._resultFree!(result);
+      jobs.remove(id)?.complete(parsed);
+    });
+
+    final worker = WhisperFFI._workerCreate!(
+        queueCapacity, policy.index, callback.nativeFunction);
+    if (worker == nullptr) {
+      callback.close();
+      return null;
+    }
+    return WhisperWorker._(worker, callback, jobs);
+  }
+
+  /// Number of jobs submitted and not yet completed
+  int get pendingJobs => _jobs.length;
+
+  /// Queue a one-shot transcription; null when it fails or is dropped
+  Future<WhisperTranscription?> transcribe(
+    Pointer<NativeWhisper> model,
+    Float32List audio, {
+    String? language,
+    bool translate = false,
+    int threads = 0,
+    int beamSize = 1,
+  }) async {
+    if (_disposed || model == nullptr || audio.isEmpty) return null;
+
+    final samples = WhisperFFI._ensureSampleCapacity(audio.length);
+    samples.asTypedList(audio.length).setAll(0, audio);
+    final languagePtr = language?.toNativeUtf8() ?? nullptr;
+    final int id;
+    try {
+      id = WhisperFFI._workerTranscribe!(_worker, model, samples, audio.length,
+          languagePtr, translate ? 1 : 0, threads, beamSize);
+    } finally {
+      if (languagePtr != nullptr) calloc.free(languagePtr);
+    }
+
+    final result = await _track(id);
+    if (result == null || result.status != _WorkerResult.ok) return null;
+    return WhisperTranscription(
+        segments: result.segments, language: result.language);
+  }
+
+  /// Queue language detection on the start of [audio]
+  ///
+  /// Runs only the encoder and one decoder step, so a few seconds of speech
+  /// is all it needs and looks at. Completes with the probability of each
+  /// language by ISO 639-1 code, or null when it fails or is dropped.
+  Future<Map<String, double>?> detectLanguage(
+    Pointer<NativeWhisper> model,
+    Float32List audio, {
+    int threads = 0,
+  }) async {
+    if (_disposed || model == nullptr || audio.isEmpty) return null;
+
+    final samples = WhisperFFI._ensureSampleCapacity(audio.length);
+    samples.asTypedList(audio.length).setAll(0, audio);
+    final id = WhisperFFI._workerDetectLanguage!(
+        _worker, model, samples, audio.length, threads);
+
+    final result = await _track(id);
+    if (result == null || result.status != _WorkerResult.ok) return null;
+    return result.languageProbabilities;
+  }
+
+  /// Queue transcription of independent [windows] on [batch]
+  ///
+  /// Completes with one entry per window, null where that window failed, or
+  /// null altogether when the job fails or is dropped.
+  Future<List<WhisperTranscription?>?> transcribeBatch(
+    Pointer<NativeWhisperBatch> batch,
+    List<Float32List> windows, {
+    String? language,
+    bool translate = false,
+    int threads = 0,
+    int beamSize = 1,
+  }) async {
+    if (_disposed || batch == nullptr) return null;
+    if (windows.isEmpty) return const [];
+
+    final total = windows.fold<int>(0, (sum, w) => sum + w.length);
+    final samples = WhisperFFI._ensureSampleCapacity(total);
+    final counts = WhisperFFI._ensureCountCapacity(windows.length);
+    final sampleView = samples.asTypedList(total);
+    final countView = counts.asTypedList(windows.length);
+    int offset = 0;
+    for (int i = 0; i < windows.length; i++) {
+      sampleView.setAll(offset, windows[i]);
+      countView[i] = windows[i].length;
+      offset += windows[i].length;
+    }
+
+    final languagePtr = language?.toNativeUtf8() ?? nullptr;
+    final int id;
+    try {
+      id = WhisperFFI._workerBatch!(_worker, batch, samples, counts,
+          windows.length, languagePtr, translate ? 1 : 0, threads, beamSize);
+    } finally {
+      if (languagePtr != nullptr) calloc.free(languagePtr);
+    }
+
+    final result = await _track(id);
+    if (result == null || result.status != _WorkerResult.ok) return null;
+    return [
+      for (final window in result.windows)
+        window.status == _WorkerResult.ok
+            ? WhisperTranscription(
+                segments: window.segments, language: window.language)
+            : null,
+    ];
+  }
+
+  /// Queue [audio] for [stream]; null when decoding fails
+  Future<WhisperStreamUpdate?> push(
+      Pointer<NativeWhisperStream> stream, Float32List audio) {
+    if (_disposed || stream == nullptr) return Future.value(null);
+    if (audio.isEmpty) {
+      return Future.value(const WhisperStreamUpdate(committed: []));
+    }
+
+    final samples = WhisperFFI._ensureSampleCapacity(audio.length);
+    samples.asTypedList(audio.length).setAll(0, audio);
+    return _streamUpdate(
+        WhisperFFI._workerPush!(_worker, stream, samples, audio.length));
+  }
+
+  /// Queue finalization of [stream] after its pending pushes
+  Future<WhisperStreamUpdate?> flush(Pointer<NativeWhisperStream> stream) {
+    if (_disposed || stream == nullptr) return Future.value(null);
+    return _streamUpdate(WhisperFFI._workerFlush!(_worker, stream));
+  }
+
+  /// Wait for submitted jobs, then stop the native thread
+  Future<void> dispose() async {
+    if (_disposed) return;
+    _disposed = true;
+
+    await Future.wait([for (final job in _jobs.values) job.future]);
+    WhisperFFI._workerFree!(_worker);
+    _callback.close();
+  }
+
+  Future<WhisperStreamUpdate?> _streamUpdate(int id) async {
+    final merged = _jobs.containsKey(id);
+    final result = await _track(id);
+    if (result == null || result.status == _WorkerResult.failed) return null;
+    if (result.status == _WorkerResult.dropped) {
+      return const WhisperStreamUpdate(committed: [], dropped: true);
+    }
+    return WhisperStreamUpdate(
+      // A merged push shares its job with an earlier push, which already
+      // reports the committed segments
+      committed: merged ? const [] : result.segments,
+      tentative: result.tentative,
+      language: result.language,
+    );
+  }
+
+  Future<_WorkerResult?> _track(int id) {
+    if (id < 0) return Future.value(null);
+    return _jobs.putIfAbsent(id, () => Completer<_WorkerResult?>()).future;
+  }
 }
 
-/// FFI bindings for Llama text generation
-/// This provides the interface for loading and using Llama models natively
+/// Dart copy of a native worker job result
+class _WorkerResult {
+  // MEETING_WHISPER_JOB_* in native/whisper/meeting_whisper.h
+  static const int ok = 0;
+  static const int failed = -1;
+  static const int dropped = 1;
+
+  final int status;
+  final List<WhisperSegment> segments;
+  final WhisperSegment? tentative;
+  final String? language;
+  final Map<String, double> languageProbabilities;
+  final List<_WorkerResult> windows;
+
+  const _WorkerResult({
+    required this.status,
+    this.segments = const [],
+    this.tentative,
+    this.language,
+    this.languageProbabilities = const {},
+    this.windows = const [],
+  });
+
+  static _WorkerResult read(Pointer<NativeWhisperResult> result) {
+    if (result == nullptr) return const _WorkerResult(status: failed);
+
+    final status = WhisperFFI._resultStatus!(result);
+    if (status != ok) return _WorkerResult(status: status);
+
+    final segment = WhisperFFI._segment;
+    final count = WhisperFFI._resultSegmentCount!(result);
+    final segments = <WhisperSegment>[];
+    for (int i = 0; i < count; i++) {
+      if (WhisperFFI._resultGetSegment!(result, i, segment) == 0) break;
+      segments.add(WhisperFFI._toWhisperSegment(segment.ref));
+    }
+    final tentative = WhisperFFI._resultTentative!(result, segment) != 0
+        ? WhisperFFI._toWhisperSegment(segment.ref)
+        : null;
+    final language = WhisperFFI._resultLanguage!(result).toDartString();
+    final windowCount = WhisperFFI._resultWindowCount!(result);
+
+    final probabilities = <String, double>{};
+    final probCount = WhisperFFI._resultLanguageProbs!(result, nullptr, 0);
+    if (probCount > 0) {
+      final probs = WhisperFFI._ensureSampleCapacity(probCount);
+      WhisperFFI._resultLanguageProbs!(result, probs, probCount);
+      final codes = WhisperFFI._languageCodes;
+      for (int i = 0; i < probCount && i < codes.length; i++) {
+        probabilities[codes[i]] = probs[i];
+      }
+    }
+
+    return _WorkerResult(
+      status: status,
+      segments: segments,
+      tentative: tentative,
+      language: language.isEmpty ? null : language,
+      languageProbabilities: probabilities,
+      windows: [
+        for (int i = 0; i < windowCount; i++)
+          read(WhisperFFI._resultWindow!(result, i)),
+      ],
+    );
+  }
+}
+
+typedef _LlamaAbiVersionNative = Int32 Function();
+typedef _LlamaAbiVersionDart = int Function();
+typedef _LlamaInitNative = Pointer<NativeLlama> Function(
+    Pointer<Utf8>, Int32, Int32);
+typedef _LlamaInitDart = Pointer<NativeLlama> Function(Pointer<Utf8>, int, int);
+typedef _LlamaFreeNative = Void Function(Pointer<NativeLlama>);
+typedef _LlamaFreeDart = void Function(Pointer<NativeLlama>);
+typedef _LlamaStringNative = Pointer<Utf8> Function(Pointer<NativeLlama>);
+typedef _LlamaStringDart = Pointer<Utf8> Function(Pointer<NativeLlama>);
+typedef _LlamaIntNative = Int32 Function(Pointer<NativeLlama>);
+typedef _LlamaIntDart = int Function(Pointer<NativeLlama>);
+typedef _LlamaEmbedNative = Int32 Function(
+    Pointer<NativeLlama>, Pointer<Utf8>, Int32, Pointer<Float>, Int32);
+typedef _LlamaEmbedDart = int Function(
+    Pointer<NativeLlama>, Pointer<Utf8>, int, Pointer<Float>, int);
+typedef _LlamaBudgetTranscriptNative = Int32 Function(Pointer<NativeLlama>,
+    Pointer<Utf8>, Int32, Int32, Int32, Pointer<Int32>);
+typedef _LlamaBudgetTranscriptDart = int Function(
+    Pointer<NativeLlama>, Pointer<Utf8>, int, int, int, Pointer<Int32>);
+typedef _LlamaSetDraftNative = Int32 Function(
+    Pointer<NativeLlama>, Pointer<NativeLlama>);
+typedef _LlamaSetDraftDart = int Function(
+    Pointer<NativeLlama>, Pointer<NativeLlama>);
+typedef _LlamaTokenizeNative = Int32 Function(
+    Pointer<NativeLlama>, Pointer<Utf8>, Int32, Pointer<Int32>, Int32);
+typedef _LlamaTokenizeDart = int Function(
+    Pointer<NativeLlama>, Pointer<Utf8>, int, Pointer<Int32>, int);
+typedef _LlamaCallbackNative = Void Function(Int64, Pointer<NativeLlamaEvent>);
+typedef _LlamaWorkerCreateNative = Pointer<NativeLlamaWorker> Function(
+    Pointer<NativeFunction<_LlamaCallbackNative>>);
+typedef _LlamaWorkerCreateDart = Pointer<NativeLlamaWorker> Function(
+    Pointer<NativeFunction<_LlamaCallbackNative>>);
+typedef _LlamaWorkerFreeNative = Void Function(Pointer<NativeLlamaWorker>);
+typedef _LlamaWorkerFreeDart = void Function(Pointer<NativeLlamaWorker>);
+typedef _LlamaWorkerSetCpusNative = Void Function(
+    Pointer<NativeLlamaWorker>, Pointer<Int32>, Int32);
+typedef _LlamaWorkerSetCpusDart = void Function(
+    Pointer<NativeLlamaWorker>, Pointer<Int32>, int);
+typedef _LlamaWorkerGenerateNative = Int64 Function(
+    Pointer<NativeLlamaWorker>,
+    Pointer<NativeLlama>,
+    Pointer<Utf8>,
+    Int32,
+    Float,
+    Int32,
+    Float,
+    Int32,
+    Int32,
+    Pointer<Utf8>);
+typedef _LlamaWorkerGenerateDart = int Function(
+    Pointer<NativeLlamaWorker>,
+    Pointer<NativeLlama>,
+    Pointer<Utf8>,
+    int,
+    double,
+    int,
+    double,
+    int,
+    int,
+    Pointer<Utf8>);
+typedef _LlamaWorkerAnalyzeNative = Int64 Function(
+    Pointer<NativeLlamaWorker>,
+    Pointer<NativeLlama>,
+    Pointer<NativeLlamaTask>,
+    Int32,
+    Float,
+    Int32,
+    Float,
+    Int32,
+    Int32);
+typedef _LlamaWorkerAnalyzeDart = int Function(
+    Pointer<NativeLlamaWorker>,
+    Pointer<NativeLlama>,
+    Pointer<NativeLlamaTask>,
+    int,
+    double,
+    int,
+    double,
+    int,
+    int);
+typedef _LlamaWorkerSaveSessionNative = Int64 Function(
+    Pointer<NativeLlamaWorker>, Pointer<NativeLlama>, Pointer<Utf8>,
+    Pointer<Utf8>);
+typedef _LlamaWorkerSaveSessionDart = int Function(
+    Pointer<NativeLlamaWorker>, Pointer<NativeLlama>, Pointer<Utf8>,
+    Pointer<Utf8>);
+typedef _LlamaWorkerLoadSessionNative = Int64 Function(
+    Pointer<NativeLlamaWorker>, Pointer<NativeLlama>, Pointer<Utf8>);
+typedef _LlamaWorkerLoadSessionDart = int Function(
+    Pointer<NativeLlamaWorker>, Pointer<NativeLlama>, Pointer<Utf8>);
+typedef _LlamaWorkerCancelNative = Int32 Function(
+    Pointer<NativeLlamaWorker>, Int64);
+typedef _LlamaWorkerCancelDart = int Function(Pointer<NativeLlamaWorker>, int);
+typedef _LlamaEventFreeNative = Void Function(Pointer<NativeLlamaEvent>);
+typedef _LlamaEventFreeDart = void Function(Pointer<NativeLlamaEvent>);
+
+/// FFI bindings for Llama text generation (libmeeting_llama)
+///
+/// The native shim wraps llama.cpp behind a flat, versioned C ABI; see
+/// native/llama/meeting_llama.h. Generation runs on a [LlamaWorker].
 class LlamaFFI {
+  /// MEETING_LLAMA_ABI_VERSION these bindings were written against
+  static const int abiVersion = 10;
+
   static DynamicLibrary? _library;
   static bool _initialized = false;
+  static bool _initializationAttempted = false;
+
+  static _LlamaInitDart? _init;
+  static _LlamaFreeDart? _free;
+  static _LlamaStringDart? _lastError;
+  static _LlamaStringDart? _modelDesc;
+  static _LlamaIntDart? _nCtx;
+  static _LlamaIntDart? _nVocab;
+  static _LlamaTokenizeDart? _tokenize;
+  static _LlamaSetDraftDart? _setDraft;
+  static _LlamaEmbedDart? _embed;
+  static _LlamaBudgetTranscriptDart? _budgetTranscript;
+  static _LlamaWorkerCreateDart? _workerCreate;
+  static _LlamaWorkerFreeDart? _workerFree;
+  static _LlamaWorkerSetCpusDart? _workerSetCpus;
+  static _LlamaWorkerGenerateDart? _workerGenerate;
+  static _LlamaWorkerAnalyzeDart? _workerAnalyze;
+  static _LlamaWorkerSaveSessionDart? _workerSaveSession;
+  static _LlamaWorkerLoadSessionDart? _workerLoadSession;
+  static _LlamaWorkerCancelDart? _workerCancel;
+  static _LlamaEventFreeDart? _eventFree;
+
+  // Native scratch buffers reused across calls
+  static Pointer<Int32> _tokens = nullptr;
+  static int _tokensCapacity = 0;
+  static Pointer<Float> _embedding = nullptr;
+  static int _embeddingCapacity = 0;
+
+  /// Whether the native shim is loaded
+  static bool get isAvailable => _initialized;
 
   /// Initialize the Llama FFI library
   static bool initialize() {
     if (_initialized) return true;
+    if (_initializationAttempted) return false;
+    _initializationAttempted = true;
 
     try {
-      // Load platform-specific library
-      String libraryName;
-      if (Platform.isWindows) {
-        libraryName = 'llama.dll';
-      } else if (Platform.isLinux) {
-        libraryName = 'libllama.so';
-      } else if (Platform.isMacOS) {
-        libraryName = 'libllama.dylib';
-      } else {
-        debugPrint('Unsupported platform for Llama FFI');
+      _library = _openLibrary();
+      if (_library == null) return false;
+
+      final version = _library!.lookupFunction<_LlamaAbiVersionNative,
+          _LlamaAbiVersionDart>('meeting_llama_abi_version')();
+      if (version != abiVersion) {
+        debugPrint('Llama shim ABI $version does not match $abiVersion');
         return false;
       }
 
-      _library = DynamicLibrary.open(libraryName);
+      // Loading runs for seconds, so it is not a leaf call
+      _init = _library!.lookupFunction<_LlamaInitNative, _LlamaInitDart>(
+          'meeting_llama_init');
+      _free = _library!.lookupFunction<_LlamaFreeNative, _LlamaFreeDart>(
+          'meeting_llama_free');
+      _lastError = _library!.lookupFunction<_LlamaStringNative,
+          _LlamaStringDart>('meeting_llama_last_error', isLeaf: true);
+      _modelDesc = _library!.lookupFunction<_LlamaStringNative,
+          _LlamaStringDart>('meeting_llama_model_desc', isLeaf: true);
+      _nCtx = _library!.lookupFunction<_LlamaIntNative, _LlamaIntDart>(
+          'meeting_llama_n_ctx',
+          isLeaf: true);
+      _nVocab = _library!.lookupFunction<_LlamaIntNative, _LlamaIntDart>(
+          'meeting_llama_n_vocab',
+          isLeaf: true);
+      _tokenize = _library!.lookupFunction<_LlamaTokenizeNative,
+          _LlamaTokenizeDart>('meeting_llama_tokenize', isLeaf: true);
+      _setDraft = _library!.lookupFunction<_LlamaSetDraftNative,
+          _LlamaSetDraftDart>('meeting_llama_set_draft', isLeaf: true);
+      // A whole meeting's transcript takes a while to tokenize
+      _budgetTranscript = _library!.lookupFunction<
+          _LlamaBudgetTranscriptNative,
+          _LlamaBudgetTranscriptDart>('meeting_llama_budget_transcript');
+      // Embedding evaluates the model, if only a small one
+      _embed = _library!.lookupFunction<_LlamaEmbedNative, _LlamaEmbedDart>(
+          'meeting_llama_embed');
+      // Worker calls only queue work, but freeing joins the worker thread
+      _workerCreate = _library!.lookupFunction<_LlamaWorkerCreateNative,
+          _LlamaWorkerCreateDart>('meeting_llama_worker_create');
+      _workerFree = _library!.lookupFunction<_LlamaWorkerFreeNative,
+          _LlamaWorkerFreeDart>('meeting_llama_worker_free');
+      _workerSetCpus = _library!.lookupFunction<_LlamaWorkerSetCpusNative,
+          _LlamaWorkerSetCpusDart>('meeting_llama_worker_set_cpus',
+          isLeaf: true);
+      _workerGenerate = _library!.lookupFunction<_LlamaWorkerGenerateNative,
+          _LlamaWorkerGenerateDart>('meeting_llama_worker_generate',
+          isLeaf: true);
+      _workerAnalyze = _library!.lookupFunction<_LlamaWorkerAnalyzeNative,
+          _LlamaWorkerAnalyzeDart>('meeting_llama_worker_analyze',
+          isLeaf: true);
+      _workerSaveSession = _library!.lookupFunction<
+          _LlamaWorkerSaveSessionNative,
+          _LlamaWorkerSaveSessionDart>('meeting_llama_worker_save_session',
+          isLeaf: true);
+      _workerLoadSession = _library!.lookupFunction<
+          _LlamaWorkerLoadSessionNative,
+          _LlamaWorkerLoadSessionDart>('meeting_llama_worker_load_session',
+          isLeaf: true);
+      // Cancelling a queued job posts its event from the calling thread
+      _workerCancel = _library!.lookupFunction<_LlamaWorkerCancelNative,
+          _LlamaWorkerCancelDart>('meeting_llama_worker_cancel');
+      _eventFree = _library!.lookupFunction<_LlamaEventFreeNative,
+          _LlamaEventFreeDart>('meeting_llama_event_free', isLeaf: true);
+
       _initialized = true;
       debugPrint('Llama FFI initialized successfully');
       return true;
@@ -161,77 +1342,519 @@ class LlamaFFI {
       debugPrint(
           'Llama FFI libraries not found - this is expected for development builds');
       debugPrint(
-          'To enable native inference, compile and place the native libraries in the appropriate directory');
-      debugPrint('For now, using mock implementations for development');
+          'To enable native inference, build the native/ CMake project with MEETING_NATIVE_LLAMA');
       return false;
     }
   }
 
-  /// Load a Llama model from file
-  static Pointer<Void>? loadModel(String modelPath) {
-    if (!_initialized || _library == null) {
+  static const int _initUseGpu = 1;
+  static const int _initEmbeddings = 2;
+
+  /// Load a GGUF model from file, or null on failure
+  ///
+  /// [contextLength] is the context size in tokens; 0 picks a default that
+  /// fits a transcript excerpt and its summary. With [embeddings] the model
+  /// is loaded for [embed] rather than generation.
+  static Pointer<NativeLlama>? loadModel(String modelPath,
+      {int contextLength = 0, bool useGpu = false, bool embeddings = false}) {
+    if (!_initialized || _init == null) {
       debugPrint('Llama FFI not initialized');
       return null;
     }
 
+    final pathPtr = modelPath.toNativeUtf8();
     try {
-      // TODO: Implement actual FFI calls to load Llama model
-      debugPrint('Loading Llama model: $modelPath');
-
-      // Placeholder - return dummy pointer
-      return Pointer<Void>.fromAddress(2); // Different address from Whisper
-    } catch (e) {
-      debugPrint('Error loading Llama model: $e');
-      return null;
+      final flags = (useGpu ? _initUseGpu : 0) |
+          (embeddings ? _initEmbeddings : 0);
+      final model = _init!(pathPtr, contextLength, flags);
+      if (model == nullptr) {
+        debugPrint('Error loading Llama model: $modelPath');
+        return null;
+      }
+      return model;
+    } finally {
+      calloc.free(pathPtr);
     }
   }
 
-  /// Generate text summary
-  static String? generateSummary(Pointer<Void> model, String inputText) {
-    if (!_initialized || _library == null || model.address == 0) {
-      return null;
-    }
+  /// Token ids of [text], with the model's BOS token first when
+  /// [addSpecial] is set
+  static List<int> tokenize(Pointer<NativeLlama> model, String text,
+      {bool addSpecial = false}) {
+    if (!_initialized || model == nullptr) return const [];
 
+    final textPtr = text.toNativeUtf8();
     try {
-      // TODO: Implement actual FFI calls for text generation
-      debugPrint('Generating summary for text length: ${inputText.length}');
-
-      // Placeholder implementation
-      return 'This is a placeholder summary generated by the Llama model. Input was: "${inputText.length > 100 ? inputText.substring(0, 100) + "..." : inputText}"';
-    } catch (e) {
-      debugPrint('Error generating summary: $e');
-      return null;
+      var count = _tokenize!(model, textPtr, addSpecial ? 1 : 0,
+          _ensureTokenCapacity(textPtr.length + 2), _tokensCapacity);
+      if (count < 0) {
+        count = _tokenize!(model, textPtr, addSpecial ? 1 : 0,
+            _ensureTokenCapacity(-count), _tokensCapacity);
+      }
+      return count > 0 ? List.of(_tokens.asTypedList(count)) : const [];
+    } finally {
+      calloc.free(textPtr);
     }
   }
 
-  /// Free a loaded model
-  static void freeModel(Pointer<Void> model) {
-    if (!_initialized || _library == null || model.address == 0) {
-      return;
+  /// Tokens each of the transcript [lines] takes in [model]'s prompts,
+  /// with its newline, or 0 for those not worth it, or null on failure
+  ///
+  /// Left out are repeats of the lines shortly before, lines of
+  /// backchannel only and, when the rest take more than [budget] tokens,
+  /// those saying least for their tokens. The first [context] lines are
+  /// already in the prompt: they are only compared against, and come back
+  /// as 0.
+  static List<int>? budgetTranscript(
+      Pointer<NativeLlama> model, List<String> lines,
+      {int context = 0, int budget = 0}) {
+    if (!_initialized || model == nullptr || lines.isEmpty) return null;
+
+    final text = lines.map((line) => line.replaceAll('\n', ' ')).join('\n');
+    final textPtr = text.toNativeUtf8();
+    try {
+      final tokens = _ensureTokenCapacity(lines.length);
+      for (int i = 0; i < context; i++) {
+        tokens[i] = 0;
+      }
+      final kept = _budgetTranscript!(
+          model, textPtr, lines.length, context, budget, tokens);
+      return kept >= 0 ? List.of(tokens.asTypedList(lines.length)) : null;
+    } finally {
+      calloc.free(textPtr);
     }
+  }
+
+  /// Unit-length embedding of [text] by [model], loaded with embeddings,
+  /// or null on failure
+  ///
+  /// Runs on the calling thread; meant for small sentence encoders, which
+  /// take milliseconds.
+  static Float32List? embed(Pointer<NativeLlama> model, String text,
+      {int threads = 0}) {
+    if (!_initialized || model == nullptr) return null;
 
+    final textPtr = text.toNativeUtf8();
     try {
-      // TODO: Implement actual FFI call to free model
-      debugPrint('Freed Llama model');
-    } catch (e) {
-      debugPrint('Error freeing model: $e');
+      var length =
+          _embed!(model, textPtr, threads, _embedding, _embeddingCapacity);
+      if (length < 0) {
+        if (_embedding != nullptr) calloc.free(_embedding);
+        _embeddingCapacity = -length;
+        _embedding = calloc<Float>(_embeddingCapacity);
+        length =
+            _embed!(model, textPtr, threads, _embedding, _embeddingCapacity);
+      }
+      return length > 0
+          ? Float32List.fromList(_embedding.asTypedList(length))
+          : null;
+    } finally {
+      calloc.free(textPtr);
     }
   }
 
+  /// Let [draft], a smaller model with the same vocabulary, guess ahead
+  /// for [model]'s completions, or stop when it is null
+  ///
+  /// Completions come out the same, in fewer evaluations of [model]. The
+  /// draft is not owned: detach it before freeing it. Returns false when
+  /// the vocabularies differ.
+  static bool setDraft(
+      Pointer<NativeLlama> model, Pointer<NativeLlama>? draft) {
+    if (!_initialized || model == nullptr) return false;
+    return _setDraft!(model, draft ?? nullptr) == 0;
+  }
+
+  /// Description of the last failure on [model]
+  static String lastError(Pointer<NativeLlama> model) {
+    if (!_initialized || model == nullptr) return '';
+    return _lastError!(model).toDartString();
+  }
+
+  /// Free a loaded model
+  static void freeModel(Pointer<NativeLlama> model) {
+    if (!_initialized || model == nullptr) return;
+    _free!(model);
+  }
+
   /// Get model information
-  static Map<String, dynamic>? getModelInfo(Pointer<Void> model) {
-    if (!_initialized || _library == null || model.address == 0) {
+  static Map<String, dynamic>? getModelInfo(Pointer<NativeLlama> model) {
+    if (!_initialized || model == nullptr) {
       return null;
     }
 
-    // TODO: Implement actual model info retrieval
     return {
       'type': 'llama',
-      'context_length': 4096,
-      'vocab_size': 32000,
+      'abi_version': abiVersion,
+      'description': _modelDesc!(model).toDartString(),
+      'context_length': _nCtx!(model),
+      'vocab_size': _nVocab!(model),
       'loaded': true,
     };
   }
+
+  static Pointer<Int32> _ensureTokenCapacity(int count) {
+    if (count > _tokensCapacity) {
+      if (_tokens != nullptr) calloc.free(_tokens);
+      _tokensCapacity = count;
+      _tokens = calloc<Int32>(_tokensCapacity);
+    }
+    return _tokens;
+  }
+
+  static DynamicLibrary? _openLibrary() {
+    if (Platform.isWindows) {
+      return DynamicLibrary.open('meeting_llama.dll');
+    } else if (Platform.isMacOS) {
+      return DynamicLibrary.open('libmeeting_llama.dylib');
+    } else if (Platform.isLinux || Platform.isAndroid) {
+      return DynamicLibrary.open('libmeeting_llama.so');
+    } else if (Platform.isIOS) {
+      return DynamicLibrary.process();
+    }
+    debugPrint('Unsupported platform for Llama FFI');
+    return null;
+  }
+}
+
+/// One completion of a [LlamaWorker.analyze] call
+class LlamaTask {
+  final String prompt;
+  final int maxTokens;
+
+  /// GBNF the completion must match, as for [LlamaWorker.generate]
+  final String? grammar;
+
+  const LlamaTask(this.prompt, {this.maxTokens = 512, this.grammar});
+}
+
+/// A generation that failed in the native shim
+class LlamaGenerationException implements Exception {
+  final String message;
+
+  const LlamaGenerationException(this.message);
+
+  @override
+  String toString() => 'LlamaGenerationException: $message';
+}
+
+/// Runs Llama generations on a persistent native inference thread
+///
+/// Each generation is a stream of text pieces, posted back through a
+/// [NativeCallable.listener] as the native thread samples them, so callers
+/// can render a completion while it is still being written. Generations on
+/// one context run side by side, continuously batched natively: each step
+/// evaluates the next token of every completion under way together, so a
+/// generation submitted while others run starts at once instead of queueing
+/// behind them. Background generations make way for foreground ones, and
+/// session snapshots wait for the generations before them. Cancelling a
+/// subscription stops its generation after the current step. A context
+/// used through a worker must not also be used directly.
+class LlamaWorker {
+  // MEETING_LLAMA_EVENT_* in native/llama/meeting_llama.h
+  static const int _eventToken = 0;
+  static const int _eventDone = 1;
+  static const int _eventCancelled = 2;
+  static const int _eventTaskDone = 3;
+
+  /// MEETING_LLAMA_MAX_TASKS in native/llama/meeting_llama.h
+  static const int maxTasks = 4;
+
+  // MEETING_LLAMA_GENERATE_* in native/llama/meeting_llama.h
+  static const int _generateChat = 1;
+  static const int _generateBackground = 2;
+
+  static int _flags({required bool chat, required bool background}) =>
+      (chat ? _generateChat : 0) | (background ? _generateBackground : 0);
+
+  final Pointer<NativeLlamaWorker> _worker;
+  final NativeCallable<_LlamaCallbackNative> _callback;
+  final Map<int, _LlamaJob> _jobs;
+  bool _disposed = false;
+
+  LlamaWorker._(this._worker, this._callback, this._jobs);
+
+  /// Start a worker, or null when the native shim is unavailable
+  static LlamaWorker? create() {
+    if (!LlamaFFI.isAvailable) return null;
+
+    final jobs = <int, _LlamaJob>{};
+    final callback = NativeCallable<_LlamaCallbackNative>.listener(
+        (int id, Pointer<NativeLlamaEvent> event) {
+      final job = jobs[id];
+      if (event == nullptr) {
+        jobs.remove(id);
+        job?.fail('out of memory');
+        return;
+      }
+
+      final kind = event.ref.kind;
+      final task = event.ref.task;
+      final text = event.ref.text.toDartString();
+      LlamaFFI._eventFree!(event);
+      if (job == null) return;
+      if (kind == _eventToken || kind == _eventTaskDone) {
+        job.add(task, text);
+        return;
+      }
+
+      jobs.remove(id);
+      if (kind == _eventDone) {
+        if (text.isNotEmpty) job.controller.add(text);
+        job.finish();
+      } else if (kind == _eventCancelled) {
+        job.cancel();
+      } else {
+        job.fail(text);
+      }
+    });
+
+    final worker = LlamaFFI._workerCreate!(callback.nativeFunction);
+    if (worker == nullptr) {
+      callback.close();
+      return null;
+    }
+    return LlamaWorker._(worker, callback, jobs);
+  }
+
+  /// Number of generations submitted and not yet finished
+  int get pendingJobs => _jobs.length;
+
+  /// Pin the worker thread, and the compute threads it starts, to [cpus]
+  /// from the next step on
+  ///
+  /// Typically [WhisperFFI.engineCpus] for [InferenceEngine.llama], so that
+  /// generation stays off the cores planned for Whisper and the one kept
+  /// free for capture and the UI. An empty list leaves placement unchanged.
+  void placeOn(List<int> cpus) {
+    if (_disposed || cpus.isEmpty) return;
+
+    final native = calloc<Int32>(cpus.length);
+    try {
+      native.asTypedList(cpus.length).setAll(0, cpus);
+      LlamaFFI._workerSetCpus!(_worker, native, cpus.length);
+    } finally {
+      calloc.free(native);
+    }
+  }
+
+  /// Queue a completion of [prompt] and stream its text as it is sampled
+  ///
+  /// With [chat] the prompt is sent as a user turn in the model's chat
+  /// template. At most [maxTokens] are generated, fewer when the context
+  /// fills up. [temperature] 0 decodes greedily. A [grammar], in llama.cpp's
+  /// GBNF with a `root` rule, restricts the completion to text it matches
+  /// and ends it as soon as the grammar is complete. A [background]
+  /// generation, for work that can wait, starts after the foreground ones
+  /// queued and pauses while any runs. The stream ends when the completion
+  /// does, and fails with a [LlamaGenerationException] when decoding fails.
+  Stream<String> generate(
+    Pointer<NativeLlama> model,
+    String prompt, {
+    int maxTokens = 512,
+    double temperature = 0.7,
+    int topK = 40,
+    double topP = 0.9,
+    int threads = 0,
+    bool chat = true,
+    bool background = false,
+    String? grammar,
+  }) {
+    if (_disposed || model == nullptr) return const Stream.empty();
+
+    final promptPtr = prompt.toNativeUtf8();
+    final grammarPtr = grammar?.toNativeUtf8() ?? nullptr;
+    final int id;
+    try {
+      id = LlamaFFI._workerGenerate!(_worker, model, promptPtr, maxTokens,
+          temperature, topK, topP, threads,
+          _flags(chat: chat, background: background), grammarPtr);
+    } finally {
+      calloc.free(promptPtr);
+      if (grammarPtr != nullptr) calloc.free(grammarPtr);
+    }
+    if (id < 0) {
+      return Stream.error(
+          const LlamaGenerationException('invalid generation request'));
+    }
+
+    final job = _LlamaJob();
+    job.controller.onCancel = () {
+      if (_jobs.containsKey(id)) LlamaFFI._workerCancel!(_worker, id);
+    };
+    _jobs[id] = job;
+    return job.controller.stream;
+  }
+
+  /// Queue completions of several [tasks] about the same text, and complete
+  /// with their texts in order
+  ///
+  /// The prompts should share as long a prefix as possible, e.g. a
+  /// transcript followed by different questions about it: the prefix is
+  /// evaluated once and forked natively into one sequence per task, and
+  /// the tasks then decode together, so the whole analysis costs about as
+  /// much as one generation. [onText] receives each task's text as it is
+  /// sampled. Other options are as for [generate]. Completes with what was
+  /// generated if cancelled by [dispose], and fails with a
+  /// [LlamaGenerationException] when decoding fails.
+  Future<List<String>> analyze(
+    Pointer<NativeLlama> model,
+    List<LlamaTask> tasks, {
+    double temperature = 0.7,
+    int topK = 40,
+    double topP = 0.9,
+    int threads = 0,
+    bool chat = true,
+    bool background = false,
+    void Function(int task, String text)? onText,
+  }) async {
+    if (tasks.isEmpty || tasks.length > maxTasks) {
+      throw ArgumentError.value(tasks.length, 'tasks');
+    }
+    if (_disposed || model == nullptr) return [for (final _ in tasks) ''];
+
+    final nativeTasks = calloc<NativeLlamaTask>(tasks.length);
+    final int id;
+    try {
+      for (var i = 0; i < tasks.length; i++) {
+        nativeTasks[i].prompt = tasks[i].prompt.toNativeUtf8();
+        nativeTasks[i].maxTokens = tasks[i].maxTokens;
+        nativeTasks[i].grammar = tasks[i].grammar?.toNativeUtf8() ?? nullptr;
+      }
+      id = LlamaFFI._workerAnalyze!(_worker, model, nativeTasks, tasks.length,
+          temperature, topK, topP, threads,
+          _flags(chat: chat, background: background));
+    } finally {
+      for (var i = 0; i < tasks.length; i++) {
+        calloc.free(nativeTasks[i].prompt);
+        if (nativeTasks[i].grammar != nullptr) {
+          calloc.free(nativeTasks[i].grammar);
+        }
+      }
+      calloc.free(nativeTasks);
+    }
+    if (id < 0) {
+      throw const LlamaGenerationException('invalid analysis request');
+    }
+
+    final job = _LlamaJob(tasks: tasks.length, onText: onText);
+    _jobs[id] = job;
+    await job.controller.stream.drain<void>();
+    return [for (final text in job.taskText!) text.toString()];
+  }
+
+  /// Queue a snapshot of [model]'s evaluated tokens and KV cache to [path]
+  ///
+  /// [metadata] is stored alongside and handed back by [loadSession]. The
+  /// snapshot is taken after the generations queued before it, and replaces
+  /// [path] only once fully written. Completes with whether it was saved.
+  Future<bool> saveSession(
+      Pointer<NativeLlama> model, String path, String metadata) async {
+    if (_disposed || model == nullptr) return false;
+
+    final pathPtr = path.toNativeUtf8();
+    final metadataPtr = metadata.toNativeUtf8();
+    final int id;
+    try {
+      id = LlamaFFI._workerSaveSession!(_worker, model, pathPtr, metadataPtr);
+    } finally {
+      calloc.free(pathPtr);
+      calloc.free(metadataPtr);
+    }
+    return await _runSessionJob(id, 'save') != null;
+  }
+
+  /// Queue a restore of the snapshot at [path] into [model]
+  ///
+  /// Completes with the metadata it was saved with, or null when there is
+  /// no usable snapshot (missing, from another model, damaged), in which
+  /// case [model] is left empty. Restoring maps the file and copies the
+  /// cache straight into the context, so the next generation only
+  /// evaluates what its prompt adds to the restored tokens.
+  Future<String?> loadSession(Pointer<NativeLlama> model, String path) async {
+    if (_disposed || model == nullptr) return null;
+
+    final pathPtr = path.toNativeUtf8();
+    final int id;
+    try {
+      id = LlamaFFI._workerLoadSession!(_worker, model, pathPtr);
+    } finally {
+      calloc.free(pathPtr);
+    }
+    return _runSessionJob(id, 'load');
+  }
+
+  /// Text of session job [id] once it is done, or null if it failed or was
+  /// cancelled
+  Future<String?> _runSessionJob(int id, String action) async {
+    if (id < 0) return null;
+
+    final job = _LlamaJob();
+    _jobs[id] = job;
+    try {
+      final text = await job.controller.stream.join();
+      return job.cancelled ? null : text;
+    } on LlamaGenerationException catch (e) {
+      debugPrint('Llama session $action failed: ${e.message}');
+      return null;
+    }
+  }
+
+  /// Cancel running and queued generations, then stop the native thread
+  Future<void> dispose() async {
+    if (_disposed) return;
+    _disposed = true;
+
+    for (final id in _jobs.keys) {
+      LlamaFFI._workerCancel!(_worker, id);
+    }
+    await Future.wait([for (final job in _jobs.values) job.finished.future]);
+    LlamaFFI._workerFree!(_worker);
+    _callback.close();
+  }
+}
+
+/// Dart side of one native generation
+class _LlamaJob {
+  final StreamController<String> controller = StreamController<String>();
+  final Completer<void> finished = Completer<void>();
+  bool cancelled = false;
+
+  // Text of each task of an analysis, which streams through [onText]
+  // rather than [controller]
+  final List<StringBuffer>? taskText;
+  final void Function(int task, String text)? onText;
+
+  _LlamaJob({int? tasks, this.onText})
+      : taskText = tasks == null
+            ? null
+            : [for (var i = 0; i < tasks; i++) StringBuffer()];
+
+  void add(int task, String text) {
+    final buffers = taskText;
+    if (buffers == null) {
+      if (text.isNotEmpty) controller.add(text);
+      return;
+    }
+    if (text.isEmpty || task < 0 || task >= buffers.length) return;
+    buffers[task].write(text);
+    onText?.call(task, text);
+  }
+
+  void cancel() {
+    cancelled = true;
+    finish();
+  }
+
+  void finish() {
+    controller.close();
+    finished.complete();
+  }
+
+  void fail(String message) {
+    controller.addError(LlamaGenerationException(message));
+    finish();
+  }
 }
 
 /// Helper class for FFI initialization and management
@@ -168,6 +168,26 @@ abstract class SpeechRecognitionInterface {
     DateTime? startTime,
   });
 
+  /// Feed live audio and return the segments finalized since the last call
+  ///
+  /// Only newly captured audio is passed; the implementation keeps the
+  /// unfinished tail and its decoding context between calls. [timestamp] is
+  /// the capture time of the first sample of the stream's first call.
+  /// Calls need not wait for each other: the audio is queued in call order
+  /// before the returned future is first suspended, and the futures complete
+  /// in that order.
+  Future<List<SpeechSegment>> processStream(
+    Float32List audioData, {
+    int sampleRate = 16000,
+    DateTime? timestamp,
+  });
+
+  /// Provisional segment for streamed audio that is not final yet
+  SpeechSegment? get tentativeSegment;
+
+  /// Finalize the stream fed by [processStream] and return its last segments
+  Future<List<SpeechSegment>> finishStream();
+
   /// Detect the primary language from audio
   Future<String> detectLanguage(Float32List audioData);
 
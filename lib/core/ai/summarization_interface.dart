@@ -1,3 +1,5 @@
+import 'package:flutter/foundation.dart';
+
 import 'speech_recognition_interface.dart';
 
 /// Configuration for text summarization
@@ -232,6 +234,23 @@ abstract class SummarizationInterface {
     List<SpeechSegment> newSegments,
   );
 
+  /// Summarize a whole meeting from its transcript, however long
+  ///
+  /// [summaries] are the incremental summaries generated so far; where
+  /// they start marks the topic changes.
+  Future<MeetingSummary> summarizeMeeting(
+    List<SpeechSegment> speechSegments, {
+    List<MeetingSummary> summaries = const [],
+  });
+
+  /// Summarize, in the background, the part of a meeting in progress that
+  /// can no longer change, so that [summarizeMeeting] at its end has less
+  /// left to do; does nothing while an earlier call is still running
+  Future<void> prepareMeetingSummary(
+    List<SpeechSegment> speechSegments, {
+    List<MeetingSummary> summaries = const [],
+  });
+
   /// Extract action items from text
   Future<List<ActionItem>> extractActionItems(String text);
 
@@ -241,6 +260,13 @@ abstract class SummarizationInterface {
     List<SpeechSegment> newSegments,
   );
 
+  /// Raw text of the completion being generated, as far as it has been
+  /// written; null while none is running
+  ValueListenable<String?> get summaryDraft;
+
+  /// Forget what earlier meetings said, before a new one starts
+  void clearSession();
+
   /// Clean up resources
   Future<void> dispose();
 }
@@ -1,43 +1,49 @@
 import 'dart:ffi';
-import 'dart:io';
 import 'dart:math' as math;
 import 'dart:typed_data';
-import 'package:ffi/ffi.dart';
 import 'package:flutter/foundation.dart';
 
+import 'device_capability_detector.dart';
 import 'speech_recognition_interface.dart';
 import 'enhanced_model_manager.dart';
-
-/// Native Whisper FFI structures
-final class WhisperContext extends Opaque {}
-
-final class WhisperFullParams extends Struct {
-  /// Decoding strategy (0 = greedy, 1 = beam search)
-  @Int32()
-  external int strategy;
-
-  /// Number of threads to use
-  @Int32()
-  external int n_threads;
-
-  /// Language ID
-  @Int32()
-  external int language_id;
-
-  /// Enable translation
-  @Bool()
-  external bool translate;
-}
+import 'model_ffi.dart';
 
 /// Native Whisper implementation for speech recognition
 /// Uses whisper.cpp through FFI for cross-platform compatibility
 class WhisperSpeechRecognition implements SpeechRecognitionInterface {
+  // Whisper decodes 16 kHz mono audio
+  static const int _sampleRate = 16000;
+
+  // Audio a language probe looks at, and the probability below which its
+  // answer is not trusted over the configured language
+  static const Duration _languageProbe = Duration(seconds: 3);
+  static const double _minLanguageProbability = 0.5;
+
   final SpeechRecognitionConfig _config;
   final ModelManager _modelManager;
 
-  // Native library and context
-  DynamicLibrary? _whisperLib;
-  Pointer<WhisperContext>? _whisperContext;
+  // Catalog model to load; picked from the device tier when null
+  final String? _requestedModelId;
+
+  // Native context, nullptr when running without the native shim, and the
+  // inference thread all decoding runs on
+  Pointer<NativeWhisper> _model = nullptr;
+  WhisperWorker? _worker;
+  Pointer<NativeWhisperBatch> _batch = nullptr;
+
+  // Live transcription stream, the capture time of its first sample and
+  // the number of samples pushed to it so far
+  Pointer<NativeWhisperStream> _stream = nullptr;
+  DateTime? _streamStart;
+  int _streamSamples = 0;
+  SpeechSegment? _tentativeSegment;
+
+  // Audio pushed to the stream that segments yet to be committed may span,
+  // in push order, so their speakers are told from their own samples. The
+  // stream decodes at most [_streamWindow] at a time, so nothing older than
+  // that before the latest sample is kept.
+  final List<_PushedAudio> _streamAudio = [];
+  static const Duration _streamWindow = Duration(seconds: 10);
 
   // State
   bool _isInitialized = false;
@@ -51,8 +57,10 @@ class WhisperSpeechRecognition implements SpeechRecognitionInterface {
   WhisperSpeechRecognition({
     SpeechRecognitionConfig? config,
     required ModelManager modelManager,
+    String? modelId,
   })  : _config = config ?? const SpeechRecognitionConfig(),
-        _modelManager = modelManager;
+        _modelManager = modelManager,
+        _requestedModelId = modelId;
 
   @override
   SpeechRecognitionConfig get config => _config;
@@ -77,7 +85,7 @@ class WhisperSpeechRecognition implements SpeechRecognitionInterface {
       }
 
       // Ensure required models are downloaded
-      final modelId = _getModelIdForPlatform();
+      final modelId = await _selectModelId();
       if (!_modelManager.loadedModels.containsKey(modelId)) {
         if (!await _modelManager.downloadModel(modelId)) {
           _lastError = 'Failed to download required Whisper model: $modelId';
@@ -99,14 +107,30 @@ class WhisperSpeechRecognition implements SpeechRecognitionInterface {
     }
   }
 
+  /// Detect the language from the first seconds of [audioData]
+  ///
+  /// Pass the start of a speech region: only the encoder and one decoder
+  /// step run, on at most [_languageProbe] of audio.
   @override
   Future<String> detectLanguage(Float32List audioData) async {
-    if (!_isInitialized) return _config.language;
+    if (!_isInitialized || _model == nullptr || audioData.isEmpty) {
+      return _config.language;
+    }
 
     try {
-      // For now, return configured language
-      // In production, this would use Whisper's language detection
-      return _config.language;
+      final probeLength =
+          math.min(audioData.length, _durationToSamples(_languageProbe));
+      final probabilities = await _worker!.detectLanguage(
+          _model, Float32List.sublistView(audioData, 0, probeLength));
+      if (probabilities == null || probabilities.isEmpty) {
+        return _config.language;
+      }
+
+      final best = probabilities.entries
+          .reduce((a, b) => a.value >= b.value ? a : b);
+      return best.value >= _minLanguageProbability
+          ? best.key
+          : _config.language;
     } catch (e) {
       return _config.language;
     }
@@ -134,7 +158,7 @@ class WhisperSpeechRecognition implements SpeechRecognitionInterface {
       // Combine all audio samples
       final combinedAudio = _combineAudioSamples(audioSamples);
 
-      if (_whisperLib == null || _whisperContext == null) {
+      if (_model == nullptr) {
         // Return empty list if Whisper is not properly initialized
         if (kDebugMode) {
           print('Whisper not initialized - cannot process audio');
@@ -142,28 +166,110 @@ class WhisperSpeechRecognition implements SpeechRecognitionInterface {
         return [];
       }
 
-      // Process with Whisper
-      final segments =
-          await _processWithWhisper(combinedAudio, sampleRate, startTime);
-
-      // Add speaker identification
-      final segmentsWithSpeakers =
-          await _addSpeakerIdentification(segments, combinedAudio);
-
-      return segmentsWithSpeakers;
+      // Process with Whisper; segments come back with speakers identified
+      return await _processWithWhisper(combinedAudio, sampleRate, startTime);
     } catch (e) {
       _lastError = 'Error processing audio batch: $e';
       return [];
     }
   }
 
+  /// Transcribe independent recordings in parallel on the loaded model
+  ///
+  /// Meant for offline catch-up over a backlog of recorded meetings: each of
+  /// [windows] is decoded on its own, concurrently with the others, and its
+  /// segments are timed from the matching entry of [startTimes] (now when
+  /// omitted). Returns one list per window, empty where decoding failed.
+  Future<List<List<SpeechSegment>>> transcribeWindows(
+    List<Float32List> windows, {
+    List<DateTime>? startTimes,
+  }) async {
+    final empty = [for (final _ in windows) <SpeechSegment>[]];
+    if (!_isInitialized || _model == nullptr || windows.isEmpty) return empty;
+
+    if (_batch == nullptr) _batch = WhisperFFI.createBatch(_model);
+    final results = await _worker!.transcribeBatch(_batch, windows,
+        language: _config.language == 'auto' ? null : _config.language);
+    if (results == null) {
+      debugPrint('Whisper batch error: transcription failed or dropped');
+      return empty;
+    }
+
+    final now = DateTime.now();
+    final segments = <List<SpeechSegment>>[];
+    for (int i = 0; i < results.length; i++) {
+      final transcription = results[i];
+      if (transcription == null) {
+        segments.add([]);
+        continue;
+      }
+      final baseTime = startTimes != null ? startTimes[i] : now;
+      final language = transcription.language ?? _config.language;
+      segments.add(await _toSpeechSegments(
+          transcription.segments, baseTime, language, windows[i]));
+    }
+    return segments;
+  }
+
   @override
-  Future<void> dispose() async {
-    if (_whisperContext != null) {
-      // In real implementation, would call whisper_free
-      _whisperContext = null;
+  SpeechSegment? get tentativeSegment => _tentativeSegment;
+
+  @override
+  Future<List<SpeechSegment>> processStream(
+    Float32List audioData, {
+    int sampleRate = 16000,
+    DateTime? timestamp,
+  }) async {
+    if (!_isInitialized || _model == nullptr || audioData.isEmpty) return [];
+
+    if (_stream == nullptr) {
+      _stream = WhisperFFI.createStream(_model,
+          language: _streamLanguage,
+          windowMs: _streamWindow.inMilliseconds);
+      if (_stream == nullptr) return [];
+      _streamStart = timestamp ?? DateTime.now();
+      _streamSamples = 0;
+      _streamAudio.clear();
     }
-    _whisperLib = null;
+
+    final baseTime = _streamStart!;
+    // Copied, as it outlives the call
+    final pushed =
+        _PushedAudio(Float32List.fromList(audioData), _streamSamples);
+    _streamAudio.add(pushed);
+    _streamSamples += audioData.length;
+    final update = await _worker!.push(_stream, audioData);
+    if (update != null && update.dropped) _forgetPush(pushed);
+    return _handleStreamUpdate(update, audioData.length, baseTime);
+  }
+
+  @override
+  Future<List<SpeechSegment>> finishStream() async {
+    if (_stream == nullptr) return [];
+
+    final stream = _stream;
+    final baseTime = _streamStart!;
+    _stream = nullptr;
+    _streamStart = null;
+
+    // Runs after the stream's queued pushes, so nothing references it after
+    final update = await _worker!.flush(stream);
+    final segments = await _handleStreamUpdate(update, 0, baseTime);
+    WhisperFFI.freeStream(stream);
+    _tentativeSegment = null;
+    _streamAudio.clear();
+    return segments;
+  }
+
+  @override
+  Future<void> dispose() async {
+    await finishStream();
+    await _worker?.dispose();
+    _worker = null;
+    WhisperFFI.freeBatch(_batch);
+    _batch = nullptr;
+    WhisperFFI.freeModel(_model);
+    _model = nullptr;
     _isInitialized = false;
   }
 
@@ -179,32 +285,36 @@ class WhisperSpeechRecognition implements SpeechRecognitionInterface {
     }
   }
 
-  /// Load platform-specific Whisper library
+  /// Language to pin live streams to, or null to have the native stream
+  /// probe each speech region's language as it starts
+  String? get _streamLanguage {
+    final probe = _config.language == 'auto' ||
+        (_config.enableLanguageDetection && _config.enableCodeSwitching);
+    return probe ? null : _config.language;
+  }
+
+  /// Load the native Whisper shim
   Future<bool> _loadWhisperLibrary() async {
-    try {
-      if (Platform.isWindows) {
-        _whisperLib = DynamicLibrary.open('whisper.dll');
-      } else if (Platform.isMacOS) {
-        _whisperLib = DynamicLibrary.open('libwhisper.dylib');
-      } else if (Platform.isLinux) {
-        _whisperLib = DynamicLibrary.open('libwhisper.so');
-      } else if (Platform.isAndroid) {
-        _whisperLib = DynamicLibrary.open('libwhisper.so');
-      } else if (Platform.isIOS) {
-        _whisperLib = DynamicLibrary.process();
-      } else {
-        return false;
-      }
+    if (!WhisperFFI.initialize() && kDebugMode) {
+      print('Failed to load Whisper library');
+      print('Using mock implementation for development');
+    }
+    // Return true to allow development with mocks
+    return true;
+  }
 
-      return _whisperLib != null;
-    } catch (e) {
-      if (kDebugMode) {
-        print('Failed to load Whisper library: $e');
-        print('Using mock implementation for development');
-      }
-      // Return true to allow development with mocks
-      return true;
+  /// Model to load: the requested one, else the device tier's
+  /// recommendation (which includes the quantization), else a per-platform
+  /// default
+  Future<String> _selectModelId() async {
+    if (_requestedModelId != null) return _requestedModelId!;
+
+    final capabilities = await DeviceCapabilityDetector.getCapabilities();
+    final recommended = capabilities.recommendedSpeechModel;
+    if (_modelManager.availableModels.containsKey(recommended)) {
+      return recommended;
     }
+    return _getModelIdForPlatform();
   }
 
   /// Get appropriate model ID for current platform
@@ -220,25 +330,20 @@ class WhisperSpeechRecognition implements SpeechRecognitionInterface {
   /// Initialize Whisper context with model
   Future<bool> _initializeWhisperContext(String modelId) async {
     try {
-      if (_whisperLib == null) {
+      if (!WhisperFFI.isAvailable) {
         // Development mode - use mock
         return true;
       }
 
       final modelInfo = _modelManager.loadedModels[modelId]!;
-      final modelPath = modelInfo.localPath!;
-
-      // Get function pointers
-      final whisperInitFromFile = _whisperLib!.lookupFunction<
-          Pointer<WhisperContext> Function(Pointer<Utf8>),
-          Pointer<WhisperContext> Function(
-              Pointer<Utf8>)>('whisper_init_from_file');
-
-      final modelPathPtr = modelPath.toNativeUtf8();
-      _whisperContext = whisperInitFromFile(modelPathPtr);
-      calloc.free(modelPathPtr);
-
-      return _whisperContext != null && _whisperContext!.address != 0;
+      // Diarization slices audio by token times, so have them aligned
+      _model = WhisperFFI.loadModel(modelInfo.localPath!,
+              alignTokens: _config.enableSpeakerDiarization) ??
+          nullptr;
+      if (_model == nullptr) return false;
+
+      _worker = WhisperWorker.create();
+      return _worker != null;
     } catch (e) {
       if (kDebugMode) {
         print('Whisper context initialization failed: $e');
@@ -271,116 +376,167 @@ class WhisperSpeechRecognition implements SpeechRecognitionInterface {
     int sampleRate,
     DateTime? startTime,
   ) async {
-    if (_whisperLib == null || _whisperContext == null) {
+    if (_model == nullptr) {
       if (kDebugMode) {
         print('Whisper not initialized - cannot process audio');
       }
       return [];
     }
 
-    try {
-      // Get Whisper function pointers
-      final whisperFull = _whisperLib!.lookupFunction<
-          Int32 Function(Pointer<WhisperContext>, Pointer<WhisperFullParams>,
-              Pointer<Float>, Int32),
-          int Function(Pointer<WhisperContext>, Pointer<WhisperFullParams>,
-              Pointer<Float>, int)>('whisper_full');
-
-      final whisperFullDefaultParams = _whisperLib!.lookupFunction<
-          Pointer<WhisperFullParams> Function(Int32),
-          Pointer<WhisperFullParams> Function(
-              int)>('whisper_full_default_params');
-
-      final whisperFullNSegments = _whisperLib!.lookupFunction<
-          Int32 Function(Pointer<WhisperContext>),
-          int Function(Pointer<WhisperContext>)>('whisper_full_n_segments');
-
-      final whisperFullGetSegmentText = _whisperLib!.lookupFunction<
-          Pointer<Utf8> Function(Pointer<WhisperContext>, Int32),
-          Pointer<Utf8> Function(
-              Pointer<WhisperContext>, int)>('whisper_full_get_segment_text');
-
-      final whisperFullGetSegmentT0 = _whisperLib!.lookupFunction<
-          Int64 Function(Pointer<WhisperContext>, Int32),
-          int Function(
-              Pointer<WhisperContext>, int)>('whisper_full_get_segment_t0');
-
-      final whisperFullGetSegmentT1 = _whisperLib!.lookupFunction<
-          Int64 Function(Pointer<WhisperContext>, Int32),
-          int Function(
-              Pointer<WhisperContext>, int)>('whisper_full_get_segment_t1');
-
-      // Set up parameters
-      final params = whisperFullDefaultParams(0); // WHISPER_SAMPLING_GREEDY
-
-      // Allocate audio data
-      final audioPtr = calloc<Float>(audioData.length);
-      for (int i = 0; i < audioData.length; i++) {
-        audioPtr[i] = audioData[i];
-      }
+    final baseTime = startTime ?? DateTime.now();
+    final transcription = await _worker!.transcribe(_model, audioData,
+        language: _config.language == 'auto' ? null : _config.language);
+    if (transcription == null) {
+      debugPrint('Whisper processing error: transcription failed or dropped');
+      return [];
+    }
 
-      // Process audio
-      final result =
-          whisperFull(_whisperContext!, params, audioPtr, audioData.length);
+    final language = transcription.language ?? _config.language;
+    return _toSpeechSegments(
+        transcription.segments, baseTime, language, audioData);
+  }
 
-      if (result != 0) {
-        calloc.free(audioPtr);
-        calloc.free(params);
-        throw Exception('Whisper processing failed with code: $result');
-      }
+  /// Convert finalized stream segments and keep the tentative one
+  ///
+  /// [pushedSamples] is the length of the push that produced [update], 0
+  /// for a flush, and is only reported when the worker dropped it.
+  /// [baseTime] is the wall-clock time of the stream's first sample, which
+  /// stream segment times are relative to.
+  Future<List<SpeechSegment>> _handleStreamUpdate(
+    WhisperStreamUpdate? update,
+    int pushedSamples,
+    DateTime baseTime,
+  ) async {
+    if (update == null) {
+      debugPrint('Whisper streaming error');
+      return [];
+    }
+    if (update.dropped) {
+      debugPrint('Whisper queue full - dropped $pushedSamples samples');
+      return [];
+    }
 
-      // Extract segments
-      final nSegments = whisperFullNSegments(_whisperContext!);
-      final segments = <SpeechSegment>[];
-      final baseTime = startTime ?? DateTime.now();
-
-      for (int i = 0; i < nSegments; i++) {
-        final textPtr = whisperFullGetSegmentText(_whisperContext!, i);
-        final text = textPtr.toDartString();
-
-        final t0 = whisperFullGetSegmentT0(_whisperContext!, i);
-        final t1 = whisperFullGetSegmentT1(_whisperContext!, i);
-
-        // Convert centiseconds to Duration
-        final startOffset = Duration(milliseconds: (t0 * 10));
-        final endOffset = Duration(milliseconds: (t1 * 10));
-
-        final speakerId = _assignSpeakerId(text);
-
-        segments.add(SpeechSegment(
-          text: text.trim(),
-          startTime: baseTime.add(startOffset),
-          endTime: baseTime.add(endOffset),
-          confidence: 0.85, // Whisper doesn't provide confidence by default
-          language: _config.language,
-          speakerId: speakerId,
-          speakerName: _getSpeakerName(speakerId),
-        ));
-      }
+    final language = update.language ?? _config.language;
+    final tentative = update.tentative;
+    _tentativeSegment = tentative != null
+        ? _toSpeechSegment(tentative, baseTime, language)
+        : null;
+
+    final committed = update.committed;
+    final start = _streamAudio.isEmpty ? 0 : _streamAudio.first.start;
+    final segments = await _toSpeechSegments(
+        committed, baseTime, language, _bufferedStreamAudio(committed),
+        audioOffset: _samplesToDuration(start));
+    _trimStreamAudio(committed.isEmpty
+        ? 0
+        : _durationToSamples(committed.last.speechEnd));
+    return segments;
+  }
 
-      calloc.free(audioPtr);
-      calloc.free(params);
-      return segments;
-    } catch (e) {
-      debugPrint('Whisper processing error: $e');
-      return [];
+  /// The buffered stream audio, back to back, when [committed] needs it
+  Float32List _bufferedStreamAudio(List<WhisperSegment> committed) {
+    if (committed.isEmpty ||
+        !_config.enableSpeakerDiarization ||
+        _streamAudio.isEmpty) {
+      return Float32List(0);
     }
+    final audio =
+        Float32List(_streamAudio.last.end - _streamAudio.first.start);
+    int offset = 0;
+    for (final pushed in _streamAudio) {
+      audio.setAll(offset, pushed.samples);
+      offset += pushed.samples.length;
+    }
+    return audio;
+  }
+
+  /// Stop buffering pushes that end before [committedEnd], or before the
+  /// oldest audio the stream's window can still hold
+  void _trimStreamAudio(int committedEnd) {
+    final keepFrom = math.max(
+        committedEnd, _streamSamples - _durationToSamples(_streamWindow));
+    while (_streamAudio.isNotEmpty && _streamAudio.first.end <= keepFrom) {
+      _streamAudio.removeAt(0);
+    }
+  }
+
+  /// Take out [pushed], which the worker dropped before the stream saw it:
+  /// stream time only counts audio it decoded, so later pushes move back
+  void _forgetPush(_PushedAudio pushed) {
+    final index = _streamAudio.indexOf(pushed);
+    if (index < 0) return;
+    _streamAudio.removeAt(index);
+    final length = pushed.samples.length;
+    for (int i = index; i < _streamAudio.length; i++) {
+      _streamAudio[i].start -= length;
+    }
+    _streamSamples -= length;
+  }
+
+  /// Convert decoded segments and identify their speakers
+  ///
+  /// [audioData] is the audio [results] were decoded from, or the part of it
+  /// starting at [audioOffset].
+  Future<List<SpeechSegment>> _toSpeechSegments(
+    List<WhisperSegment> results,
+    DateTime baseTime,
+    String language,
+    Float32List audioData, {
+    Duration audioOffset = Duration.zero,
+  }) {
+    final segments = [
+      for (final result in results)
+        _toSpeechSegment(result, baseTime, language),
+    ];
+    return _addSpeakerIdentification(
+        segments, results, audioData, audioOffset);
+  }
+
+  SpeechSegment _toSpeechSegment(
+    WhisperSegment result,
+    DateTime baseTime,
+    String language,
+  ) {
+    final speakerId = _assignSpeakerId(result.text);
+
+    return SpeechSegment(
+      text: result.text.trim(),
+      startTime: baseTime.add(result.start),
+      endTime: baseTime.add(result.end),
+      confidence: result.confidence,
+      language: language,
+      speakerId: speakerId,
+      speakerName: _getSpeakerName(speakerId),
+    );
   }
 
   /// Add speaker identification to segments
+  ///
+  /// Each of [segments] is identified from the samples of [audioData] its
+  /// decoded tokens span; segments whose speech lies outside [audioData]
+  /// keep their speaker.
   Future<List<SpeechSegment>> _addSpeakerIdentification(
     List<SpeechSegment> segments,
+    List<WhisperSegment> results,
     Float32List audioData,
+    Duration audioOffset,
   ) async {
-    if (!_config.enableSpeakerDiarization) {
+    if (!_config.enableSpeakerDiarization || audioData.isEmpty) {
       return segments;
     }
 
     final updatedSegments = <SpeechSegment>[];
 
-    for (final segment in segments) {
+    for (int i = 0; i < segments.length; i++) {
+      final segment = segments[i];
+
       // Extract audio for this segment
-      final segmentAudio = _extractSegmentAudio(audioData, segment);
+      final segmentAudio =
+          _extractSegmentAudio(audioData, results[i], audioOffset);
+      if (segmentAudio.isEmpty) {
+        updatedSegments.add(segment);
+        continue;
+      }
 
       // Get speaker embedding
       final embedding = await _computeSpeakerEmbedding(segmentAudio);
@@ -419,24 +575,28 @@ class WhisperSpeechRecognition implements SpeechRecognitionInterface {
     return null;
   }
 
-  /// Extract audio segment from full audio
+  /// Extract the samples of [audio] that [result]'s speech spans
+  ///
+  /// [audio] starts [audioOffset] into the audio [result] is timed against.
+  /// Empty when the speech falls outside [audio].
   Float32List _extractSegmentAudio(
-      Float32List fullAudio, SpeechSegment segment) {
-    // This is a simplified extraction
-    // In reality, would use precise timing
-    final duration = segment.duration.inMilliseconds;
-    final sampleRate = 16000;
-    final samplesNeeded = (duration * sampleRate) ~/ 1000;
-
-    if (samplesNeeded >= fullAudio.length) {
-      return fullAudio;
-    }
+    Float32List audio,
+    WhisperSegment result,
+    Duration audioOffset,
+  ) {
+    final startSample = _durationToSamples(result.speechStart - audioOffset)
+        .clamp(0, audio.length);
+    final endSample = _durationToSamples(result.speechEnd - audioOffset)
+        .clamp(startSample, audio.length);
+
+    return Float32List.sublistView(audio, startSample, endSample);
+  }
 
-    final startSample = 0; // Simplified - would calculate from timing
-    final endSample = (startSample + samplesNeeded).clamp(0, fullAudio.length);
+  static int _durationToSamples(Duration duration) =>
+      duration.inMicroseconds * _sampleRate ~/ Duration.microsecondsPerSecond;
 
-    return Float32List.sublistView(fullAudio, startSample, endSample);
-  }
+  static Duration _samplesToDuration(int samples) => Duration(
+      microseconds: samples * Duration.microsecondsPerSecond ~/ _sampleRate);
 
   /// Compute speaker embedding for voice identification
   Future<List<double>> _computeSpeakerEmbedding(Float32List audioData) async {
@@ -521,3 +681,14 @@ class WhisperSpeechRecognition implements SpeechRecognitionInterface {
     return sum > 0 ? math.sqrt(sum) : 0.0;
   }
 }
+
+/// Audio pushed to a live stream, and the stream time it starts at in
+/// samples
+class _PushedAudio {
+  final Float32List samples;
+  int start;
+
+  _PushedAudio(this.samples, this.start);
+
+  int get end => start + samples.length;
+}
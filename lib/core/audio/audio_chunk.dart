@@ -71,6 +71,24 @@ class AudioChunk {
     return samples;
   }
 
+  /// 16-bit PCM samples for the fixed-point DSP path
+  /// Returns a view of [data] when it is 16-bit and 2-byte aligned on a
+  /// little-endian host, otherwise a copy
+  Int16List toInt16Samples() {
+    if (bitsPerSample == 16 &&
+        Endian.host == Endian.little &&
+        data.offsetInBytes % 2 == 0) {
+      return data.buffer.asInt16List(data.offsetInBytes, data.length ~/ 2);
+    }
+
+    final samples = Int16List(sampleCount);
+    final floats = toFloat32Samples();
+    for (int i = 0; i < samples.length; i++) {
+      samples[i] = (floats[i] * 32768).round().clamp(-32768, 32767);
+    }
+    return samples;
+  }
+
   /// Convert to map for isolate communication
   Map<String, dynamic> toMap() {
     return {
@@ -0,0 +1,475 @@
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:typed_data';
+import 'package:ffi/ffi.dart';
+import 'package:flutter/foundation.dart';
+
+import 'noise_floor_estimator.dart';
+
+/// Number of bins in the native noise-floor histogram (AUDIO_DSP_NOISE_BINS)
+const int kNativeNoiseBins = 130;
+
+/// Mirror of `audio_dsp_quality_metrics` in native/audio/audio_dsp.h
+final class NativeAudioQualityMetrics extends Struct {
+  @Double()
+  external double meanAbs;
+
+  @Double()
+  external double rms;
+
+  @Double()
+  external double peak;
+
+  @Double()
+  external double zeroCrossingRate;
+
+  @Double()
+  external double spectralCentroid;
+
+  @Double()
+  external double noiseFloor;
+
+  @Int32()
+  external int clipCount;
+
+  @Int32()
+  external int sampleCount;
+}
+
+/// Mirror of `audio_vad_config` in native/audio/audio_vad.h
+final class NativeVadConfig extends Struct {
+  @Int32()
+  external int sampleRate;
+
+  @Int32()
+  external int frameSamples;
+
+  @Float()
+  external double onsetLevel;
+
+  @Float()
+  external double offsetLevel;
+
+  @Float()
+  external double onsetSnrDb;
+
+  @Float()
+  external double offsetSnrDb;
+
+  @Int32()
+  external int onsetFrames;
+
+  @Int32()
+  external int hangoverFrames;
+
+  @Int32()
+  external int minSpeechFrames;
+}
+
+/// Mirror of `audio_vad_region` in native/audio/audio_vad.h
+final class NativeVadRegion extends Struct {
+  @Int64()
+  external int startSample;
+
+  @Int64()
+  external int endSample;
+
+  @Float()
+  external double confidence;
+
+  @Float()
+  external double meanLevel;
+}
+
+/// Opaque native voice activity detector handle
+final class NativeVad extends Opaque {}
+
+/// A detected speech region in sample positions
+class VadRegion {
+  final int startSample;
+  final int endSample;
+  final double confidence;
+  final double meanLevel;
+
+  const VadRegion({
+    required this.startSample,
+    required this.endSample,
+    required this.confidence,
+    required this.meanLevel,
+  });
+}
+
+/// Single-pass statistics for a block of audio samples
+class AudioChunkStats {
+  final double meanAbs;
+  final double rms;
+  final double peak;
+  final int clipCount;
+  final double zeroCrossingRate;
+  final double spectralCentroid;
+  final int sampleCount;
+
+  const AudioChunkStats({
+    required this.meanAbs,
+    required this.rms,
+    required this.peak,
+    required this.clipCount,
+    required this.zeroCrossingRate,
+    required this.spectralCentroid,
+    required this.sampleCount,
+  });
+
+  static const AudioChunkStats empty = AudioChunkStats(
+    meanAbs: 0.0,
+    rms: 0.0,
+    peak: 0.0,
+    clipCount: 0,
+    zeroCrossingRate: 0.0,
+    spectralCentroid: 0.0,
+    sampleCount: 0,
+  );
+}
+
+typedef _ComputeQualityMetricsNative = Int32 Function(Pointer<Float>, Int32,
+    Int32, Pointer<Int32>, Pointer<NativeAudioQualityMetrics>);
+typedef _ComputeQualityMetricsDart = int Function(Pointer<Float>, int, int,
+    Pointer<Int32>, Pointer<NativeAudioQualityMetrics>);
+
+typedef _ComputeQualityMetricsS16Native = Int32 Function(Pointer<Int16>,
+    Int32, Int32, Pointer<Int32>, Pointer<NativeAudioQualityMetrics>);
+typedef _ComputeQualityMetricsS16Dart = int Function(Pointer<Int16>, int, int,
+    Pointer<Int32>, Pointer<NativeAudioQualityMetrics>);
+typedef _Pcm16ToFloatNative = Int32 Function(
+    Pointer<Int16>, Int32, Float, Pointer<Float>);
+typedef _Pcm16ToFloatDart = int Function(
+    Pointer<Int16>, int, double, Pointer<Float>);
+
+typedef _VadCreateNative = Pointer<NativeVad> Function(
+    Pointer<NativeVadConfig>);
+typedef _VadCreateDart = Pointer<NativeVad> Function(Pointer<NativeVadConfig>);
+typedef _VadHandleNative = Void Function(Pointer<NativeVad>);
+typedef _VadHandleDart = void Function(Pointer<NativeVad>);
+typedef _VadProcessNative = Int32 Function(
+    Pointer<NativeVad>, Pointer<Float>, Int32, Pointer<NativeVadRegion>, Int32);
+typedef _VadProcessDart = int Function(
+    Pointer<NativeVad>, Pointer<Float>, int, Pointer<NativeVadRegion>, int);
+typedef _VadProcessS16Native = Int32 Function(
+    Pointer<NativeVad>, Pointer<Int16>, Int32, Pointer<NativeVadRegion>, Int32);
+typedef _VadProcessS16Dart = int Function(
+    Pointer<NativeVad>, Pointer<Int16>, int, Pointer<NativeVadRegion>, int);
+typedef _VadFlushNative = Int32 Function(
+    Pointer<NativeVad>, Pointer<NativeVadRegion>, Int32);
+typedef _VadFlushDart = int Function(
+    Pointer<NativeVad>, Pointer<NativeVadRegion>, int);
+typedef _VadOpenRegionNative = Int32 Function(
+    Pointer<NativeVad>, Pointer<NativeVadRegion>);
+typedef _VadOpenRegionDart = int Function(
+    Pointer<NativeVad>, Pointer<NativeVadRegion>);
+
+/// FFI bindings for the native audio analysis kernels (libmeeting_native)
+class AudioDspFFI {
+  static DynamicLibrary? _library;
+  static bool _initialized = false;
+  static bool _initializationAttempted = false;
+
+  static _ComputeQualityMetricsDart? _computeQualityMetrics;
+  static _ComputeQualityMetricsS16Dart? _computeQualityMetricsS16;
+  static _Pcm16ToFloatDart? _pcm16ToFloat;
+  static _VadCreateDart? _vadCreate;
+  static _VadHandleDart? _vadFree;
+  static _VadHandleDart? _vadReset;
+  static _VadProcessDart? _vadProcess;
+  static _VadProcessS16Dart? _vadProcessS16;
+  static _VadFlushDart? _vadFlush;
+  static _VadOpenRegionDart? _vadOpenRegion;
+
+  // Native scratch buffers reused across calls
+  static Pointer<Float> _samples = nullptr;
+  static int _samplesCapacity = 0;
+  static Pointer<Int16> _pcm = nullptr;
+  static int _pcmCapacity = 0;
+  static Pointer<Int32> _histogram = nullptr;
+  static Pointer<NativeAudioQualityMetrics> _metrics = nullptr;
+  static Pointer<NativeVadConfig> _vadConfig = nullptr;
+  static Pointer<NativeVadRegion> _vadRegions = nullptr;
+  static const int _vadRegionCapacity = 16;
+
+  /// Whether the native kernels are loaded
+  static bool get isAvailable => _initialized;
+
+  /// Initialize the audio DSP FFI library
+  static bool initialize() {
+    if (_initialized) return true;
+    if (_initializationAttempted) return false;
+    _initializationAttempted = true;
+
+    try {
+      _library = _openLibrary();
+      if (_library == null) return false;
+
+      _computeQualityMetrics = _library!.lookupFunction<
+          _ComputeQualityMetricsNative,
+          _ComputeQualityMetricsDart>('audio_dsp_compute_quality_metrics',
+          isLeaf: true);
+      _computeQualityMetricsS16 = _library!.lookupFunction<
+              _ComputeQualityMetricsS16Native, _ComputeQualityMetricsS16Dart>(
+          'audio_dsp_compute_quality_metrics_s16',
+          isLeaf: true);
+      _pcm16ToFloat =
+          _library!.lookupFunction<_Pcm16ToFloatNative, _Pcm16ToFloatDart>(
+              'audio_dsp_pcm16_to_float',
+              isLeaf: true);
+      _vadCreate = _library!.lookupFunction<_VadCreateNative, _VadCreateDart>(
+          'audio_vad_create',
+          isLeaf: true);
+      _vadFree = _library!.lookupFunction<_VadHandleNative, _VadHandleDart>(
+          'audio_vad_free',
+          isLeaf: true);
+      _vadReset = _library!.lookupFunction<_VadHandleNative, _VadHandleDart>(
+          'audio_vad_reset',
+          isLeaf: true);
+      _vadProcess = _library!.lookupFunction<_VadProcessNative,
+          _VadProcessDart>('audio_vad_process', isLeaf: true);
+      _vadProcessS16 = _library!.lookupFunction<_VadProcessS16Native,
+          _VadProcessS16Dart>('audio_vad_process_s16', isLeaf: true);
+      _vadFlush = _library!.lookupFunction<_VadFlushNative, _VadFlushDart>(
+          'audio_vad_flush',
+          isLeaf: true);
+      _vadOpenRegion = _library!.lookupFunction<_VadOpenRegionNative,
+          _VadOpenRegionDart>('audio_vad_open_region', isLeaf: true);
+
+      _histogram = calloc<Int32>(kNativeNoiseBins);
+      _metrics = calloc<NativeAudioQualityMetrics>();
+      _vadConfig = calloc<NativeVadConfig>();
+      _vadRegions = calloc<NativeVadRegion>(_vadRegionCapacity);
+
+      _initialized = true;
+      debugPrint('Audio DSP FFI initialized successfully');
+      return true;
+    } catch (e) {
+      debugPrint('Audio DSP native library not found - using Dart kernels');
+      return false;
+    }
+  }
+
+  /// Compute quality statistics for [audio] in one native pass
+  ///
+  /// The chunk's amplitude histogram is merged into [noiseFloor]. Returns
+  /// null when the native library is unavailable so callers can fall back.
+  static AudioChunkStats? computeQualityMetrics(
+    Float32List audio, {
+    required int sampleRate,
+    NoiseFloorEstimator? noiseFloor,
+  }) {
+    if (!_initialized || _computeQualityMetrics == null) return null;
+    if (audio.isEmpty) return AudioChunkStats.empty;
+
+    final samples = _ensureSampleCapacity(audio.length);
+    samples.asTypedList(audio.length).setAll(0, audio);
+
+    final result = _computeQualityMetrics!(
+      samples,
+      audio.length,
+      sampleRate,
+      noiseFloor != null ? _histogram : nullptr,
+      _metrics,
+    );
+    return _readMetrics(result, noiseFloor);
+  }
+
+  /// Fixed-point variant of [computeQualityMetrics] for 16-bit PCM
+  static AudioChunkStats? computeQualityMetricsPcm16(
+    Int16List pcm, {
+    required int sampleRate,
+    NoiseFloorEstimator? noiseFloor,
+  }) {
+    if (!_initialized || _computeQualityMetricsS16 == null) return null;
+    if (pcm.isEmpty) return AudioChunkStats.empty;
+
+    final samples = _ensurePcmCapacity(pcm.length);
+    samples.asTypedList(pcm.length).setAll(0, pcm);
+
+    final result = _computeQualityMetricsS16!(
+      samples,
+      pcm.length,
+      sampleRate,
+      noiseFloor != null ? _histogram : nullptr,
+      _metrics,
+    );
+    return _readMetrics(result, noiseFloor);
+  }
+
+  /// Convert 16-bit PCM to float scaled by [gain], clamped to [-1, 1]
+  ///
+  /// Returns null when the native library is unavailable.
+  static Float32List? pcm16ToFloat(Int16List pcm, {double gain = 1.0}) {
+    if (!_initialized || _pcm16ToFloat == null) return null;
+    if (pcm.isEmpty) return Float32List(0);
+
+    final samples = _ensurePcmCapacity(pcm.length);
+    samples.asTypedList(pcm.length).setAll(0, pcm);
+    final out = _ensureSampleCapacity(pcm.length);
+
+    if (_pcm16ToFloat!(samples, pcm.length, gain, out) != 0) return null;
+    return Float32List.fromList(out.asTypedList(pcm.length));
+  }
+
+  static AudioChunkStats? _readMetrics(
+      int result, NoiseFloorEstimator? noiseFloor) {
+    if (result != 0) return null;
+
+    if (noiseFloor != null) {
+      noiseFloor.addHistogram(_histogram.asTypedList(kNativeNoiseBins));
+    }
+
+    final metrics = _metrics.ref;
+    return AudioChunkStats(
+      meanAbs: metrics.meanAbs,
+      rms: metrics.rms,
+      peak: metrics.peak,
+      clipCount: metrics.clipCount,
+      zeroCrossingRate: metrics.zeroCrossingRate,
+      spectralCentroid: metrics.spectralCentroid,
+      sampleCount: metrics.sampleCount,
+    );
+  }
+
+  /// Create a native voice activity detector, or nullptr when unavailable
+  static Pointer<NativeVad> createVad({
+    required int sampleRate,
+    required int frameSamples,
+    required double onsetLevel,
+    required double offsetLevel,
+    required double onsetSnrDb,
+    required double offsetSnrDb,
+    required int onsetFrames,
+    required int hangoverFrames,
+    required int minSpeechFrames,
+  }) {
+    if (!_initialized || _vadCreate == null) return nullptr;
+
+    _vadConfig.ref
+      ..sampleRate = sampleRate
+      ..frameSamples = frameSamples
+      ..onsetLevel = onsetLevel
+      ..offsetLevel = offsetLevel
+      ..onsetSnrDb = onsetSnrDb
+      ..offsetSnrDb = offsetSnrDb
+      ..onsetFrames = onsetFrames
+      ..hangoverFrames = hangoverFrames
+      ..minSpeechFrames = minSpeechFrames;
+    return _vadCreate!(_vadConfig);
+  }
+
+  static void freeVad(Pointer<NativeVad> vad) {
+    if (vad != nullptr) _vadFree?.call(vad);
+  }
+
+  static void resetVad(Pointer<NativeVad> vad) {
+    if (vad != nullptr) _vadReset?.call(vad);
+  }
+
+  /// Feed [audio] to [vad] and return the regions it completed
+  static List<VadRegion> processVad(
+      Pointer<NativeVad> vad, Float32List audio) {
+    if (audio.isEmpty) return const [];
+
+    final samples = _ensureSampleCapacity(audio.length);
+    samples.asTypedList(audio.length).setAll(0, audio);
+
+    final regions = <VadRegion>[];
+    var count = _vadProcess!(
+        vad, samples, audio.length, _vadRegions, _vadRegionCapacity);
+    while (count > 0) {
+      _readVadRegions(count, regions);
+      if (count < _vadRegionCapacity) break;
+      // More regions queued than fit; drain without feeding samples
+      count = _vadProcess!(vad, nullptr, 0, _vadRegions, _vadRegionCapacity);
+    }
+    return regions;
+  }
+
+  /// Feed 16-bit PCM to [vad] and return the regions it completed
+  static List<VadRegion> processVadPcm16(
+      Pointer<NativeVad> vad, Int16List pcm) {
+    if (pcm.isEmpty) return const [];
+
+    final samples = _ensurePcmCapacity(pcm.length);
+    samples.asTypedList(pcm.length).setAll(0, pcm);
+
+    final regions = <VadRegion>[];
+    var count = _vadProcessS16!(
+        vad, samples, pcm.length, _vadRegions, _vadRegionCapacity);
+    while (count > 0) {
+      _readVadRegions(count, regions);
+      if (count < _vadRegionCapacity) break;
+      count = _vadProcess!(vad, nullptr, 0, _vadRegions, _vadRegionCapacity);
+    }
+    return regions;
+  }
+
+  /// Close any open region in [vad] and return the remaining regions
+  static List<VadRegion> flushVad(Pointer<NativeVad> vad) {
+    final regions = <VadRegion>[];
+    var count = _vadFlush!(vad, _vadRegions, _vadRegionCapacity);
+    while (count > 0) {
+      _readVadRegions(count, regions);
+      if (count < _vadRegionCapacity) break;
+      count = _vadFlush!(vad, _vadRegions, _vadRegionCapacity);
+    }
+    return regions;
+  }
+
+  /// The region [vad] currently has open, if any
+  static VadRegion? openVadRegion(Pointer<NativeVad> vad) {
+    if (_vadOpenRegion!(vad, _vadRegions) == 0) return null;
+    return _toVadRegion(_vadRegions.ref);
+  }
+
+  static void _readVadRegions(int count, List<VadRegion> out) {
+    for (int i = 0; i < count; i++) {
+      out.add(_toVadRegion(_vadRegions[i]));
+    }
+  }
+
+  static VadRegion _toVadRegion(NativeVadRegion region) {
+    return VadRegion(
+      startSample: region.startSample,
+      endSample: region.endSample,
+      confidence: region.confidence,
+      meanLevel: region.meanLevel,
+    );
+  }
+
+  static Pointer<Float> _ensureSampleCapacity(int count) {
+    if (count > _samplesCapacity) {
+      if (_samples != nullptr) calloc.free(_samples);
+      _samplesCapacity = count;
+      _samples = calloc<Float>(_samplesCapacity);
+    }
+    return _samples;
+  }
+
+  static Pointer<Int16> _ensurePcmCapacity(int count) {
+    if (count > _pcmCapacity) {
+      if (_pcm != nullptr) calloc.free(_pcm);
+      _pcmCapacity = count;
+      _pcm = calloc<Int16>(_pcmCapacity);
+    }
+    return _pcm;
+  }
+
+  static DynamicLibrary? _openLibrary() {
+    if (Platform.isWindows) {
+      return DynamicLibrary.open('meeting_native.dll');
+    } else if (Platform.isMacOS) {
+      return DynamicLibrary.open('libmeeting_native.dylib');
+    } else if (Platform.isLinux || Platform.isAndroid) {
+      return DynamicLibrary.open('libmeeting_native.so');
+    } else if (Platform.isIOS) {
+      return DynamicLibrary.process();
+    }
+    debugPrint('Unsupported platform for audio DSP FFI');
+    return null;
+  }
+}
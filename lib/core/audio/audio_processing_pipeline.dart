@@ -2,8 +2,13 @@ import 'dart:async';
 import 'dart:typed_data';
 import 'dart:math' as math;
 import 'package:flutter/foundation.dart';
+import '../ai/device_capability_detector.dart';
 import 'audio_chunk.dart';
+import 'audio_dsp_ffi.dart';
+import 'audio_ring_buffer.dart';
 import 'audio_visualizer.dart';
+import 'noise_floor_estimator.dart';
+import 'speech_activity_detector.dart';
 
 /// Advanced audio processing pipeline with sliding window analysis
 /// Handles real-time audio segmentation, buffering, and preprocessing
@@ -14,17 +19,24 @@ class AudioProcessingPipeline extends ChangeNotifier {
       Duration(seconds: 10); // 10-second overlap
   static const Duration _windowSize =
       Duration(seconds: 5); // 5-second analysis windows
+  // Segment + overlap, plus headroom for timer jitter and audio arriving
+  // while a segment view is being processed
+  static const Duration _bufferDuration = Duration(seconds: 90);
   static const int _sampleRate = 16000;
   static const int _channels = 1;
 
-  // Audio buffers and segments
-  final List<AudioChunk> _rawBuffer = [];
+  static final int _bufferSamples =
+      (_bufferDuration.inMilliseconds * _sampleRate / 1000).round();
+
+  // Audio buffers and segments; the buffer holds 16-bit PCM in fixed-point
+  // mode and float samples otherwise (allocated lazily once the mode is known)
+  late SampleRingBuffer _buffer = AudioRingBuffer(_bufferSamples);
   final List<AudioSegment> _processedSegments = [];
-  final List<AudioChunk> _currentWindow = [];
 
   // Processing state
   bool _isProcessing = false;
   bool _isInitialized = false;
+  bool _useFixedPointDsp = false;
   int _segmentCounter = 0;
   DateTime? _processingStartTime;
 
@@ -40,6 +52,11 @@ class AudioProcessingPipeline extends ChangeNotifier {
   final AudioAnalyzer _analyzer = AudioAnalyzer();
   Timer? _processingTimer;
 
+  // Incremental speech detection over the whole stream; region positions are
+  // absolute sample offsets since processing started
+  SpeechActivityDetector? _speechDetector;
+  final List<VadRegion> _speechActivity = [];
+
   // Configuration
   final AudioProcessingConfig _config;
 
@@ -49,6 +66,7 @@ class AudioProcessingPipeline extends ChangeNotifier {
   // Getters
   bool get isProcessing => _isProcessing;
   bool get isInitialized => _isInitialized;
+  bool get usesFixedPointDsp => _useFixedPointDsp;
   List<AudioSegment> get processedSegments =>
       List.unmodifiable(_processedSegments);
   Stream<AudioSegment> get segmentStream => _segmentController.stream;
@@ -56,12 +74,20 @@ class AudioProcessingPipeline extends ChangeNotifier {
       _visualizerController.stream;
   Stream<AudioQualityMetrics> get qualityStream => _qualityController.stream;
 
+  /// The most recent analysis window, as a view into the pipeline buffer
+  Float32List get currentWindow => _bufferedAudio(
+      (_windowSize.inMilliseconds * _sampleRate / 1000).round());
+
   /// Initialize the audio processing pipeline
   Future<bool> initialize() async {
     if (_isInitialized) return true;
 
     try {
       await _analyzer.initialize();
+      _useFixedPointDsp = await _selectFixedPointDsp();
+      if (_useFixedPointDsp) _buffer = Pcm16RingBuffer(_bufferSamples);
+      _speechDetector =
+          _analyzer.createSpeechDetector(_config.speechThreshold);
       _setupProcessingTimer();
       _isInitialized = true;
       notifyListeners();
@@ -93,8 +119,9 @@ class AudioProcessingPipeline extends ChangeNotifier {
     _isProcessing = false;
     _processingTimer?.cancel();
 
-    // Process any remaining audio in buffer
-    if (_rawBuffer.isNotEmpty) {
+    // Close any open speech region and process remaining audio in buffer
+    _speechActivity.addAll(_speechDetector?.flush() ?? const []);
+    if (_buffer.isNotEmpty) {
       await _processCurrentBuffer();
     }
 
@@ -112,23 +139,34 @@ class AudioProcessingPipeline extends ChangeNotifier {
       return;
     }
 
-    // Add to raw buffer
-    _rawBuffer.add(chunk);
-    _currentWindow.add(chunk);
-
-    // Update visualizer with real-time data
-    _updateVisualizer(chunk);
+    // Fixed-point mode keeps the captured PCM as-is; otherwise convert once
+    // and share the samples between all analysis stages
+    final AudioQualityMetrics metrics;
+    final List<VadRegion> regions;
+    if (_useFixedPointDsp) {
+      final pcm = chunk.toInt16Samples();
+      _buffer.append(pcm);
+      metrics = _analyzer.calculateQualityMetricsPcm16(pcm);
+      regions = _speechDetector?.addPcm16(pcm) ?? const [];
+    } else {
+      final samples = chunk.toFloat32Samples();
+      _buffer.append(samples);
+      metrics = _analyzer.calculateQualityMetrics(samples);
+      regions = _speechDetector?.addSamples(samples) ?? const [];
+    }
 
-    // Analyze audio quality
-    _analyzeAudioQuality(chunk);
+    // Analyze audio quality and update visualizer with real-time data
+    _qualityController.add(metrics);
+    _visualizerController
+        .add(_analyzer.visualizerDataForLevel(metrics.averageVolume));
 
-    // Trim window if too large
-    _trimCurrentWindow();
+    // Completed speech regions are kept until segmented
+    _speechActivity.addAll(regions);
   }
 
   /// Force processing of current buffer (for manual triggers)
   Future<AudioSegment?> processCurrentBuffer() async {
-    if (!_isProcessing || _rawBuffer.isEmpty) return null;
+    if (!_isProcessing || _buffer.isEmpty) return null;
 
     return await _processCurrentBuffer();
   }
@@ -144,7 +182,7 @@ class AudioProcessingPipeline extends ChangeNotifier {
   }
 
   Future<AudioSegment?> _processCurrentBuffer() async {
-    if (_rawBuffer.isEmpty) return null;
+    if (_buffer.isEmpty) return null;
 
     try {
       // Create segment from current buffer
@@ -171,20 +209,25 @@ class AudioProcessingPipeline extends ChangeNotifier {
     final startTime = _processingStartTime ?? DateTime.now();
     final endTime = DateTime.now();
 
-    // Combine all audio chunks into a single buffer
-    final combinedAudio = _combineAudioChunks(_rawBuffer);
+    // Zero-copy view of the buffered audio (converted once in fixed-point
+    // mode); positions are captured before any await so chunks arriving
+    // meanwhile don't shift them
+    final fixedPoint = _buffer is Pcm16RingBuffer;
+    final combinedAudio = _bufferedAudio();
+
+    // Speech regions were detected incrementally as chunks arrived
+    final speechRegions = _collectSpeechRegions(
+      _buffer.startPosition,
+      _buffer.endPosition,
+    );
 
     // Analyze audio properties
     final analysis = await _analyzer.analyzeSegment(combinedAudio);
 
-    // Detect speech regions
-    final speechRegions = await _analyzer.detectSpeechRegions(
-      combinedAudio,
-      _config.speechThreshold,
-    );
-
-    // Apply audio preprocessing
-    final processedAudio = await _preprocessAudio(combinedAudio);
+    // Apply audio preprocessing; the converted copy is ours to scale
+    final processedAudio = fixedPoint
+        ? _analyzer.normalizeInPlace(combinedAudio, analysis.peakVolume)
+        : await _preprocessAudio(combinedAudio);
 
     return AudioSegment(
       id: segmentId,
@@ -200,24 +243,52 @@ class AudioProcessingPipeline extends ChangeNotifier {
     );
   }
 
-  Float32List _combineAudioChunks(List<AudioChunk> chunks) {
-    if (chunks.isEmpty) return Float32List(0);
+  /// Speech regions overlapping stream samples [start, end), relative to start
+  List<SpeechRegion> _collectSpeechRegions(int start, int end) {
+    // Regions ending before this buffer can no longer be part of any segment
+    _speechActivity.removeWhere((region) => region.endSample <= start);
 
-    final totalSamples = chunks.fold<int>(
-      0,
-      (sum, chunk) => sum + chunk.sampleCount,
-    );
+    final openRegion = _speechDetector?.openRegion;
+    final candidates = [
+      ..._speechActivity,
+      if (openRegion != null)
+        VadRegion(
+          startSample: openRegion.startSample,
+          endSample: end,
+          confidence: openRegion.confidence,
+          meanLevel: openRegion.meanLevel,
+        ),
+    ];
 
-    final combined = Float32List(totalSamples);
-    int offset = 0;
+    final regions = <SpeechRegion>[];
+    for (final region in candidates) {
+      if (region.startSample >= end) continue;
+      regions.add(AudioAnalyzer.toSpeechRegion(
+        region,
+        offsetSamples: start,
+        maxSamples: end - start,
+      ));
+    }
+    return regions;
+  }
 
-    for (final chunk in chunks) {
-      final chunkSamples = chunk.toFloat32Samples();
-      combined.setRange(offset, offset + chunkSamples.length, chunkSamples);
-      offset += chunkSamples.length;
+  /// Buffered audio (newest [count] samples) as float
+  Float32List _bufferedAudio([int? count]) {
+    final buffer = _buffer;
+    if (buffer is Pcm16RingBuffer) {
+      return _analyzer.pcm16ToFloat(buffer.view(count));
     }
+    return (buffer as AudioRingBuffer).view(count);
+  }
+
+  /// Fixed-point kernels halve memory traffic for low-tier devices; they need
+  /// the native library, and [AudioProcessingConfig.fixedPointDsp] overrides
+  Future<bool> _selectFixedPointDsp() async {
+    if (!AudioDspFFI.isAvailable) return false;
+    if (_config.fixedPointDsp != null) return _config.fixedPointDsp!;
 
-    return combined;
+    final capabilities = await DeviceCapabilityDetector.getCapabilities();
+    return capabilities.performanceTier == DevicePerformanceTier.low;
   }
 
   Future<Float32List> _preprocessAudio(Float32List audio) async {
@@ -239,47 +310,10 @@ class AudioProcessingPipeline extends ChangeNotifier {
   }
 
   void _implementSlidingWindow() {
-    if (_rawBuffer.isEmpty) return;
-
-    // Calculate how much audio to keep for overlap
+    // Keep only the last overlap duration worth of audio
     final overlapSamples =
         (_overlapDuration.inMilliseconds * _sampleRate / 1000).round();
-    final totalSamples =
-        _rawBuffer.fold<int>(0, (sum, chunk) => sum + chunk.sampleCount);
-
-    if (totalSamples <= overlapSamples) {
-      // Keep all if less than overlap duration
-      return;
-    }
-
-    // Keep only the last overlap duration worth of audio
-    final newBuffer = <AudioChunk>[];
-    int samplesKept = 0;
-
-    for (int i = _rawBuffer.length - 1; i >= 0; i--) {
-      final chunk = _rawBuffer[i];
-      newBuffer.insert(0, chunk);
-      samplesKept += chunk.sampleCount;
-
-      if (samplesKept >= overlapSamples) {
-        break;
-      }
-    }
-
-    _rawBuffer.clear();
-    _rawBuffer.addAll(newBuffer);
-  }
-
-  void _updateVisualizer(AudioChunk chunk) {
-    final float32Data = chunk.toFloat32Samples();
-    final data = _analyzer.calculateVisualizerData(float32Data);
-    _visualizerController.add(data);
-  }
-
-  void _analyzeAudioQuality(AudioChunk chunk) {
-    final float32Data = chunk.toFloat32Samples();
-    final metrics = _analyzer.calculateQualityMetrics(float32Data);
-    _qualityController.add(metrics);
+    _buffer.retainLast(overlapSamples);
   }
 
   bool _isValidAudioChunk(AudioChunk chunk) {
@@ -288,17 +322,6 @@ class AudioProcessingPipeline extends ChangeNotifier {
         chunk.data.isNotEmpty;
   }
 
-  void _trimCurrentWindow() {
-    final maxWindowSamples =
-        (_windowSize.inMilliseconds * _sampleRate / 1000).round();
-    final currentSamples =
-        _currentWindow.fold<int>(0, (sum, chunk) => sum + chunk.sampleCount);
-
-    while (currentSamples > maxWindowSamples && _currentWindow.isNotEmpty) {
-      _currentWindow.removeAt(0);
-    }
-  }
-
   void _trimProcessedSegments() {
     // Keep only last 10 segments in memory
     while (_processedSegments.length > 10) {
@@ -307,8 +330,9 @@ class AudioProcessingPipeline extends ChangeNotifier {
   }
 
   void _clearBuffers() {
-    _rawBuffer.clear();
-    _currentWindow.clear();
+    _buffer.clear();
+    _speechActivity.clear();
+    _speechDetector?.reset();
     _segmentCounter = 0;
     _processingStartTime = null;
   }
@@ -319,6 +343,7 @@ class AudioProcessingPipeline extends ChangeNotifier {
     _segmentController.close();
     _visualizerController.close();
     _qualityController.close();
+    _speechDetector?.dispose();
     _analyzer.dispose();
     super.dispose();
   }
@@ -332,12 +357,17 @@ class AudioProcessingConfig {
   final bool enableQualityAnalysis;
   final int maxSegmentsInMemory;
 
+  /// Use the int16 fixed-point DSP kernels; null selects them automatically
+  /// on low-tier devices when the native library is available
+  final bool? fixedPointDsp;
+
   const AudioProcessingConfig({
     this.speechThreshold = 0.1,
     this.noiseReductionLevel = 0.3,
     this.enablePreprocessing = true,
     this.enableQualityAnalysis = true,
     this.maxSegmentsInMemory = 10,
+    this.fixedPointDsp,
   });
 }
 
@@ -378,8 +408,8 @@ class AudioSegment {
           (region.endTime.inMilliseconds * sampleRate / 1000).round();
 
       if (startSample < audioData.length && endSample <= audioData.length) {
-        final regionAudio = audioData.sublist(startSample, endSample);
-        speechAudio.add(Float32List.fromList(regionAudio));
+        speechAudio.add(
+            Float32List.sublistView(audioData, startSample, endSample));
       }
     }
 
@@ -428,6 +458,8 @@ class AudioQualityMetrics {
   final bool isClipping;
   final bool isSilent;
   final DateTime timestamp;
+  final double rms;
+  final int clipCount;
 
   const AudioQualityMetrics({
     required this.signalToNoiseRatio,
@@ -438,6 +470,8 @@ class AudioQualityMetrics {
     required this.isClipping,
     required this.isSilent,
     required this.timestamp,
+    this.rms = 0.0,
+    this.clipCount = 0,
   });
 
   /// Overall quality score (0.0 to 1.0)
@@ -491,18 +525,28 @@ class AudioAnalysisResult {
 class AudioAnalyzer {
   bool _isInitialized = false;
 
+  // Scratch histogram for one-shot segment estimates
+  final NoiseFloorEstimator _segmentNoiseFloor = NoiseFloorEstimator();
+
+  // Rolling noise floor over the last ~30 seconds of chunks, used for SNR
+  final NoiseFloorEstimator _streamNoiseFloor =
+      NoiseFloorEstimator(maxSamples: 30 * 16000);
+
   Future<void> initialize() async {
-    // Initialize any native audio analysis libraries here
+    // Native kernels are optional; Dart fallbacks are used without them
+    AudioDspFFI.initialize();
     _isInitialized = true;
   }
 
   Future<AudioAnalysisResult> analyzeSegment(Float32List audio) async {
     if (!_isInitialized) throw StateError('AudioAnalyzer not initialized');
 
-    // Calculate basic audio statistics
-    final avgVolume = _calculateAverageVolume(audio);
-    final peakVolume = _calculatePeakVolume(audio);
-    final noiseLevel = _estimateNoiseLevel(audio);
+    // Calculate basic audio statistics in a single pass
+    _segmentNoiseFloor.reset();
+    final stats = _computeStats(audio, _segmentNoiseFloor);
+    final avgVolume = stats.meanAbs;
+    final peakVolume = stats.peak;
+    final noiseLevel = _segmentNoiseFloor.noiseFloor;
     final fundamentalFreq = await _estimateFundamentalFrequency(audio);
     final spectralFeatures = await _extractSpectralFeatures(audio);
     final hasSpeech = avgVolume > 0.01; // Simple speech detection
@@ -529,49 +573,44 @@ class AudioAnalyzer {
     Float32List audio,
     double threshold,
   ) async {
-    final regions = <SpeechRegion>[];
-    const windowSize = 1600; // 100ms at 16kHz
-    const stepSize = 800; // 50ms step
-
-    bool inSpeech = false;
-    int speechStart = 0;
-
-    for (int i = 0; i < audio.length - windowSize; i += stepSize) {
-      final window = audio.sublist(i, i + windowSize);
-      final energy = _calculateAverageVolume(window);
-
-      if (!inSpeech && energy > threshold) {
-        // Speech started
-        inSpeech = true;
-        speechStart = i;
-      } else if (inSpeech && energy <= threshold) {
-        // Speech ended
-        inSpeech = false;
-        final speechEnd = i;
-
-        if (speechEnd > speechStart) {
-          regions.add(SpeechRegion(
-            startTime:
-                Duration(milliseconds: (speechStart * 1000 / 16000).round()),
-            endTime: Duration(milliseconds: (speechEnd * 1000 / 16000).round()),
-            confidence: 0.8, // Simplified confidence
-            averageVolume: energy,
-          ));
-        }
-      }
+    final detector = createSpeechDetector(threshold);
+    try {
+      final regions = [
+        ...detector.addSamples(audio),
+        ...detector.flush(),
+      ];
+      return regions.map(toSpeechRegion).toList();
+    } finally {
+      detector.dispose();
     }
+  }
 
-    // Handle case where speech continues to the end
-    if (inSpeech) {
-      regions.add(SpeechRegion(
-        startTime: Duration(milliseconds: (speechStart * 1000 / 16000).round()),
-        endTime: Duration(milliseconds: (audio.length * 1000 / 16000).round()),
-        confidence: 0.8,
-        averageVolume: threshold,
-      ));
-    }
+  /// Frame VAD whose onset level is [threshold] (mean absolute amplitude)
+  SpeechActivityDetector createSpeechDetector(double threshold) {
+    return SpeechActivityDetector(
+      sampleRate: 16000,
+      onsetLevel: threshold,
+      offsetLevel: threshold * 0.6,
+    );
+  }
 
-    return regions;
+  /// Convert a sample-domain region to a [SpeechRegion], optionally shifted
+  /// by [offsetSamples] and clipped to [0, maxSamples)
+  static SpeechRegion toSpeechRegion(
+    VadRegion region, {
+    int offsetSamples = 0,
+    int? maxSamples,
+  }) {
+    final start = math.max(0, region.startSample - offsetSamples);
+    var end = region.endSample - offsetSamples;
+    if (maxSamples != null) end = math.min(end, maxSamples);
+
+    return SpeechRegion(
+      startTime: Duration(microseconds: start * 1000000 ~/ 16000),
+      endTime: Duration(microseconds: end * 1000000 ~/ 16000),
+      confidence: region.confidence,
+      averageVolume: region.meanLevel,
+    );
   }
 
   Future<Float32List> reduceNoise(Float32List audio, double level) async {
@@ -612,8 +651,11 @@ class AudioAnalyzer {
   }
 
   AudioVisualizerData calculateVisualizerData(Float32List audio) {
-    final volume = _calculateAverageVolume(audio);
+    return visualizerDataForLevel(_calculateAverageVolume(audio));
+  }
 
+  /// Visualizer data from an already computed mean absolute level
+  AudioVisualizerData visualizerDataForLevel(double volume) {
     // Calculate frequency bins for visualization
     final bins = List<double>.filled(32, 0.0);
     // Simplified frequency analysis
@@ -631,20 +673,64 @@ class AudioAnalyzer {
   }
 
   AudioQualityMetrics calculateQualityMetrics(Float32List audio) {
-    final avgVolume = _calculateAverageVolume(audio);
-    final peakVolume = _calculatePeakVolume(audio);
-    final snr = _calculateSNR(audio);
-    final zcr = _calculateZeroCrossingRate(audio);
+    // One fused pass; the chunk histogram updates the rolling noise floor
+    return _qualityMetricsFromStats(_computeStats(audio, _streamNoiseFloor));
+  }
+
+  /// Fixed-point variant of [calculateQualityMetrics] for 16-bit PCM
+  AudioQualityMetrics calculateQualityMetricsPcm16(Int16List pcm) {
+    final stats = AudioDspFFI.computeQualityMetricsPcm16(
+          pcm,
+          sampleRate: 16000,
+          noiseFloor: _streamNoiseFloor,
+        ) ??
+        _computeStatsDart(pcm16ToFloat(pcm), _streamNoiseFloor);
+    return _qualityMetricsFromStats(stats);
+  }
+
+  /// Convert 16-bit PCM to float samples scaled by [gain]
+  Float32List pcm16ToFloat(Int16List pcm, {double gain = 1.0}) {
+    final native = AudioDspFFI.pcm16ToFloat(pcm, gain: gain);
+    if (native != null) return native;
+
+    final scale = gain / 32768;
+    final samples = Float32List(pcm.length);
+    for (int i = 0; i < pcm.length; i++) {
+      samples[i] = (pcm[i] * scale).clamp(-1.0, 1.0);
+    }
+    return samples;
+  }
+
+  /// Fixed-point equivalent of [reduceNoise] followed by [normalizeAudio]
+  ///
+  /// The noise reduction is a uniform gain that normalization cancels, so the
+  /// whole chain is one scaling of [audio], whose [peak] is already known, to
+  /// the target peak. Scales [audio] in place and returns it.
+  Float32List normalizeInPlace(Float32List audio, double peak) {
+    const targetPeak = 0.8;
+    if (peak <= 0) return audio;
+
+    final gain = targetPeak / peak;
+    for (int i = 0; i < audio.length; i++) {
+      audio[i] = (audio[i] * gain).clamp(-1.0, 1.0);
+    }
+    return audio;
+  }
+
+  AudioQualityMetrics _qualityMetricsFromStats(AudioChunkStats stats) {
+    final snr = _calculateSNR(stats.meanAbs, _streamNoiseFloor.noiseFloor);
 
     return AudioQualityMetrics(
       signalToNoiseRatio: snr,
-      averageVolume: avgVolume,
-      peakVolume: peakVolume,
-      zeroCrossingRate: zcr,
-      spectralCentroid: 1000.0, // Placeholder
-      isClipping: peakVolume >= 0.99,
-      isSilent: avgVolume < 0.001,
+      averageVolume: stats.meanAbs,
+      peakVolume: stats.peak,
+      zeroCrossingRate: stats.zeroCrossingRate,
+      spectralCentroid: stats.spectralCentroid,
+      isClipping: stats.clipCount > 0,
+      isSilent: stats.meanAbs < 0.001,
       timestamp: DateTime.now(),
+      rms: stats.rms,
+      clipCount: stats.clipCount,
     );
   }
 
@@ -670,11 +756,67 @@ class AudioAnalyzer {
     return peak;
   }
 
-  double _estimateNoiseLevel(Float32List audio) {
-    // Estimate noise level using lower percentile of audio energy
-    final sortedAmplitudes = audio.map((s) => s.abs()).toList()..sort();
-    final percentile10 = (sortedAmplitudes.length * 0.1).round();
-    return sortedAmplitudes[percentile10];
+  /// Fused statistics pass, native when available
+  AudioChunkStats _computeStats(
+      Float32List audio, NoiseFloorEstimator noiseFloor) {
+    return AudioDspFFI.computeQualityMetrics(
+          audio,
+          sampleRate: 16000,
+          noiseFloor: noiseFloor,
+        ) ??
+        _computeStatsDart(audio, noiseFloor);
+  }
+
+  /// Dart equivalent of audio_dsp_compute_quality_metrics
+  AudioChunkStats _computeStatsDart(
+      Float32List audio, NoiseFloorEstimator noiseFloor) {
+    if (audio.isEmpty) return AudioChunkStats.empty;
+
+    double sumAbs = 0.0;
+    double sumSquares = 0.0;
+    double sumDiffSquares = 0.0;
+    double peak = 0.0;
+    int clips = 0;
+    int crossings = 0;
+    double previous = audio[0];
+
+    for (int i = 0; i < audio.length; i++) {
+      final sample = audio[i];
+      final amplitude = sample.abs();
+
+      sumAbs += amplitude;
+      sumSquares += sample * sample;
+      if (amplitude > peak) peak = amplitude;
+      if (amplitude >= 0.99) clips++;
+
+      if (i > 0) {
+        final diff = sample - previous;
+        sumDiffSquares += diff * diff;
+        if ((sample >= 0) != (previous >= 0)) crossings++;
+      }
+      previous = sample;
+    }
+
+    noiseFloor.addSamples(audio);
+
+    return AudioChunkStats(
+      meanAbs: sumAbs / audio.length,
+      rms: math.sqrt(sumSquares / audio.length),
+      peak: peak,
+      clipCount: clips,
+      zeroCrossingRate: crossings / audio.length,
+      spectralCentroid: _estimateSpectralCentroid(sumSquares, sumDiffSquares),
+      sampleCount: audio.length,
+    );
+  }
+
+  /// Mean frequency from first-difference energy: for a tone of frequency f,
+  /// sum(d^2) / sum(x^2) = 4 sin^2(pi f / fs)
+  double _estimateSpectralCentroid(double sumSquares, double sumDiffSquares) {
+    if (sumSquares <= 0) return 0.0;
+
+    final ratio = math.sqrt(sumDiffSquares / sumSquares) / 2;
+    return 16000 / math.pi * math.asin(math.min(1.0, ratio));
   }
 
   Future<double> _estimateFundamentalFrequency(Float32List audio) async {
@@ -715,28 +857,13 @@ class AudioAnalyzer {
     return quality.clamp(0.0, 1.0);
   }
 
-  double _calculateSNR(Float32List audio) {
-    final signal = _calculateAverageVolume(audio);
-    final noise = _estimateNoiseLevel(audio);
-
+  double _calculateSNR(double signal, double noise) {
     if (noise == 0) return 60.0; // Maximum SNR
     return 20 * math.log(signal / noise) / math.ln10;
   }
 
-  double _calculateZeroCrossingRate(Float32List audio) {
-    if (audio.length < 2) return 0.0;
-
-    int crossings = 0;
-    for (int i = 1; i < audio.length; i++) {
-      if ((audio[i] >= 0) != (audio[i - 1] >= 0)) {
-        crossings++;
-      }
-    }
-
-    return crossings / audio.length;
-  }
-
   void dispose() {
+    _streamNoiseFloor.reset();
     _isInitialized = false;
   }
 }
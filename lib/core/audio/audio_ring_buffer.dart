@@ -0,0 +1,99 @@
+import 'dart:math' as math;
+import 'dart:typed_data';
+
+/// Fixed-capacity sample ring with contiguous zero-copy views
+///
+/// Storage is mirrored: every sample is written at index `i` and at
+/// `i + capacity`, so the most recent `n <= capacity` samples always form one
+/// contiguous range and can be returned as a typed-data view without
+/// copying, regardless of where the write index has wrapped to. Appends are
+/// two memcpy-style range copies and never allocate.
+///
+/// Views alias the ring. They stay valid until the ring has wrapped over
+/// them, i.e. until `capacity - view.length` further samples are appended,
+/// so callers holding a view across async gaps should size [capacity] with
+/// headroom for the audio that may arrive meanwhile.
+abstract class SampleRingBuffer<T extends List<num>> {
+  final int capacity;
+  final T _data;
+
+  int _writeIndex = 0;
+  int _length = 0;
+  int _totalWritten = 0;
+
+  SampleRingBuffer._(this.capacity, this._data) : assert(capacity > 0);
+
+  /// Zero-copy view of [list] over [start, end)
+  T _slice(T list, int start, int end);
+
+  /// Number of samples currently retained
+  int get length => _length;
+
+  bool get isEmpty => _length == 0;
+  bool get isNotEmpty => _length > 0;
+
+  /// Stream position one past the newest sample (samples appended since
+  /// construction or [clear])
+  int get endPosition => _totalWritten;
+
+  /// Stream position of the oldest retained sample
+  int get startPosition => _totalWritten - _length;
+
+  /// Append [samples], overwriting the oldest audio once full
+  void append(T samples) {
+    var source = samples;
+    if (source.length > capacity) {
+      source = _slice(source, source.length - capacity, source.length);
+    }
+
+    int offset = 0;
+    while (offset < source.length) {
+      final count = math.min(capacity - _writeIndex, source.length - offset);
+      _data.setRange(_writeIndex, _writeIndex + count, source, offset);
+      _data.setRange(_writeIndex + capacity, _writeIndex + capacity + count,
+          source, offset);
+      _writeIndex = (_writeIndex + count) % capacity;
+      offset += count;
+    }
+
+    _totalWritten += samples.length;
+    _length = math.min(_length + samples.length, capacity);
+  }
+
+  /// View of the newest [count] samples (all retained samples by default)
+  T view([int? count]) {
+    final n = math.min(count ?? _length, _length);
+    final start = (_writeIndex - n) % capacity;
+    return _slice(_data, start, start + n);
+  }
+
+  /// Drop all but the newest [count] samples
+  void retainLast(int count) {
+    _length = math.min(_length, math.max(0, count));
+  }
+
+  /// Drop all samples and restart stream positions at zero
+  void clear() {
+    _writeIndex = 0;
+    _length = 0;
+    _totalWritten = 0;
+  }
+}
+
+/// Float samples in [-1, 1]
+class AudioRingBuffer extends SampleRingBuffer<Float32List> {
+  AudioRingBuffer(int capacity) : super._(capacity, Float32List(capacity * 2));
+
+  @override
+  Float32List _slice(Float32List list, int start, int end) =>
+      Float32List.sublistView(list, start, end);
+}
+
+/// 16-bit PCM samples, half the footprint of [AudioRingBuffer]
+class Pcm16RingBuffer extends SampleRingBuffer<Int16List> {
+  Pcm16RingBuffer(int capacity) : super._(capacity, Int16List(capacity * 2));
+
+  @override
+  Int16List _slice(Int16List list, int start, int end) =>
+      Int16List.sublistView(list, start, end);
+}
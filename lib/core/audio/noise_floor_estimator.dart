@@ -0,0 +1,127 @@
+import 'dart:math' as math;
+import 'dart:typed_data';
+
+/// Streaming noise-floor estimator based on a log-spaced amplitude histogram
+///
+/// Samples are binned by the exponent and top mantissa bits of their float32
+/// representation, which gives ~0.75 dB wide bins without calling `log` or
+/// sorting. Quantiles are read from the cumulative histogram in O(bins), so a
+/// chunk costs O(n) with no per-sample allocation.
+class NoiseFloorEstimator {
+  /// Mantissa bits kept per octave (8 bins per octave)
+  static const int mantissaBits = 3;
+
+  /// Lowest tracked amplitude is 2^-16 (~-96 dBFS, below 16-bit quantization)
+  static const int minExponent = -16;
+
+  /// Underflow bin + 16 octaves + overflow bin (amplitudes >= 1.0)
+  static const int binCount = (-minExponent << mantissaBits) + 2;
+
+  static const int _shift = 23 - mantissaBits;
+  static const int _minBits = (127 + minExponent) << 23;
+  static const int _maxBits = 127 << 23; // 1.0f
+  static const int _binBase = (127 + minExponent) << mantissaBits;
+
+  /// Representative amplitude for each bin (geometric centre of its range)
+  static final Float64List _binValues = _buildBinValues();
+
+  final Int32List _counts = Int32List(binCount);
+  final int _maxSamples;
+  int _total = 0;
+
+  /// [maxSamples] bounds the memory of the estimator: once more samples than
+  /// this have been added, all counts are halved so older audio decays
+  /// exponentially. Pass 0 to keep every sample (one-shot estimation).
+  NoiseFloorEstimator({int maxSamples = 0}) : _maxSamples = maxSamples;
+
+  /// Number of samples currently represented in the histogram
+  int get sampleCount => _total;
+
+  /// Raw bin counts, laid out as described by [binIndexForBits]
+  Int32List get counts => _counts;
+
+  /// Map the IEEE-754 bits of `|sample|` to a histogram bin
+  static int binIndexForBits(int absBits) {
+    if (absBits < _minBits) return 0;
+    if (absBits >= _maxBits) return binCount - 1;
+    return (absBits >> _shift) - _binBase + 1;
+  }
+
+  /// Add every sample of [audio] to the histogram
+  void addSamples(Float32List audio) {
+    if (audio.isEmpty) return;
+
+    // Reinterpret the float buffer in place; no copies, no boxing
+    final bits =
+        Int32List.view(audio.buffer, audio.offsetInBytes, audio.length);
+    for (int i = 0; i < bits.length; i++) {
+      _counts[binIndexForBits(bits[i] & 0x7fffffff)]++;
+    }
+
+    _total += audio.length;
+    _decayIfNeeded();
+  }
+
+  /// Merge a histogram computed elsewhere (e.g. by the native stats kernel)
+  void addHistogram(List<int> histogram) {
+    final n = math.min(histogram.length, binCount);
+    for (int i = 0; i < n; i++) {
+      _counts[i] += histogram[i];
+      _total += histogram[i];
+    }
+    _decayIfNeeded();
+  }
+
+  /// Amplitude below which a fraction [q] of the tracked samples fall
+  double quantile(double q) {
+    if (_total == 0) return 0.0;
+
+    final target = (_total * q.clamp(0.0, 1.0)).round();
+    int cumulative = 0;
+    for (int i = 0; i < binCount; i++) {
+      cumulative += _counts[i];
+      if (cumulative > target) return _binValues[i];
+    }
+    return _binValues[binCount - 1];
+  }
+
+  /// Noise floor as the 10th percentile of absolute amplitude
+  double get noiseFloor => quantile(0.1);
+
+  /// Clear all accumulated samples
+  void reset() {
+    _counts.fillRange(0, binCount, 0);
+    _total = 0;
+  }
+
+  void _decayIfNeeded() {
+    if (_maxSamples <= 0) return;
+
+    while (_total > _maxSamples) {
+      _total = 0;
+      for (int i = 0; i < binCount; i++) {
+        final halved = _counts[i] >> 1;
+        _counts[i] = halved;
+        _total += halved;
+      }
+    }
+  }
+
+  static Float64List _buildBinValues() {
+    final values = Float64List(binCount);
+    final bits = Int32List(1);
+    final asFloat = Float32List.view(bits.buffer);
+
+    values[0] = 0.0;
+    for (int i = 1; i < binCount - 1; i++) {
+      bits[0] = (i - 1 + _binBase) << _shift;
+      final low = asFloat[0];
+      bits[0] = (i + _binBase) << _shift;
+      final high = asFloat[0];
+      values[i] = math.sqrt(low * high);
+    }
+    values[binCount - 1] = 1.0;
+
+    return values;
+  }
+}
@@ -0,0 +1,290 @@
+import 'dart:ffi';
+import 'dart:math' as math;
+import 'dart:typed_data';
+
+import 'audio_dsp_ffi.dart';
+
+/// Streaming frame-level voice activity detector with onset/offset hysteresis
+///
+/// Audio is cut into fixed frames and each frame's mean absolute level is
+/// compared against both an absolute level and a tracked noise floor. A
+/// region opens after [onsetFrames] consecutive frames pass the (stricter)
+/// onset thresholds, stays open while frames pass the offset thresholds, and
+/// closes after more than [hangoverFrames] failing frames. Regions shorter
+/// than [minSpeechFrames] active frames are dropped.
+///
+/// Regions are returned from [addSamples] as soon as they close, in sample
+/// positions counted from the first sample fed after construction or
+/// [reset]. Uses the native detector when available, with a Dart fallback
+/// implementing the same state machine as native/audio/audio_vad.cc.
+class SpeechActivityDetector {
+  final int sampleRate;
+  final int frameSamples;
+  final double onsetLevel;
+  final double offsetLevel;
+  final double onsetSnrDb;
+  final double offsetSnrDb;
+  final int onsetFrames;
+  final int hangoverFrames;
+  final int minSpeechFrames;
+
+  Pointer<NativeVad> _native = nullptr;
+  _DartVad? _fallback;
+
+  /// Defaults match audio_vad_default_config(): 20 ms frames at 16 kHz, a
+  /// 60 ms onset, 300 ms hangover and 200 ms minimum speech duration.
+  SpeechActivityDetector({
+    this.sampleRate = 16000,
+    this.frameSamples = 320,
+    this.onsetLevel = 0.01,
+    this.offsetLevel = 0.006,
+    this.onsetSnrDb = 9.0,
+    this.offsetSnrDb = 4.0,
+    this.onsetFrames = 3,
+    this.hangoverFrames = 15,
+    this.minSpeechFrames = 10,
+  }) {
+    _native = AudioDspFFI.createVad(
+      sampleRate: sampleRate,
+      frameSamples: frameSamples,
+      onsetLevel: onsetLevel,
+      offsetLevel: offsetLevel,
+      onsetSnrDb: onsetSnrDb,
+      offsetSnrDb: offsetSnrDb,
+      onsetFrames: onsetFrames,
+      hangoverFrames: hangoverFrames,
+      minSpeechFrames: minSpeechFrames,
+    );
+    if (_native == nullptr) _fallback = _DartVad(this);
+  }
+
+  /// Whether decisions are made by the native detector
+  bool get isNative => _native != nullptr;
+
+  /// Feed [audio] and return any regions completed by it
+  List<VadRegion> addSamples(Float32List audio) {
+    if (_native != nullptr) return AudioDspFFI.processVad(_native, audio);
+    return _fallback?.process(audio) ?? const [];
+  }
+
+  /// Feed 16-bit PCM through the fixed-point level kernel; levels are in the
+  /// same units as [addSamples], so both may be mixed on one detector
+  List<VadRegion> addPcm16(Int16List pcm) {
+    if (_native != nullptr) return AudioDspFFI.processVadPcm16(_native, pcm);
+    return _fallback?.processPcm16(pcm) ?? const [];
+  }
+
+  /// Close any open region and return all remaining regions
+  List<VadRegion> flush() {
+    if (_native != nullptr) return AudioDspFFI.flushVad(_native);
+    return _fallback?.flush() ?? const [];
+  }
+
+  /// The region currently open (still in speech or hangover), if any
+  VadRegion? get openRegion {
+    if (_native != nullptr) return AudioDspFFI.openVadRegion(_native);
+    return _fallback?.openRegion;
+  }
+
+  /// Forget all state and restart sample positions at zero
+  void reset() {
+    if (_native != nullptr) {
+      AudioDspFFI.resetVad(_native);
+    } else {
+      _fallback?.reset();
+    }
+  }
+
+  /// Release the native detector
+  void dispose() {
+    AudioDspFFI.freeVad(_native);
+    _native = nullptr;
+  }
+}
+
+/// Dart equivalent of audio_vad.cc, used when the native library is missing
+class _DartVad {
+  static const double _initialNoise = 1e-3;
+  static const double _minNoise = 1e-5;
+  static const double _noiseRiseDbPerSecond = 3.0;
+  static const double _speechNoiseRiseDbPerSecond = 2.0;
+  static const double _probabilitySlopeDb = 3.0;
+
+  final SpeechActivityDetector _config;
+  final int frameSamples;
+  final double _noiseRise;
+  final double _speechNoiseRise;
+
+  final List<VadRegion> _ready = [];
+
+  // Partial frame carried between calls
+  double _pendingSum = 0.0;
+  int _pendingCount = 0;
+
+  int _baseSample = 0;
+  int _frames = 0;
+  double _noise = _initialNoise;
+  bool _inSpeech = false;
+
+  int _onsetRun = 0;
+  int _onsetStartFrame = 0;
+  double _onsetProbSum = 0.0;
+  double _onsetLevelSum = 0.0;
+
+  int _regionStartFrame = 0;
+  int _lastActiveFrame = 0;
+  int _activeFrames = 0;
+  int _silenceRun = 0;
+  double _probSum = 0.0;
+  double _levelSum = 0.0;
+
+  _DartVad(this._config)
+      : frameSamples = _config.frameSamples,
+        _noiseRise = math.pow(
+            10.0,
+            _noiseRiseDbPerSecond /
+                20.0 /
+                (_config.sampleRate / _config.frameSamples)) as double,
+        _speechNoiseRise = math.pow(
+            10.0,
+            _speechNoiseRiseDbPerSecond /
+                20.0 /
+                (_config.sampleRate / _config.frameSamples)) as double;
+
+  List<VadRegion> process(Float32List audio) {
+    for (int i = 0; i < audio.length; i++) {
+      _pendingSum += audio[i].abs();
+      if (++_pendingCount == frameSamples) {
+        _processFrame(_pendingSum / frameSamples);
+        _pendingSum = 0.0;
+        _pendingCount = 0;
+      }
+    }
+    return _drain();
+  }
+
+  List<VadRegion> processPcm16(Int16List pcm) {
+    for (int i = 0; i < pcm.length; i++) {
+      _pendingSum += pcm[i].abs() / 32768;
+      if (++_pendingCount == frameSamples) {
+        _processFrame(_pendingSum / frameSamples);
+        _pendingSum = 0.0;
+        _pendingCount = 0;
+      }
+    }
+    return _drain();
+  }
+
+  List<VadRegion> flush() {
+    if (_inSpeech) _closeRegion();
+    _onsetRun = 0;
+
+    _baseSample += _frames * frameSamples + _pendingCount;
+    _frames = 0;
+    _pendingSum = 0.0;
+    _pendingCount = 0;
+
+    return _drain();
+  }
+
+  VadRegion? get openRegion => _inSpeech ? _currentRegion() : null;
+
+  void reset() {
+    _ready.clear();
+    _pendingSum = 0.0;
+    _pendingCount = 0;
+    _baseSample = 0;
+    _frames = 0;
+    _noise = _initialNoise;
+    _inSpeech = false;
+    _onsetRun = 0;
+    _activeFrames = 0;
+    _silenceRun = 0;
+    _probSum = 0.0;
+    _levelSum = 0.0;
+  }
+
+  void _processFrame(double level) {
+    final frame = _frames++;
+
+    // Noise floor: follows drops immediately, rises slowly, slower in
+    // speech, so steady noise that opened a region closes it again
+    if (level < _noise) {
+      _noise = math.max(level, _minNoise);
+    } else {
+      _noise = math.min(_noise * (_inSpeech ? _speechNoiseRise : _noiseRise),
+          level);
+    }
+
+    final snrDb =
+        level <= 0 ? -100.0 : 20 * math.log(level / _noise) / math.ln10;
+    final centre = 0.5 * (_config.onsetSnrDb + _config.offsetSnrDb);
+    final probability =
+        1.0 / (1.0 + math.exp(-(snrDb - centre) / _probabilitySlopeDb));
+
+    if (!_inSpeech) {
+      if (level < _config.onsetLevel || snrDb < _config.onsetSnrDb) {
+        _onsetRun = 0;
+        return;
+      }
+
+      if (_onsetRun == 0) {
+        _onsetStartFrame = frame;
+        _onsetProbSum = 0.0;
+        _onsetLevelSum = 0.0;
+      }
+      _onsetRun++;
+      _onsetProbSum += probability;
+      _onsetLevelSum += level;
+
+      if (_onsetRun >= _config.onsetFrames) {
+        _inSpeech = true;
+        _regionStartFrame = _onsetStartFrame;
+        _lastActiveFrame = frame;
+        _activeFrames = _onsetRun;
+        _probSum = _onsetProbSum;
+        _levelSum = _onsetLevelSum;
+        _silenceRun = 0;
+        _onsetRun = 0;
+      }
+      return;
+    }
+
+    if (level >= _config.offsetLevel && snrDb >= _config.offsetSnrDb) {
+      _lastActiveFrame = frame;
+      _activeFrames++;
+      _probSum += probability;
+      _levelSum += level;
+      _silenceRun = 0;
+    } else if (++_silenceRun > _config.hangoverFrames) {
+      _closeRegion();
+    }
+  }
+
+  VadRegion _currentRegion() {
+    return VadRegion(
+      startSample: _baseSample + _regionStartFrame * frameSamples,
+      endSample: _baseSample + (_lastActiveFrame + 1) * frameSamples,
+      confidence: _probSum / _activeFrames,
+      meanLevel: _levelSum / _activeFrames,
+    );
+  }
+
+  void _closeRegion() {
+    if (_activeFrames >= _config.minSpeechFrames) _ready.add(_currentRegion());
+
+    _inSpeech = false;
+    _onsetRun = 0;
+    _activeFrames = 0;
+    _silenceRun = 0;
+    _probSum = 0.0;
+    _levelSum = 0.0;
+  }
+
+  List<VadRegion> _drain() {
+    if (_ready.isEmpty) return const [];
+    final regions = List<VadRegion>.of(_ready);
+    _ready.clear();
+    return regions;
+  }
+}
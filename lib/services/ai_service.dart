@@ -29,6 +29,11 @@ class AiService extends ChangeNotifier {
   final List<List<AudioChunk>> _processingQueue = [];
   bool _isProcessingQueue = false;
 
+  // The finished part of the meeting is summarized ahead of its end at most
+  // this often, so stopping only has the rest left
+  static const Duration _meetingPrepareInterval = Duration(minutes: 1);
+  DateTime? _lastMeetingPrepare;
+
   AiService({
     SpeechRecognitionInterface? speechRecognition,
     SummarizationInterface? summarization,
@@ -71,6 +76,9 @@ class AiService extends ChangeNotifier {
   List<SpeechSegment> get allSpeechSegments =>
       List.unmodifiable(_allSpeechSegments);
   List<MeetingSummary> get summaries => List.unmodifiable(_summaries);
+
+  /// Summary text generated so far by the running summarization, if any
+  ValueListenable<String?> get summaryDraft => _summarization.summaryDraft;
   List<String> get identifiedSpeakers => _speechRecognition.identifiedSpeakers;
   ModelManager get modelManager => _modelManager;
 
@@ -125,6 +133,8 @@ class AiService extends ChangeNotifier {
     _allSpeechSegments.clear();
     _summaries.clear();
     _processingQueue.clear();
+    _lastMeetingPrepare = null;
+    _summarization.clearSession();
     _currentLanguage = 'en';
     _lastError = null;
     notifyListeners();
@@ -143,6 +153,37 @@ class AiService extends ChangeNotifier {
     return allItems;
   }
 
+  /// Summarize the whole session so far in one summary
+  Future<MeetingSummary?> summarizeMeeting() async {
+    if (!_isInitialized || _allSpeechSegments.isEmpty) return null;
+
+    try {
+      // Copies, as batches keep arriving while it runs
+      return await _summarization.summarizeMeeting(
+        List.of(_allSpeechSegments),
+        summaries: List.of(_summaries),
+      );
+    } catch (e) {
+      _lastError = 'Error summarizing meeting: $e';
+      notifyListeners();
+      return null;
+    }
+  }
+
+  /// Summarize the finished part of the session in the background, if not
+  /// done recently; not awaited
+  void _prepareMeetingSummary() {
+    final now = DateTime.now();
+    final last = _lastMeetingPrepare;
+    if (last != null && now.difference(last) < _meetingPrepareInterval) return;
+    _lastMeetingPrepare = now;
+
+    _summarization.prepareMeetingSummary(
+      List.of(_allSpeechSegments),
+      summaries: List.of(_summaries),
+    );
+  }
+
   /// Process the queue of audio batches
   Future<void> _processQueue() async {
     if (_isProcessingQueue) return;
@@ -203,6 +244,7 @@ class AiService extends ChangeNotifier {
       if (newSummary.hasContent) {
         _summaries.add(newSummary);
       }
+      _prepareMeetingSummary();
 
       // Update speaker profiles
       for (final segment in speechSegments) {
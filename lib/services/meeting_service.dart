@@ -92,6 +92,7 @@ class MeetingService extends ChangeNotifier {
   String get currentLanguage => _aiService.currentLanguage;
   List<String> get identifiedSpeakers => _aiService.identifiedSpeakers;
   bool get isProcessing => _aiService.isProcessing;
+  ValueListenable<String?> get summaryDraft => _aiService.summaryDraft;
 
   // Database methods for retrieving saved meetings
   Future<List<MeetingSession>> getAllMeetings() async {
@@ -346,30 +347,25 @@ class MeetingService extends ChangeNotifier {
       _summaryTimer = null;
 
       // Finalize session
+      MeetingSession? finished;
       if (_currentSession != null) {
-        _currentSession = _currentSession!.copyWith(
+        finished = _currentSession!.copyWith(
           endTime: DateTime.now(),
-          segments: _liveSegments,
+          segments: List.of(_liveSegments),
           comments: _sessionComments,
           hasCodeSwitching: _detectCodeSwitching(),
         );
-
-        // Save session to database
-        try {
-          await _databaseService.saveMeetingSession(_currentSession!);
-          if (kDebugMode) {
-            print('Meeting session saved successfully: ${_currentSession!.id}');
-          }
-        } catch (dbError) {
-          if (kDebugMode) {
-            print('Failed to save meeting session: $dbError');
-          }
-          // Don't fail the whole stop operation due to database error
-        }
+        _currentSession = finished;
+        await _saveSession(finished);
       }
 
       _recordingState = RecordingState.stopped;
       notifyListeners();
+
+      // Live segments only keep the last few summaries; the meeting is
+      // saved without waiting for one of the whole of it, which is
+      // attached once ready
+      if (finished != null) _attachMeetingSummary(finished);
       return true;
     } catch (e) {
       _lastError = 'Error stopping meeting: $e';
@@ -378,6 +374,39 @@ class MeetingService extends ChangeNotifier {
     }
   }
 
+  /// Save [session] to the database; a failure is logged, not thrown
+  Future<void> _saveSession(MeetingSession session) async {
+    try {
+      await _databaseService.saveMeetingSession(session);
+      if (kDebugMode) {
+        print('Meeting session saved successfully: ${session.id}');
+      }
+    } catch (dbError) {
+      if (kDebugMode) {
+        print('Failed to save meeting session: $dbError');
+      }
+    }
+  }
+
+  /// Summarize the whole of the meeting that just stopped, saved as
+  /// [session], and save it again with the summary added
+  Future<void> _attachMeetingSummary(MeetingSession session) async {
+    // A copy, taken before another meeting can clear them
+    final speechSegments = _aiService.allSpeechSegments;
+    final meetingSummary = await _aiService.summarizeMeeting();
+    if (meetingSummary == null) return;
+
+    final summarized = session.copyWith(segments: [
+      ...session.segments,
+      _convertAiSummaryToSegment(meetingSummary, speechSegments),
+    ]);
+    await _saveSession(summarized);
+    if (_currentSession?.id == session.id) {
+      _currentSession = summarized;
+      notifyListeners();
+    }
+  }
+
   /// Select an audio source
   Future<bool> selectAudioSource(AudioSource source) async {
     final success = await _audioService.selectAudioSource(source);
@@ -336,10 +336,14 @@ class _MainMeetingScreenState extends State<MainMeetingScreen>
           );
         }).toList();
 
-        return LiveSummaryWidget(
-          summaries: summaries,
-          speechSegments: meetingService.recentSpeechSegments,
-          onSummarySegmentTap: _handleSummarySegmentTap,
+        return ValueListenableBuilder<String?>(
+          valueListenable: meetingService.summaryDraft,
+          builder: (context, draftSummary, child) => LiveSummaryWidget(
+            summaries: summaries,
+            speechSegments: meetingService.recentSpeechSegments,
+            draftSummary: draftSummary,
+            onSummarySegmentTap: _handleSummarySegmentTap,
+          ),
         );
       },
     );
@@ -220,6 +220,10 @@ class _ModelManagementScreenState extends State<ModelManagementScreen>
         iconData = Icons.language;
         color = Colors.purple;
         break;
+      case ModelType.textEmbedding:
+        iconData = Icons.topic;
+        color = Colors.teal;
+        break;
     }
 
     return CircleAvatar(
@@ -298,6 +298,14 @@ class _AiStatusWidgetState extends State<AiStatusWidget>
         return 'Whisper Base';
       case 'whisper-small':
         return 'Whisper Small';
+      case 'whisper-base-q5_1':
+        return 'Whisper Base (Q5)';
+      case 'whisper-base-q8_0':
+        return 'Whisper Base (Q8)';
+      case 'whisper-small-q5_1':
+        return 'Whisper Small (Q5)';
+      case 'whisper-small-q8_0':
+        return 'Whisper Small (Q8)';
       case 'llama-3.2-1b-q4':
         return 'Llama 3.2 1B';
       case 'llama-3.2-3b-q4':
@@ -515,6 +523,14 @@ class _QuickSwitchSheetState extends State<_QuickSwitchSheet> {
         return 'Whisper Base';
       case 'whisper-small':
         return 'Whisper Small';
+      case 'whisper-base-q5_1':
+        return 'Whisper Base (Q5)';
+      case 'whisper-base-q8_0':
+        return 'Whisper Base (Q8)';
+      case 'whisper-small-q5_1':
+        return 'Whisper Small (Q5)';
+      case 'whisper-small-q8_0':
+        return 'Whisper Small (Q8)';
       case 'llama-3.2-1b-q4':
         return 'Llama 3.2 1B';
       case 'llama-3.2-3b-q4':
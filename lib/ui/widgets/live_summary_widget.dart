@@ -8,16 +8,21 @@ class LiveSummaryWidget extends StatelessWidget {
   final List<SpeechSegment> speechSegments;
   final Function(String)? onSummarySegmentTap;
 
+  /// Text of a summary still being generated, shown after the finished ones
+  /// as it streams in
+  final String? draftSummary;
+
   const LiveSummaryWidget({
     super.key,
     required this.summaries,
     required this.speechSegments,
     this.onSummarySegmentTap,
+    this.draftSummary,
   });
 
   @override
   Widget build(BuildContext context) {
-    if (summaries.isEmpty) {
+    if (summaries.isEmpty && draftSummary == null) {
       return const Center(
         child: Column(
           mainAxisAlignment: MainAxisAlignment.center,
@@ -50,14 +55,52 @@ class LiveSummaryWidget extends StatelessWidget {
 
     return ListView.builder(
       padding: const EdgeInsets.all(16),
-      itemCount: summaries.length,
+      itemCount: summaries.length + (draftSummary != null ? 1 : 0),
       itemBuilder: (context, index) {
+        if (index == summaries.length) {
+          return _buildDraftCard(context, draftSummary!);
+        }
         final summary = summaries[index];
         return _buildSummaryCard(context, summary, index);
       },
     );
   }
 
+  Widget _buildDraftCard(BuildContext context, String draft) {
+    return Card(
+      margin: const EdgeInsets.only(bottom: 16),
+      child: Padding(
+        padding: const EdgeInsets.all(16),
+        child: Column(
+          crossAxisAlignment: CrossAxisAlignment.start,
+          children: [
+            const Row(
+              children: [
+                SizedBox(
+                  width: 16,
+                  height: 16,
+                  child: CircularProgressIndicator(strokeWidth: 2),
+                ),
+                SizedBox(width: 12),
+                Text(
+                  'Summarizing...',
+                  style: TextStyle(fontWeight: FontWeight.bold),
+                ),
+              ],
+            ),
+            if (draft.isNotEmpty) ...[
+              const SizedBox(height: 12),
+              Text(
+                draft,
+                style: TextStyle(fontSize: 13, color: Colors.grey[700]),
+              ),
+            ],
+          ],
+        ),
+      ),
+    );
+  }
+
   Widget _buildSummaryCard(
       BuildContext context, MeetingSummary summary, int index) {
     return Card(
@@ -0,0 +1,315 @@
+#include "audio/audio_dsp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "audio/audio_dsp_internal.h"
+
+namespace {
+
+using audio_dsp::BinIndex;
+using audio_dsp::BitsFloat;
+using audio_dsp::FloatBits;
+using audio_dsp::kBinBase;
+using audio_dsp::kPi;
+using audio_dsp::kShift;
+
+// SIMD partial sums are kept in float and flushed to double every block so
+// long chunks do not lose precision.
+constexpr int32_t kFlushBlock = 1024;
+
+double BinValue(int bin) {
+  if (bin <= 0) return 0.0;
+  if (bin >= AUDIO_DSP_NOISE_BINS - 1) return 1.0;
+  const double low = BitsFloat(static_cast<uint32_t>(bin - 1 + kBinBase)
+                               << kShift);
+  const double high = BitsFloat(static_cast<uint32_t>(bin + kBinBase)
+                                << kShift);
+  return std::sqrt(low * high);
+}
+
+struct Accumulators {
+  double sum_abs = 0.0;
+  double sum_sq = 0.0;
+  double sum_diff_sq = 0.0;
+  float peak = 0.0f;
+  int64_t clips = 0;
+  int64_t crossings = 0;
+};
+
+// Scalar step for sample |i|; |i| must be >= 1.
+inline void AccumulateScalar(const float* samples,
+                             int32_t i,
+                             Accumulators* acc,
+                             int32_t* histogram) {
+  const float x = samples[i];
+  const float prev = samples[i - 1];
+  const float a = std::fabs(x);
+  const float d = x - prev;
+
+  acc->sum_abs += a;
+  acc->sum_sq += static_cast<double>(x) * x;
+  acc->sum_diff_sq += static_cast<double>(d) * d;
+  acc->peak = std::max(acc->peak, a);
+  acc->clips += a >= AUDIO_DSP_CLIP_LEVEL;
+  acc->crossings += (x >= 0.0f) != (prev >= 0.0f);
+  histogram[BinIndex(FloatBits(a))]++;
+}
+
+#if defined(AUDIO_DSP_SSE2)
+
+inline float HorizontalSum(__m128 v) {
+  __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 sums = _mm_add_ps(v, shuf);
+  shuf = _mm_movehl_ps(shuf, sums);
+  sums = _mm_add_ss(sums, shuf);
+  return _mm_cvtss_f32(sums);
+}
+
+inline float HorizontalMax(__m128 v) {
+  __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 maxes = _mm_max_ps(v, shuf);
+  shuf = _mm_movehl_ps(shuf, maxes);
+  maxes = _mm_max_ss(maxes, shuf);
+  return _mm_cvtss_f32(maxes);
+}
+
+inline int64_t HorizontalSum(__m128i v) {
+  alignas(16) int32_t lanes[4];
+  _mm_store_si128(reinterpret_cast<__m128i*>(lanes), v);
+  return static_cast<int64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+}
+
+// Processes samples [begin, end) four at a time; returns the first index not
+// consumed. |begin| must be >= 1 so that samples[i - 1] is valid.
+int32_t AccumulateSimd(const float* samples,
+                       int32_t begin,
+                       int32_t end,
+                       Accumulators* acc,
+                       int32_t* histogram) {
+  const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  const __m128 clip_level = _mm_set1_ps(AUDIO_DSP_CLIP_LEVEL);
+  const __m128 zero = _mm_setzero_ps();
+  __m128 peak = _mm_set1_ps(acc->peak);
+  alignas(16) uint32_t lanes[4];
+
+  int32_t i = begin;
+  while (i + 4 <= end) {
+    const int32_t block_end = std::min(end, i + kFlushBlock);
+    __m128 sum_abs = zero;
+    __m128 sum_sq = zero;
+    __m128 sum_diff_sq = zero;
+    __m128i clips = _mm_setzero_si128();
+    __m128i crossings = _mm_setzero_si128();
+
+    for (; i + 4 <= block_end; i += 4) {
+      const __m128 x = _mm_loadu_ps(samples + i);
+      const __m128 prev = _mm_loadu_ps(samples + i - 1);
+      const __m128 a = _mm_and_ps(x, abs_mask);
+      const __m128 d = _mm_sub_ps(x, prev);
+
+      sum_abs = _mm_add_ps(sum_abs, a);
+      sum_sq = _mm_add_ps(sum_sq, _mm_mul_ps(x, x));
+      sum_diff_sq = _mm_add_ps(sum_diff_sq, _mm_mul_ps(d, d));
+      peak = _mm_max_ps(peak, a);
+
+      // Comparison masks are all-ones (-1) per lane, so subtracting counts.
+      clips = _mm_sub_epi32(
+          clips, _mm_castps_si128(_mm_cmpge_ps(a, clip_level)));
+      const __m128 sign_change =
+          _mm_xor_ps(_mm_cmpge_ps(x, zero), _mm_cmpge_ps(prev, zero));
+      crossings = _mm_sub_epi32(crossings, _mm_castps_si128(sign_change));
+
+      _mm_store_si128(reinterpret_cast<__m128i*>(lanes),
+                      _mm_castps_si128(a));
+      histogram[BinIndex(lanes[0])]++;
+      histogram[BinIndex(lanes[1])]++;
+      histogram[BinIndex(lanes[2])]++;
+      histogram[BinIndex(lanes[3])]++;
+    }
+
+    acc->sum_abs += HorizontalSum(sum_abs);
+    acc->sum_sq += HorizontalSum(sum_sq);
+    acc->sum_diff_sq += HorizontalSum(sum_diff_sq);
+    acc->clips += HorizontalSum(clips);
+    acc->crossings += HorizontalSum(crossings);
+  }
+
+  acc->peak = std::max(acc->peak, HorizontalMax(peak));
+  return i;
+}
+
+#elif defined(AUDIO_DSP_NEON)
+
+int32_t AccumulateSimd(const float* samples,
+                       int32_t begin,
+                       int32_t end,
+                       Accumulators* acc,
+                       int32_t* histogram) {
+  const float32x4_t clip_level = vdupq_n_f32(AUDIO_DSP_CLIP_LEVEL);
+  const float32x4_t zero = vdupq_n_f32(0.0f);
+  float32x4_t peak = vdupq_n_f32(acc->peak);
+  uint32_t lanes[4];
+
+  int32_t i = begin;
+  while (i + 4 <= end) {
+    const int32_t block_end = std::min(end, i + kFlushBlock);
+    float32x4_t sum_abs = zero;
+    float32x4_t sum_sq = zero;
+    float32x4_t sum_diff_sq = zero;
+    uint32x4_t clips = vdupq_n_u32(0);
+    uint32x4_t crossings = vdupq_n_u32(0);
+
+    for (; i + 4 <= block_end; i += 4) {
+      const float32x4_t x = vld1q_f32(samples + i);
+      const float32x4_t prev = vld1q_f32(samples + i - 1);
+      const float32x4_t a = vabsq_f32(x);
+      const float32x4_t d = vsubq_f32(x, prev);
+
+      sum_abs = vaddq_f32(sum_abs, a);
+      sum_sq = vfmaq_f32(sum_sq, x, x);
+      sum_diff_sq = vfmaq_f32(sum_diff_sq, d, d);
+      peak = vmaxq_f32(peak, a);
+
+      clips = vsubq_u32(clips, vcgeq_f32(a, clip_level));
+      crossings = vsubq_u32(
+          crossings, veorq_u32(vcgeq_f32(x, zero), vcgeq_f32(prev, zero)));
+
+      vst1q_u32(lanes, vreinterpretq_u32_f32(a));
+      histogram[BinIndex(lanes[0])]++;
+      histogram[BinIndex(lanes[1])]++;
+      histogram[BinIndex(lanes[2])]++;
+      histogram[BinIndex(lanes[3])]++;
+    }
+
+    acc->sum_abs += vaddvq_f32(sum_abs);
+    acc->sum_sq += vaddvq_f32(sum_sq);
+    acc->sum_diff_sq += vaddvq_f32(sum_diff_sq);
+    acc->clips += vaddvq_u32(clips);
+    acc->crossings += vaddvq_u32(crossings);
+  }
+
+  acc->peak = std::max(acc->peak, vmaxvq_f32(peak));
+  return i;
+}
+
+#else
+
+int32_t AccumulateSimd(const float*, int32_t begin, int32_t, Accumulators*,
+                       int32_t*) {
+  return begin;
+}
+
+#endif
+
+float FrameLevel(const float* samples, int32_t count) {
+  int32_t i = 0;
+  double sum = 0.0;
+#if defined(AUDIO_DSP_SSE2)
+  const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  __m128 acc = _mm_setzero_ps();
+  for (; i + 4 <= count; i += 4) {
+    acc = _mm_add_ps(acc, _mm_and_ps(_mm_loadu_ps(samples + i), abs_mask));
+  }
+  sum = HorizontalSum(acc);
+#elif defined(AUDIO_DSP_NEON)
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  for (; i + 4 <= count; i += 4) {
+    acc = vaddq_f32(acc, vabsq_f32(vld1q_f32(samples + i)));
+  }
+  sum = vaddvq_f32(acc);
+#endif
+  for (; i < count; i++) sum += std::fabs(samples[i]);
+  return count > 0 ? static_cast<float>(sum / count) : 0.0f;
+}
+
+double HistogramQuantile(const int32_t* histogram, double q) {
+  int64_t total = 0;
+  for (int i = 0; i < AUDIO_DSP_NOISE_BINS; i++) total += histogram[i];
+  if (total == 0) return 0.0;
+
+  const int64_t target =
+      std::llround(static_cast<double>(total) * std::clamp(q, 0.0, 1.0));
+  int64_t cumulative = 0;
+  for (int i = 0; i < AUDIO_DSP_NOISE_BINS; i++) {
+    cumulative += histogram[i];
+    if (cumulative > target) return BinValue(i);
+  }
+  return 1.0;
+}
+
+}  // namespace
+
+int32_t audio_dsp_compute_quality_metrics(const float* samples,
+                                          int32_t count,
+                                          int32_t sample_rate,
+                                          int32_t* noise_histogram,
+                                          audio_dsp_quality_metrics* out) {
+  if (out == nullptr || count < 0 || (count > 0 && samples == nullptr)) {
+    return -1;
+  }
+
+  std::memset(out, 0, sizeof(*out));
+  int32_t histogram[AUDIO_DSP_NOISE_BINS] = {0};
+  out->sample_count = count;
+
+  if (count > 0) {
+    Accumulators acc;
+
+    // The first sample has no predecessor for the difference terms.
+    const float first = samples[0];
+    const float first_abs = std::fabs(first);
+    acc.sum_abs = first_abs;
+    acc.sum_sq = static_cast<double>(first) * first;
+    acc.peak = first_abs;
+    acc.clips = first_abs >= AUDIO_DSP_CLIP_LEVEL;
+    histogram[BinIndex(FloatBits(first_abs))]++;
+
+    int32_t i = AccumulateSimd(samples, 1, count, &acc, histogram);
+    for (; i < count; i++) {
+      AccumulateScalar(samples, i, &acc, histogram);
+    }
+
+    out->mean_abs = acc.sum_abs / count;
+    out->rms = std::sqrt(acc.sum_sq / count);
+    out->peak = acc.peak;
+    out->clip_count = static_cast<int32_t>(acc.clips);
+    out->zero_crossing_rate = static_cast<double>(acc.crossings) / count;
+
+    // For a tone of frequency f, sum(d^2) / sum(x^2) = 4 sin^2(pi f / fs).
+    if (acc.sum_sq > 0.0 && sample_rate > 0) {
+      const double ratio = std::sqrt(acc.sum_diff_sq / acc.sum_sq) / 2.0;
+      out->spectral_centroid =
+          sample_rate / kPi * std::asin(std::min(1.0, ratio));
+    }
+
+    out->noise_floor = HistogramQuantile(histogram, 0.1);
+  }
+
+  if (noise_histogram != nullptr) {
+    std::memcpy(noise_histogram, histogram, sizeof(histogram));
+  }
+  return 0;
+}
+
+int32_t audio_dsp_frame_levels(const float* samples,
+                               int32_t count,
+                               int32_t frame_samples,
+                               float* levels) {
+  if (frame_samples <= 0 || count < 0 || levels == nullptr ||
+      (count > 0 && samples == nullptr)) {
+    return -1;
+  }
+
+  const int32_t frames = count / frame_samples;
+  for (int32_t f = 0; f < frames; f++) {
+    levels[f] = FrameLevel(samples + f * frame_samples, frame_samples);
+  }
+  return frames;
+}
+
+double audio_dsp_histogram_quantile(const int32_t* histogram, double q) {
+  if (histogram == nullptr) return 0.0;
+  return HistogramQuantile(histogram, q);
+}
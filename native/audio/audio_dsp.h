@@ -0,0 +1,84 @@
+#ifndef MEETING_NATIVE_AUDIO_AUDIO_DSP_H_
+#define MEETING_NATIVE_AUDIO_AUDIO_DSP_H_
+
+#include <stdint.h>
+
+#include "common/native_export.h"
+
+// Number of bins in the noise-floor histogram. Bin 0 holds amplitudes below
+// 2^-16, bins 1..128 cover [2^-16, 1.0) at 8 bins per octave and the last bin
+// holds amplitudes >= 1.0. The layout matches NoiseFloorEstimator in Dart.
+#define AUDIO_DSP_NOISE_BINS 130
+
+// Amplitude at or above which a sample counts as clipped.
+#define AUDIO_DSP_CLIP_LEVEL 0.99f
+
+// Per-chunk quality statistics, mirrored by NativeAudioQualityMetrics in
+// lib/core/audio/audio_dsp_ffi.dart. Keep the field order in sync.
+typedef struct audio_dsp_quality_metrics {
+  double mean_abs;
+  double rms;
+  double peak;
+  double zero_crossing_rate;
+  double spectral_centroid;
+  double noise_floor;
+  int32_t clip_count;
+  int32_t sample_count;
+} audio_dsp_quality_metrics;
+
+// Computes mean-abs, RMS, peak, clip count, zero-crossing rate, spectral
+// centroid and the noise-floor histogram of |samples| in a single pass.
+//
+// |noise_histogram| may be null; otherwise it must hold AUDIO_DSP_NOISE_BINS
+// counters and is overwritten with this chunk's histogram. The spectral
+// centroid is estimated from first-difference energy (no FFT), which is exact
+// for a pure tone and tracks the power-weighted mean frequency for speech.
+//
+// Returns 0 on success, -1 on invalid arguments.
+NATIVE_API int32_t audio_dsp_compute_quality_metrics(
+    const float* samples,
+    int32_t count,
+    int32_t sample_rate,
+    int32_t* noise_histogram,
+    audio_dsp_quality_metrics* out);
+
+// Writes the mean absolute level of each complete |frame_samples| frame of
+// |samples| to |levels|. This is the frame feature stream consumed by the
+// voice activity detector. Returns the number of frames written, or -1 on
+// invalid arguments.
+NATIVE_API int32_t audio_dsp_frame_levels(const float* samples,
+                                          int32_t count,
+                                          int32_t frame_samples,
+                                          float* levels);
+
+// Fixed-point variants for 16-bit PCM, used on low-tier devices so capture
+// buffers never need converting to float. They produce the same units as the
+// float kernels (amplitudes normalised by 32768), so their results and
+// histograms are interchangeable. Arithmetic stays in int16/int32 lanes; the
+// first difference is taken as an unsigned magnitude so even full-scale steps
+// are exact. The only saturation is |-32768| -> 32767.
+NATIVE_API int32_t audio_dsp_compute_quality_metrics_s16(
+    const int16_t* samples,
+    int32_t count,
+    int32_t sample_rate,
+    int32_t* noise_histogram,
+    audio_dsp_quality_metrics* out);
+
+NATIVE_API int32_t audio_dsp_frame_levels_s16(const int16_t* samples,
+                                              int32_t count,
+                                              int32_t frame_samples,
+                                              float* levels);
+
+// Converts |count| PCM samples to float, scaled by |gain| / 32768 and clamped
+// to [-1, 1]. Folds segment gain staging into the one conversion pass.
+// Returns 0 on success, -1 on invalid arguments.
+NATIVE_API int32_t audio_dsp_pcm16_to_float(const int16_t* samples,
+                                            int32_t count,
+                                            float gain,
+                                            float* out);
+
+// Returns the amplitude at quantile |q| of a histogram produced above.
+NATIVE_API double audio_dsp_histogram_quantile(const int32_t* histogram,
+                                               double q);
+
+#endif  // MEETING_NATIVE_AUDIO_AUDIO_DSP_H_
@@ -0,0 +1,60 @@
+#ifndef MEETING_NATIVE_AUDIO_AUDIO_DSP_INTERNAL_H_
+#define MEETING_NATIVE_AUDIO_AUDIO_DSP_INTERNAL_H_
+
+// Helpers shared by the float and int16 kernels. Not part of the C ABI.
+
+#include <stdint.h>
+
+#include <cstring>
+
+#include "audio/audio_dsp.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_DSP_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define AUDIO_DSP_NEON 1
+#endif
+
+namespace audio_dsp {
+
+// Histogram layout shared with NoiseFloorEstimator (see audio_dsp.h).
+constexpr int kMantissaBits = 3;
+constexpr int kMinExponent = -16;
+constexpr int kShift = 23 - kMantissaBits;
+constexpr uint32_t kMinBits = static_cast<uint32_t>(127 + kMinExponent) << 23;
+constexpr uint32_t kMaxBits = 127u << 23;  // 1.0f
+constexpr int kBinBase = (127 + kMinExponent) << kMantissaBits;
+
+constexpr double kPi = 3.14159265358979323846;
+
+inline uint32_t FloatBits(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline float BitsFloat(uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+inline int BinIndex(uint32_t abs_bits) {
+  if (abs_bits < kMinBits) return 0;
+  if (abs_bits >= kMaxBits) return AUDIO_DSP_NOISE_BINS - 1;
+  return static_cast<int>(abs_bits >> kShift) - kBinBase + 1;
+}
+
+// Bin of the amplitude |abs_sample| / 32768. The int-to-float conversion is
+// exact, and dividing by 2^15 only lowers the exponent field.
+inline int BinIndexS16(uint32_t abs_sample) {
+  if (abs_sample == 0) return 0;
+  return BinIndex(FloatBits(static_cast<float>(abs_sample)) - (15u << 23));
+}
+
+}  // namespace audio_dsp
+
+#endif  // MEETING_NATIVE_AUDIO_AUDIO_DSP_INTERNAL_H_
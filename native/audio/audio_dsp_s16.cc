@@ -0,0 +1,407 @@
+#include "audio/audio_dsp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "audio/audio_dsp_internal.h"
+
+namespace {
+
+using audio_dsp::BinIndexS16;
+using audio_dsp::kPi;
+
+constexpr double kScale = 1.0 / 32768.0;
+
+// Smallest |sample| counted as clipped: AUDIO_DSP_CLIP_LEVEL * 32768, rounded
+// up so both paths agree.
+constexpr int32_t kClipThreshold =
+    static_cast<int32_t>(AUDIO_DSP_CLIP_LEVEL * 32768.0f) + 1;
+
+// Lane counters are 16-bit; flush them long before they can overflow.
+constexpr int32_t kFlushBlock = 1024;
+
+struct Accumulators {
+  int64_t sum_abs = 0;
+  int64_t sum_sq = 0;
+  int64_t sum_diff_sq = 0;
+  int32_t peak = 0;
+  int64_t clips = 0;
+  int64_t crossings = 0;
+};
+
+// Saturating |x|, matching the SIMD paths (|-32768| -> 32767).
+inline int32_t SatAbs(int32_t x) {
+  return std::min(std::abs(x), 32767);
+}
+
+// Scalar step for sample |i|; |i| must be >= 1.
+inline void AccumulateScalar(const int16_t* samples,
+                             int32_t i,
+                             Accumulators* acc,
+                             int32_t* histogram) {
+  const int32_t x = samples[i];
+  const int32_t prev = samples[i - 1];
+  const int32_t a = SatAbs(x);
+  // Up to 65535, so the square needs 64 bits.
+  const int64_t d = std::abs(x - prev);
+
+  acc->sum_abs += a;
+  acc->sum_sq += a * a;
+  acc->sum_diff_sq += d * d;
+  acc->peak = std::max(acc->peak, a);
+  acc->clips += a >= kClipThreshold;
+  acc->crossings += (x < 0) != (prev < 0);
+  histogram[BinIndexS16(a)]++;
+}
+
+#if defined(AUDIO_DSP_SSE2)
+
+inline int64_t HorizontalSum32(__m128i v) {
+  alignas(16) int32_t lanes[4];
+  _mm_store_si128(reinterpret_cast<__m128i*>(lanes), v);
+  return static_cast<int64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+}
+
+inline int64_t HorizontalSum64(__m128i v) {
+  alignas(16) int64_t lanes[2];
+  _mm_store_si128(reinterpret_cast<__m128i*>(lanes), v);
+  return lanes[0] + lanes[1];
+}
+
+inline int32_t HorizontalMax16(__m128i v) {
+  v = _mm_max_epi16(v, _mm_srli_si128(v, 8));
+  v = _mm_max_epi16(v, _mm_srli_si128(v, 4));
+  v = _mm_max_epi16(v, _mm_srli_si128(v, 2));
+  return static_cast<int16_t>(_mm_cvtsi128_si32(v));
+}
+
+inline __m128i SatAbs(__m128i x) {
+  return _mm_max_epi16(x, _mm_subs_epi16(_mm_setzero_si128(), x));
+}
+
+// Adds the four uint32 lanes of |v| into two int64 lanes.
+inline __m128i AddWide(__m128i acc, __m128i v) {
+  const __m128i zero = _mm_setzero_si128();
+  acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, zero));
+  return _mm_add_epi64(acc, _mm_unpackhi_epi32(v, zero));
+}
+
+// |a - b| per lane as uint16. A saturating subtract would clip steps wider
+// than 32767, which loud broadband audio has plenty of.
+inline __m128i AbsDiff(__m128i a, __m128i b) {
+  return _mm_sub_epi16(_mm_max_epi16(a, b), _mm_min_epi16(a, b));
+}
+
+// Adds the squares of the eight uint16 lanes of |v| into two int64 lanes.
+inline __m128i AddSquares(__m128i acc, __m128i v) {
+  const __m128i lo = _mm_mullo_epi16(v, v);
+  const __m128i hi = _mm_mulhi_epu16(v, v);
+  acc = AddWide(acc, _mm_unpacklo_epi16(lo, hi));
+  return AddWide(acc, _mm_unpackhi_epi16(lo, hi));
+}
+
+// Processes samples [begin, end) eight at a time; returns the first index not
+// consumed. |begin| must be >= 1 so that samples[i - 1] is valid.
+int32_t AccumulateSimd(const int16_t* samples,
+                       int32_t begin,
+                       int32_t end,
+                       Accumulators* acc,
+                       int32_t* histogram) {
+  const __m128i ones = _mm_set1_epi16(1);
+  const __m128i clip_level = _mm_set1_epi16(kClipThreshold - 1);
+  __m128i peak = _mm_set1_epi16(static_cast<int16_t>(acc->peak));
+  __m128i sum_sq = _mm_setzero_si128();
+  __m128i sum_diff_sq = _mm_setzero_si128();
+  alignas(16) int16_t lanes[8];
+
+  int32_t i = begin;
+  while (i + 8 <= end) {
+    const int32_t block_end = std::min(end, i + kFlushBlock);
+    __m128i sum_abs = _mm_setzero_si128();
+    __m128i clips = _mm_setzero_si128();
+    __m128i crossings = _mm_setzero_si128();
+
+    for (; i + 8 <= block_end; i += 8) {
+      const __m128i x =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+      const __m128i prev =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i - 1));
+      const __m128i a = SatAbs(x);
+      const __m128i d = AbsDiff(x, prev);
+
+      // Pairwise multiply-add: each int32 lane is at most 2 * 32767^2.
+      sum_abs = _mm_add_epi32(sum_abs, _mm_madd_epi16(a, ones));
+      sum_sq = AddWide(sum_sq, _mm_madd_epi16(a, a));
+      sum_diff_sq = AddSquares(sum_diff_sq, d);
+      peak = _mm_max_epi16(peak, a);
+
+      // Masks are all-ones (-1) per lane, so subtracting counts.
+      clips = _mm_sub_epi16(clips, _mm_cmpgt_epi16(a, clip_level));
+      crossings = _mm_sub_epi16(
+          crossings, _mm_srai_epi16(_mm_xor_si128(x, prev), 15));
+
+      _mm_store_si128(reinterpret_cast<__m128i*>(lanes), a);
+      for (int lane = 0; lane < 8; lane++) {
+        histogram[BinIndexS16(static_cast<uint32_t>(lanes[lane]))]++;
+      }
+    }
+
+    acc->sum_abs += HorizontalSum32(sum_abs);
+    acc->clips += HorizontalSum32(_mm_madd_epi16(clips, ones));
+    acc->crossings += HorizontalSum32(_mm_madd_epi16(crossings, ones));
+  }
+
+  acc->sum_sq += HorizontalSum64(sum_sq);
+  acc->sum_diff_sq += HorizontalSum64(sum_diff_sq);
+  acc->peak = std::max(acc->peak, HorizontalMax16(peak));
+  return i;
+}
+
+int64_t AbsSum(const int16_t* samples, int32_t count, int32_t* consumed) {
+  const __m128i ones = _mm_set1_epi16(1);
+  int64_t sum = 0;
+  int32_t i = 0;
+  while (i + 8 <= count) {
+    const int32_t block_end = std::min(count, i + kFlushBlock);
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 8 <= block_end; i += 8) {
+      const __m128i x =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(SatAbs(x), ones));
+    }
+    sum += HorizontalSum32(acc);
+  }
+  *consumed = i;
+  return sum;
+}
+
+void ConvertSimd(const int16_t* samples,
+                 int32_t count,
+                 float scale,
+                 float* out,
+                 int32_t* consumed) {
+  const __m128 factor = _mm_set1_ps(scale);
+  const __m128 low = _mm_set1_ps(-1.0f);
+  const __m128 high = _mm_set1_ps(1.0f);
+  int32_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i x =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+    // Sign-extend by unpacking into the high half and shifting back down.
+    const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+    const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+    __m128 f0 = _mm_mul_ps(_mm_cvtepi32_ps(lo), factor);
+    __m128 f1 = _mm_mul_ps(_mm_cvtepi32_ps(hi), factor);
+    f0 = _mm_min_ps(_mm_max_ps(f0, low), high);
+    f1 = _mm_min_ps(_mm_max_ps(f1, low), high);
+    _mm_storeu_ps(out + i, f0);
+    _mm_storeu_ps(out + i + 4, f1);
+  }
+  *consumed = i;
+}
+
+#elif defined(AUDIO_DSP_NEON)
+
+int32_t AccumulateSimd(const int16_t* samples,
+                       int32_t begin,
+                       int32_t end,
+                       Accumulators* acc,
+                       int32_t* histogram) {
+  const int16x8_t clip_level = vdupq_n_s16(kClipThreshold - 1);
+  int16x8_t peak = vdupq_n_s16(static_cast<int16_t>(acc->peak));
+  int64x2_t sum_sq = vdupq_n_s64(0);
+  uint64x2_t sum_diff_sq = vdupq_n_u64(0);
+  int16_t lanes[8];
+
+  int32_t i = begin;
+  while (i + 8 <= end) {
+    const int32_t block_end = std::min(end, i + kFlushBlock);
+    uint32x4_t sum_abs = vdupq_n_u32(0);
+    uint16x8_t clips = vdupq_n_u16(0);
+    uint16x8_t crossings = vdupq_n_u16(0);
+
+    for (; i + 8 <= block_end; i += 8) {
+      const int16x8_t x = vld1q_s16(samples + i);
+      const int16x8_t prev = vld1q_s16(samples + i - 1);
+      const int16x8_t a = vqabsq_s16(x);
+      // The absolute difference is exact as uint16.
+      const uint16x8_t d = vreinterpretq_u16_s16(vabdq_s16(x, prev));
+
+      sum_abs = vpadalq_u16(sum_abs, vreinterpretq_u16_s16(a));
+      sum_sq = vpadalq_s32(sum_sq, vmull_s16(vget_low_s16(a), vget_low_s16(a)));
+      sum_sq = vpadalq_s32(sum_sq, vmull_high_s16(a, a));
+      sum_diff_sq =
+          vpadalq_u32(sum_diff_sq, vmull_u16(vget_low_u16(d), vget_low_u16(d)));
+      sum_diff_sq = vpadalq_u32(sum_diff_sq, vmull_high_u16(d, d));
+      peak = vmaxq_s16(peak, a);
+
+      clips = vsubq_u16(clips, vcgtq_s16(a, clip_level));
+      crossings = vaddq_u16(
+          crossings,
+          vshrq_n_u16(vreinterpretq_u16_s16(veorq_s16(x, prev)), 15));
+
+      vst1q_s16(lanes, a);
+      for (int lane = 0; lane < 8; lane++) {
+        histogram[BinIndexS16(static_cast<uint32_t>(lanes[lane]))]++;
+      }
+    }
+
+    acc->sum_abs += vaddlvq_u32(sum_abs);
+    acc->clips += vaddlvq_u16(clips);
+    acc->crossings += vaddlvq_u16(crossings);
+  }
+
+  acc->sum_sq += vaddvq_s64(sum_sq);
+  acc->sum_diff_sq += static_cast<int64_t>(vaddvq_u64(sum_diff_sq));
+  acc->peak = std::max<int32_t>(acc->peak, vmaxvq_s16(peak));
+  return i;
+}
+
+int64_t AbsSum(const int16_t* samples, int32_t count, int32_t* consumed) {
+  uint64x2_t sum = vdupq_n_u64(0);
+  int32_t i = 0;
+  while (i + 8 <= count) {
+    const int32_t block_end = std::min(count, i + kFlushBlock);
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; i + 8 <= block_end; i += 8) {
+      acc = vpadalq_u16(acc, vreinterpretq_u16_s16(vqabsq_s16(
+                                 vld1q_s16(samples + i))));
+    }
+    sum = vpadalq_u32(sum, acc);
+  }
+  *consumed = i;
+  return static_cast<int64_t>(vaddvq_u64(sum));
+}
+
+void ConvertSimd(const int16_t* samples,
+                 int32_t count,
+                 float scale,
+                 float* out,
+                 int32_t* consumed) {
+  const float32x4_t low = vdupq_n_f32(-1.0f);
+  const float32x4_t high = vdupq_n_f32(1.0f);
+  int32_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const int16x8_t x = vld1q_s16(samples + i);
+    float32x4_t f0 = vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))),
+                                 scale);
+    float32x4_t f1 = vmulq_n_f32(vcvtq_f32_s32(vmovl_high_s16(x)), scale);
+    vst1q_f32(out + i, vminq_f32(vmaxq_f32(f0, low), high));
+    vst1q_f32(out + i + 4, vminq_f32(vmaxq_f32(f1, low), high));
+  }
+  *consumed = i;
+}
+
+#else
+
+int32_t AccumulateSimd(const int16_t*, int32_t begin, int32_t, Accumulators*,
+                       int32_t*) {
+  return begin;
+}
+
+int64_t AbsSum(const int16_t*, int32_t, int32_t* consumed) {
+  *consumed = 0;
+  return 0;
+}
+
+void ConvertSimd(const int16_t*, int32_t, float, float*, int32_t* consumed) {
+  *consumed = 0;
+}
+
+#endif
+
+float FrameLevel(const int16_t* samples, int32_t count) {
+  int32_t i = 0;
+  int64_t sum = AbsSum(samples, count, &i);
+  for (; i < count; i++) sum += SatAbs(samples[i]);
+  return count > 0 ? static_cast<float>(sum * kScale / count) : 0.0f;
+}
+
+}  // namespace
+
+int32_t audio_dsp_compute_quality_metrics_s16(const int16_t* samples,
+                                              int32_t count,
+                                              int32_t sample_rate,
+                                              int32_t* noise_histogram,
+                                              audio_dsp_quality_metrics* out) {
+  if (out == nullptr || count < 0 || (count > 0 && samples == nullptr)) {
+    return -1;
+  }
+
+  std::memset(out, 0, sizeof(*out));
+  int32_t histogram[AUDIO_DSP_NOISE_BINS] = {0};
+  out->sample_count = count;
+
+  if (count > 0) {
+    Accumulators acc;
+
+    // The first sample has no predecessor for the difference terms.
+    const int32_t first_abs = SatAbs(samples[0]);
+    acc.sum_abs = first_abs;
+    acc.sum_sq = first_abs * first_abs;
+    acc.peak = first_abs;
+    acc.clips = first_abs >= kClipThreshold;
+    histogram[BinIndexS16(first_abs)]++;
+
+    int32_t i = AccumulateSimd(samples, 1, count, &acc, histogram);
+    for (; i < count; i++) {
+      AccumulateScalar(samples, i, &acc, histogram);
+    }
+
+    out->mean_abs = acc.sum_abs * kScale / count;
+    out->rms = std::sqrt(static_cast<double>(acc.sum_sq) / count) * kScale;
+    out->peak = acc.peak * kScale;
+    out->clip_count = static_cast<int32_t>(acc.clips);
+    out->zero_crossing_rate = static_cast<double>(acc.crossings) / count;
+
+    // For a tone of frequency f, sum(d^2) / sum(x^2) = 4 sin^2(pi f / fs).
+    if (acc.sum_sq > 0 && sample_rate > 0) {
+      const double ratio =
+          std::sqrt(static_cast<double>(acc.sum_diff_sq) / acc.sum_sq) / 2.0;
+      out->spectral_centroid =
+          sample_rate / kPi * std::asin(std::min(1.0, ratio));
+    }
+
+    out->noise_floor = audio_dsp_histogram_quantile(histogram, 0.1);
+  }
+
+  if (noise_histogram != nullptr) {
+    std::memcpy(noise_histogram, histogram, sizeof(histogram));
+  }
+  return 0;
+}
+
+int32_t audio_dsp_frame_levels_s16(const int16_t* samples,
+                                   int32_t count,
+                                   int32_t frame_samples,
+                                   float* levels) {
+  if (frame_samples <= 0 || count < 0 || levels == nullptr ||
+      (count > 0 && samples == nullptr)) {
+    return -1;
+  }
+
+  const int32_t frames = count / frame_samples;
+  for (int32_t f = 0; f < frames; f++) {
+    levels[f] = FrameLevel(samples + f * frame_samples, frame_samples);
+  }
+  return frames;
+}
+
+int32_t audio_dsp_pcm16_to_float(const int16_t* samples,
+                                 int32_t count,
+                                 float gain,
+                                 float* out) {
+  if (count < 0 || (count > 0 && (samples == nullptr || out == nullptr))) {
+    return -1;
+  }
+
+  const float scale = gain / 32768.0f;
+  int32_t i = 0;
+  ConvertSimd(samples, count, scale, out, &i);
+  for (; i < count; i++) {
+    out[i] = std::clamp(samples[i] * scale, -1.0f, 1.0f);
+  }
+  return 0;
+}
@@ -0,0 +1,363 @@
+#include "audio/audio_vad.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <new>
+#include <vector>
+
+#include "audio/audio_dsp.h"
+
+namespace {
+
+// Noise floor starts at -60 dBFS and never drops below -100 dBFS.
+constexpr float kInitialNoise = 1e-3f;
+constexpr float kMinNoise = 1e-5f;
+
+// Upward drift of the noise tracker while no speech is active, and while
+// speech is. The floor drops to any quieter frame at once, and speech has
+// quiet frames between words, so in speech it stays near the real floor;
+// steady noise loud enough to open a region has none and carries the
+// floor up to itself, which closes the region.
+constexpr float kNoiseRiseDbPerSecond = 3.0f;
+constexpr float kSpeechNoiseRiseDbPerSecond = 2.0f;
+
+// Slope of the logistic mapping from frame SNR to speech probability.
+constexpr float kProbabilitySlopeDb = 3.0f;
+
+}  // namespace
+
+struct audio_vad {
+  audio_vad_config config;
+  float noise_rise;
+  float speech_noise_rise;
+
+  // Absolute-sample sum of the partial frame carried between calls.
+  double pending_sum = 0.0;
+  int32_t pending_count = 0;
+
+  std::vector<float> levels;
+  std::deque<audio_vad_region> ready;
+
+  // Sample position of frame 0 and number of frames decided since then.
+  int64_t base_sample = 0;
+  int64_t frames = 0;
+
+  float noise = kInitialNoise;
+  bool in_speech = false;
+
+  // Candidate onset run while closed.
+  int32_t onset_run = 0;
+  int64_t onset_start_frame = 0;
+  double onset_prob_sum = 0.0;
+  double onset_level_sum = 0.0;
+
+  // Open region.
+  int64_t region_start_frame = 0;
+  int64_t last_active_frame = 0;
+  int32_t active_frames = 0;
+  int32_t silence_run = 0;
+  double prob_sum = 0.0;
+  double level_sum = 0.0;
+};
+
+namespace {
+
+float FrameSnrDb(float level, float noise) {
+  if (level <= 0.0f) return -100.0f;
+  return 20.0f * std::log10(level / noise);
+}
+
+float SpeechProbability(const audio_vad_config& config, float snr_db) {
+  const float centre = 0.5f * (config.onset_snr_db + config.offset_snr_db);
+  return 1.0f / (1.0f + std::exp(-(snr_db - centre) / kProbabilitySlopeDb));
+}
+
+audio_vad_region OpenRegion(const audio_vad* vad) {
+  const int32_t frame_samples = vad->config.frame_samples;
+  audio_vad_region region;
+  region.start_sample =
+      vad->base_sample + vad->region_start_frame * frame_samples;
+  region.end_sample =
+      vad->base_sample + (vad->last_active_frame + 1) * frame_samples;
+  region.confidence = static_cast<float>(vad->prob_sum / vad->active_frames);
+  region.mean_level = static_cast<float>(vad->level_sum / vad->active_frames);
+  return region;
+}
+
+void CloseRegion(audio_vad* vad) {
+  if (vad->active_frames >= vad->config.min_speech_frames) {
+    vad->ready.push_back(OpenRegion(vad));
+  }
+
+  vad->in_speech = false;
+  vad->onset_run = 0;
+  vad->active_frames = 0;
+  vad->silence_run = 0;
+  vad->prob_sum = 0.0;
+  vad->level_sum = 0.0;
+}
+
+void ProcessFrame(audio_vad* vad, float level) {
+  const audio_vad_config& config = vad->config;
+  const int64_t frame = vad->frames++;
+
+  // Noise floor: follows drops immediately, rises slowly, slower in speech.
+  if (level < vad->noise) {
+    vad->noise = std::max(level, kMinNoise);
+  } else {
+    const float rise =
+        vad->in_speech ? vad->speech_noise_rise : vad->noise_rise;
+    vad->noise = std::min(vad->noise * rise, level);
+  }
+
+  const float snr_db = FrameSnrDb(level, vad->noise);
+  const float probability = SpeechProbability(config, snr_db);
+
+  if (!vad->in_speech) {
+    const bool onset =
+        level >= config.onset_level && snr_db >= config.onset_snr_db;
+    if (!onset) {
+      vad->onset_run = 0;
+      return;
+    }
+
+    if (vad->onset_run == 0) {
+      vad->onset_start_frame = frame;
+      vad->onset_prob_sum = 0.0;
+      vad->onset_level_sum = 0.0;
+    }
+    vad->onset_run++;
+    vad->onset_prob_sum += probability;
+    vad->onset_level_sum += level;
+
+    if (vad->onset_run >= config.onset_frames) {
+      vad->in_speech = true;
+      vad->region_start_frame = vad->onset_start_frame;
+      vad->last_active_frame = frame;
+      vad->active_frames = vad->onset_run;
+      vad->prob_sum = vad->onset_prob_sum;
+      vad->level_sum = vad->onset_level_sum;
+      vad->silence_run = 0;
+      vad->onset_run = 0;
+    }
+    return;
+  }
+
+  const bool sustain =
+      level >= config.offset_level && snr_db >= config.offset_snr_db;
+  if (sustain) {
+    vad->last_active_frame = frame;
+    vad->active_frames++;
+    vad->prob_sum += probability;
+    vad->level_sum += level;
+    vad->silence_run = 0;
+  } else if (++vad->silence_run > config.hangover_frames) {
+    CloseRegion(vad);
+  }
+}
+
+inline float SampleMagnitude(float sample) {
+  return std::fabs(sample);
+}
+
+inline float SampleMagnitude(int16_t sample) {
+  return std::fabs(static_cast<float>(sample)) * (1.0f / 32768.0f);
+}
+
+inline int32_t FrameLevels(const float* samples,
+                           int32_t count,
+                           int32_t frame_samples,
+                           float* levels) {
+  return audio_dsp_frame_levels(samples, count, frame_samples, levels);
+}
+
+inline int32_t FrameLevels(const int16_t* samples,
+                           int32_t count,
+                           int32_t frame_samples,
+                           float* levels) {
+  return audio_dsp_frame_levels_s16(samples, count, frame_samples, levels);
+}
+
+// Feeds float or int16 samples; both produce levels in the same units.
+template <typename Sample>
+void ProcessSamples(audio_vad* vad, const Sample* samples, int32_t count) {
+  const int32_t frame_samples = vad->config.frame_samples;
+  int32_t offset = 0;
+
+  // Complete a partial frame left over from the previous call.
+  if (vad->pending_count > 0) {
+    const int32_t take =
+        std::min(frame_samples - vad->pending_count, count);
+    for (; offset < take; offset++) {
+      vad->pending_sum += SampleMagnitude(samples[offset]);
+    }
+    vad->pending_count += take;
+
+    if (vad->pending_count < frame_samples) return;
+    ProcessFrame(vad, static_cast<float>(vad->pending_sum / frame_samples));
+    vad->pending_sum = 0.0;
+    vad->pending_count = 0;
+  }
+
+  const int32_t frames = (count - offset) / frame_samples;
+  if (frames > 0) {
+    vad->levels.resize(frames);
+    FrameLevels(samples + offset, frames * frame_samples, frame_samples,
+                vad->levels.data());
+    for (int32_t f = 0; f < frames; f++) ProcessFrame(vad, vad->levels[f]);
+    offset += frames * frame_samples;
+  }
+
+  for (; offset < count; offset++) {
+    vad->pending_sum += SampleMagnitude(samples[offset]);
+    vad->pending_count++;
+  }
+}
+
+int32_t DrainRegions(audio_vad* vad,
+                     audio_vad_region* regions,
+                     int32_t max_regions) {
+  int32_t written = 0;
+  while (written < max_regions && !vad->ready.empty()) {
+    regions[written++] = vad->ready.front();
+    vad->ready.pop_front();
+  }
+  return written;
+}
+
+}  // namespace
+
+void audio_vad_default_config(int32_t sample_rate, audio_vad_config* config) {
+  if (config == nullptr) return;
+
+  const int32_t rate = sample_rate > 0 ? sample_rate : 16000;
+  const int32_t frame_ms = 20;
+
+  config->sample_rate = rate;
+  config->frame_samples = rate * frame_ms / 1000;
+  config->onset_level = 0.01f;
+  config->offset_level = 0.006f;
+  config->onset_snr_db = 9.0f;
+  config->offset_snr_db = 4.0f;
+  config->onset_frames = 60 / frame_ms;
+  config->hangover_frames = 300 / frame_ms;
+  config->min_speech_frames = 200 / frame_ms;
+}
+
+audio_vad* audio_vad_create(const audio_vad_config* config) {
+  if (config == nullptr || config->sample_rate <= 0 ||
+      config->frame_samples <= 0 || config->onset_frames <= 0 ||
+      config->hangover_frames < 0 || config->min_speech_frames < 0) {
+    return nullptr;
+  }
+
+  audio_vad* vad = new (std::nothrow) audio_vad();
+  if (vad == nullptr) return nullptr;
+
+  vad->config = *config;
+  const float frames_per_second =
+      static_cast<float>(config->sample_rate) / config->frame_samples;
+  vad->noise_rise =
+      std::pow(10.0f, kNoiseRiseDbPerSecond / 20.0f / frames_per_second);
+  vad->speech_noise_rise = std::pow(
+      10.0f, kSpeechNoiseRiseDbPerSecond / 20.0f / frames_per_second);
+  return vad;
+}
+
+void audio_vad_free(audio_vad* vad) {
+  delete vad;
+}
+
+void audio_vad_reset(audio_vad* vad) {
+  if (vad == nullptr) return;
+
+  const audio_vad_config config = vad->config;
+  const float noise_rise = vad->noise_rise;
+  const float speech_noise_rise = vad->speech_noise_rise;
+  *vad = audio_vad();
+  vad->config = config;
+  vad->noise_rise = noise_rise;
+  vad->speech_noise_rise = speech_noise_rise;
+}
+
+int32_t audio_vad_process(audio_vad* vad,
+                          const float* samples,
+                          int32_t count,
+                          audio_vad_region* regions,
+                          int32_t max_regions) {
+  if (vad == nullptr || count < 0 || (count > 0 && samples == nullptr) ||
+      (max_regions > 0 && regions == nullptr)) {
+    return -1;
+  }
+
+  ProcessSamples(vad, samples, count);
+  return DrainRegions(vad, regions, max_regions);
+}
+
+int32_t audio_vad_process_s16(audio_vad* vad,
+                              const int16_t* samples,
+                              int32_t count,
+                              audio_vad_region* regions,
+                              int32_t max_regions) {
+  if (vad == nullptr || count < 0 || (count > 0 && samples == nullptr) ||
+      (max_regions > 0 && regions == nullptr)) {
+    return -1;
+  }
+
+  ProcessSamples(vad, samples, count);
+  return DrainRegions(vad, regions, max_regions);
+}
+
+int32_t audio_vad_process_levels(audio_vad* vad,
+                                 const float* levels,
+                                 int32_t frame_count,
+                                 audio_vad_region* regions,
+                                 int32_t max_regions) {
+  if (vad == nullptr || frame_count < 0 ||
+      (frame_count > 0 && levels == nullptr) ||
+      (max_regions > 0 && regions == nullptr)) {
+    return -1;
+  }
+
+  for (int32_t f = 0; f < frame_count; f++) ProcessFrame(vad, levels[f]);
+  return DrainRegions(vad, regions, max_regions);
+}
+
+int32_t audio_vad_flush(audio_vad* vad,
+                        audio_vad_region* regions,
+                        int32_t max_regions) {
+  if (vad == nullptr || (max_regions > 0 && regions == nullptr)) return -1;
+
+  if (vad->in_speech) CloseRegion(vad);
+  vad->onset_run = 0;
+
+  // Restart frame numbering after the discarded partial frame.
+  vad->base_sample = audio_vad_position(vad);
+  vad->frames = 0;
+  vad->pending_sum = 0.0;
+  vad->pending_count = 0;
+
+  return DrainRegions(vad, regions, max_regions);
+}
+
+int64_t audio_vad_position(const audio_vad* vad) {
+  if (vad == nullptr) return 0;
+  return vad->base_sample + vad->frames * vad->config.frame_samples +
+         vad->pending_count;
+}
+
+int32_t audio_vad_in_speech(const audio_vad* vad) {
+  return vad != nullptr && vad->in_speech ? 1 : 0;
+}
+
+int32_t audio_vad_open_region(const audio_vad* vad,
+                              audio_vad_region* region) {
+  if (vad == nullptr || region == nullptr || !vad->in_speech) return 0;
+  *region = OpenRegion(vad);
+  return 1;
+}
+
+float audio_vad_noise_level(const audio_vad* vad) {
+  return vad != nullptr ? vad->noise : 0.0f;
+}
@@ -0,0 +1,104 @@
+#ifndef MEETING_NATIVE_AUDIO_AUDIO_VAD_H_
+#define MEETING_NATIVE_AUDIO_AUDIO_VAD_H_
+
+#include <stdint.h>
+
+#include "common/native_export.h"
+
+// Frame-level voice activity detector with onset/offset hysteresis.
+//
+// The detector consumes a stream of per-frame levels (mean absolute
+// amplitude). Levels can be produced from float samples with
+// audio_vad_process(), or by any other feature producer and passed to
+// audio_vad_process_levels(), so all DSP paths share one decision stage.
+// Completed regions are emitted incrementally as audio arrives.
+
+// Mirrored by NativeVadConfig in lib/core/audio/audio_dsp_ffi.dart.
+typedef struct audio_vad_config {
+  int32_t sample_rate;
+  // Samples per analysis frame (e.g. 320 = 20 ms at 16 kHz).
+  int32_t frame_samples;
+  // Minimum frame level required to open / keep open a region.
+  float onset_level;
+  float offset_level;
+  // Required distance above the tracked noise floor, in dB.
+  float onset_snr_db;
+  float offset_snr_db;
+  // Consecutive active frames required before a region opens.
+  int32_t onset_frames;
+  // Consecutive inactive frames tolerated before a region closes.
+  int32_t hangover_frames;
+  // Regions with fewer active frames than this are discarded.
+  int32_t min_speech_frames;
+} audio_vad_config;
+
+// Mirrored by NativeVadRegion in lib/core/audio/audio_dsp_ffi.dart.
+typedef struct audio_vad_region {
+  // Sample positions relative to the first sample fed after create/reset.
+  int64_t start_sample;
+  int64_t end_sample;
+  // Mean per-frame speech probability over the region's active frames.
+  float confidence;
+  // Mean frame level over the region's active frames.
+  float mean_level;
+} audio_vad_region;
+
+typedef struct audio_vad audio_vad;
+
+// Fills |config| with defaults for |sample_rate|.
+NATIVE_API void audio_vad_default_config(int32_t sample_rate,
+                                         audio_vad_config* config);
+
+// Returns null on invalid configuration.
+NATIVE_API audio_vad* audio_vad_create(const audio_vad_config* config);
+
+NATIVE_API void audio_vad_free(audio_vad* vad);
+
+NATIVE_API void audio_vad_reset(audio_vad* vad);
+
+// Feeds |count| samples. Partial frames are buffered internally. Up to
+// |max_regions| completed regions are written to |regions|; any overflow is
+// kept and returned by the next call. Returns the number written, or -1 on
+// invalid arguments.
+NATIVE_API int32_t audio_vad_process(audio_vad* vad,
+                                     const float* samples,
+                                     int32_t count,
+                                     audio_vad_region* regions,
+                                     int32_t max_regions);
+
+// Same as audio_vad_process() for 16-bit PCM; levels are computed with the
+// fixed-point kernel and match the float path's units.
+NATIVE_API int32_t audio_vad_process_s16(audio_vad* vad,
+                                         const int16_t* samples,
+                                         int32_t count,
+                                         audio_vad_region* regions,
+                                         int32_t max_regions);
+
+// Feeds |frame_count| precomputed frame levels (one per frame_samples).
+NATIVE_API int32_t audio_vad_process_levels(audio_vad* vad,
+                                            const float* levels,
+                                            int32_t frame_count,
+                                            audio_vad_region* regions,
+                                            int32_t max_regions);
+
+// Closes any open region at the current position and drains pending
+// regions. Buffered partial-frame samples are discarded.
+NATIVE_API int32_t audio_vad_flush(audio_vad* vad,
+                                   audio_vad_region* regions,
+                                   int32_t max_regions);
+
+// Number of samples consumed since create/reset.
+NATIVE_API int64_t audio_vad_position(const audio_vad* vad);
+
+// 1 while a region is open, 0 otherwise.
+NATIVE_API int32_t audio_vad_in_speech(const audio_vad* vad);
+
+// Fills |region| with the currently open region, ending after its last
+// active frame, and returns 1. Returns 0 when no region is open.
+NATIVE_API int32_t audio_vad_open_region(const audio_vad* vad,
+                                         audio_vad_region* region);
+
+// Current noise-floor estimate (frame level units).
+NATIVE_API float audio_vad_noise_level(const audio_vad* vad);
+
+#endif  // MEETING_NATIVE_AUDIO_AUDIO_VAD_H_
@@ -0,0 +1,101 @@
+#include "common/mapped_file.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+#include <string>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace native_common {
+
+#if defined(_WIN32)
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) UnmapViewOfFile(data_);
+  if (mapping_ != nullptr) CloseHandle(mapping_);
+}
+
+bool MappedFile::Open(const char* path, bool prefetch) {
+  const int wide_size = MultiByteToWideChar(CP_UTF8, 0, path, -1, nullptr, 0);
+  if (wide_size <= 0) return false;
+  std::wstring wide_path(static_cast<size_t>(wide_size), L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, path, -1, &wide_path[0], wide_size);
+
+  HANDLE file = CreateFileW(wide_path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  mapping_ = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping_ == nullptr) return false;
+
+  void* view = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+  if (view == nullptr) return false;
+  data_ = static_cast<const uint8_t*>(view);
+  size_ = static_cast<size_t>(file_size.QuadPart);
+
+  if (prefetch) {
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = view;
+    range.NumberOfBytes = size_;
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+  }
+  return true;
+}
+
+#else
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    munmap(const_cast<uint8_t*>(data_), size_);
+  }
+}
+
+bool MappedFile::Open(const char* path, bool prefetch) {
+  const int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+  const size_t size = static_cast<size_t>(info.st_size);
+
+  int flags = MAP_SHARED;
+#if defined(MAP_POPULATE)
+  if (prefetch) flags |= MAP_POPULATE;
+#endif
+  void* addr = mmap(nullptr, size, PROT_READ, flags, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) return false;
+
+  // Callers read front to back exactly once: read ahead aggressively and
+  // let the kernel drop pages behind the cursor.
+  madvise(addr, size, MADV_SEQUENTIAL);
+#if !defined(MAP_POPULATE)
+  if (prefetch) madvise(addr, size, MADV_WILLNEED);
+#endif
+
+  data_ = static_cast<const uint8_t*>(addr);
+  size_ = size;
+  return true;
+}
+
+#endif
+
+}  // namespace native_common
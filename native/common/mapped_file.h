@@ -0,0 +1,42 @@
+#ifndef MEETING_NATIVE_COMMON_MAPPED_FILE_H_
+#define MEETING_NATIVE_COMMON_MAPPED_FILE_H_
+
+// File mapping shared by the native libraries. Not part of the C ABI.
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace native_common {
+
+// Read-only memory mapping of a whole file.
+//
+// Pages come straight from the OS page cache, so a file that was read
+// recently (by this process or another one, e.g. the batch runner) is read
+// without touching the disk, and nothing is staged through a heap buffer.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Maps |path|, to be read front to back. With |prefetch| the whole file
+  // is faulted in up front (MAP_POPULATE / PrefetchVirtualMemory) instead
+  // of on first access.
+  bool Open(const char* path, bool prefetch);
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+#if defined(_WIN32)
+  void* mapping_ = nullptr;
+#endif
+};
+
+}  // namespace native_common
+
+#endif  // MEETING_NATIVE_COMMON_MAPPED_FILE_H_
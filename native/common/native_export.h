@@ -0,0 +1,20 @@
+#ifndef MEETING_NATIVE_COMMON_NATIVE_EXPORT_H_
+#define MEETING_NATIVE_COMMON_NATIVE_EXPORT_H_
+
+// Symbols marked NATIVE_EXPORT form the flat C ABI looked up from Dart via
+// dart:ffi. Everything else is built with hidden visibility.
+#if defined(_WIN32)
+#define NATIVE_EXPORT __declspec(dllexport)
+#else
+#define NATIVE_EXPORT __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+#define NATIVE_EXTERN_C extern "C"
+#else
+#define NATIVE_EXTERN_C
+#endif
+
+#define NATIVE_API NATIVE_EXTERN_C NATIVE_EXPORT
+
+#endif  // MEETING_NATIVE_COMMON_NATIVE_EXPORT_H_
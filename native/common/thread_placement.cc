@@ -0,0 +1,37 @@
+#include "common/thread_placement.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <sys/qos.h>
+#else
+#include <sched.h>
+#endif
+
+namespace native_common {
+
+void PlaceCurrentThread(const std::vector<int32_t>& cpus) {
+#if defined(_WIN32)
+  DWORD_PTR mask = 0;
+  for (const int32_t cpu : cpus) {
+    if (cpu < 64) mask |= static_cast<DWORD_PTR>(1) << cpu;
+  }
+  if (mask != 0) SetThreadAffinityMask(GetCurrentThread(), mask);
+#elif defined(__APPLE__)
+  // Keeps the thread on performance cores.
+  pthread_set_qos_class_self_np(QOS_CLASS_USER_INITIATED, 0);
+#else
+  if (cpus.empty()) return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const int32_t cpu : cpus) {
+    if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+  }
+  sched_setaffinity(0, sizeof(set), &set);
+#endif
+}
+
+}  // namespace native_common
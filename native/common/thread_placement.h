@@ -0,0 +1,22 @@
+#ifndef MEETING_NATIVE_COMMON_THREAD_PLACEMENT_H_
+#define MEETING_NATIVE_COMMON_THREAD_PLACEMENT_H_
+
+// Inference thread placement shared by the native libraries. Not part of
+// the C ABI.
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace native_common {
+
+// Pins the calling thread to the logical CPUs |cpus|. A thread's affinity
+// is inherited by the threads it starts, so pinning a worker also places
+// the ggml compute threads it runs. Does nothing when |cpus| is empty. On
+// Apple platforms, which do not support affinity, the thread is kept on
+// performance cores through its QoS class instead, whatever |cpus| holds.
+void PlaceCurrentThread(const std::vector<int32_t>& cpus);
+
+}  // namespace native_common
+
+#endif  // MEETING_NATIVE_COMMON_THREAD_PLACEMENT_H_
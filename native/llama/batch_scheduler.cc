@@ -0,0 +1,499 @@
+#include "llama/batch_scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "llama/llama_context.h"
+#include "llama/speculative.h"
+
+namespace llama_shim {
+
+namespace {
+
+// Length of the prefix every task's prompt starts with, short of the last
+// token of any: each task evaluates at least that one itself, as its
+// completion starts from its logits.
+size_t CommonPrefix(const std::vector<BatchTask>& tasks) {
+  const std::vector<int32_t>& first = tasks.front().tokens;
+  size_t common = first.size();
+  for (const BatchTask& task : tasks) {
+    size_t n = 0;
+    while (n < common && n < task.tokens.size() &&
+           task.tokens[n] == first[n]) {
+      ++n;
+    }
+    common = std::min(n, task.tokens.size() - 1);
+  }
+  return common;
+}
+
+// Appends |token| at |pos| of every sequence in |seqs| to |batch|, without
+// logits.
+void BatchAddShared(llama_batch* batch,
+                    llama_token token,
+                    llama_pos pos,
+                    const std::vector<llama_seq_id>& seqs) {
+  const int32_t i = batch->n_tokens;
+  batch->token[i] = token;
+  batch->pos[i] = pos;
+  batch->n_seq_id[i] = static_cast<int32_t>(seqs.size());
+  for (size_t s = 0; s < seqs.size(); ++s) batch->seq_id[i][s] = seqs[s];
+  batch->logits[i] = false;
+  ++batch->n_tokens;
+}
+
+}  // namespace
+
+// A completion in flight, in a sequence of its own.
+struct BatchScheduler::Task {
+  Job* job = nullptr;
+  int32_t index = 0;
+  llama_seq_id seq = kMainSequence;
+  // The prompt, followed by the tokens sampled so far.
+  std::vector<int32_t> tokens;
+  int32_t n_prompt = 0;
+  // Leading tokens of |tokens| in the sequence's cache.
+  int32_t n_evaluated = 0;
+  // Leading cache cells the sequence shares with the context's own.
+  int32_t shared = 0;
+  int32_t budget = 0;
+  int32_t n_generated = 0;
+  // Index of the task's logits in the last batch, or -1.
+  int32_t output = -1;
+  llama_sampler* chain = nullptr;
+  llama_sampler* grammar = nullptr;
+  bool active = false;
+
+  // Whether the whole prompt is evaluated and the last token sampled.
+  bool generating() const { return n_generated > 0; }
+  // Whether the cache holds every token but the last sampled, the next
+  // input; not so while a preempted task reads its tokens in again.
+  bool caught_up() const {
+    return generating() &&
+           n_evaluated + 1 == static_cast<int32_t>(tokens.size());
+  }
+};
+
+struct BatchScheduler::Job {
+  BatchJob spec;
+  std::vector<Task> tasks;
+  // Prompt tokens the tasks share, read onto the context's sequence.
+  int32_t shared = 0;
+  int32_t n_running = 0;
+  bool ended = false;
+  // Background job whose tasks gave up their sequences to a foreground
+  // job; they read their tokens in again when resumed.
+  bool preempted = false;
+};
+
+// Cells |job|'s running tasks take beyond the first |main| of the
+// context's sequence, which they may share, counting full completions.
+int64_t BatchScheduler::Cells(const Job& job, int32_t main) {
+  int64_t cells = 0;
+  for (const Task& task : job.tasks) {
+    if (!task.active) continue;
+    cells += task.n_prompt + task.budget - std::min(task.shared, main);
+  }
+  return cells;
+}
+
+int64_t BatchScheduler::RunningCells(int32_t main) const {
+  int64_t cells = 0;
+  for (const std::unique_ptr<Job>& job : jobs_) {
+    if (!job->preempted) cells += Cells(*job, main);
+  }
+  return cells;
+}
+
+bool BatchScheduler::Running() const {
+  return std::any_of(
+      jobs_.begin(), jobs_.end(),
+      [](const std::unique_ptr<Job>& job) { return !job->preempted; });
+}
+
+BatchScheduler::BatchScheduler(meeting_llama* ctx)
+    : ctx_(ctx), sequences_(MEETING_LLAMA_MAX_TASKS, false) {
+  batch_capacity_ = std::max(
+      static_cast<int32_t>(llama_n_batch(ctx->context)), kMaxSequences);
+  batch_ = llama_batch_init(batch_capacity_, 0, kMaxSequences);
+}
+
+BatchScheduler::~BatchScheduler() {
+  for (const std::unique_ptr<Job>& job : jobs_) {
+    if (!job->ended) EndJob(job.get(), BatchResult::kCancelled, nullptr);
+  }
+  llama_batch_free(batch_);
+}
+
+BatchScheduler::Admission BatchScheduler::Admit(BatchJob* spec) {
+  const auto n_tasks = static_cast<int32_t>(spec->tasks.size());
+  for (const BatchTask& task : spec->tasks) {
+    if (task.tokens.empty()) {
+      spec->observer->OnJobDone(BatchResult::kFailed, "empty prompt");
+      return Admission::kStarted;
+    }
+  }
+
+  const auto common = static_cast<int32_t>(CommonPrefix(spec->tasks));
+  const std::vector<int32_t>& prefix = spec->tasks.front().tokens;
+  const auto held = static_cast<int32_t>(ctx_->tokens.size());
+  int32_t keep = 0;
+  while (keep < held && keep < common && ctx_->tokens[keep] == prefix[keep]) {
+    ++keep;
+  }
+  int64_t completions = 0;
+  for (const BatchTask& task : spec->tasks) completions += task.max_tokens;
+  const int32_t n_ctx = meeting_llama_n_ctx(ctx_);
+
+  // A foreground job takes what it lacks from the background jobs, newest
+  // first, rather than wait for them.
+  int64_t cells = 0;
+  for (;;) {
+    // Cells for the running jobs once the context's sequence holds this
+    // job's prefix, and for its prompts; its completions come on top.
+    cells = common + RunningCells(keep);
+    for (const BatchTask& task : spec->tasks) {
+      cells += static_cast<int64_t>(task.tokens.size()) - common;
+    }
+    const bool fits =
+        extending_ == nullptr &&
+        std::count(sequences_.begin(), sequences_.end(), false) >= n_tasks &&
+        (cells + completions <= n_ctx || !Running());
+    if (fits) break;
+    // Preempting does not hurry a foreground job extending the prefix.
+    const bool helps = !spec->background &&
+                       (extending_ == nullptr || extending_->spec.background);
+    if (!helps || !PreemptBackground()) return Admission::kWait;
+  }
+  int64_t share = INT32_MAX;
+  if (cells + completions > n_ctx) {
+    if (n_ctx - cells < n_tasks) {
+      spec->observer->OnJobDone(BatchResult::kFailed,
+                                "prompts do not fit in the context");
+      return Admission::kStarted;
+    }
+    share = (n_ctx - cells) / n_tasks;
+  }
+
+  if (meeting_llama_truncate(ctx_, keep) != 0) {
+    meeting_llama_reset(ctx_);
+    keep = 0;
+  }
+  for (const std::unique_ptr<Job>& job : jobs_) {
+    for (Task& task : job->tasks) task.shared = std::min(task.shared, keep);
+  }
+
+  auto job = std::make_unique<Job>();
+  job->spec = std::move(*spec);
+  job->shared = common;
+  job->tasks.resize(job->spec.tasks.size());
+  for (int32_t i = 0; i < n_tasks; ++i) {
+    BatchTask& spec_task = job->spec.tasks[i];
+    Task& task = job->tasks[i];
+    task.job = job.get();
+    task.index = i;
+    task.tokens = std::move(spec_task.tokens);
+    task.n_prompt = static_cast<int32_t>(task.tokens.size());
+    task.n_evaluated = keep;
+    task.shared = common;
+    task.budget = static_cast<int32_t>(
+        std::min<int64_t>(spec_task.max_tokens, share));
+  }
+  Job* started = job.get();
+  jobs_.push_back(std::move(job));
+  if (started->spec.n_threads > 0) UseThreads(ctx_, started->spec.n_threads);
+  for (int32_t i = 0; i < n_tasks && !started->ended; ++i) {
+    StartTask(started, i);
+  }
+  if (!started->ended && common > keep) extending_ = started;
+  RemoveFinishedJobs();
+  return Admission::kStarted;
+}
+
+void BatchScheduler::TakeSequence(Task* task) {
+  const auto free =
+      std::find(sequences_.begin(), sequences_.end(), false) -
+      sequences_.begin();
+  sequences_[free] = true;
+  task->seq = kMainSequence + 1 + static_cast<llama_seq_id>(free);
+  llama_kv_cache_seq_rm(ctx_->context, task->seq, -1, -1);
+  if (task->n_evaluated > 0) {
+    llama_kv_cache_seq_cp(ctx_->context, kMainSequence, task->seq, 0,
+                          task->n_evaluated);
+  }
+}
+
+void BatchScheduler::ReleaseSequence(Task* task) {
+  if (task->seq == kMainSequence) return;
+  llama_kv_cache_seq_rm(ctx_->context, task->seq, -1, -1);
+  sequences_[task->seq - kMainSequence - 1] = false;
+  task->seq = kMainSequence;
+}
+
+void BatchScheduler::StartTask(Job* job, int32_t index) {
+  Task& task = job->tasks[index];
+  TakeSequence(&task);
+  task.active = true;
+  ++job->n_running;
+
+  task.chain = CreateSampler(job->spec.temperature, job->spec.top_k,
+                             job->spec.top_p, MEETING_LLAMA_RANDOM_SEED);
+  if (task.chain == nullptr) {
+    EndJob(job, BatchResult::kFailed, "out of memory");
+    return;
+  }
+  const std::string& grammar = job->spec.tasks[index].grammar;
+  if (!grammar.empty()) {
+    task.grammar = InstantiateGrammar(ctx_, grammar.c_str());
+    if (task.grammar == nullptr) {
+      EndJob(job, BatchResult::kFailed, meeting_llama_last_error(ctx_));
+      return;
+    }
+  }
+}
+
+bool BatchScheduler::PreemptBackground() {
+  for (auto it = jobs_.rbegin(); it != jobs_.rend(); ++it) {
+    Job* job = it->get();
+    if (!job->spec.background || job->preempted || job->ended) continue;
+    for (Task& task : job->tasks) {
+      if (!task.active) continue;
+      ReleaseSequence(&task);
+      // What it had of the context's sequence is still there.
+      task.shared = std::min(task.shared, task.n_evaluated);
+      task.n_evaluated = 0;
+    }
+    if (extending_ == job) extending_ = nullptr;
+    job->preempted = true;
+    return true;
+  }
+  return false;
+}
+
+bool BatchScheduler::Resume(Job* job) {
+  int32_t n_active = 0;
+  for (const Task& task : job->tasks) n_active += task.active ? 1 : 0;
+  if (std::count(sequences_.begin(), sequences_.end(), false) < n_active) {
+    return false;
+  }
+
+  const int32_t n_ctx = meeting_llama_n_ctx(ctx_);
+  if (!Running()) {
+    // Alone, it needs no more of the context's sequence than it shares.
+    int32_t shared = 0;
+    for (const Task& task : job->tasks) {
+      if (task.active) shared = std::max(shared, task.shared);
+    }
+    if (static_cast<int32_t>(ctx_->tokens.size()) > shared &&
+        meeting_llama_truncate(ctx_, shared) != 0) {
+      meeting_llama_reset(ctx_);
+    }
+    const auto held = static_cast<int32_t>(ctx_->tokens.size());
+    for (const std::unique_ptr<Job>& other : jobs_) {
+      for (Task& task : other->tasks) {
+        task.shared = std::min(task.shared, held);
+      }
+    }
+    // And its completions shorten to what room there is, as when it was
+    // admitted alone.
+    int64_t fixed = held;
+    for (const Task& task : job->tasks) {
+      if (task.active) fixed += task.n_prompt - task.shared;
+    }
+    const int64_t share = (n_ctx - fixed) / n_active;
+    for (Task& task : job->tasks) {
+      if (!task.active) continue;
+      if (share <= task.n_generated) {
+        EndJob(job, BatchResult::kFailed, "context full");
+        return false;
+      }
+      task.budget = static_cast<int32_t>(
+          std::min<int64_t>(task.budget, share));
+    }
+  }
+  const auto held = static_cast<int32_t>(ctx_->tokens.size());
+  if (held + RunningCells(held) + Cells(*job, held) > n_ctx) return false;
+
+  for (Task& task : job->tasks) {
+    if (!task.active) continue;
+    task.n_evaluated = task.shared;
+    TakeSequence(&task);
+  }
+  job->preempted = false;
+  return true;
+}
+
+void BatchScheduler::EndJob(Job* job, BatchResult result, const char* error) {
+  for (Task& task : job->tasks) {
+    if (task.chain != nullptr) llama_sampler_free(task.chain);
+    if (task.grammar != nullptr) llama_sampler_free(task.grammar);
+    task.chain = task.grammar = nullptr;
+    ReleaseSequence(&task);
+    task.active = false;
+  }
+  if (extending_ == job) extending_ = nullptr;
+  job->n_running = 0;
+  job->ended = true;
+  job->spec.observer->OnJobDone(result, error);
+}
+
+void BatchScheduler::Advance(Task* task, int32_t token) {
+  Job* job = task->job;
+  bool more = false;
+  if (!llama_token_is_eog(ctx_->model, token)) {
+    ++task->n_generated;
+    task->tokens.push_back(token);
+    job->spec.observer->OnToken(task->index, task->n_generated, token);
+    // The last token of the budget is never needed as input.
+    more = task->n_generated < task->budget;
+  }
+  if (more) return;
+
+  // Frees its cells for the tasks still running.
+  task->active = false;
+  ReleaseSequence(task);
+  job->spec.observer->OnTaskDone(task->index, task->n_generated);
+  if (--job->n_running == 0) EndJob(job, BatchResult::kDone, nullptr);
+}
+
+bool BatchScheduler::GenerateAlone(Task* task) {
+  std::vector<int32_t> sampled;
+  const int32_t n_tokens = static_cast<int32_t>(task->tokens.size());
+  if (DecodeAhead(ctx_, task->seq, task->tokens, task->chain, task->grammar,
+                  task->budget - task->n_generated, task->job->spec.n_threads,
+                  &sampled) != 0) {
+    return false;
+  }
+  // The cache holds the task's tokens and every token sampled but the
+  // last.
+  task->n_evaluated = n_tokens + static_cast<int32_t>(sampled.size()) - 1;
+  for (const int32_t token : sampled) {
+    if (!task->active) break;
+    Advance(task, token);
+  }
+  return true;
+}
+
+void BatchScheduler::Step() {
+  for (const std::unique_ptr<Job>& job : jobs_) {
+    if (!job->ended && job->spec.observer->Cancelled()) {
+      EndJob(job.get(), BatchResult::kCancelled, nullptr);
+    }
+  }
+  RemoveFinishedJobs();
+  if (jobs_.empty()) return;
+
+  const bool foreground = std::any_of(
+      jobs_.begin(), jobs_.end(),
+      [](const std::unique_ptr<Job>& job) { return !job->spec.background; });
+  if (!foreground) {
+    for (const std::unique_ptr<Job>& job : jobs_) {
+      if (job->preempted) Resume(job.get());
+    }
+    RemoveFinishedJobs();
+  }
+  std::vector<Job*> stepping;
+  for (const std::unique_ptr<Job>& job : jobs_) {
+    if (job->preempted) continue;
+    if (!foreground || !job->spec.background) stepping.push_back(job.get());
+  }
+
+  std::vector<Task*> tasks;
+  for (Job* job : stepping) {
+    for (Task& task : job->tasks) {
+      if (task.active) tasks.push_back(&task);
+    }
+  }
+  if (ctx_->draft != nullptr && tasks.size() == 1 &&
+      tasks.front()->caught_up()) {
+    Task* task = tasks.front();
+    if (!GenerateAlone(task)) {
+      EndJob(task->job, BatchResult::kFailed, meeting_llama_last_error(ctx_));
+    }
+    RemoveFinishedJobs();
+    return;
+  }
+
+  // A token for each task generating, then prompt tokens in what room is
+  // left: the shared prefix being extended first, then the tasks' own. A
+  // resumed task reads its completion so far like its prompt.
+  llama_batch& batch = batch_;
+  batch.n_tokens = 0;
+  std::vector<int32_t> n_read(tasks.size(), 0);
+  for (size_t t = 0; t < tasks.size(); ++t) {
+    Task* task = tasks[t];
+    task->output = -1;
+    if (!task->caught_up()) continue;
+    task->output = batch.n_tokens;
+    BatchAdd(&batch, task->tokens.back(), task->n_evaluated, task->seq, true);
+    n_read[t] = 1;
+  }
+  int32_t n_extended = 0;
+  if (extending_ != nullptr &&
+      std::find(stepping.begin(), stepping.end(), extending_) !=
+          stepping.end()) {
+    std::vector<llama_seq_id> seqs = {kMainSequence};
+    for (const Task& task : extending_->tasks) seqs.push_back(task.seq);
+    const std::vector<int32_t>& prefix = extending_->tasks.front().tokens;
+    for (auto pos = static_cast<int32_t>(ctx_->tokens.size());
+         pos < extending_->shared && batch.n_tokens < batch_capacity_;
+         ++pos, ++n_extended) {
+      BatchAddShared(&batch, prefix[pos], pos, seqs);
+    }
+  }
+  for (size_t t = 0; t < tasks.size(); ++t) {
+    Task* task = tasks[t];
+    if (task->caught_up() || task->job == extending_) continue;
+    const auto n_tokens = static_cast<int32_t>(task->tokens.size());
+    for (int32_t pos = task->n_evaluated;
+         pos < n_tokens && batch.n_tokens < batch_capacity_; ++pos) {
+      const bool last = pos == n_tokens - 1;
+      if (last) task->output = batch.n_tokens;
+      BatchAdd(&batch, task->tokens[pos], pos, task->seq, last);
+      ++n_read[t];
+    }
+  }
+  if (batch.n_tokens == 0) return;
+
+  for (Job* job : stepping) {
+    if (job->spec.n_threads > 0) {
+      UseThreads(ctx_, job->spec.n_threads);
+      break;
+    }
+  }
+  if (llama_decode(ctx_->context, batch) != 0) {
+    for (Job* job : stepping) {
+      EndJob(job, BatchResult::kFailed, "llama_decode failed");
+    }
+    RemoveFinishedJobs();
+    return;
+  }
+
+  if (n_extended > 0) {
+    const std::vector<int32_t>& prefix = extending_->tasks.front().tokens;
+    const auto from = static_cast<int32_t>(ctx_->tokens.size());
+    ctx_->tokens.insert(ctx_->tokens.end(), prefix.begin() + from,
+                        prefix.begin() + from + n_extended);
+    for (Task& task : extending_->tasks) task.n_evaluated += n_extended;
+    if (static_cast<int32_t>(ctx_->tokens.size()) == extending_->shared) {
+      extending_ = nullptr;
+    }
+  }
+  for (size_t t = 0; t < tasks.size(); ++t) {
+    Task* task = tasks[t];
+    task->n_evaluated += n_read[t];
+    if (task->output < 0) continue;
+    Advance(task, Sample(ctx_, task->chain, task->grammar, task->output));
+  }
+  RemoveFinishedJobs();
+}
+
+void BatchScheduler::RemoveFinishedJobs() {
+  jobs_.erase(std::remove_if(jobs_.begin(), jobs_.end(),
+                             [](const std::unique_ptr<Job>& job) {
+                               return job->ended;
+                             }),
+              jobs_.end());
+}
+
+}  // namespace llama_shim
@@ -0,0 +1,145 @@
+#ifndef MEETING_NATIVE_LLAMA_BATCH_SCHEDULER_H_
+#define MEETING_NATIVE_LLAMA_BATCH_SCHEDULER_H_
+
+// Continuous batching for the llama shim's worker. Not part of the C ABI.
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llama.h"
+#include "llama/meeting_llama.h"
+
+namespace llama_shim {
+
+struct BatchTask {
+  // The whole prompt, BOS first.
+  std::vector<int32_t> tokens;
+  int32_t max_tokens = 0;
+  // GBNF the completion must match, or empty.
+  std::string grammar;
+};
+
+enum class BatchResult { kDone, kCancelled, kFailed };
+
+// Receives the progress of a job, on the scheduler's thread.
+class BatchObserver {
+ public:
+  virtual ~BatchObserver() = default;
+
+  // Checked between steps; true stops the job.
+  virtual bool Cancelled() = 0;
+  // |token| is the |n_generated|th of |task|'s completion.
+  virtual void OnToken(int32_t task, int32_t n_generated, int32_t token) = 0;
+  // |task|'s completion ended after |n_generated| tokens.
+  virtual void OnTaskDone(int32_t task, int32_t n_generated) = 0;
+  // The job ended; called last. For kFailed, |error| says why.
+  virtual void OnJobDone(BatchResult result, const char* error) = 0;
+};
+
+// One generation or analysis: completions of up to
+// MEETING_LLAMA_MAX_TASKS prompts, typically sharing a long prefix.
+struct BatchJob {
+  std::vector<BatchTask> tasks;
+  float temperature = 0.0f;
+  int32_t top_k = 0;
+  float top_p = 1.0f;
+  int32_t n_threads = 0;
+  // Waits while any foreground job runs.
+  bool background = false;
+  std::unique_ptr<BatchObserver> observer;
+};
+
+// Runs jobs on one context side by side, each task in a sequence of its
+// own, and advances them all with one llama_decode() per step: a token of
+// every task generating, and as many prompt tokens of tasks still reading
+// their prompt as the batch has room for. Decoding is bound by reading the
+// weights, so a batch of a few tokens costs little more than one, and jobs
+// finish about as fast together as each would alone.
+//
+// A job's prompts are read onto the context's own sequence, as far as the
+// prompts share a prefix, then forked into the tasks' sequences, which
+// share the prefix's cache cells; only the rest of each prompt and the
+// completions take cells of their own. The context thus keeps the prefix
+// for later jobs, as meeting_llama_prefill() would, and a job whose
+// prompts extend it reads only what they add. One job at a time extends
+// the context's sequence; the others wait to start.
+//
+// Foreground jobs come first: while any runs, background jobs pause, their
+// cache kept, and resume once none is left. A foreground job short of
+// sequences or cells preempts them instead, newest first: their sequences
+// are freed, and once resumed they read their prompts and completions so
+// far in again. With one task alone generating and a draft attached, it
+// decodes speculatively (see DecodeAhead()).
+class BatchScheduler {
+ public:
+  explicit BatchScheduler(meeting_llama* ctx);
+  // Cancels the jobs still running.
+  ~BatchScheduler();
+
+  BatchScheduler(const BatchScheduler&) = delete;
+  BatchScheduler& operator=(const BatchScheduler&) = delete;
+
+  meeting_llama* ctx() const { return ctx_; }
+  bool Idle() const { return jobs_.empty(); }
+
+  enum class Admission { kStarted, kWait };
+
+  // Starts |job| if it can run alongside the jobs running: there are free
+  // sequences for its tasks, no other job is extending the context's
+  // sequence, and the context has room for its prompts and full
+  // completions. A foreground job preempts background jobs until it can.
+  // Alone, a job is always started, with its completions shortened to
+  // what room there is; a job that does not fit even so is failed at
+  // once. Returns kWait, leaving |job| untouched, when it cannot start
+  // yet; otherwise the scheduler owns it.
+  Admission Admit(BatchJob* job);
+
+  // Advances the running jobs by one batch, ending those that are done,
+  // cancelled or failed. Does nothing when idle.
+  void Step();
+
+ private:
+  struct Task;
+  struct Job;
+
+  static int64_t Cells(const Job& job, int32_t main);
+  // Cells the jobs not preempted take beyond the first |main| of the
+  // context's sequence.
+  int64_t RunningCells(int32_t main) const;
+  // Whether any job is not preempted.
+  bool Running() const;
+
+  // Gives |task| a free sequence holding its first n_evaluated tokens from
+  // the context's.
+  void TakeSequence(Task* task);
+  void ReleaseSequence(Task* task);
+  void StartTask(Job* job, int32_t index);
+  // Frees the sequences of the newest background job holding any. Returns
+  // false if there is none.
+  bool PreemptBackground();
+  // Gives a preempted |job| sequences again if there are enough, and room
+  // for it. Alone, it is shortened to fit, or failed.
+  bool Resume(Job* job);
+  // Ends |job|'s tasks still running and reports the result.
+  void EndJob(Job* job, BatchResult result, const char* error);
+  // Takes |token| as |task|'s next, or ends the task.
+  void Advance(Task* task, int32_t token);
+  bool GenerateAlone(Task* task);
+  void RemoveFinishedJobs();
+
+  meeting_llama* const ctx_;
+  std::vector<std::unique_ptr<Job>> jobs_;
+  // Sequences 1 to MEETING_LLAMA_MAX_TASKS, true while a task holds one.
+  std::vector<bool> sequences_;
+  // Job reading its shared prefix onto the context's sequence, or null.
+  Job* extending_ = nullptr;
+  llama_batch batch_;
+  int32_t batch_capacity_ = 0;
+};
+
+}  // namespace llama_shim
+
+#endif  // MEETING_NATIVE_LLAMA_BATCH_SCHEDULER_H_
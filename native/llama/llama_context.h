@@ -0,0 +1,94 @@
+#ifndef MEETING_NATIVE_LLAMA_LLAMA_CONTEXT_H_
+#define MEETING_NATIVE_LLAMA_LLAMA_CONTEXT_H_
+
+// The llama shim's context, shared by its translation units. Not part of
+// the C ABI.
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "llama.h"
+#include "llama/meeting_llama.h"
+
+namespace llama_shim {
+
+// The context's own tokens live in sequence 0 of the KV cache; analyses
+// fork one further sequence per task.
+constexpr llama_seq_id kMainSequence = 0;
+constexpr int32_t kMaxSequences = 1 + MEETING_LLAMA_MAX_TASKS;
+
+struct CompiledGrammar {
+  std::string text;
+  // Never sampled with; each completion starts from a clone.
+  llama_sampler* sampler;
+};
+
+}  // namespace llama_shim
+
+struct meeting_llama {
+  llama_model* model = nullptr;
+  llama_context* context = nullptr;
+  llama_sampler* sampler = nullptr;
+  // Grammar constraining the current completion, or null.
+  llama_sampler* grammar = nullptr;
+  // Most recently used first.
+  std::vector<llama_shim::CompiledGrammar> grammars;
+  // Candidates scratch for constrained sampling, one per vocabulary entry.
+  std::vector<llama_token_data> candidates;
+  // Smaller model guessing ahead for the worker's completions, or null.
+  // Not owned.
+  meeting_llama* draft = nullptr;
+
+  // Tokens evaluated into the context, in order; their keys and values are
+  // what the KV cache holds.
+  std::vector<int32_t> tokens;
+  // Set for embedding contexts, which keep nothing between calls.
+  bool embeddings = false;
+  // Threads last passed to llama_set_n_threads(), 0 before the first.
+  int32_t n_threads = 0;
+  // Identifies the model in session snapshots.
+  uint64_t fingerprint = 0;
+  // Metadata of the last snapshot saved or restored.
+  std::string session_metadata;
+  std::string description;
+  std::string error;
+};
+
+namespace llama_shim {
+
+// Sets the last error. Returns -1.
+int32_t Fail(meeting_llama* ctx, const char* message);
+
+// Sampler chain for the options of meeting_llama_set_sampling(), or null.
+llama_sampler* CreateSampler(float temperature,
+                             int32_t top_k,
+                             float top_p,
+                             uint32_t seed);
+
+// Fresh parse state for |grammar|, which is compiled once per context.
+// Returns null and sets the last error on failure.
+llama_sampler* InstantiateGrammar(meeting_llama* ctx, const char* grammar);
+
+// Appends |token| at |pos| of sequence |seq| to |batch|, with its logits
+// computed when |logits| is set.
+void BatchAdd(llama_batch* batch,
+              llama_token token,
+              llama_pos pos,
+              llama_seq_id seq,
+              bool logits);
+
+// Passes |n_threads| (> 0) to llama.cpp if it changed.
+void UseThreads(meeting_llama* ctx, int32_t n_threads);
+
+// Samples a token from output |idx| of the last decode with |chain|,
+// constrained by |grammar| unless it is null, and accepts it into both.
+llama_token Sample(meeting_llama* ctx,
+                   llama_sampler* chain,
+                   llama_sampler* grammar,
+                   int32_t idx);
+
+}  // namespace llama_shim
+
+#endif  // MEETING_NATIVE_LLAMA_LLAMA_CONTEXT_H_
@@ -0,0 +1,615 @@
+#include "llama/meeting_llama.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/thread_placement.h"
+#include "llama/batch_scheduler.h"
+
+namespace {
+
+enum class JobKind { kGenerate, kAnalyze, kSaveSession, kLoadSession };
+
+struct TaskSpec {
+  std::string prompt;
+  int32_t max_tokens = 0;
+  std::string grammar;
+};
+
+struct Job {
+  JobKind kind = JobKind::kGenerate;
+  int64_t id = 0;
+  meeting_llama* ctx = nullptr;
+  // Generation prompt, or snapshot metadata to save.
+  std::string prompt;
+  std::string path;
+  int32_t max_tokens = 0;
+  float temperature = 0.0f;
+  int32_t top_k = 0;
+  float top_p = 1.0f;
+  int32_t n_threads = 0;
+  int32_t flags = 0;
+  // GBNF the completion must match, or empty.
+  std::string grammar;
+  // kAnalyze's completions, which use the options above but not the
+  // prompt, length and grammar.
+  std::vector<TaskSpec> tasks;
+};
+
+// Length of the longest prefix of |text| that does not end inside a UTF-8
+// sequence. Tokens split multi-byte characters, and each event must carry
+// text Dart can decode on its own.
+size_t CompleteUtf8Length(const std::string& text) {
+  const size_t size = text.size();
+  // A sequence is at most 4 bytes, so only the tail needs checking.
+  for (size_t back = 1; back <= std::min<size_t>(size, 4); ++back) {
+    const auto byte = static_cast<unsigned char>(text[size - back]);
+    if ((byte & 0xC0) == 0x80) continue;  // Continuation byte.
+    size_t needed = 1;
+    if ((byte & 0xE0) == 0xC0) {
+      needed = 2;
+    } else if ((byte & 0xF0) == 0xE0) {
+      needed = 3;
+    } else if ((byte & 0xF8) == 0xF0) {
+      needed = 4;
+    }
+    return back >= needed ? size : size - back;
+  }
+  return size;
+}
+
+}  // namespace
+
+// A job taken off the queue by the thread, waiting to start or running.
+struct RunningJob {
+  int64_t id = 0;
+  // Checked between steps by the job.
+  std::shared_ptr<std::atomic<bool>> cancel;
+};
+
+struct meeting_llama_worker {
+  meeting_llama_callback callback = nullptr;
+
+  mutable std::mutex mutex;
+  std::condition_variable wake;
+  std::deque<Job> queue;
+  std::vector<RunningJob> running;
+  bool stopping = false;
+  int64_t next_id = 1;
+  // Set by meeting_llama_worker_set_cpus(); |place| until the thread has
+  // moved there.
+  std::vector<int32_t> cpus;
+  bool place = false;
+
+  std::thread thread;
+};
+
+namespace {
+
+void EmitForTask(meeting_llama_worker* worker,
+                 int64_t job_id,
+                 int32_t kind,
+                 int32_t task,
+                 int32_t n_tokens,
+                 const char* text,
+                 size_t length) {
+  auto* event = new (std::nothrow) meeting_llama_event();
+  char* owned = new (std::nothrow) char[length + 1];
+  if (event == nullptr || owned == nullptr) {
+    delete event;
+    delete[] owned;
+    worker->callback(job_id, nullptr);
+    return;
+  }
+  std::memcpy(owned, text, length);
+  owned[length] = '\0';
+  event->kind = kind;
+  event->n_tokens = n_tokens;
+  event->task = task;
+  event->text = owned;
+  worker->callback(job_id, event);
+}
+
+void Emit(meeting_llama_worker* worker,
+          int64_t job_id,
+          int32_t kind,
+          int32_t n_tokens,
+          const char* text,
+          size_t length) {
+  EmitForTask(worker, job_id, kind, 0, n_tokens, text, length);
+}
+
+void Emit(meeting_llama_worker* worker,
+          int64_t job_id,
+          int32_t kind,
+          int32_t n_tokens,
+          const std::string& text) {
+  Emit(worker, job_id, kind, n_tokens, text.data(), text.size());
+}
+
+// Calls |fill|(buffer, capacity), which follows the shim's convention of
+// returning minus the size needed when |capacity| is too small, until the
+// result fits.
+template <typename T, typename Fill>
+int32_t FillGrowing(std::vector<T>* buffer, Fill fill) {
+  int32_t count =
+      fill(buffer->data(), static_cast<int32_t>(buffer->size()));
+  if (count < 0) {
+    buffer->resize(static_cast<size_t>(-count));
+    count = fill(buffer->data(), static_cast<int32_t>(buffer->size()));
+  }
+  return count;
+}
+
+// |prompt| as the model should see it.
+std::string PreparePrompt(const Job& job, const std::string& prompt) {
+  if ((job.flags & MEETING_LLAMA_GENERATE_CHAT) == 0) return prompt;
+  std::vector<char> text(prompt.size() * 2 + 256);
+  const int32_t length =
+      FillGrowing(&text, [&job, &prompt](char* buf, int32_t cap) {
+        return meeting_llama_chat_prompt(job.ctx, prompt.c_str(), buf, cap);
+      });
+  return length > 0 ? std::string(text.data(), static_cast<size_t>(length))
+                    : prompt;
+}
+
+// Tokens of |prompt| as the model should see it, BOS first; sized to the
+// token count.
+std::vector<int32_t> TokenizePrompt(const Job& job, const std::string& prompt) {
+  const std::string text = PreparePrompt(job, prompt);
+  std::vector<int32_t> tokens(text.size() + 2);
+  const int32_t count =
+      FillGrowing(&tokens, [&job, &text](int32_t* buf, int32_t cap) {
+        return meeting_llama_tokenize(job.ctx, text.c_str(), 1, buf, cap);
+      });
+  tokens.resize(static_cast<size_t>(std::max(count, 0)));
+  return tokens;
+}
+
+// Streams a job's tokens as text, per task for analyses, and reports its
+// end.
+class JobEmitter : public llama_shim::BatchObserver {
+ public:
+  JobEmitter(meeting_llama_worker* worker,
+             const Job& job,
+             std::shared_ptr<std::atomic<bool>> cancel)
+      : worker_(worker),
+        id_(job.id),
+        ctx_(job.ctx),
+        analysis_(job.kind == JobKind::kAnalyze),
+        cancel_(std::move(cancel)),
+        pending_(analysis_ ? job.tasks.size() : 1),
+        piece_(64) {}
+
+  bool Cancelled() override {
+    return cancel_->load(std::memory_order_relaxed);
+  }
+
+  void OnToken(int32_t task, int32_t n_generated, int32_t token) override {
+    n_generated_ = n_generated;
+    const int32_t length =
+        FillGrowing(&piece_, [this, token](char* buf, int32_t cap) {
+          return meeting_llama_token_piece(ctx_, token, buf, cap);
+        });
+    std::string& pending = pending_[task];
+    if (length > 0) pending.append(piece_.data(), static_cast<size_t>(length));
+    const size_t complete = CompleteUtf8Length(pending);
+    if (complete > 0) {
+      EmitForTask(worker_, id_, MEETING_LLAMA_EVENT_TOKEN,
+                  analysis_ ? task : 0, n_generated, pending.data(),
+                  complete);
+      pending.erase(0, complete);
+    }
+  }
+
+  void OnTaskDone(int32_t task, int32_t n_generated) override {
+    // A generation's remainder goes with DONE.
+    if (!analysis_) return;
+    const std::string& pending = pending_[task];
+    EmitForTask(worker_, id_, MEETING_LLAMA_EVENT_TASK_DONE, task,
+                n_generated, pending.data(), pending.size());
+  }
+
+  void OnJobDone(llama_shim::BatchResult result, const char* error) override {
+    {
+      std::lock_guard<std::mutex> lock(worker_->mutex);
+      auto& running = worker_->running;
+      running.erase(std::remove_if(running.begin(), running.end(),
+                                   [this](const RunningJob& job) {
+                                     return job.id == id_;
+                                   }),
+                    running.end());
+    }
+    const int32_t n_tokens = analysis_ ? 0 : n_generated_;
+    switch (result) {
+      case llama_shim::BatchResult::kDone:
+        Emit(worker_, id_, MEETING_LLAMA_EVENT_DONE, n_tokens,
+             analysis_ ? std::string() : pending_.front());
+        break;
+      case llama_shim::BatchResult::kCancelled:
+        Emit(worker_, id_, MEETING_LLAMA_EVENT_CANCELLED, n_tokens, "");
+        break;
+      case llama_shim::BatchResult::kFailed:
+        Emit(worker_, id_, MEETING_LLAMA_EVENT_FAILED, n_tokens,
+             error != nullptr ? error : "");
+        break;
+    }
+  }
+
+ private:
+  meeting_llama_worker* const worker_;
+  const int64_t id_;
+  const meeting_llama* const ctx_;
+  const bool analysis_;
+  const std::shared_ptr<std::atomic<bool>> cancel_;
+  int32_t n_generated_ = 0;
+  // Bytes of an unfinished character, per task.
+  std::vector<std::string> pending_;
+  std::vector<char> piece_;
+};
+
+// A generation or analysis taken off the queue, ready to start.
+struct PreparedJob {
+  meeting_llama* ctx = nullptr;
+  llama_shim::BatchJob batch;
+};
+
+PreparedJob Prepare(meeting_llama_worker* worker,
+                    const Job& job,
+                    std::shared_ptr<std::atomic<bool>> cancel) {
+  PreparedJob prepared;
+  prepared.ctx = job.ctx;
+  llama_shim::BatchJob& batch = prepared.batch;
+  if (job.kind == JobKind::kAnalyze) {
+    for (const TaskSpec& spec : job.tasks) {
+      batch.tasks.push_back(
+          {TokenizePrompt(job, spec.prompt), spec.max_tokens, spec.grammar});
+    }
+  } else {
+    batch.tasks.push_back(
+        {TokenizePrompt(job, job.prompt), job.max_tokens, job.grammar});
+  }
+  batch.temperature = job.temperature;
+  batch.top_k = job.top_k;
+  batch.top_p = job.top_p;
+  batch.n_threads = job.n_threads;
+  batch.background = (job.flags & MEETING_LLAMA_GENERATE_BACKGROUND) != 0;
+  batch.observer =
+      std::make_unique<JobEmitter>(worker, job, std::move(cancel));
+  return prepared;
+}
+
+void RunSaveSession(meeting_llama_worker* worker, const Job& job) {
+  if (meeting_llama_session_save(job.ctx, job.path.c_str(),
+                                 job.prompt.c_str()) != 0) {
+    Emit(worker, job.id, MEETING_LLAMA_EVENT_FAILED, 0,
+         meeting_llama_last_error(job.ctx));
+    return;
+  }
+  Emit(worker, job.id, MEETING_LLAMA_EVENT_DONE, 0, "");
+}
+
+void RunLoadSession(meeting_llama_worker* worker, const Job& job) {
+  const int32_t n_tokens = meeting_llama_session_load(job.ctx,
+                                                      job.path.c_str());
+  if (n_tokens < 0) {
+    Emit(worker, job.id, MEETING_LLAMA_EVENT_FAILED, 0,
+         meeting_llama_last_error(job.ctx));
+    return;
+  }
+  Emit(worker, job.id, MEETING_LLAMA_EVENT_DONE, n_tokens,
+       meeting_llama_session_metadata(job.ctx));
+}
+
+// Starts the waiting jobs that can run now, foreground first and each
+// class in submission order; the first that must wait holds back those
+// after it, so a long prompt is not starved by shorter ones.
+void StartWaiting(std::deque<PreparedJob>* waiting,
+                  std::unique_ptr<llama_shim::BatchScheduler>* scheduler) {
+  while (!waiting->empty()) {
+    PreparedJob& next = waiting->front();
+    if (next.batch.observer->Cancelled()) {
+      next.batch.observer->OnJobDone(llama_shim::BatchResult::kCancelled,
+                                     nullptr);
+      waiting->pop_front();
+      continue;
+    }
+    // Jobs on another context start once this one is idle.
+    if (*scheduler == nullptr || (*scheduler)->ctx() != next.ctx) {
+      if (*scheduler != nullptr && !(*scheduler)->Idle()) return;
+      *scheduler = std::make_unique<llama_shim::BatchScheduler>(next.ctx);
+    }
+    if ((*scheduler)->Admit(&next.batch) ==
+        llama_shim::BatchScheduler::Admission::kWait) {
+      return;
+    }
+    waiting->pop_front();
+  }
+}
+
+void RunWorker(meeting_llama_worker* worker) {
+  // Sets the QoS class on Apple platforms; no CPUs are known yet.
+  native_common::PlaceCurrentThread({});
+
+  std::unique_ptr<llama_shim::BatchScheduler> scheduler;
+  std::deque<PreparedJob> waiting;
+  for (;;) {
+    const bool busy =
+        !waiting.empty() || (scheduler != nullptr && !scheduler->Idle());
+    std::vector<std::pair<Job, std::shared_ptr<std::atomic<bool>>>> taken;
+    Job session;
+    bool has_session = false;
+    std::vector<int32_t> cpus;
+    {
+      std::unique_lock<std::mutex> lock(worker->mutex);
+      worker->wake.wait(lock, [worker, busy] {
+        return worker->stopping || busy || !worker->queue.empty();
+      });
+      if (worker->stopping) break;
+      if (worker->place) {
+        cpus = worker->cpus;
+        worker->place = false;
+      }
+
+      // Generations queued before a session job start before it, and
+      // background ones queued after it once it is done. A session job
+      // waits for the context to be idle, which foreground generations
+      // queued after it do not wait for.
+      bool held_back = false;
+      auto it = worker->queue.begin();
+      while (it != worker->queue.end()) {
+        Job& job = *it;
+        const bool is_session = job.kind == JobKind::kSaveSession ||
+                                job.kind == JobKind::kLoadSession;
+        if (is_session) {
+          if (busy || !taken.empty() || held_back) {
+            held_back = true;
+            ++it;
+            continue;
+          }
+          session = std::move(job);
+          has_session = true;
+          worker->queue.erase(it);
+          worker->running.push_back({session.id, nullptr});
+          break;
+        }
+        if (held_back && (job.flags & MEETING_LLAMA_GENERATE_BACKGROUND) != 0) {
+          ++it;
+          continue;
+        }
+        auto cancel = std::make_shared<std::atomic<bool>>(false);
+        worker->running.push_back({job.id, cancel});
+        taken.emplace_back(std::move(job), std::move(cancel));
+        it = worker->queue.erase(it);
+      }
+    }
+
+    if (!cpus.empty()) native_common::PlaceCurrentThread(cpus);
+
+    if (has_session) {
+      if (session.kind == JobKind::kSaveSession) {
+        RunSaveSession(worker, session);
+      } else {
+        RunLoadSession(worker, session);
+      }
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      auto& running = worker->running;
+      running.erase(std::remove_if(running.begin(), running.end(),
+                                   [&session](const RunningJob& job) {
+                                     return job.id == session.id;
+                                   }),
+                    running.end());
+      continue;
+    }
+
+    for (auto& [job, cancel] : taken) {
+      PreparedJob prepared = Prepare(worker, job, std::move(cancel));
+      if (prepared.batch.background) {
+        waiting.push_back(std::move(prepared));
+      } else {
+        // Ahead of the background jobs waiting.
+        auto it = std::find_if(waiting.begin(), waiting.end(),
+                               [](const PreparedJob& other) {
+                                 return other.batch.background;
+                               });
+        waiting.insert(it, std::move(prepared));
+      }
+    }
+    StartWaiting(&waiting, &scheduler);
+    if (scheduler != nullptr) scheduler->Step();
+  }
+
+  for (PreparedJob& job : waiting) {
+    job.batch.observer->OnJobDone(llama_shim::BatchResult::kCancelled,
+                                  nullptr);
+  }
+  // Cancels the jobs still running.
+  scheduler.reset();
+}
+
+// Assigns |job| an id and queues it. Returns the id, or -1 once the worker
+// is stopping.
+int64_t Enqueue(meeting_llama_worker* worker, Job job) {
+  int64_t id = 0;
+  {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    if (worker->stopping) return -1;
+    id = worker->next_id++;
+    job.id = id;
+    worker->queue.push_back(std::move(job));
+  }
+  worker->wake.notify_one();
+  return id;
+}
+
+}  // namespace
+
+meeting_llama_worker* meeting_llama_worker_create(
+    meeting_llama_callback callback) {
+  if (callback == nullptr) return nullptr;
+
+  auto* worker = new (std::nothrow) meeting_llama_worker();
+  if (worker == nullptr) return nullptr;
+  worker->callback = callback;
+  worker->thread = std::thread(RunWorker, worker);
+  return worker;
+}
+
+void meeting_llama_worker_free(meeting_llama_worker* worker) {
+  if (worker == nullptr) return;
+  std::deque<Job> cancelled;
+  {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    worker->stopping = true;
+    cancelled.swap(worker->queue);
+  }
+  worker->wake.notify_one();
+  for (const Job& job : cancelled) {
+    Emit(worker, job.id, MEETING_LLAMA_EVENT_CANCELLED, 0, "");
+  }
+  worker->thread.join();
+  delete worker;
+}
+
+void meeting_llama_worker_set_cpus(meeting_llama_worker* worker,
+                                   const int32_t* cpus,
+                                   int32_t count) {
+  if (worker == nullptr || count <= 0 || cpus == nullptr) return;
+
+  std::vector<int32_t> set(cpus, cpus + count);
+  std::lock_guard<std::mutex> lock(worker->mutex);
+  if (set == worker->cpus) return;
+  worker->cpus = std::move(set);
+  worker->place = true;
+}
+
+int64_t meeting_llama_worker_generate(meeting_llama_worker* worker,
+                                      meeting_llama* ctx,
+                                      const char* prompt,
+                                      int32_t max_tokens,
+                                      float temperature,
+                                      int32_t top_k,
+                                      float top_p,
+                                      int32_t n_threads,
+                                      int32_t flags,
+                                      const char* grammar) {
+  if (worker == nullptr || ctx == nullptr || prompt == nullptr ||
+      max_tokens <= 0) {
+    return -1;
+  }
+
+  Job job;
+  job.ctx = ctx;
+  job.prompt = prompt;
+  job.max_tokens = max_tokens;
+  job.temperature = temperature;
+  job.top_k = top_k;
+  job.top_p = top_p;
+  job.n_threads = n_threads;
+  job.flags = flags;
+  if (grammar != nullptr) job.grammar = grammar;
+  return Enqueue(worker, std::move(job));
+}
+
+int64_t meeting_llama_worker_analyze(meeting_llama_worker* worker,
+                                     meeting_llama* ctx,
+                                     const meeting_llama_task* tasks,
+                                     int32_t n_tasks,
+                                     float temperature,
+                                     int32_t top_k,
+                                     float top_p,
+                                     int32_t n_threads,
+                                     int32_t flags) {
+  if (worker == nullptr || ctx == nullptr || tasks == nullptr ||
+      n_tasks <= 0 || n_tasks > MEETING_LLAMA_MAX_TASKS) {
+    return -1;
+  }
+
+  Job job;
+  job.kind = JobKind::kAnalyze;
+  job.ctx = ctx;
+  job.temperature = temperature;
+  job.top_k = top_k;
+  job.top_p = top_p;
+  job.n_threads = n_threads;
+  job.flags = flags;
+  for (int32_t i = 0; i < n_tasks; ++i) {
+    if (tasks[i].prompt == nullptr || tasks[i].max_tokens <= 0) return -1;
+    TaskSpec spec;
+    spec.prompt = tasks[i].prompt;
+    spec.max_tokens = tasks[i].max_tokens;
+    if (tasks[i].grammar != nullptr) spec.grammar = tasks[i].grammar;
+    job.tasks.push_back(std::move(spec));
+  }
+  return Enqueue(worker, std::move(job));
+}
+
+int64_t meeting_llama_worker_save_session(meeting_llama_worker* worker,
+                                          meeting_llama* ctx,
+                                          const char* path,
+                                          const char* metadata) {
+  if (worker == nullptr || ctx == nullptr || path == nullptr) return -1;
+
+  Job job;
+  job.kind = JobKind::kSaveSession;
+  job.ctx = ctx;
+  job.path = path;
+  if (metadata != nullptr) job.prompt = metadata;
+  return Enqueue(worker, std::move(job));
+}
+
+int64_t meeting_llama_worker_load_session(meeting_llama_worker* worker,
+                                          meeting_llama* ctx,
+                                          const char* path) {
+  if (worker == nullptr || ctx == nullptr || path == nullptr) return -1;
+
+  Job job;
+  job.kind = JobKind::kLoadSession;
+  job.ctx = ctx;
+  job.path = path;
+  return Enqueue(worker, std::move(job));
+}
+
+int32_t meeting_llama_worker_cancel(meeting_llama_worker* worker,
+                                    int64_t job_id) {
+  if (worker == nullptr || job_id <= 0) return 0;
+  {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    for (const RunningJob& job : worker->running) {
+      if (job.id != job_id) continue;
+      // Session jobs cannot be stopped part-way.
+      if (job.cancel == nullptr) return 0;
+      job.cancel->store(true, std::memory_order_relaxed);
+      return 1;
+    }
+    auto it = std::find_if(
+        worker->queue.begin(), worker->queue.end(),
+        [job_id](const Job& job) { return job.id == job_id; });
+    if (it == worker->queue.end()) return 0;
+    worker->queue.erase(it);
+  }
+  Emit(worker, job_id, MEETING_LLAMA_EVENT_CANCELLED, 0, "");
+  return 1;
+}
+
+int32_t meeting_llama_worker_pending(const meeting_llama_worker* worker) {
+  if (worker == nullptr) return 0;
+  std::lock_guard<std::mutex> lock(worker->mutex);
+  return static_cast<int32_t>(worker->queue.size() + worker->running.size());
+}
+
+void meeting_llama_event_free(meeting_llama_event* event) {
+  if (event == nullptr) return;
+  delete[] event->text;
+  delete event;
+}
@@ -0,0 +1,574 @@
+#include "llama/meeting_llama.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "llama.h"
+#include "llama/llama_context.h"
+#include "llama/session_file.h"
+#include "llama/transcript_budget.h"
+
+namespace {
+
+// Context used when the caller does not ask for a size: room for a long
+// transcript excerpt plus the summary, without the memory of a model's full
+// training context.
+constexpr int32_t kDefaultContext = 4096;
+
+// Offloads every layer; llama.cpp clamps this to the model's layer count.
+constexpr int32_t kAllGpuLayers = 999;
+
+// Sampling a fresh context starts with, llama.cpp's usual defaults.
+constexpr float kDefaultTemperature = 0.8f;
+constexpr int32_t kDefaultTopK = 40;
+constexpr float kDefaultTopP = 0.95f;
+
+// Grammars compiled per context. The shim's callers use a handful of
+// fixed output formats, so a few cover them all.
+constexpr size_t kMaxCompiledGrammars = 8;
+
+void InitBackend() {
+  static std::once_flag once;
+  std::call_once(once, [] { llama_backend_init(); });
+}
+
+// Candidates for the next token, from output |idx| of the last decode.
+llama_token_data_array Candidates(meeting_llama* ctx, int32_t idx) {
+  const float* logits = llama_get_logits_ith(ctx->context, idx);
+  const int32_t n_vocab = llama_n_vocab(ctx->model);
+  ctx->candidates.resize(static_cast<size_t>(n_vocab));
+  for (int32_t id = 0; id < n_vocab; ++id) {
+    ctx->candidates[id] = llama_token_data{id, logits[id], 0.0f};
+  }
+  return llama_token_data_array{ctx->candidates.data(),
+                                ctx->candidates.size(), -1, false};
+}
+
+// Whether |a| and |b| share one vocabulary, token for token, so that
+// tokens of one mean the same to the other.
+bool SameVocabulary(const llama_model* a, const llama_model* b) {
+  const int32_t n_vocab = llama_n_vocab(a);
+  if (llama_n_vocab(b) != n_vocab ||
+      llama_token_bos(a) != llama_token_bos(b) ||
+      llama_token_eos(a) != llama_token_eos(b)) {
+    return false;
+  }
+  for (llama_token id = 0; id < n_vocab; ++id) {
+    if (std::strcmp(llama_token_get_text(a, id), llama_token_get_text(b, id)) !=
+        0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+namespace llama_shim {
+
+int32_t Fail(meeting_llama* ctx, const char* message) {
+  ctx->error = message;
+  return -1;
+}
+
+llama_sampler* CreateSampler(float temperature,
+                             int32_t top_k,
+                             float top_p,
+                             uint32_t seed) {
+  llama_sampler* chain =
+      llama_sampler_chain_init(llama_sampler_chain_default_params());
+  if (chain == nullptr) return nullptr;
+  if (temperature <= 0.0f) {
+    llama_sampler_chain_add(chain, llama_sampler_init_greedy());
+    return chain;
+  }
+  if (top_k > 0) {
+    llama_sampler_chain_add(chain, llama_sampler_init_top_k(top_k));
+  }
+  if (top_p < 1.0f) {
+    llama_sampler_chain_add(chain, llama_sampler_init_top_p(top_p, 1));
+  }
+  llama_sampler_chain_add(chain, llama_sampler_init_temp(temperature));
+  llama_sampler_chain_add(chain, llama_sampler_init_dist(seed));
+  return chain;
+}
+
+llama_sampler* InstantiateGrammar(meeting_llama* ctx, const char* grammar) {
+  auto it = std::find_if(ctx->grammars.begin(), ctx->grammars.end(),
+                         [grammar](const CompiledGrammar& entry) {
+                           return entry.text == grammar;
+                         });
+  if (it == ctx->grammars.end()) {
+    llama_sampler* compiled =
+        llama_sampler_init_grammar(ctx->model, grammar, "root");
+    if (compiled == nullptr) {
+      Fail(ctx, "invalid grammar");
+      return nullptr;
+    }
+    if (ctx->grammars.size() == kMaxCompiledGrammars) {
+      llama_sampler_free(ctx->grammars.back().sampler);
+      ctx->grammars.pop_back();
+    }
+    ctx->grammars.insert(ctx->grammars.begin(), {grammar, compiled});
+  } else {
+    std::rotate(ctx->grammars.begin(), it, it + 1);
+  }
+
+  // A clone copies the parsed rules rather than parsing the text again.
+  llama_sampler* instance = llama_sampler_clone(ctx->grammars.front().sampler);
+  if (instance == nullptr) Fail(ctx, "out of memory");
+  return instance;
+}
+
+void BatchAdd(llama_batch* batch,
+              llama_token token,
+              llama_pos pos,
+              llama_seq_id seq,
+              bool logits) {
+  const int32_t i = batch->n_tokens++;
+  batch->token[i] = token;
+  batch->pos[i] = pos;
+  batch->n_seq_id[i] = 1;
+  batch->seq_id[i][0] = seq;
+  batch->logits[i] = logits ? 1 : 0;
+}
+
+void UseThreads(meeting_llama* ctx, int32_t n_threads) {
+  if (n_threads > 0 && n_threads != ctx->n_threads) {
+    llama_set_n_threads(ctx->context, n_threads, n_threads);
+    ctx->n_threads = n_threads;
+  }
+}
+
+// Masking the vocabulary against a grammar is the expensive part of a
+// constrained step, and the token the model prefers is almost always one
+// the grammar allows. So the unconstrained pick is checked on its own
+// first, and the whole vocabulary is only masked when it is rejected.
+llama_token Sample(meeting_llama* ctx,
+                   llama_sampler* chain,
+                   llama_sampler* grammar,
+                   int32_t idx) {
+  if (grammar == nullptr) {
+    return llama_sampler_sample(chain, ctx->context, idx);
+  }
+
+  llama_token_data_array cur = Candidates(ctx, idx);
+  llama_sampler_apply(chain, &cur);
+  llama_token token = cur.data[cur.selected].id;
+
+  llama_token_data single = {token, 1.0f, 0.0f};
+  llama_token_data_array check = {&single, 1, -1, false};
+  llama_sampler_apply(grammar, &check);
+  if (std::isinf(single.logit)) {
+    cur = Candidates(ctx, idx);
+    llama_sampler_apply(grammar, &cur);
+    llama_sampler_apply(chain, &cur);
+    token = cur.data[cur.selected].id;
+  }
+
+  llama_sampler_accept(grammar, token);
+  llama_sampler_accept(chain, token);
+  return token;
+}
+
+}  // namespace llama_shim
+
+using llama_shim::CreateSampler;
+using llama_shim::Fail;
+
+int32_t meeting_llama_abi_version(void) {
+  return MEETING_LLAMA_ABI_VERSION;
+}
+
+meeting_llama* meeting_llama_init(const char* model_path,
+                                  int32_t n_ctx,
+                                  int32_t flags) {
+  if (model_path == nullptr) return nullptr;
+  InitBackend();
+
+  llama_model_params model_params = llama_model_default_params();
+  model_params.n_gpu_layers =
+      (flags & MEETING_LLAMA_INIT_USE_GPU) != 0 ? kAllGpuLayers : 0;
+  llama_model* model = llama_load_model_from_file(model_path, model_params);
+  if (model == nullptr) return nullptr;
+
+  const int32_t n_ctx_train = llama_n_ctx_train(model);
+  if (n_ctx <= 0) {
+    n_ctx = n_ctx_train > 0 ? std::min(kDefaultContext, n_ctx_train)
+                            : kDefaultContext;
+  }
+  const bool embeddings = (flags & MEETING_LLAMA_INIT_EMBEDDINGS) != 0;
+  llama_context_params context_params = llama_context_default_params();
+  context_params.n_ctx = static_cast<uint32_t>(n_ctx);
+  context_params.n_batch =
+      std::min(context_params.n_batch, static_cast<uint32_t>(n_ctx));
+  context_params.n_seq_max = llama_shim::kMaxSequences;
+  if (embeddings) {
+    // Encoders see the whole text at once, so it is one micro-batch.
+    context_params.n_batch = static_cast<uint32_t>(n_ctx);
+    context_params.n_ubatch = static_cast<uint32_t>(n_ctx);
+    context_params.embeddings = true;
+  }
+  llama_context* context = llama_new_context_with_model(model, context_params);
+  if (context != nullptr && embeddings &&
+      llama_pooling_type(context) == LLAMA_POOLING_TYPE_NONE) {
+    // Generative models name no pooling of their own.
+    llama_free(context);
+    context_params.pooling_type = LLAMA_POOLING_TYPE_MEAN;
+    context = llama_new_context_with_model(model, context_params);
+  }
+  if (context == nullptr) {
+    llama_free_model(model);
+    return nullptr;
+  }
+
+  llama_sampler* sampler =
+      CreateSampler(kDefaultTemperature, kDefaultTopK, kDefaultTopP,
+                    MEETING_LLAMA_RANDOM_SEED);
+  auto* ctx = sampler != nullptr ? new (std::nothrow) meeting_llama() : nullptr;
+  if (ctx == nullptr) {
+    if (sampler != nullptr) llama_sampler_free(sampler);
+    llama_free(context);
+    llama_free_model(model);
+    return nullptr;
+  }
+  ctx->model = model;
+  ctx->context = context;
+  ctx->sampler = sampler;
+  ctx->embeddings = embeddings;
+  ctx->fingerprint = llama_shim::ModelFingerprint(model);
+
+  char description[128];
+  if (llama_model_desc(model, description, sizeof(description)) > 0) {
+    ctx->description = description;
+  }
+  return ctx;
+}
+
+void meeting_llama_free(meeting_llama* ctx) {
+  if (ctx == nullptr) return;
+  if (ctx->grammar != nullptr) llama_sampler_free(ctx->grammar);
+  for (const llama_shim::CompiledGrammar& grammar : ctx->grammars) {
+    llama_sampler_free(grammar.sampler);
+  }
+  llama_sampler_free(ctx->sampler);
+  llama_free(ctx->context);
+  llama_free_model(ctx->model);
+  delete ctx;
+}
+
+const char* meeting_llama_last_error(const meeting_llama* ctx) {
+  return ctx != nullptr ? ctx->error.c_str() : "";
+}
+
+const char* meeting_llama_model_desc(const meeting_llama* ctx) {
+  return ctx != nullptr ? ctx->description.c_str() : "";
+}
+
+int32_t meeting_llama_n_ctx(const meeting_llama* ctx) {
+  return ctx != nullptr ? static_cast<int32_t>(llama_n_ctx(ctx->context)) : 0;
+}
+
+int32_t meeting_llama_n_past(const meeting_llama* ctx) {
+  return ctx != nullptr ? static_cast<int32_t>(ctx->tokens.size()) : 0;
+}
+
+int32_t meeting_llama_n_vocab(const meeting_llama* ctx) {
+  return ctx != nullptr ? llama_n_vocab(ctx->model) : 0;
+}
+
+int32_t meeting_llama_tokenize(const meeting_llama* ctx,
+                               const char* text,
+                               int32_t add_special,
+                               int32_t* tokens,
+                               int32_t capacity) {
+  if (ctx == nullptr || text == nullptr) return 0;
+  const auto length = static_cast<int32_t>(std::strlen(text));
+  // Special tokens in the text are parsed as such, so a chat-templated
+  // prompt keeps its turn markers.
+  return llama_tokenize(ctx->model, text, length, tokens,
+                        tokens != nullptr ? capacity : 0, add_special != 0,
+                        /*parse_special=*/true);
+}
+
+int32_t meeting_llama_token_piece(const meeting_llama* ctx,
+                                  int32_t token,
+                                  char* buf,
+                                  int32_t capacity) {
+  if (ctx == nullptr) return 0;
+  return llama_token_to_piece(ctx->model, token, buf,
+                              buf != nullptr ? capacity : 0, /*lstrip=*/0,
+                              /*special=*/false);
+}
+
+int32_t meeting_llama_is_eog(const meeting_llama* ctx, int32_t token) {
+  return ctx != nullptr && llama_token_is_eog(ctx->model, token) ? 1 : 0;
+}
+
+int32_t meeting_llama_chat_prompt(const meeting_llama* ctx,
+                                  const char* prompt,
+                                  char* buf,
+                                  int32_t capacity) {
+  if (ctx == nullptr || prompt == nullptr) return 0;
+  const llama_chat_message message = {"user", prompt};
+  // A null template selects the one stored in the model's metadata.
+  const int32_t length = llama_chat_apply_template(
+      ctx->model, nullptr, &message, 1, /*add_ass=*/true, buf,
+      buf != nullptr ? capacity : 0);
+  if (length < 0) return 0;
+  return length > capacity || buf == nullptr ? -length : length;
+}
+
+void meeting_llama_reset(meeting_llama* ctx) {
+  if (ctx == nullptr) return;
+  llama_kv_cache_clear(ctx->context);
+  llama_sampler_reset(ctx->sampler);
+  ctx->tokens.clear();
+}
+
+int32_t meeting_llama_truncate(meeting_llama* ctx, int32_t n_keep) {
+  if (ctx == nullptr) return -1;
+  n_keep = std::max(n_keep, 0);
+  if (n_keep >= static_cast<int32_t>(ctx->tokens.size())) return 0;
+  if (!llama_kv_cache_seq_rm(ctx->context, 0, n_keep, -1)) {
+    return Fail(ctx, "llama_kv_cache_seq_rm failed");
+  }
+  ctx->tokens.resize(static_cast<size_t>(n_keep));
+  return 0;
+}
+
+int32_t meeting_llama_decode(meeting_llama* ctx,
+                             const int32_t* tokens,
+                             int32_t count,
+                             int32_t n_threads) {
+  if (ctx == nullptr) return -1;
+  if (tokens == nullptr || count <= 0) return Fail(ctx, "no tokens");
+  if (meeting_llama_n_past(ctx) + count > meeting_llama_n_ctx(ctx)) {
+    return Fail(ctx, "tokens do not fit in the context");
+  }
+  llama_shim::UseThreads(ctx, n_threads);
+
+  // llama_batch_get_one() takes a mutable pointer but only reads the
+  // tokens.
+  auto* batch_tokens = const_cast<llama_token*>(tokens);
+  const auto n_batch = static_cast<int32_t>(llama_n_batch(ctx->context));
+  for (int32_t i = 0; i < count; i += n_batch) {
+    const int32_t n = std::min(n_batch, count - i);
+    if (llama_decode(ctx->context, llama_batch_get_one(batch_tokens + i, n)) !=
+        0) {
+      return Fail(ctx, "llama_decode failed");
+    }
+    ctx->tokens.insert(ctx->tokens.end(), tokens + i, tokens + i + n);
+  }
+  return 0;
+}
+
+int32_t meeting_llama_prefill(meeting_llama* ctx,
+                              const int32_t* tokens,
+                              int32_t count,
+                              int32_t n_threads) {
+  if (ctx == nullptr) return -1;
+  if (tokens == nullptr || count <= 0) return Fail(ctx, "no tokens");
+
+  const auto held = static_cast<int32_t>(ctx->tokens.size());
+  int32_t keep = 0;
+  while (keep < held && keep < count && ctx->tokens[keep] == tokens[keep]) {
+    ++keep;
+  }
+  // The last token is always evaluated again: sampling needs its logits,
+  // and only the most recent decode leaves them.
+  keep = std::min(keep, count - 1);
+  if (meeting_llama_truncate(ctx, keep) != 0) {
+    meeting_llama_reset(ctx);
+    keep = 0;
+  }
+  llama_sampler_reset(ctx->sampler);
+
+  if (meeting_llama_decode(ctx, tokens + keep, count - keep, n_threads) != 0) {
+    return -1;
+  }
+  return count - keep;
+}
+
+void meeting_llama_set_sampling(meeting_llama* ctx,
+                                float temperature,
+                                int32_t top_k,
+                                float top_p,
+                                uint32_t seed) {
+  if (ctx == nullptr) return;
+  llama_sampler* sampler = CreateSampler(temperature, top_k, top_p, seed);
+  if (sampler == nullptr) return;
+  llama_sampler_free(ctx->sampler);
+  ctx->sampler = sampler;
+}
+
+int32_t meeting_llama_set_grammar(meeting_llama* ctx, const char* grammar) {
+  if (ctx == nullptr) return -1;
+  if (ctx->grammar != nullptr) {
+    llama_sampler_free(ctx->grammar);
+    ctx->grammar = nullptr;
+  }
+  if (grammar == nullptr || grammar[0] == '\0') return 0;
+
+  ctx->grammar = llama_shim::InstantiateGrammar(ctx, grammar);
+  return ctx->grammar != nullptr ? 0 : -1;
+}
+
+int32_t meeting_llama_sample(meeting_llama* ctx) {
+  if (ctx == nullptr) return -1;
+  if (ctx->tokens.empty()) return Fail(ctx, "nothing decoded");
+  return llama_shim::Sample(ctx, ctx->sampler, ctx->grammar, -1);
+}
+
+int32_t meeting_llama_budget_transcript(const meeting_llama* ctx,
+                                        const char* lines,
+                                        int32_t n_lines,
+                                        int32_t n_context,
+                                        int32_t budget,
+                                        int32_t* tokens) {
+  if (ctx == nullptr || lines == nullptr || tokens == nullptr ||
+      n_lines <= 0 || n_context < 0 || n_context > n_lines) {
+    return -1;
+  }
+  std::vector<std::string_view> split;
+  std::string_view text(lines);
+  for (size_t start = 0;;) {
+    const size_t end = text.find('\n', start);
+    split.push_back(text.substr(start, end - start));
+    if (end == std::string_view::npos) break;
+    start = end + 1;
+  }
+  if (static_cast<int32_t>(split.size()) != n_lines) return -1;
+
+  // Lines are measured with their newline, as prompts hold them; context
+  // lines are not measured at all.
+  std::string line;
+  std::vector<int32_t> scratch;
+  for (int32_t i = n_context; i < n_lines; ++i) {
+    line.assign(split[i]).push_back('\n');
+    scratch.resize(line.size() + 1);
+    int32_t count = meeting_llama_tokenize(
+        ctx, line.c_str(), 0, scratch.data(),
+        static_cast<int32_t>(scratch.size()));
+    if (count < 0) {
+      scratch.resize(static_cast<size_t>(-count));
+      count = meeting_llama_tokenize(ctx, line.c_str(), 0, scratch.data(),
+                                     -count);
+    }
+    tokens[i] = std::max(count, 0);
+  }
+  return llama_shim::BudgetTranscript(split, n_context, budget, tokens);
+}
+
+int32_t meeting_llama_n_embd(const meeting_llama* ctx) {
+  return ctx != nullptr && ctx->embeddings ? llama_n_embd(ctx->model) : 0;
+}
+
+int32_t meeting_llama_embed(meeting_llama* ctx,
+                            const char* text,
+                            int32_t n_threads,
+                            float* out,
+                            int32_t capacity) {
+  if (ctx == nullptr || text == nullptr) return 0;
+  if (!ctx->embeddings) {
+    Fail(ctx, "not an embedding context");
+    return 0;
+  }
+  const int32_t n_embd = llama_n_embd(ctx->model);
+  if (out == nullptr || capacity < n_embd) return -n_embd;
+
+  // The context's token list is free scratch, as nothing is kept.
+  std::vector<int32_t>& tokens = ctx->tokens;
+  tokens.resize(std::strlen(text) + 2);
+  int32_t count = meeting_llama_tokenize(ctx, text, 1, tokens.data(),
+                                         static_cast<int32_t>(tokens.size()));
+  if (count < 0) {
+    tokens.resize(static_cast<size_t>(-count));
+    count = meeting_llama_tokenize(ctx, text, 1, tokens.data(), -count);
+  }
+  count = std::min(count, meeting_llama_n_ctx(ctx));
+  if (count <= 0) {
+    tokens.clear();
+    Fail(ctx, "no tokens");
+    return 0;
+  }
+  llama_shim::UseThreads(ctx, n_threads);
+
+  llama_kv_cache_clear(ctx->context);
+  llama_batch batch = llama_batch_init(count, 0, 1);
+  for (int32_t i = 0; i < count; ++i) {
+    llama_shim::BatchAdd(&batch, tokens[i], i, llama_shim::kMainSequence,
+                         true);
+  }
+  const bool decoded = llama_decode(ctx->context, batch) == 0;
+  llama_batch_free(batch);
+  tokens.clear();
+  if (!decoded) {
+    Fail(ctx, "llama_decode failed");
+    return 0;
+  }
+
+  const float* pooled =
+      llama_get_embeddings_seq(ctx->context, llama_shim::kMainSequence);
+  if (pooled == nullptr) {
+    Fail(ctx, "no pooled embedding");
+    return 0;
+  }
+  double norm = 0.0;
+  for (int32_t i = 0; i < n_embd; ++i) norm += pooled[i] * pooled[i];
+  const float scale = norm > 0.0 ? static_cast<float>(1.0 / std::sqrt(norm))
+                                 : 0.0f;
+  for (int32_t i = 0; i < n_embd; ++i) out[i] = pooled[i] * scale;
+  return n_embd;
+}
+
+int32_t meeting_llama_set_draft(meeting_llama* ctx, meeting_llama* draft) {
+  if (ctx == nullptr) return -1;
+  if (draft == ctx) return Fail(ctx, "a model cannot draft for itself");
+  if (draft != nullptr && !SameVocabulary(ctx->model, draft->model)) {
+    return Fail(ctx, "the draft model has a different vocabulary");
+  }
+  ctx->draft = draft;
+  return 0;
+}
+
+int32_t meeting_llama_session_save(meeting_llama* ctx,
+                                   const char* path,
+                                   const char* metadata) {
+  if (ctx == nullptr) return -1;
+  if (path == nullptr) return Fail(ctx, "no session path");
+  const std::string text = metadata != nullptr ? metadata : "";
+  if (!llama_shim::SaveSession(ctx->context, ctx->fingerprint, ctx->tokens,
+                               text, path, &ctx->error)) {
+    return -1;
+  }
+  ctx->session_metadata = text;
+  return 0;
+}
+
+int32_t meeting_llama_session_load(meeting_llama* ctx, const char* path) {
+  if (ctx == nullptr) return -1;
+  if (path == nullptr) return Fail(ctx, "no session path");
+  meeting_llama_reset(ctx);
+  std::vector<int32_t> tokens;
+  std::string metadata;
+  if (!llama_shim::LoadSession(ctx->context, ctx->fingerprint, path, &tokens,
+                               &metadata, &ctx->error)) {
+    meeting_llama_reset(ctx);
+    return -1;
+  }
+  ctx->tokens = std::move(tokens);
+  ctx->session_metadata = std::move(metadata);
+  return static_cast<int32_t>(ctx->tokens.size());
+}
+
+const char* meeting_llama_session_metadata(const meeting_llama* ctx) {
+  return ctx != nullptr ? ctx->session_metadata.c_str() : "";
+}
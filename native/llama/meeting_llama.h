@@ -0,0 +1,395 @@
+#ifndef MEETING_NATIVE_LLAMA_MEETING_LLAMA_H_
+#define MEETING_NATIVE_LLAMA_MEETING_LLAMA_H_
+
+#include <stdint.h>
+
+#include "common/native_export.h"
+
+// Text generation on top of llama.cpp (LlamaFFI).
+//
+// Like the whisper shim, this exposes a small flat ABI instead of
+// llama.cpp's own, whose parameter structs are passed by value and change
+// layout between releases: options are scalar arguments and tokens are
+// plain int32 ids. Bump MEETING_LLAMA_ABI_VERSION whenever a function or
+// struct below is added or changed; LlamaFFI refuses to bind a library with
+// a different version.
+
+#define MEETING_LLAMA_ABI_VERSION 10
+
+typedef struct meeting_llama meeting_llama;
+
+NATIVE_API int32_t meeting_llama_abi_version(void);
+
+// Flags for meeting_llama_init().
+#define MEETING_LLAMA_INIT_USE_GPU 1
+// Creates an embedding context; see meeting_llama_embed().
+#define MEETING_LLAMA_INIT_EMBEDDINGS 2
+
+// Loads a GGUF model with a context of |n_ctx| tokens (<= 0 picks a default
+// no larger than the model was trained with), a combination of
+// MEETING_LLAMA_INIT_* |flags|. Returns null on failure.
+NATIVE_API meeting_llama* meeting_llama_init(const char* model_path,
+                                             int32_t n_ctx,
+                                             int32_t flags);
+
+NATIVE_API void meeting_llama_free(meeting_llama* ctx);
+
+// Description of the last failure, or "".
+NATIVE_API const char* meeting_llama_last_error(const meeting_llama* ctx);
+
+// Short description of the loaded model, e.g. "llama 3B Q4_K - Medium".
+NATIVE_API const char* meeting_llama_model_desc(const meeting_llama* ctx);
+
+// Context size in tokens, and tokens currently held in it.
+NATIVE_API int32_t meeting_llama_n_ctx(const meeting_llama* ctx);
+NATIVE_API int32_t meeting_llama_n_past(const meeting_llama* ctx);
+
+NATIVE_API int32_t meeting_llama_n_vocab(const meeting_llama* ctx);
+
+// Tokenizes UTF-8 |text| into at most |capacity| tokens, with the model's
+// BOS token first when |add_special| is set. Returns the token count, or
+// minus the count needed when |capacity| is too small.
+NATIVE_API int32_t meeting_llama_tokenize(const meeting_llama* ctx,
+                                          const char* text,
+                                          int32_t add_special,
+                                          int32_t* tokens,
+                                          int32_t capacity);
+
+// Writes the UTF-8 bytes of |token| to |buf| (not NUL-terminated). Returns
+// the byte count, or minus the count needed when |capacity| is too small.
+// A piece may end part-way through a multi-byte character that the next
+// token completes. Control tokens have no text.
+NATIVE_API int32_t meeting_llama_token_piece(const meeting_llama* ctx,
+                                             int32_t token,
+                                             char* buf,
+                                             int32_t capacity);
+
+// 1 if |token| ends a generation (EOS, end of turn, ...), else 0.
+NATIVE_API int32_t meeting_llama_is_eog(const meeting_llama* ctx,
+                                        int32_t token);
+
+// Wraps |prompt| as a single user turn in the model's chat template,
+// ready for the assistant's reply, and writes it to |buf| (not
+// NUL-terminated). Returns the byte count, minus the count needed when
+// |capacity| is too small, or 0 when the model has no usable template.
+NATIVE_API int32_t meeting_llama_chat_prompt(const meeting_llama* ctx,
+                                             const char* prompt,
+                                             char* buf,
+                                             int32_t capacity);
+
+// Empties the context.
+NATIVE_API void meeting_llama_reset(meeting_llama* ctx);
+
+// Drops every token after the first |n_keep| from the context. Returns 0,
+// or -1 on failure.
+NATIVE_API int32_t meeting_llama_truncate(meeting_llama* ctx, int32_t n_keep);
+
+// Appends |count| tokens to the context and evaluates them, in batches.
+// |n_threads| <= 0 keeps the previous thread count. Returns 0, or -1 on
+// failure (see meeting_llama_last_error()), including when the tokens do
+// not fit in the context.
+NATIVE_API int32_t meeting_llama_decode(meeting_llama* ctx,
+                                        const int32_t* tokens,
+                                        int32_t count,
+                                        int32_t n_threads);
+
+// Makes the context hold exactly |tokens|, ready to sample what follows.
+//
+// The context keeps every token it evaluated, prompts and completions
+// alike, so only the part of |tokens| after their common prefix with it is
+// evaluated; prompts that share their leading instructions, or extend the
+// previous prompt, cost only the difference. Returns the number of tokens
+// evaluated (at least 1), or -1 on failure.
+NATIVE_API int32_t meeting_llama_prefill(meeting_llama* ctx,
+                                         const int32_t* tokens,
+                                         int32_t count,
+                                         int32_t n_threads);
+
+// Sampling used by meeting_llama_sample(). |temperature| <= 0 samples
+// greedily; |top_k| <= 0 and |top_p| >= 1 disable those filters.
+// MEETING_LLAMA_RANDOM_SEED seeds from the clock.
+#define MEETING_LLAMA_RANDOM_SEED 0xFFFFFFFFu
+
+NATIVE_API void meeting_llama_set_sampling(meeting_llama* ctx,
+                                           float temperature,
+                                           int32_t top_k,
+                                           float top_p,
+                                           uint32_t seed);
+
+// Constrains meeting_llama_sample() to text matching |grammar|, in
+// llama.cpp's GBNF with a rule named "root", from the start of that rule;
+// call it before each constrained completion. Once the grammar is complete
+// only end-of-generation tokens are allowed, so a completion stops right
+// after the structure it describes. Each distinct grammar is parsed once
+// per context and reused. Null or "" removes the constraint. Returns 0, or
+// -1 on failure. llama.cpp logs grammars it cannot parse and leaves them
+// unconstrained.
+NATIVE_API int32_t meeting_llama_set_grammar(meeting_llama* ctx,
+                                             const char* grammar);
+
+// Samples the next token from the logits of the last decoded token, or
+// returns -1 when nothing has been decoded. The token is not appended;
+// pass it to meeting_llama_decode() to continue.
+NATIVE_API int32_t meeting_llama_sample(meeting_llama* ctx);
+
+// Transcript budgeting.
+//
+// Transcripts are prompted one line per utterance. Many lines add nothing
+// but prefill work: speech in the audio two batches share is transcribed
+// twice, and "yeah", "mm-hmm" or "[BLANK_AUDIO]" lines tell a summary
+// nothing.
+
+// Measures the |n_lines| '\n'-separated UTF-8 |lines| of a transcript,
+// "[HH:MM:SS] Speaker: text", in the model's tokens, and picks those worth
+// a place in a prompt. Writes to |tokens| what each line takes with its
+// newline, or 0 when it is left out:
+// - repeats of one of the lines shortly before it;
+// - lines of hesitations and backchannel only;
+// - when the rest still take more than |budget| tokens (> 0), those with
+//   the fewest distinct content words for their tokens, until they fit.
+// The first |n_context| lines are already in the prompt: they are only
+// compared against, and their entries of |tokens| left as they are. Only
+// reads the model's vocabulary, so it may be called while jobs run on
+// |ctx|. Returns the tokens of the lines kept after them, or -1 on invalid
+// arguments, including text with other than |n_lines| lines.
+NATIVE_API int32_t meeting_llama_budget_transcript(const meeting_llama* ctx,
+                                                   const char* lines,
+                                                   int32_t n_lines,
+                                                   int32_t n_context,
+                                                   int32_t budget,
+                                                   int32_t* tokens);
+
+// Embeddings.
+//
+// A context initialized with MEETING_LLAMA_INIT_EMBEDDINGS maps text to a
+// vector instead of continuing it, pooled over the text's tokens as the
+// model specifies, or by their mean for models that do not. Texts about
+// the same subject get vectors pointing the same way. Small sentence
+// encoders such as all-MiniLM-L6-v2 embed a sentence in milliseconds.
+
+// Length of the context's embeddings, or 0 for a generation context.
+NATIVE_API int32_t meeting_llama_n_embd(const meeting_llama* ctx);
+
+// Embeds UTF-8 |text| on the calling thread, ignoring what does not fit in
+// the context, and writes the vector, scaled to unit length, to |out|.
+// |n_threads| <= 0 keeps the previous thread count. Returns the vector's
+// length, minus it when |capacity| is too small, or 0 on failure.
+NATIVE_API int32_t meeting_llama_embed(meeting_llama* ctx,
+                                       const char* text,
+                                       int32_t n_threads,
+                                       float* out,
+                                       int32_t capacity);
+
+// Speculative decoding.
+//
+// A draft is a second, much smaller model with the same vocabulary, such
+// as the 1B model of the same family. With one attached, generation jobs
+// on the context let the draft guess a few tokens ahead and check the
+// guesses in one batch, keeping those the context would have sampled
+// itself: completions are unchanged, but each evaluation of the larger
+// model can yield several tokens. The worker uses it while a single
+// completion is generating on the context; when several are, they already
+// share each evaluation.
+
+// Attaches |draft| to |ctx|, or detaches it when null. The draft is not
+// owned: it must outlive the attachment, and like |ctx| must not be used
+// directly while jobs on |ctx| are in flight. Returns 0, or -1 when the
+// vocabularies differ.
+NATIVE_API int32_t meeting_llama_set_draft(meeting_llama* ctx,
+                                           meeting_llama* draft);
+
+// Session snapshots.
+//
+// A snapshot holds the tokens the context has evaluated and their KV cache,
+// so a context can pick up where an earlier one (in this process or a
+// previous run) stopped: the next meeting_llama_prefill() only evaluates
+// what follows the restored tokens, instead of the whole prompt. Snapshots
+// are tied to the model they were taken with and to this machine.
+
+// Writes the context's tokens and cache, plus the caller's UTF-8
+// |metadata| (may be null), to |path|, replacing it atomically. Returns 0,
+// or -1 on failure.
+NATIVE_API int32_t meeting_llama_session_save(meeting_llama* ctx,
+                                              const char* path,
+                                              const char* metadata);
+
+// Replaces the context's contents with the snapshot at |path|, mapping the
+// file rather than reading it. Returns the number of tokens restored, or -1
+// on failure (a missing file, another model's snapshot, ...), which leaves
+// the context empty.
+NATIVE_API int32_t meeting_llama_session_load(meeting_llama* ctx,
+                                              const char* path);
+
+// Metadata of the snapshot last saved or restored, or "".
+NATIVE_API const char* meeting_llama_session_metadata(
+    const meeting_llama* ctx);
+
+// Generation worker.
+//
+// A worker owns one long-lived thread that runs generation (and session
+// snapshot) jobs. Jobs on the same context run side by side: each step
+// evaluates one batch holding the next token of every completion under way and
+// prompt tokens of the jobs just started, so a client submitting while
+// another's job runs does not wait for it to finish. Jobs start in submission
+// order, foreground jobs ahead of background ones, as the context has room for
+// their prompts and completions; background jobs pause while any foreground job
+// runs. Session jobs wait for the jobs before them to finish and hold back the
+// background jobs after them; foreground jobs go ahead of a waiting session
+// job. Submission copies the prompt and returns immediately with a job id; as
+// tokens are sampled the worker hands events to |callback| on its thread (from
+// Dart, a NativeCallable.listener), so text streams out while the completion is
+// still running. Every job ends with exactly one DONE, CANCELLED or FAILED
+// event.
+//
+// The receiver owns each event and releases it with
+// meeting_llama_event_free(); a null event means the job failed for lack of
+// memory and no further events follow.
+//
+// Contexts used by queued jobs must stay alive until their last event
+// arrives, and must not be used directly while jobs are in flight.
+
+// |text| is the next piece of the completion. Pieces always end on a
+// character boundary; bytes of an unfinished character are held back until
+// it completes.
+#define MEETING_LLAMA_EVENT_TOKEN 0
+// The completion ended (end of generation or |max_tokens|). |text| is any
+// held-back remainder, usually "". For analyses, every task has ended.
+#define MEETING_LLAMA_EVENT_DONE 1
+// meeting_llama_worker_cancel() or meeting_llama_worker_free() stopped the
+// job. |text| is "".
+#define MEETING_LLAMA_EVENT_CANCELLED 2
+// |text| describes the failure.
+#define MEETING_LLAMA_EVENT_FAILED -1
+// Analyses only: the completion of |task| ended; the others may still be
+// running. |text| is as for DONE.
+#define MEETING_LLAMA_EVENT_TASK_DONE 3
+
+// Mirrored by NativeLlamaEvent in lib/core/ai/model_ffi.dart.
+typedef struct meeting_llama_event {
+  // One of MEETING_LLAMA_EVENT_*.
+  int32_t kind;
+  // Tokens generated so far by the job, or for analyses by the task.
+  int32_t n_tokens;
+  // Index of the analysis task the event is about, otherwise 0.
+  int32_t task;
+  // UTF-8, owned by the event.
+  const char* text;
+} meeting_llama_event;
+
+typedef struct meeting_llama_worker meeting_llama_worker;
+
+typedef void (*meeting_llama_callback)(int64_t job_id,
+                                       meeting_llama_event* event);
+
+// Flags for meeting_llama_worker_generate() and
+// meeting_llama_worker_analyze().
+// Wraps the prompt in the model's chat template (see
+// meeting_llama_chat_prompt()); the raw prompt is used when it has none.
+#define MEETING_LLAMA_GENERATE_CHAT 1
+// Runs the job in the background: it starts after the foreground jobs
+// queued and pauses while any runs, for work such as re-summarizing that
+// can wait on the live one.
+#define MEETING_LLAMA_GENERATE_BACKGROUND 2
+
+// Returns null on invalid arguments.
+NATIVE_API meeting_llama_worker* meeting_llama_worker_create(
+    meeting_llama_callback callback);
+
+// Cancels the running and queued jobs, then stops the thread.
+NATIVE_API void meeting_llama_worker_free(meeting_llama_worker* worker);
+
+// Pins the worker thread, and with it the compute threads it starts, to
+// the |count| logical CPUs |cpus|, typically Llama's share of the cores as
+// planned by meeting_whisper_sched_cpus(). Takes effect before the
+// worker's next step. An empty set leaves the placement as it is; on
+// Apple platforms the thread runs at a performance QoS class instead.
+NATIVE_API void meeting_llama_worker_set_cpus(meeting_llama_worker* worker,
+                                              const int32_t* cpus,
+                                              int32_t count);
+
+// Queues a completion of |prompt| on |ctx|. The prompt is evaluated as by
+// meeting_llama_prefill(), so whatever the context still holds of it from
+// earlier jobs is reused and it stays there for later ones. At most
+// |max_tokens| are generated, fewer when the job runs alone and the
+// context has no more room; a prompt that fills the context alone fails
+// the job. Sampling options are as for
+// meeting_llama_set_sampling(), with a clock seed; a non-null |grammar|
+// constrains the completion as meeting_llama_set_grammar() does. Returns
+// the job id, or -1 on invalid arguments.
+NATIVE_API int64_t meeting_llama_worker_generate(meeting_llama_worker* worker,
+                                                 meeting_llama* ctx,
+                                                 const char* prompt,
+                                                 int32_t max_tokens,
+                                                 float temperature,
+                                                 int32_t top_k,
+                                                 float top_p,
+                                                 int32_t n_threads,
+                                                 int32_t flags,
+                                                 const char* grammar);
+
+// Most tasks an analysis can run at once.
+#define MEETING_LLAMA_MAX_TASKS 4
+
+// One completion of an analysis. Mirrored by NativeLlamaTask in
+// lib/core/ai/model_ffi.dart.
+typedef struct meeting_llama_task {
+  const char* prompt;
+  int32_t max_tokens;
+  // GBNF the completion must match, or null.
+  const char* grammar;
+} meeting_llama_task;
+
+// Queues an analysis: completions of up to MEETING_LLAMA_MAX_TASKS prompts
+// about the same text, typically one transcript followed by different
+// questions.
+//
+// The prompts' common prefix is evaluated once, as by
+// meeting_llama_prefill(), and stays in the context for later jobs. Each
+// task then gets its own sequence forked from it in the KV cache, which
+// shares the prefix's cells rather than copying them, evaluates the rest
+// of its prompt there, and the tasks generate together, one batch per
+// step. Forked sequences are dropped when the job ends. TOKEN and
+// TASK_DONE events carry the task index; the job ends with DONE once every
+// task has. Options are as for meeting_llama_worker_generate(), with the
+// context's free room shared out between tasks. Returns the job id, or -1
+// on invalid arguments. The tasks are copied.
+NATIVE_API int64_t meeting_llama_worker_analyze(meeting_llama_worker* worker,
+                                                meeting_llama* ctx,
+                                                const meeting_llama_task* tasks,
+                                                int32_t n_tasks,
+                                                float temperature,
+                                                int32_t top_k,
+                                                float top_p,
+                                                int32_t n_threads,
+                                                int32_t flags);
+
+// Stops job |job_id|: a queued job is completed with CANCELLED at once, a
+// running one after the batch being evaluated. Returns 1, or 0 if the job
+// already finished.
+NATIVE_API int32_t meeting_llama_worker_cancel(meeting_llama_worker* worker,
+                                               int64_t job_id);
+
+// Queues meeting_llama_session_save() on |ctx|, after the jobs before it.
+// The job ends with DONE, or FAILED and the error. Returns the job id, or
+// -1 on invalid arguments.
+NATIVE_API int64_t meeting_llama_worker_save_session(
+    meeting_llama_worker* worker,
+    meeting_llama* ctx,
+    const char* path,
+    const char* metadata);
+
+// Queues meeting_llama_session_load() on |ctx|. The job ends with DONE,
+// |n_tokens| the tokens restored and |text| the snapshot's metadata, or
+// FAILED and the error. Returns the job id, or -1 on invalid arguments.
+NATIVE_API int64_t meeting_llama_worker_load_session(
+    meeting_llama_worker* worker,
+    meeting_llama* ctx,
+    const char* path);
+
+// Number of jobs queued or running.
+NATIVE_API int32_t meeting_llama_worker_pending(
+    const meeting_llama_worker* worker);
+
+NATIVE_API void meeting_llama_event_free(meeting_llama_event* event);
+
+#endif  // MEETING_NATIVE_LLAMA_MEETING_LLAMA_H_
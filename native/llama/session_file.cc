@@ -0,0 +1,201 @@
+#include "llama/session_file.h"
+
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#include "common/mapped_file.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace llama_shim {
+
+namespace {
+
+constexpr uint32_t kSessionMagic = 0x564b4c4d;  // "MLKV"
+constexpr uint32_t kSessionVersion = 1;
+
+constexpr uint64_t kFnvOffset = 0xcbf29ce484222325ull;
+constexpr uint64_t kFnvPrime = 0x100000001b3ull;
+
+// Start of a snapshot file, followed by |n_tokens| int32 token ids,
+// |metadata_size| bytes of metadata and |state_size| bytes of cache, all in
+// the host's byte order: a snapshot is only ever read back on the machine
+// that wrote it.
+struct SessionHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t fingerprint;
+  uint32_t n_tokens;
+  uint32_t reserved;
+  uint64_t metadata_size;
+  uint64_t state_size;
+};
+
+uint64_t HashBytes(uint64_t h, const void* data, size_t size) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    h = (h ^ bytes[i]) * kFnvPrime;
+  }
+  return h;
+}
+
+#if defined(_WIN32)
+
+std::wstring WidePath(const std::string& path) {
+  const int size = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr,
+                                       0);
+  if (size <= 0) return std::wstring();
+  std::wstring wide(static_cast<size_t>(size), L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide[0], size);
+  return wide;
+}
+
+std::FILE* OpenForWriting(const std::string& path) {
+  return _wfopen(WidePath(path).c_str(), L"wb");
+}
+
+bool ReplaceFile(const std::string& from, const std::string& to) {
+  return MoveFileExW(WidePath(from).c_str(), WidePath(to).c_str(),
+                     MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+void RemoveFile(const std::string& path) {
+  DeleteFileW(WidePath(path).c_str());
+}
+
+#else
+
+std::FILE* OpenForWriting(const std::string& path) {
+  return std::fopen(path.c_str(), "wb");
+}
+
+bool ReplaceFile(const std::string& from, const std::string& to) {
+  return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+void RemoveFile(const std::string& path) {
+  std::remove(path.c_str());
+}
+
+#endif
+
+bool Fail(std::string* error, const char* message) {
+  *error = message;
+  return false;
+}
+
+}  // namespace
+
+uint64_t ModelFingerprint(const llama_model* model) {
+  char description[128] = {};
+  llama_model_desc(model, description, sizeof(description));
+  const uint64_t size = llama_model_size(model);
+  const uint64_t n_params = llama_model_n_params(model);
+  const int32_t n_vocab = llama_n_vocab(model);
+
+  uint64_t h = kFnvOffset;
+  h = HashBytes(h, description, std::strlen(description));
+  h = HashBytes(h, &size, sizeof(size));
+  h = HashBytes(h, &n_params, sizeof(n_params));
+  h = HashBytes(h, &n_vocab, sizeof(n_vocab));
+  return h;
+}
+
+bool SaveSession(llama_context* context,
+                 uint64_t fingerprint,
+                 const std::vector<int32_t>& tokens,
+                 const std::string& metadata,
+                 const char* path,
+                 std::string* error) {
+  std::vector<uint8_t> state;
+  try {
+    state.resize(llama_state_seq_get_size(context, 0));
+  } catch (const std::bad_alloc&) {
+    return Fail(error, "out of memory");
+  }
+  if (llama_state_seq_get_data(context, state.data(), state.size(), 0) !=
+      state.size()) {
+    return Fail(error, "llama_state_seq_get_data failed");
+  }
+
+  SessionHeader header = {};
+  header.magic = kSessionMagic;
+  header.version = kSessionVersion;
+  header.fingerprint = fingerprint;
+  header.n_tokens = static_cast<uint32_t>(tokens.size());
+  header.metadata_size = metadata.size();
+  header.state_size = state.size();
+
+  const std::string final_path = path;
+  const std::string temp_path = final_path + ".tmp";
+  std::FILE* file = OpenForWriting(temp_path);
+  if (file == nullptr) return Fail(error, "cannot create the session file");
+  bool written =
+      std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+      std::fwrite(tokens.data(), sizeof(int32_t), tokens.size(), file) ==
+          tokens.size() &&
+      std::fwrite(metadata.data(), 1, metadata.size(), file) ==
+          metadata.size() &&
+      std::fwrite(state.data(), 1, state.size(), file) == state.size();
+  written = std::fclose(file) == 0 && written;
+  if (!written || !ReplaceFile(temp_path, final_path)) {
+    RemoveFile(temp_path);
+    return Fail(error, "cannot write the session file");
+  }
+  return true;
+}
+
+bool LoadSession(llama_context* context,
+                 uint64_t fingerprint,
+                 const char* path,
+                 std::vector<int32_t>* tokens,
+                 std::string* metadata,
+                 std::string* error) {
+  native_common::MappedFile file;
+  if (!file.Open(path, /*prefetch=*/true)) {
+    return Fail(error, "cannot open the session file");
+  }
+
+  SessionHeader header;
+  if (file.size() < sizeof(header)) {
+    return Fail(error, "truncated session file");
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (header.magic != kSessionMagic || header.version != kSessionVersion) {
+    return Fail(error, "not a session file");
+  }
+  if (header.fingerprint != fingerprint) {
+    return Fail(error, "session was saved with another model");
+  }
+  if (header.n_tokens > llama_n_ctx(context)) {
+    return Fail(error, "session does not fit in the context");
+  }
+
+  const uint64_t tokens_size = uint64_t{header.n_tokens} * sizeof(int32_t);
+  const uint64_t body_size = file.size() - sizeof(header);
+  if (tokens_size > body_size ||
+      header.metadata_size > body_size - tokens_size ||
+      header.state_size != body_size - tokens_size - header.metadata_size) {
+    return Fail(error, "truncated session file");
+  }
+
+  const uint8_t* cursor = file.data() + sizeof(header);
+  tokens->resize(header.n_tokens);
+  std::memcpy(tokens->data(), cursor, tokens_size);
+  cursor += tokens_size;
+  metadata->assign(reinterpret_cast<const char*>(cursor),
+                   header.metadata_size);
+  cursor += header.metadata_size;
+
+  if (llama_state_seq_set_data(context, cursor, header.state_size, 0) == 0) {
+    return Fail(error, "llama_state_seq_set_data failed");
+  }
+  return true;
+}
+
+}  // namespace llama_shim
@@ -0,0 +1,50 @@
+#ifndef MEETING_NATIVE_LLAMA_SESSION_FILE_H_
+#define MEETING_NATIVE_LLAMA_SESSION_FILE_H_
+
+// KV-cache snapshots for the llama shim. Not part of the C ABI.
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "llama.h"
+
+namespace llama_shim {
+
+// Identifies the weights a snapshot was taken with; a cache is meaningless
+// to any other model.
+uint64_t ModelFingerprint(const llama_model* model);
+
+// Writes the cache of sequence 0 of |context|, the |tokens| it holds and
+// the caller's |metadata| to |path|.
+//
+// The file is written next to |path| and renamed over it once complete, so
+// a crash mid-save leaves the previous snapshot intact. Only occupied cache
+// cells are stored: a snapshot is the size of the tokens evaluated, not of
+// the context. Returns false and sets |error| on failure.
+bool SaveSession(llama_context* context,
+                 uint64_t fingerprint,
+                 const std::vector<int32_t>& tokens,
+                 const std::string& metadata,
+                 const char* path,
+                 std::string* error);
+
+// Restores a snapshot written by SaveSession() into sequence 0 of
+// |context|, which should be empty.
+//
+// The file is mapped rather than read, and the cache is copied straight
+// out of the mapping into the backend buffers. Snapshots from another
+// model, or holding more tokens than |context| fits, are refused. Returns
+// false and sets |error| on failure, after which the cache must be
+// cleared.
+bool LoadSession(llama_context* context,
+                 uint64_t fingerprint,
+                 const char* path,
+                 std::vector<int32_t>* tokens,
+                 std::string* metadata,
+                 std::string* error);
+
+}  // namespace llama_shim
+
+#endif  // MEETING_NATIVE_LLAMA_SESSION_FILE_H_
@@ -0,0 +1,119 @@
+#include "llama/speculative.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "llama.h"
+#include "llama/llama_context.h"
+
+namespace llama_shim {
+
+namespace {
+
+// Most tokens the draft guesses per step. Guesses after the first wrong
+// one are evaluated for nothing.
+constexpr int32_t kMaxGuesses = 8;
+
+// The draft stops guessing once its own pick is less likely than this;
+// the larger model mostly disagrees with such guesses.
+constexpr double kMinGuessProbability = 0.6;
+
+// The draft's pick for the token after its last decode, greedily, or -1
+// when it is unsure of it.
+llama_token Guess(meeting_llama* draft) {
+  const float* logits = llama_get_logits_ith(draft->context, -1);
+  const int32_t n_vocab = llama_n_vocab(draft->model);
+  llama_token best = 0;
+  for (llama_token id = 1; id < n_vocab; ++id) {
+    if (logits[id] > logits[best]) best = id;
+  }
+  double sum = 0.0;
+  for (llama_token id = 0; id < n_vocab; ++id) {
+    sum += std::exp(static_cast<double>(logits[id] - logits[best]));
+  }
+  return 1.0 / sum >= kMinGuessProbability ? best : -1;
+}
+
+// Up to |max_guesses| tokens the draft expects after |text|. Empty when
+// the draft is unsure, or cannot hold the text.
+std::vector<llama_token> Guesses(meeting_llama* ctx,
+                                 const std::vector<int32_t>& text,
+                                 int32_t max_guesses,
+                                 int32_t n_threads) {
+  meeting_llama* draft = ctx->draft;
+  // The draft keeps its own tokens between steps and jobs, so this
+  // evaluates only what it has not seen, usually the last few tokens.
+  std::vector<llama_token> guesses;
+  if (meeting_llama_prefill(draft, text.data(),
+                            static_cast<int32_t>(text.size()),
+                            n_threads) < 0) {
+    return guesses;
+  }
+
+  while (static_cast<int32_t>(guesses.size()) < max_guesses) {
+    llama_token guess = Guess(draft);
+    if (guess < 0) break;
+    guesses.push_back(guess);
+    if (llama_token_is_eog(draft->model, guess) ||
+        static_cast<int32_t>(guesses.size()) == max_guesses ||
+        meeting_llama_decode(draft, &guess, 1, n_threads) != 0) {
+      break;
+    }
+  }
+  return guesses;
+}
+
+}  // namespace
+
+int32_t DecodeAhead(meeting_llama* ctx,
+                    llama_seq_id seq,
+                    const std::vector<int32_t>& tokens,
+                    llama_sampler* chain,
+                    llama_sampler* grammar,
+                    int32_t max_tokens,
+                    int32_t n_threads,
+                    std::vector<int32_t>* sampled) {
+  const llama_token token = tokens.back();
+  const auto n_past = static_cast<int32_t>(tokens.size()) - 1;
+  // Each guess takes a position after |token|, and yields at most one
+  // token besides the one sampled after the last.
+  const int32_t max_guesses = std::min(
+      {kMaxGuesses, max_tokens - 1, meeting_llama_n_ctx(ctx) - n_past - 1});
+  std::vector<llama_token> guesses;
+  if (ctx->draft != nullptr && max_guesses > 0) {
+    guesses = Guesses(ctx, tokens, max_guesses, n_threads);
+  }
+
+  UseThreads(ctx, n_threads);
+  const auto n_guesses = static_cast<int32_t>(guesses.size());
+  llama_batch batch = llama_batch_init(1 + n_guesses, 0, 1);
+  BatchAdd(&batch, token, n_past, seq, true);
+  for (int32_t i = 0; i < n_guesses; ++i) {
+    BatchAdd(&batch, guesses[i], n_past + 1 + i, seq, true);
+  }
+  const bool decoded = llama_decode(ctx->context, batch) == 0;
+  llama_batch_free(batch);
+  if (!decoded) return Fail(ctx, "llama_decode failed");
+
+  // Output i of the batch holds the logits after guess i - 1 (|token| for
+  // the first), so it is sampled as long as every guess before it was.
+  int32_t accepted = 0;
+  for (;;) {
+    const llama_token next = Sample(ctx, chain, grammar, accepted);
+    sampled->push_back(next);
+    if (accepted == n_guesses || next != guesses[accepted] ||
+        llama_token_is_eog(ctx->model, next)) {
+      break;
+    }
+    ++accepted;
+  }
+  // The cache keeps |token| and the confirmed guesses; the last token
+  // sampled is evaluated by the next step.
+  if (accepted < n_guesses &&
+      !llama_kv_cache_seq_rm(ctx->context, seq, n_past + 1 + accepted, -1)) {
+    return Fail(ctx, "llama_kv_cache_seq_rm failed");
+  }
+  return 0;
+}
+
+}  // namespace llama_shim
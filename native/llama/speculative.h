@@ -0,0 +1,44 @@
+#ifndef MEETING_NATIVE_LLAMA_SPECULATIVE_H_
+#define MEETING_NATIVE_LLAMA_SPECULATIVE_H_
+
+// Speculative decoding for the llama shim's worker. Not part of the C ABI.
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "llama.h"
+#include "llama/meeting_llama.h"
+
+namespace llama_shim {
+
+// Evaluates the last of |tokens|, just sampled, in sequence |seq|, whose
+// cache holds all the others, and samples what follows it with |chain|,
+// constrained by |grammar| unless it is null, appending to |sampled|.
+//
+// Without a draft model this is one decode and one sample. With one, the
+// draft first guesses a few tokens ahead, and the context evaluates the
+// token and the guesses in one batch, then samples each position in turn
+// for as long as its sample matches the guess; the first mismatch, or the
+// position after the last guess, yields one more token of its own. So
+// every token appended is one the context sampled itself, what sampling
+// one at a time would have produced up to the rounding of a batched
+// evaluation, and a step costs roughly one decode however many guesses it
+// confirms.
+//
+// At most |max_tokens| (>= 1) are appended, fewer after an
+// end-of-generation token. The cache is left holding |tokens| and every
+// token appended but the last. Returns 0, or -1 on failure (see
+// meeting_llama_last_error()).
+int32_t DecodeAhead(meeting_llama* ctx,
+                    llama_seq_id seq,
+                    const std::vector<int32_t>& tokens,
+                    llama_sampler* chain,
+                    llama_sampler* grammar,
+                    int32_t max_tokens,
+                    int32_t n_threads,
+                    std::vector<int32_t>* sampled);
+
+}  // namespace llama_shim
+
+#endif  // MEETING_NATIVE_LLAMA_SPECULATIVE_H_
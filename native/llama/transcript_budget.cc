@@ -0,0 +1,169 @@
+#include "llama/transcript_budget.h"
+
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <string>
+#include <unordered_set>
+
+namespace llama_shim {
+
+namespace {
+
+// Lines kept before a line that it may repeat. Whisper transcribes the
+// audio two batches share twice, within a few lines of each other.
+constexpr size_t kRepeatWindow = 8;
+
+// Share of a line's words that must match a run in an earlier line for it
+// to be a repeat; the edges of an overlap are often transcribed slightly
+// differently.
+constexpr int32_t kRepeatPercent = 80;
+
+// Words a line can be made of alone and still say nothing: hesitations,
+// backchannel and acknowledgements.
+constexpr std::string_view kFillers[] = {
+    "ah",   "alright", "cool", "er",    "erm",  "exactly", "got",
+    "hm",   "hmm",     "huh",  "i",     "it",   "mhm",     "mm",
+    "mmm",  "nice",    "oh",   "ok",    "okay", "right",   "see",
+    "so",   "sure",    "uh",   "uhm",   "um",   "umm",     "well",
+    "yeah", "yep",     "yes",  "yup",
+};
+
+// Words too common to tell lines apart when packing.
+constexpr std::string_view kStopWords[] = {
+    "a",     "about", "all",   "also", "an",    "and",   "are",  "as",
+    "at",    "be",    "but",   "can",  "do",    "for",   "from", "have",
+    "he",    "if",    "in",    "is",   "just",  "kind",  "know", "like",
+    "me",    "mean",  "my",    "no",   "not",   "of",    "on",   "or",
+    "our",   "she",   "that",  "the",  "there", "they",  "this", "think",
+    "to",    "was",   "we",    "what", "with",  "would", "you",  "your",
+};
+
+template <size_t N>
+bool Contains(const std::string_view (&words)[N], const std::string& word) {
+  return std::find(words, words + N, word) != words + N;
+}
+
+bool IsWordByte(unsigned char c) {
+  // Bytes of multi-byte characters are letters of some script.
+  return c >= 0x80 || std::isalnum(c) || c == '\'';
+}
+
+// Lowercased words of what |line| says, past its "[time] Speaker: "
+// prefix and without bracketed annotations.
+std::vector<std::string> Words(std::string_view line) {
+  if (!line.empty() && line.front() == '[') {
+    const size_t close = line.find(']');
+    if (close != std::string_view::npos) line.remove_prefix(close + 1);
+  }
+  const size_t speaker = line.find(": ");
+  if (speaker != std::string_view::npos) line.remove_prefix(speaker + 2);
+
+  std::vector<std::string> words;
+  std::string word;
+  int depth = 0;
+  for (const char ch : line) {
+    const auto c = static_cast<unsigned char>(ch);
+    if (c == '[' || c == '(') ++depth;
+    if (depth == 0 && IsWordByte(c)) {
+      word.push_back(static_cast<char>(std::tolower(c)));
+    } else if (!word.empty()) {
+      words.push_back(std::move(word));
+      word.clear();
+    }
+    if ((c == ']' || c == ')') && depth > 0) --depth;
+  }
+  if (!word.empty()) words.push_back(std::move(word));
+  return words;
+}
+
+bool IsBackchannel(const std::vector<std::string>& words) {
+  return std::all_of(words.begin(), words.end(), [](const std::string& w) {
+    return Contains(kFillers, w);
+  });
+}
+
+// Longest run of words |a| and |b| share.
+size_t LongestCommonRun(const std::vector<std::string>& a,
+                        const std::vector<std::string>& b) {
+  std::vector<size_t> previous(b.size() + 1, 0);
+  std::vector<size_t> current(b.size() + 1, 0);
+  size_t longest = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    for (size_t j = 0; j < b.size(); ++j) {
+      current[j + 1] = a[i] == b[j] ? previous[j] + 1 : 0;
+      longest = std::max(longest, current[j + 1]);
+    }
+    std::swap(previous, current);
+  }
+  return longest;
+}
+
+// Distinct words of |words| that carry content.
+size_t ContentWords(const std::vector<std::string>& words) {
+  std::unordered_set<std::string> content;
+  for (const std::string& word : words) {
+    if (!Contains(kFillers, word) && !Contains(kStopWords, word)) {
+      content.insert(word);
+    }
+  }
+  return content.size();
+}
+
+}  // namespace
+
+int32_t BudgetTranscript(const std::vector<std::string_view>& lines,
+                         int32_t n_context,
+                         int32_t budget,
+                         int32_t* tokens) {
+  const auto n_lines = static_cast<int32_t>(lines.size());
+  std::vector<std::vector<std::string>> words(lines.size());
+  std::deque<int32_t> recent;
+  std::vector<int32_t> kept;
+  for (int32_t i = 0; i < n_lines; ++i) {
+    words[i] = Words(lines[i]);
+    if (i >= n_context) {
+      bool drop = tokens[i] <= 0 || words[i].empty() ||
+                  IsBackchannel(words[i]);
+      for (const int32_t earlier : recent) {
+        if (drop) break;
+        const size_t run = LongestCommonRun(words[i], words[earlier]);
+        drop = static_cast<int32_t>(run) * 100 >=
+               static_cast<int32_t>(words[i].size()) * kRepeatPercent;
+      }
+      if (drop) {
+        tokens[i] = 0;
+        continue;
+      }
+      kept.push_back(i);
+    }
+    recent.push_back(i);
+    if (recent.size() > kRepeatWindow) recent.pop_front();
+  }
+
+  int32_t total = 0;
+  for (const int32_t i : kept) total += tokens[i];
+  if (budget <= 0 || total <= budget) return total;
+
+  // Densest lines first, the later of two equally dense ones, then as many
+  // of the rest as still fit.
+  std::vector<double> density(lines.size(), 0.0);
+  for (const int32_t i : kept) {
+    density[i] = static_cast<double>(ContentWords(words[i])) / tokens[i];
+  }
+  std::vector<int32_t> order = kept;
+  std::stable_sort(order.begin(), order.end(), [&](int32_t a, int32_t b) {
+    return density[a] != density[b] ? density[a] > density[b] : a > b;
+  });
+  total = 0;
+  for (const int32_t i : order) {
+    if (total + tokens[i] <= budget) {
+      total += tokens[i];
+    } else {
+      tokens[i] = 0;
+    }
+  }
+  return total;
+}
+
+}  // namespace llama_shim
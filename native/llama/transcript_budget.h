@@ -0,0 +1,30 @@
+#ifndef MEETING_NATIVE_LLAMA_TRANSCRIPT_BUDGET_H_
+#define MEETING_NATIVE_LLAMA_TRANSCRIPT_BUDGET_H_
+
+// Transcript compaction for the llama shim. Not part of the C ABI.
+
+#include <stdint.h>
+
+#include <string_view>
+#include <vector>
+
+namespace llama_shim {
+
+// Picks the transcript |lines| worth their place in a prompt, as
+// meeting_llama_budget_transcript() describes, given in |tokens| what each
+// takes. Zeroes |tokens| for the lines left out and returns the tokens kept
+// after the first |n_context|.
+//
+// Only the words of a line count, lowercased, after its "[time] Speaker: "
+// prefix and without bracketed annotations such as "[BLANK_AUDIO]" or
+// "(laughs)". A line is a repeat when its words make up nearly all of a
+// run of words in one of the few lines kept before it, whoever spoke them.
+// Packing prefers lines with the most distinct content words per token.
+int32_t BudgetTranscript(const std::vector<std::string_view>& lines,
+                         int32_t n_context,
+                         int32_t budget,
+                         int32_t* tokens);
+
+}  // namespace llama_shim
+
+#endif  // MEETING_NATIVE_LLAMA_TRANSCRIPT_BUDGET_H_
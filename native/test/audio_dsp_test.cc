@@ -0,0 +1,112 @@
+// Tests that the 16-bit audio kernels agree with the float ones, run with
+// ctest.
+
+#include "audio/audio_dsp.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "test/expect.h"
+
+namespace {
+
+using native_test::current_test;
+
+constexpr int32_t kRate = 16000;
+constexpr double kPi = 3.14159265358979323846;
+
+// An odd length, so the scalar tails run as well as the vector loops.
+constexpr int32_t kCount = 16001;
+
+bool Near(double expected, double actual, double relative) {
+  return std::abs(expected - actual) <=
+         relative * std::max(std::abs(expected), 1e-9);
+}
+
+// Compares the s16 metrics of |pcm| with the float metrics of the same
+// samples. The histograms must match exactly unless |pcm| holds -32768,
+// which the s16 kernel saturates to 32767.
+void ExpectParity(const std::vector<int16_t>& pcm, bool same_histogram) {
+  std::vector<float> samples(pcm.size());
+  EXPECT_EQ(0, audio_dsp_pcm16_to_float(pcm.data(),
+                                        static_cast<int32_t>(pcm.size()),
+                                        1.0f, samples.data()));
+
+  audio_dsp_quality_metrics s16;
+  audio_dsp_quality_metrics f32;
+  int32_t s16_histogram[AUDIO_DSP_NOISE_BINS];
+  int32_t f32_histogram[AUDIO_DSP_NOISE_BINS];
+  const auto count = static_cast<int32_t>(pcm.size());
+  EXPECT_EQ(0, audio_dsp_compute_quality_metrics_s16(pcm.data(), count, kRate,
+                                                     s16_histogram, &s16));
+  EXPECT_EQ(0, audio_dsp_compute_quality_metrics(samples.data(), count, kRate,
+                                                 f32_histogram, &f32));
+
+  EXPECT_TRUE(Near(f32.mean_abs, s16.mean_abs, 1e-4));
+  EXPECT_TRUE(Near(f32.rms, s16.rms, 1e-4));
+  EXPECT_TRUE(Near(f32.peak, s16.peak, 1e-4));
+  EXPECT_TRUE(Near(f32.spectral_centroid, s16.spectral_centroid, 1e-3));
+  EXPECT_TRUE(Near(f32.noise_floor, s16.noise_floor, 1e-4));
+  EXPECT_EQ(f32.zero_crossing_rate, s16.zero_crossing_rate);
+  EXPECT_EQ(f32.clip_count, s16.clip_count);
+  EXPECT_EQ(f32.sample_count, s16.sample_count);
+  if (same_histogram) {
+    for (int bin = 0; bin < AUDIO_DSP_NOISE_BINS; bin++) {
+      EXPECT_EQ(f32_histogram[bin], s16_histogram[bin]);
+    }
+  }
+}
+
+// Uniform white noise in [-amplitude, amplitude].
+std::vector<int16_t> WhiteNoise(int32_t amplitude) {
+  std::mt19937 random(7);
+  std::uniform_int_distribution<int32_t> uniform(-amplitude, amplitude);
+  std::vector<int16_t> pcm(kCount);
+  for (int16_t& sample : pcm) sample = static_cast<int16_t>(uniform(random));
+  return pcm;
+}
+
+void FullScaleNoiseMatches() {
+  current_test = "FullScaleNoiseMatches";
+  // Most first differences here are wider than int16.
+  ExpectParity(WhiteNoise(32767), /*same_histogram=*/true);
+}
+
+void QuietNoiseMatches() {
+  current_test = "QuietNoiseMatches";
+  ExpectParity(WhiteNoise(300), /*same_histogram=*/true);
+}
+
+void ToneMatches() {
+  current_test = "ToneMatches";
+  std::vector<int16_t> pcm(kCount);
+  for (int32_t i = 0; i < kCount; i++) {
+    pcm[i] = static_cast<int16_t>(
+        std::lround(12000.0 * std::sin(2.0 * kPi * 1000.0 * i / kRate)));
+  }
+  ExpectParity(pcm, /*same_histogram=*/true);
+}
+
+void FullScaleSquareWaveMatches() {
+  current_test = "FullScaleSquareWaveMatches";
+  // Steps of 65535 at 4 kHz, where the estimate is not yet steep.
+  std::vector<int16_t> pcm(kCount);
+  for (int32_t i = 0; i < kCount; i++) {
+    pcm[i] = static_cast<int16_t>(i % 4 < 2 ? 32767 : -32768);
+  }
+  ExpectParity(pcm, /*same_histogram=*/false);
+}
+
+}  // namespace
+
+int main() {
+  FullScaleNoiseMatches();
+  QuietNoiseMatches();
+  ToneMatches();
+  FullScaleSquareWaveMatches();
+  return native_test::TestResult();
+}
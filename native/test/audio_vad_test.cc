@@ -0,0 +1,119 @@
+// Tests of the voice activity detector, run with ctest.
+
+#include "audio/audio_vad.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "test/expect.h"
+
+namespace {
+
+using native_test::current_test;
+
+constexpr int32_t kRate = 16000;
+constexpr double kPi = 3.14159265358979323846;
+
+// |seconds| of white noise with standard deviation |sigma|.
+std::vector<float> Noise(double seconds, float sigma) {
+  std::mt19937 random(7);
+  std::normal_distribution<float> normal(0.0f, sigma);
+  std::vector<float> audio(static_cast<size_t>(seconds * kRate));
+  for (float& sample : audio) sample = normal(random);
+  return audio;
+}
+
+// Adds a 220 Hz tone of |amplitude| from |start| to |end| seconds.
+void AddTone(std::vector<float>* audio,
+             double start,
+             double end,
+             float amplitude) {
+  for (auto i = static_cast<size_t>(start * kRate);
+       i < static_cast<size_t>(end * kRate) && i < audio->size(); ++i) {
+    (*audio)[i] += amplitude * static_cast<float>(
+                                   std::sin(2.0 * kPi * 220.0 * i / kRate));
+  }
+}
+
+// Feeds |audio| in 100 ms chunks, then flushes unless |flush| is false.
+std::vector<audio_vad_region> Detect(audio_vad* vad,
+                                     const std::vector<float>& audio,
+                                     bool flush = true) {
+  std::vector<audio_vad_region> regions;
+  audio_vad_region chunk_regions[8];
+  constexpr int32_t kChunk = kRate / 10;
+  for (size_t offset = 0; offset < audio.size(); offset += kChunk) {
+    const auto count = static_cast<int32_t>(
+        std::min<size_t>(kChunk, audio.size() - offset));
+    const int32_t n =
+        audio_vad_process(vad, audio.data() + offset, count, chunk_regions, 8);
+    regions.insert(regions.end(), chunk_regions, chunk_regions + n);
+  }
+  if (flush) {
+    const int32_t n = audio_vad_flush(vad, chunk_regions, 8);
+    regions.insert(regions.end(), chunk_regions, chunk_regions + n);
+  }
+  return regions;
+}
+
+audio_vad* CreateVad() {
+  audio_vad_config config;
+  audio_vad_default_config(kRate, &config);
+  return audio_vad_create(&config);
+}
+
+void FindsToneBursts() {
+  current_test = "FindsToneBursts";
+  std::vector<float> audio = Noise(8.0, 0.003f);
+  AddTone(&audio, 1.0, 2.0, 0.2f);
+  // Long enough for the floor to rise through it if it did so quickly.
+  AddTone(&audio, 3.0, 7.0, 0.2f);
+  audio_vad* vad = CreateVad();
+  const std::vector<audio_vad_region> regions = Detect(vad, audio);
+  audio_vad_free(vad);
+
+  EXPECT_EQ(2u, regions.size());
+  if (regions.size() != 2) return;
+  EXPECT_TRUE(std::abs(regions[0].start_sample - 16000) <= 320);
+  EXPECT_TRUE(std::abs(regions[0].end_sample - 32000) <= 320);
+  EXPECT_TRUE(std::abs(regions[1].start_sample - 48000) <= 320);
+  EXPECT_TRUE(std::abs(regions[1].end_sample - 112000) <= 320);
+}
+
+void SteadyNoiseDoesNotHoldSpeechOpen() {
+  current_test = "SteadyNoiseDoesNotHoldSpeechOpen";
+  audio_vad_config config;
+  audio_vad_default_config(kRate, &config);
+  // Mean level about 0.024, above the offset level.
+  std::vector<float> audio = Noise(60.0, 0.03f);
+  AddTone(&audio, 40.0, 41.0, 0.3f);
+  audio_vad* vad = CreateVad();
+  const std::vector<audio_vad_region> regions =
+      Detect(vad, audio, /*flush=*/false);
+
+  EXPECT_EQ(0, audio_vad_in_speech(vad));
+  EXPECT_TRUE(audio_vad_noise_level(vad) > config.offset_level);
+  // At most the noise's own onset, closed once the floor caught up, and
+  // the tone.
+  EXPECT_TRUE(!regions.empty() && regions.size() <= 2);
+  if (!regions.empty()) {
+    const audio_vad_region& tone = regions.back();
+    EXPECT_TRUE(std::abs(tone.start_sample - 40 * kRate) <= 320);
+    EXPECT_TRUE(std::abs(tone.end_sample - 41 * kRate) <= 320);
+  }
+  if (regions.size() == 2) EXPECT_TRUE(regions[0].end_sample < 20 * kRate);
+  audio_vad_free(vad);
+}
+
+}  // namespace
+
+int main() {
+  FindsToneBursts();
+  SteadyNoiseDoesNotHoldSpeechOpen();
+  return native_test::TestResult();
+}
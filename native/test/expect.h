@@ -0,0 +1,37 @@
+#ifndef MEETING_NATIVE_TEST_EXPECT_H_
+#define MEETING_NATIVE_TEST_EXPECT_H_
+
+// Minimal expectations for the native tests, which ctest runs as plain
+// executables: a failed expectation is reported and the test goes on, and
+// main() returns TestResult().
+
+#include <cstdio>
+
+namespace native_test {
+
+inline int failures = 0;
+inline const char* current_test = "";
+
+inline int TestResult() {
+  if (failures > 0) {
+    std::fprintf(stderr, "%d expectations failed\n", failures);
+    return 1;
+  }
+  std::printf("all passed\n");
+  return 0;
+}
+
+}  // namespace native_test
+
+#define EXPECT_TRUE(condition)                                              \
+  do {                                                                      \
+    if (!(condition)) {                                                     \
+      std::fprintf(stderr, "%s:%d: %s: expected %s\n", __FILE__, __LINE__, \
+                   native_test::current_test, #condition);                  \
+      ++native_test::failures;                                              \
+    }                                                                       \
+  } while (0)
+
+#define EXPECT_EQ(expected, actual) EXPECT_TRUE((expected) == (actual))
+
+#endif  // MEETING_NATIVE_TEST_EXPECT_H_
@@ -0,0 +1,197 @@
+// Tests of llama_shim::BudgetTranscript(), run with ctest.
+
+#include "llama/transcript_budget.h"
+
+#include <stdint.h>
+
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+#include "test/expect.h"
+
+namespace {
+
+using native_test::current_test;
+
+// Runs BudgetTranscript() over |lines|, each taking |tokens| as given, and
+// returns what it left of |tokens|.
+std::vector<int32_t> Budget(const std::vector<std::string_view>& lines,
+                            std::vector<int32_t> tokens,
+                            int32_t n_context = 0,
+                            int32_t budget = 0,
+                            int32_t* total = nullptr) {
+  const int32_t kept = llama_shim::BudgetTranscript(lines, n_context, budget,
+                                                    tokens.data());
+  if (total != nullptr) *total = kept;
+  return tokens;
+}
+
+void RepeatsWithinTheWindowAreDropped() {
+  current_test = "RepeatsWithinTheWindowAreDropped";
+  const std::vector<int32_t> kept = Budget(
+      {
+          "[00:01] Ana: we should ship the release on friday",
+          "[00:03] Ben: ship the release on Friday.",
+          "[00:05] Ben: ship the release on a friday",
+          "[00:07] Ana: the release notes are not written yet",
+      },
+      {9, 6, 7, 8});
+  // Any speaker; case and punctuation do not matter.
+  EXPECT_EQ(0, kept[1]);
+  // A run of 4 of its 6 words is not enough.
+  EXPECT_EQ(7, kept[2]);
+  EXPECT_EQ(8, kept[3]);
+}
+
+void RepeatsPastTheWindowAreKept() {
+  current_test = "RepeatsPastTheWindowAreKept";
+  std::vector<std::string_view> lines = {"Ana: budget review for the quarter"};
+  const std::string_view others[] = {
+      "Ben: alpha one",   "Ben: bravo two", "Ben: charlie three",
+      "Ben: delta four",  "Ben: echo five", "Ben: foxtrot six",
+      "Ben: golf seven",  "Ben: hotel eight",
+  };
+  lines.insert(lines.end(), std::begin(others), std::end(others));
+  lines.push_back("Ana: budget review for the quarter");
+  std::vector<int32_t> kept = Budget(lines, std::vector<int32_t>(10, 5));
+  // Eight lines came between them.
+  EXPECT_EQ(5, kept[9]);
+
+  // Dropped lines take no place in the window.
+  lines[8] = "Ben: yeah";
+  kept = Budget(lines, std::vector<int32_t>(10, 5));
+  EXPECT_EQ(0, kept[8]);
+  EXPECT_EQ(0, kept[9]);
+}
+
+void ContextLinesAreKeptAndCompared() {
+  current_test = "ContextLinesAreKeptAndCompared";
+  int32_t total = 0;
+  const std::vector<int32_t> kept = Budget(
+      {
+          "Ana: um yeah",
+          "Ana: the vendor contract renews in march",
+          "Ben: the vendor contract renews in march",
+          "Ben: we need legal to look at it",
+      },
+      {3, 8, 8, 7}, /*n_context=*/2, /*budget=*/0, &total);
+  EXPECT_EQ(3, kept[0]);
+  EXPECT_EQ(8, kept[1]);
+  EXPECT_EQ(0, kept[2]);
+  EXPECT_EQ(7, kept[3]);
+  // Context lines are not counted.
+  EXPECT_EQ(7, total);
+}
+
+void FillerOnlyLinesAreDropped() {
+  current_test = "FillerOnlyLinesAreDropped";
+  const std::vector<int32_t> kept = Budget(
+      {
+          "[00:01] Ana: Um, yeah. Okay.",
+          "[00:02] Ben: mhm",
+          "[00:03] Ana: okay, let's move on",
+          "[00:04] Ben: right, I see",
+          "[00:05] Ana: ",
+      },
+      {4, 2, 5, 4, 1});
+  EXPECT_EQ(0, kept[0]);
+  EXPECT_EQ(0, kept[1]);
+  EXPECT_EQ(5, kept[2]);
+  EXPECT_EQ(0, kept[3]);
+  // Nothing said at all.
+  EXPECT_EQ(0, kept[4]);
+}
+
+void BracketedAnnotationsAreIgnored() {
+  current_test = "BracketedAnnotationsAreIgnored";
+  const std::vector<int32_t> kept = Budget(
+      {
+          "[00:01] [BLANK_AUDIO]",
+          "[00:02] Ana: (laughs) [MUSIC]",
+          "[00:03] Ana: the demo (laughs) went [inaudible] really well",
+          "[00:04] Ben: the demo went really well",
+          "[00:05] Ben: (coughs) okay",
+      },
+      {4, 5, 9, 6, 3});
+  EXPECT_EQ(0, kept[0]);
+  EXPECT_EQ(0, kept[1]);
+  EXPECT_EQ(9, kept[2]);
+  // The annotations do not keep it from repeating the line before.
+  EXPECT_EQ(0, kept[3]);
+  EXPECT_EQ(0, kept[4]);
+}
+
+void LinesWithoutTokensAreDropped() {
+  current_test = "LinesWithoutTokensAreDropped";
+  const std::vector<int32_t> kept =
+      Budget({"Ana: the roadmap slipped", "Ben: hiring is on track"}, {0, 5});
+  EXPECT_EQ(0, kept[0]);
+  EXPECT_EQ(5, kept[1]);
+}
+
+void PackingPrefersDenseLines() {
+  current_test = "PackingPrefersDenseLines";
+  int32_t total = 0;
+  const std::vector<int32_t> kept = Budget(
+      {
+          // 2 content words in 4 tokens, as dense as the third.
+          "Ana: revenue grew",
+          // Stop words and fillers only.
+          "Ben: and so we think that is about what we would like",
+          // 2 in 4: the later of two equally dense lines goes first.
+          "Ana: churn fell",
+          // 3 in 3.
+          "Ben: hiring freeze lifted",
+      },
+      {4, 10, 4, 3}, /*n_context=*/0, /*budget=*/10, &total);
+  EXPECT_EQ(3, kept[3]);
+  EXPECT_EQ(4, kept[2]);
+  // No room is left for the first line or the sparse one.
+  EXPECT_EQ(0, kept[0]);
+  EXPECT_EQ(0, kept[1]);
+  EXPECT_EQ(7, total);
+}
+
+void PackingFillsWithLaterLinesThatFit() {
+  current_test = "PackingFillsWithLaterLinesThatFit";
+  int32_t total = 0;
+  const std::vector<int32_t> kept = Budget(
+      {
+          "Ana: launch date moved",
+          "Ben: the design review covers pricing tiers and discounts today",
+          "Ana: and that is about it for me",
+      },
+      {3, 20, 8}, /*n_context=*/0, /*budget=*/12, &total);
+  EXPECT_EQ(3, kept[0]);
+  // Denser than the last line, but too long.
+  EXPECT_EQ(0, kept[1]);
+  EXPECT_EQ(8, kept[2]);
+  EXPECT_EQ(11, total);
+}
+
+void WithinBudgetNothingMoreIsDropped() {
+  current_test = "WithinBudgetNothingMoreIsDropped";
+  int32_t total = 0;
+  const std::vector<int32_t> kept = Budget(
+      {"Ana: launch date moved", "Ben: and that is about it for me"}, {3, 8},
+      /*n_context=*/0, /*budget=*/11, &total);
+  EXPECT_EQ(3, kept[0]);
+  EXPECT_EQ(8, kept[1]);
+  EXPECT_EQ(11, total);
+}
+
+}  // namespace
+
+int main() {
+  RepeatsWithinTheWindowAreDropped();
+  RepeatsPastTheWindowAreKept();
+  ContextLinesAreKeptAndCompared();
+  FillerOnlyLinesAreDropped();
+  BracketedAnnotationsAreIgnored();
+  LinesWithoutTokensAreDropped();
+  PackingPrefersDenseLines();
+  PackingFillsWithLaterLinesThatFit();
+  WithinBudgetNothingMoreIsDropped();
+  return native_test::TestResult();
+}
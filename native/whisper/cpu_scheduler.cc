@@ -0,0 +1,373 @@
+#include "whisper/cpu_scheduler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+
+#include "common/thread_placement.h"
+
+namespace whisper_shim {
+
+namespace {
+
+// Decoding stops scaling well before this many threads.
+constexpr int32_t kMaxEngineThreads = 8;
+
+// Cores slower than this fraction of the fastest are efficiency cores. Low
+// enough to keep the "big" cluster of prime + big + little phone SoCs.
+constexpr double kPerformanceRatio = 0.75;
+
+// With no efficiency cores to run them, capture and UI threads get one fast
+// core to themselves once there are at least this many.
+constexpr size_t kMinCoresToReserve = 4;
+
+constexpr int32_t kMaxNumaNodes = 64;
+
+struct Cpu {
+  // Logical CPU number, as used for affinity.
+  int32_t id;
+  // Lowest logical CPU on the same physical core.
+  int32_t core;
+  int32_t node;
+  // Relative speed, higher is faster; only compared within one machine.
+  int64_t capacity;
+};
+
+struct Topology {
+  std::vector<Cpu> cpus;
+  // Whether Cpu::id can be used for thread affinity.
+  bool placeable = false;
+};
+
+Topology FallbackTopology() {
+  Topology topology;
+  const int32_t count =
+      std::max(1, static_cast<int32_t>(std::thread::hardware_concurrency()));
+  for (int32_t i = 0; i < count; ++i) topology.cpus.push_back({i, i, 0, 1});
+  return topology;
+}
+
+#if defined(_WIN32)
+
+Topology DetectTopology() {
+  DWORD length = 0;
+  GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+  std::vector<uint8_t> buffer(length);
+  auto* info =
+      reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data());
+  if (length == 0 ||
+      !GetLogicalProcessorInformationEx(RelationAll, info, &length)) {
+    return FallbackTopology();
+  }
+
+  // Only processor group 0 is placed; it holds the first 64 CPUs.
+  Topology topology;
+  std::vector<std::pair<KAFFINITY, int32_t>> nodes;
+  for (DWORD offset = 0; offset < length;) {
+    const auto* entry =
+        reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(
+            buffer.data() + offset);
+    if (entry->Relationship == RelationProcessorCore &&
+        entry->Processor.GroupMask[0].Group == 0) {
+      const KAFFINITY mask = entry->Processor.GroupMask[0].Mask;
+      int32_t core = -1;
+      for (int32_t bit = 0; bit < 64; ++bit) {
+        if ((mask & (static_cast<KAFFINITY>(1) << bit)) == 0) continue;
+        if (core < 0) core = bit;
+        topology.cpus.push_back(
+            {bit, core, 0, entry->Processor.EfficiencyClass + 1});
+      }
+    } else if (entry->Relationship == RelationNumaNode &&
+               entry->NumaNode.GroupMask.Group == 0) {
+      nodes.push_back({entry->NumaNode.GroupMask.Mask,
+                       static_cast<int32_t>(entry->NumaNode.NodeNumber)});
+    }
+    offset += entry->Size;
+  }
+  if (topology.cpus.empty()) return FallbackTopology();
+
+  for (Cpu& cpu : topology.cpus) {
+    for (const auto& node : nodes) {
+      if (node.first & (static_cast<KAFFINITY>(1) << cpu.id)) {
+        cpu.node = node.second;
+      }
+    }
+  }
+  topology.placeable = true;
+  return topology;
+}
+
+#elif defined(__APPLE__)
+
+int32_t SysctlInt(const char* name, int32_t fallback) {
+  int32_t value = 0;
+  size_t size = sizeof(value);
+  if (sysctlbyname(name, &value, &size, nullptr, 0) != 0 || value <= 0) {
+    return fallback;
+  }
+  return value;
+}
+
+// Apple platforms do not expose CPU numbers for affinity; the ids here only
+// describe the shape of the machine.
+Topology DetectTopology() {
+  const Topology fallback = FallbackTopology();
+  const int32_t logical =
+      SysctlInt("hw.logicalcpu", static_cast<int32_t>(fallback.cpus.size()));
+  const int32_t physical = SysctlInt("hw.physicalcpu", logical);
+  // perflevel0 is the fastest class on Apple silicon.
+  const int32_t performance = SysctlInt("hw.perflevel0.physicalcpu", physical);
+
+  Topology topology;
+  for (int32_t i = 0; i < logical; ++i) {
+    const int32_t core = i % physical;
+    topology.cpus.push_back({i, core, 0, core < performance ? 2 : 1});
+  }
+  return topology;
+}
+
+#else
+
+bool ReadText(const std::string& path, std::string* text) {
+  FILE* file = std::fopen(path.c_str(), "r");
+  if (file == nullptr) return false;
+  char buffer[4096];
+  const size_t size = std::fread(buffer, 1, sizeof(buffer) - 1, file);
+  std::fclose(file);
+  text->assign(buffer, size);
+  return true;
+}
+
+int64_t ReadInt(const std::string& path) {
+  std::string text;
+  if (!ReadText(path, &text)) return 0;
+  return std::strtoll(text.c_str(), nullptr, 10);
+}
+
+// Parses a sysfs CPU list such as "0-3,8,10-11".
+std::vector<int32_t> ParseCpuList(const std::string& text) {
+  std::vector<int32_t> cpus;
+  const char* p = text.c_str();
+  while (*p != '\0') {
+    char* end = nullptr;
+    const long first = std::strtol(p, &end, 10);
+    if (end == p) break;
+    long last = first;
+    p = end;
+    if (*p == '-') {
+      last = std::strtol(p + 1, &end, 10);
+      p = end;
+    }
+    for (long cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(static_cast<int32_t>(cpu));
+    }
+    if (*p == ',') ++p;
+    if (*p == '\n') break;
+  }
+  return cpus;
+}
+
+// Linux and Android: sysfs describes SMT siblings, NUMA nodes and, on
+// heterogeneous CPUs, each core's capacity or maximum frequency.
+Topology DetectTopology() {
+  const std::string root = "/sys/devices/system/cpu/";
+  std::string text;
+  if (!ReadText(root + "online", &text)) return FallbackTopology();
+  const std::vector<int32_t> online = ParseCpuList(text);
+  if (online.empty()) return FallbackTopology();
+
+  std::map<int32_t, int32_t> node_of;
+  for (int32_t node = 0; node < kMaxNumaNodes; ++node) {
+    const std::string path = "/sys/devices/system/node/node" +
+                             std::to_string(node) + "/cpulist";
+    if (!ReadText(path, &text)) continue;
+    for (const int32_t cpu : ParseCpuList(text)) node_of[cpu] = node;
+  }
+
+  Topology topology;
+  for (const int32_t id : online) {
+    const std::string base = root + "cpu" + std::to_string(id);
+    Cpu cpu{id, id, node_of.count(id) != 0 ? node_of[id] : 0, 0};
+    if (ReadText(base + "/topology/thread_siblings_list", &text)) {
+      const std::vector<int32_t> siblings = ParseCpuList(text);
+      if (!siblings.empty()) {
+        cpu.core = *std::min_element(siblings.begin(), siblings.end());
+      }
+    }
+    cpu.capacity = ReadInt(base + "/cpu_capacity");
+    if (cpu.capacity <= 0) {
+      cpu.capacity = ReadInt(base + "/cpufreq/cpuinfo_max_freq");
+    }
+    topology.cpus.push_back(cpu);
+  }
+  topology.placeable = true;
+  return topology;
+}
+
+#endif
+
+int64_t PerformanceThreshold(const Topology& topology) {
+  int64_t fastest = 0;
+  for (const Cpu& cpu : topology.cpus) {
+    fastest = std::max(fastest, cpu.capacity);
+  }
+  return static_cast<int64_t>(static_cast<double>(fastest) *
+                              kPerformanceRatio);
+}
+
+// One logical CPU per fast physical core, on the NUMA node with the most of
+// them. SMT siblings are left out: the matrix kernels saturate a core's
+// vector units from one thread, and a second one only adds contention.
+std::vector<int32_t> InferenceCores(const Topology& topology) {
+  const int64_t threshold = PerformanceThreshold(topology);
+  bool heterogeneous = false;
+  std::map<int32_t, std::vector<int32_t>> by_node;
+  for (const Cpu& cpu : topology.cpus) {
+    if (cpu.capacity < threshold) {
+      heterogeneous = true;
+      continue;
+    }
+    if (cpu.id == cpu.core) by_node[cpu.node].push_back(cpu.id);
+  }
+
+  std::vector<int32_t> cores;
+  for (const auto& node : by_node) {
+    if (node.second.size() > cores.size()) cores = node.second;
+  }
+  if (!heterogeneous && cores.size() >= kMinCoresToReserve) {
+    // The lowest core also takes most device interrupts.
+    cores.erase(cores.begin());
+  }
+  if (cores.empty()) cores.push_back(0);
+  return cores;
+}
+
+struct Scheduler {
+  std::mutex mutex;
+  Topology topology;
+  CpuTopology summary;
+  bool active[kEngineCount] = {};
+  std::vector<int32_t> cpus[kEngineCount];
+  uint64_t generation = 0;
+};
+
+CpuTopology Summarize(const Topology& topology) {
+  const int64_t threshold = PerformanceThreshold(topology);
+  std::set<int32_t> cores;
+  std::set<int32_t> fast_cores;
+  std::set<int32_t> nodes;
+  for (const Cpu& cpu : topology.cpus) {
+    cores.insert(cpu.core);
+    if (cpu.capacity >= threshold) fast_cores.insert(cpu.core);
+    nodes.insert(cpu.node);
+  }
+
+  CpuTopology summary;
+  summary.logical_cpus = static_cast<int32_t>(topology.cpus.size());
+  summary.physical_cores = static_cast<int32_t>(cores.size());
+  summary.performance_cores = static_cast<int32_t>(fast_cores.size());
+  summary.numa_nodes = static_cast<int32_t>(nodes.size());
+  return summary;
+}
+
+// Caller holds |scheduler->mutex|.
+void Replan(Scheduler* scheduler) {
+  const std::vector<int32_t> cores = InferenceCores(scheduler->topology);
+  auto& whisper = scheduler->cpus[kEngineWhisper];
+  auto& llama = scheduler->cpus[kEngineLlama];
+
+  if (scheduler->active[kEngineWhisper] && scheduler->active[kEngineLlama] &&
+      cores.size() >= 2) {
+    // Live transcription has a deadline and summarization does not, so
+    // Whisper gets the larger half.
+    const size_t split = (cores.size() + 1) / 2;
+    whisper.assign(cores.begin(), cores.begin() + split);
+    llama.assign(cores.begin() + split, cores.end());
+  } else {
+    whisper = cores;
+    llama = cores;
+  }
+  ++scheduler->generation;
+}
+
+Scheduler& GetScheduler() {
+  // Leaked so threads still running during exit never see it destroyed.
+  static Scheduler* scheduler = [] {
+    auto* created = new Scheduler();
+    created->topology = DetectTopology();
+    created->summary = Summarize(created->topology);
+    Replan(created);
+    return created;
+  }();
+  return *scheduler;
+}
+
+}  // namespace
+
+CpuTopology DetectedTopology() {
+  Scheduler& scheduler = GetScheduler();
+  std::lock_guard<std::mutex> lock(scheduler.mutex);
+  return scheduler.summary;
+}
+
+void SetEngineActive(Engine engine, bool active) {
+  Scheduler& scheduler = GetScheduler();
+  std::lock_guard<std::mutex> lock(scheduler.mutex);
+  if (scheduler.active[engine] == active) return;
+  scheduler.active[engine] = active;
+  Replan(&scheduler);
+}
+
+int32_t EngineThreads(Engine engine) {
+  Scheduler& scheduler = GetScheduler();
+  std::lock_guard<std::mutex> lock(scheduler.mutex);
+  const auto size = static_cast<int32_t>(scheduler.cpus[engine].size());
+  return std::max(1, std::min(size, kMaxEngineThreads));
+}
+
+int32_t EngineCores(Engine engine) {
+  Scheduler& scheduler = GetScheduler();
+  std::lock_guard<std::mutex> lock(scheduler.mutex);
+  return std::max(1, static_cast<int32_t>(scheduler.cpus[engine].size()));
+}
+
+std::vector<int32_t> EngineCpus(Engine engine) {
+  Scheduler& scheduler = GetScheduler();
+  std::lock_guard<std::mutex> lock(scheduler.mutex);
+  if (!scheduler.topology.placeable) return {};
+  return scheduler.cpus[engine];
+}
+
+void PlaceCurrentThread(Engine engine) {
+  thread_local uint64_t placed_generation = 0;
+  thread_local int placed_engine = -1;
+
+  Scheduler& scheduler = GetScheduler();
+  std::vector<int32_t> cpus;
+  {
+    std::lock_guard<std::mutex> lock(scheduler.mutex);
+    if (placed_generation == scheduler.generation &&
+        placed_engine == engine) {
+      return;
+    }
+    placed_generation = scheduler.generation;
+    placed_engine = engine;
+    if (scheduler.topology.placeable) cpus = scheduler.cpus[engine];
+  }
+  native_common::PlaceCurrentThread(cpus);
+}
+
+}  // namespace whisper_shim
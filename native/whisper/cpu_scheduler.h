@@ -0,0 +1,50 @@
+#ifndef MEETING_NATIVE_WHISPER_CPU_SCHEDULER_H_
+#define MEETING_NATIVE_WHISPER_CPU_SCHEDULER_H_
+
+// CPU topology and inference thread placement. Not part of the C ABI; see
+// the meeting_whisper_sched_* functions in meeting_whisper.h.
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace whisper_shim {
+
+// MEETING_WHISPER_ENGINE_* in meeting_whisper.h.
+enum Engine { kEngineWhisper = 0, kEngineLlama = 1, kEngineCount = 2 };
+
+struct CpuTopology {
+  int32_t logical_cpus = 0;
+  int32_t physical_cores = 0;
+  // Cores in the fastest class, all of them on homogeneous CPUs.
+  int32_t performance_cores = 0;
+  int32_t numa_nodes = 1;
+};
+
+CpuTopology DetectedTopology();
+
+// Marks |engine| as running inference. While both engines are active the
+// inference cores are split between them instead of shared.
+void SetEngineActive(Engine engine, bool active);
+
+// Threads one |engine| decode should use under the current plan (>= 1).
+int32_t EngineThreads(Engine engine);
+
+// Cores planned for |engine| (>= 1); more than EngineThreads() on wide
+// machines, where several decodes can run side by side.
+int32_t EngineCores(Engine engine);
+
+// Logical CPUs |engine| is placed on. Empty where placement is not
+// supported (Apple platforms schedule by QoS class instead).
+std::vector<int32_t> EngineCpus(Engine engine);
+
+// Places the calling thread on |engine|'s CPUs. Only called on threads the
+// shim owns: a thread's affinity is inherited by the compute threads it
+// starts, so pinning the worker also places ggml's thread pool.
+//
+// Cheap when the plan is unchanged since the last call on this thread.
+void PlaceCurrentThread(Engine engine);
+
+}  // namespace whisper_shim
+
+#endif  // MEETING_NATIVE_WHISPER_CPU_SCHEDULER_H_
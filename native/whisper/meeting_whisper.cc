@@ -0,0 +1,917 @@
+#include "whisper/meeting_whisper.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "whisper.h"
+#include "whisper/cpu_scheduler.h"
+#include "whisper/model_file.h"
+#include "whisper/transcript_cache.h"
+
+namespace {
+
+constexpr int kSamplesPerMs = WHISPER_SAMPLE_RATE / 1000;
+
+// The encoder produces one audio context position per 20 ms.
+constexpr int kMsPerAudioCtx = 20;
+
+constexpr int kDefaultStepMs = 2000;
+constexpr int kDefaultWindowMs = 10000;
+
+// Audio kept when a full window decoded to nothing, so an onset that
+// straddles the cut is not lost.
+constexpr int kSilenceCarryMs = 500;
+
+// Committed tokens carried into the next window's prompt.
+constexpr size_t kMaxPromptTokens = 128;
+
+// Audio a stream probes the language of a speech region on, and the most
+// the encoder takes in one pass.
+constexpr int kLanguageProbeMs = 3000;
+constexpr int kMaxLanguageProbeMs = 30000;
+
+// RMS level below which a stream window is not worth a language probe
+// (about -40 dBFS); probing silence only yields a guess.
+constexpr float kLanguageProbeMinRms = 0.01f;
+
+using whisper_shim::Segment;
+
+int DefaultThreads() {
+  return whisper_shim::EngineThreads(whisper_shim::kEngineWhisper);
+}
+
+bool IsAutoLanguage(const char* language) {
+  return language == nullptr || language[0] == '\0' ||
+         std::strcmp(language, "auto") == 0;
+}
+
+// whisper.cpp timestamps are in centiseconds.
+int64_t ToMilliseconds(int64_t t) { return t * 10; }
+
+whisper_full_params DecodeParams(whisper_sampling_strategy strategy,
+                                 int32_t n_threads,
+                                 const char* language) {
+  whisper_full_params params = whisper_full_default_params(strategy);
+  params.n_threads = n_threads > 0 ? n_threads : DefaultThreads();
+  params.language = IsAutoLanguage(language) ? "auto" : language;
+  params.no_context = true;
+  params.print_special = false;
+  params.print_progress = false;
+  params.print_realtime = false;
+  params.print_timestamps = false;
+  // Per-token times from the timestamp token probabilities; cheap next to
+  // the decode, and what DTW alignment refines when it is enabled.
+  params.token_timestamps = true;
+  return params;
+}
+
+// Parameters for a one-shot transcription; see meeting_whisper_transcribe().
+whisper_full_params TranscribeParams(const char* language,
+                                     int32_t translate,
+                                     int32_t n_threads,
+                                     int32_t beam_size) {
+  const bool beam = beam_size > 1;
+  whisper_full_params params = DecodeParams(
+      beam ? WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY, n_threads,
+      language);
+  params.translate = translate != 0;
+  if (beam) params.beam_search.beam_size = beam_size;
+  return params;
+}
+
+// Scores the language of the first |count| samples on |state| and fills
+// |probs|, indexed by language id. Returns the most likely id, or -1.
+int DetectLanguage(whisper_context* context,
+                   whisper_state* state,
+                   const float* samples,
+                   int32_t count,
+                   int32_t n_threads,
+                   std::vector<float>* probs) {
+  probs->assign(static_cast<size_t>(whisper_lang_max_id()) + 1, 0.0f);
+  if (!whisper_is_multilingual(context)) {
+    const int english = whisper_lang_id("en");
+    (*probs)[english] = 1.0f;
+    return english;
+  }
+
+  count = std::min(count, kMaxLanguageProbeMs * kSamplesPerMs);
+  if (n_threads <= 0) n_threads = DefaultThreads();
+  if (whisper_pcm_to_mel_with_state(context, state, samples, count,
+                                    n_threads) != 0) {
+    return -1;
+  }
+  const int id = whisper_lang_auto_detect_with_state(context, state, 0,
+                                                     n_threads, probs->data());
+  return id >= 0 ? id : -1;
+}
+
+float Rms(const float* samples, size_t count) {
+  double sum = 0.0;
+  for (size_t i = 0; i < count; ++i) sum += samples[i] * samples[i];
+  return count > 0 ? static_cast<float>(std::sqrt(sum / count)) : 0.0f;
+}
+
+// Language the last decode on |state| ran in, or "".
+const char* DecodedLanguage(whisper_state* state) {
+  const int lang_id = whisper_full_lang_id_from_state(state);
+  const char* language = lang_id >= 0 ? whisper_lang_str(lang_id) : nullptr;
+  return language != nullptr ? language : "";
+}
+
+// Reads the text tokens of segment |i|. Their texts concatenate to the
+// segment's text, which is how each token's byte range is found.
+void ReadTokens(whisper_context* context,
+                whisper_state* state,
+                int i,
+                int64_t offset_ms,
+                Segment* segment) {
+  const whisper_token eot = whisper_token_eot(context);
+  const int n_tokens = whisper_full_n_tokens_from_state(state, i);
+  const auto text_size = static_cast<int32_t>(segment->text.size());
+  int32_t text_offset = 0;
+  segment->tokens.reserve(n_tokens);
+  for (int j = 0; j < n_tokens; ++j) {
+    const whisper_token_data data =
+        whisper_full_get_token_data_from_state(state, i, j);
+    if (data.id >= eot) continue;
+
+    const char* text = whisper_full_get_token_text_from_state(context, state,
+                                                              i, j);
+    const auto length = std::min(
+        static_cast<int32_t>(text != nullptr ? std::strlen(text) : 0),
+        text_size - text_offset);
+
+    meeting_whisper_token token;
+    token.start_ms = offset_ms + ToMilliseconds(data.t0);
+    token.end_ms = offset_ms + ToMilliseconds(data.t1);
+    token.logprob = data.plog;
+    token.text_offset = text_offset;
+    token.text_length = length;
+    if (data.t_dtw >= 0) {
+      // DTW yields one aligned time per token, where it is spoken; it
+      // lasts until the next token starts.
+      token.start_ms = offset_ms + ToMilliseconds(data.t_dtw);
+      if (!segment->tokens.empty()) {
+        segment->tokens.back().end_ms = token.start_ms;
+      }
+      token.end_ms = segment->end_ms;
+    }
+    segment->tokens.push_back(token);
+    text_offset += length;
+  }
+}
+
+Segment ReadSegment(whisper_context* context,
+                    whisper_state* state,
+                    int i,
+                    int64_t offset_ms) {
+  const int64_t t0 = whisper_full_get_segment_t0_from_state(state, i);
+  const int64_t t1 = whisper_full_get_segment_t1_from_state(state, i);
+  Segment segment;
+  segment.start_ms = offset_ms + ToMilliseconds(t0);
+  segment.end_ms = offset_ms + ToMilliseconds(t1);
+  segment.no_speech_prob =
+      whisper_full_get_segment_no_speech_prob_from_state(state, i);
+  segment.text = whisper_full_get_segment_text_from_state(state, i);
+  ReadTokens(context, state, i, offset_ms, &segment);
+  return segment;
+}
+
+// Init flags that change the loaded model; contexts share a model only if
+// they agree on these.
+constexpr int32_t kModelFlags =
+    MEETING_WHISPER_INIT_USE_GPU | MEETING_WHISPER_INIT_ALIGN_TOKENS;
+
+// Loaded models, shared by every context initialized from the same file.
+struct SharedModel {
+  std::string path;
+  int32_t flags;
+  whisper_context* context;
+  int refs;
+};
+
+std::mutex& ModelsMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<SharedModel>& Models() {
+  static std::vector<SharedModel> models;
+  return models;
+}
+
+whisper_context* AcquireModel(const char* path, int32_t flags) {
+  const int32_t model_flags = flags & kModelFlags;
+  // Held across the load so concurrent inits of one file load it once.
+  std::lock_guard<std::mutex> lock(ModelsMutex());
+  for (SharedModel& model : Models()) {
+    if (model.flags == model_flags && model.path == path) {
+      ++model.refs;
+      return model.context;
+    }
+  }
+
+  whisper_context_params params = whisper_context_default_params();
+  params.use_gpu = (flags & MEETING_WHISPER_INIT_USE_GPU) != 0;
+  whisper_context* context = whisper_shim::LoadMappedModel(
+      path, params, (flags & MEETING_WHISPER_INIT_PREFETCH) != 0,
+      (flags & MEETING_WHISPER_INIT_ALIGN_TOKENS) != 0);
+  if (context == nullptr) return nullptr;
+  if (Models().empty()) {
+    whisper_shim::SetEngineActive(whisper_shim::kEngineWhisper, true);
+  }
+  Models().push_back({path, model_flags, context, 1});
+  return context;
+}
+
+void ReleaseModel(whisper_context* context) {
+  std::lock_guard<std::mutex> lock(ModelsMutex());
+  auto& models = Models();
+  for (auto it = models.begin(); it != models.end(); ++it) {
+    if (it->context != context) continue;
+    if (--it->refs == 0) {
+      whisper_shim::SharedTranscriptCache().Forget(it->context);
+      whisper_free(it->context);
+      models.erase(it);
+      if (models.empty()) {
+        whisper_shim::SetEngineActive(whisper_shim::kEngineWhisper, false);
+      }
+    }
+    return;
+  }
+}
+
+void WriteSegment(const Segment& source, meeting_whisper_segment* segment) {
+  segment->start_ms = source.start_ms;
+  segment->end_ms = source.end_ms;
+  segment->no_speech_prob = source.no_speech_prob;
+  segment->text = source.text.c_str();
+  segment->tokens = source.tokens.data();
+  segment->n_tokens = static_cast<int32_t>(source.tokens.size());
+}
+
+}  // namespace
+
+struct meeting_whisper {
+  whisper_context* context = nullptr;
+  whisper_state* state = nullptr;
+
+  std::vector<Segment> segments;
+  std::string language;
+  std::string error;
+};
+
+namespace {
+
+void Fail(meeting_whisper* ctx, const char* message) {
+  ctx->error = message;
+  ctx->segments.clear();
+}
+
+// Decodes |count| samples on |state| and reads back every segment, or
+// returns the result of an identical earlier decode on the same model.
+bool DecodeAll(whisper_context* context,
+               whisper_state* state,
+               const whisper_full_params& params,
+               const float* samples,
+               int32_t count,
+               std::vector<Segment>* segments,
+               std::string* language) {
+  whisper_shim::TranscriptKey key;
+  key.model = context;
+  key.audio_hash = whisper_shim::HashSamples(samples, count);
+  key.count = count;
+  key.language = params.language;
+  key.translate = params.translate ? 1 : 0;
+  key.beam_size = params.strategy == WHISPER_SAMPLING_BEAM_SEARCH
+                      ? params.beam_search.beam_size
+                      : 1;
+  auto& cache = whisper_shim::SharedTranscriptCache();
+  if (cache.Lookup(key, segments, language)) return true;
+
+  segments->clear();
+  if (whisper_full_with_state(context, state, params, samples, count) != 0) {
+    return false;
+  }
+
+  const int n_segments = whisper_full_n_segments_from_state(state);
+  segments->reserve(n_segments);
+  for (int i = 0; i < n_segments; ++i) {
+    segments->push_back(ReadSegment(context, state, i, 0));
+  }
+  *language = DecodedLanguage(state);
+  cache.Insert(key, *segments, *language);
+  return true;
+}
+
+}  // namespace
+
+int32_t meeting_whisper_abi_version(void) {
+  return MEETING_WHISPER_ABI_VERSION;
+}
+
+meeting_whisper* meeting_whisper_init(const char* model_path,
+                                      int32_t flags) {
+  if (model_path == nullptr) return nullptr;
+
+  whisper_context* context = AcquireModel(model_path, flags);
+  if (context == nullptr) return nullptr;
+
+  whisper_state* state = whisper_init_state(context);
+  if (state == nullptr) {
+    ReleaseModel(context);
+    return nullptr;
+  }
+
+  auto* ctx = new (std::nothrow) meeting_whisper();
+  if (ctx == nullptr) {
+    whisper_free_state(state);
+    ReleaseModel(context);
+    return nullptr;
+  }
+  ctx->context = context;
+  ctx->state = state;
+  return ctx;
+}
+
+void meeting_whisper_free(meeting_whisper* ctx) {
+  if (ctx == nullptr) return;
+  whisper_free_state(ctx->state);
+  ReleaseModel(ctx->context);
+  delete ctx;
+}
+
+int32_t meeting_whisper_transcribe(meeting_whisper* ctx,
+                                   const float* samples,
+                                   int32_t count,
+                                   const char* language,
+                                   int32_t translate,
+                                   int32_t n_threads,
+                                   int32_t beam_size) {
+  if (ctx == nullptr) return -1;
+  if (samples == nullptr || count <= 0) {
+    Fail(ctx, "no audio");
+    return -1;
+  }
+
+  const whisper_full_params params =
+      TranscribeParams(language, translate, n_threads, beam_size);
+  if (!DecodeAll(ctx->context, ctx->state, params, samples, count,
+                 &ctx->segments, &ctx->language)) {
+    Fail(ctx, "whisper_full failed");
+    return -1;
+  }
+  ctx->error.clear();
+  return static_cast<int32_t>(ctx->segments.size());
+}
+
+int32_t meeting_whisper_segment_count(const meeting_whisper* ctx) {
+  return ctx != nullptr ? static_cast<int32_t>(ctx->segments.size()) : 0;
+}
+
+int32_t meeting_whisper_get_segment(const meeting_whisper* ctx,
+                                    int32_t index,
+                                    meeting_whisper_segment* segment) {
+  if (ctx == nullptr || segment == nullptr || index < 0 ||
+      index >= static_cast<int32_t>(ctx->segments.size())) {
+    return 0;
+  }
+  WriteSegment(ctx->segments[index], segment);
+  return 1;
+}
+
+const char* meeting_whisper_language(const meeting_whisper* ctx) {
+  return ctx != nullptr ? ctx->language.c_str() : "";
+}
+
+const char* meeting_whisper_last_error(const meeting_whisper* ctx) {
+  return ctx != nullptr ? ctx->error.c_str() : "";
+}
+
+int32_t meeting_whisper_detect_language(meeting_whisper* ctx,
+                                        const float* samples,
+                                        int32_t count,
+                                        int32_t n_threads,
+                                        float* probs,
+                                        int32_t capacity) {
+  if (ctx == nullptr) return -1;
+  if (samples == nullptr || count <= 0) {
+    ctx->error = "no audio";
+    return -1;
+  }
+
+  std::vector<float> detected;
+  const int id = DetectLanguage(ctx->context, ctx->state, samples, count,
+                                n_threads, &detected);
+  if (id < 0) {
+    ctx->error = "language detection failed";
+    return -1;
+  }
+  if (probs != nullptr && capacity > 0) {
+    std::copy_n(detected.begin(),
+                std::min(detected.size(), static_cast<size_t>(capacity)),
+                probs);
+  }
+  ctx->error.clear();
+  return id;
+}
+
+int32_t meeting_whisper_language_count(void) {
+  return whisper_lang_max_id() + 1;
+}
+
+const char* meeting_whisper_language_code(int32_t id) {
+  if (id < 0 || id > whisper_lang_max_id()) return "";
+  const char* code = whisper_lang_str(id);
+  return code != nullptr ? code : "";
+}
+
+int32_t meeting_whisper_model_ftype(const meeting_whisper* ctx) {
+  return ctx != nullptr ? whisper_model_ftype(ctx->context) : -1;
+}
+
+const char* meeting_whisper_model_type(const meeting_whisper* ctx) {
+  return ctx != nullptr ? whisper_model_type_readable(ctx->context) : "";
+}
+
+struct meeting_whisper_stream {
+  whisper_context* context = nullptr;
+  whisper_state* state = nullptr;
+
+  // Decode language, "" to auto-detect. With |auto_language| it is probed
+  // per speech region: |probe_language| is set until the current region has
+  // been probed.
+  std::string language;
+  bool auto_language = false;
+  bool probe_language = false;
+  int32_t n_threads = 0;
+  size_t step_samples = 0;
+  size_t window_samples = 0;
+  int audio_ctx = 0;
+
+  // Uncommitted audio, starting at stream sample |window_start|.
+  std::vector<float> audio;
+  int64_t window_start = 0;
+  // Size of |audio| when it was last decoded.
+  size_t decoded_samples = 0;
+
+  std::vector<whisper_token> prompt;
+  std::vector<Segment> committed;
+  Segment tentative;
+  bool has_tentative = false;
+};
+
+namespace {
+
+void DropAudio(meeting_whisper_stream* stream, size_t count) {
+  count = std::min(count, stream->audio.size());
+  stream->audio.erase(stream->audio.begin(), stream->audio.begin() + count);
+  stream->window_start += static_cast<int64_t>(count);
+}
+
+// Appends the first |max_text_tokens| text tokens of |segment| to the
+// prompt.
+void AppendPrompt(meeting_whisper_stream* stream,
+                  int segment,
+                  size_t max_text_tokens = SIZE_MAX) {
+  const whisper_token eot = whisper_token_eot(stream->context);
+  const int n_tokens = whisper_full_n_tokens_from_state(stream->state, segment);
+  size_t appended = 0;
+  for (int j = 0; j < n_tokens && appended < max_text_tokens; ++j) {
+    const whisper_token id =
+        whisper_full_get_token_id_from_state(stream->state, segment, j);
+    // Special and timestamp tokens follow EOT in the vocabulary.
+    if (id >= eot) continue;
+    stream->prompt.push_back(id);
+    ++appended;
+  }
+}
+
+// Splits |segment| before its last word, which the end of a full window
+// may have cut off. |segment| keeps the words before it and the rest is
+// returned in |last|. Returns how many tokens |segment| keeps, or 0,
+// leaving it whole, when its last word starts before |min_split_ms|.
+size_t SplitLastWord(Segment* segment, int64_t min_split_ms, Segment* last) {
+  const std::vector<meeting_whisper_token>& tokens = segment->tokens;
+  for (size_t k = tokens.size(); k-- > 1;) {
+    const meeting_whisper_token& token = tokens[k];
+    if (token.text_length == 0 || segment->text[token.text_offset] != ' ') {
+      continue;
+    }
+    if (token.start_ms < min_split_ms) return 0;
+    const auto cut = static_cast<size_t>(token.text_offset);
+    *last = {token.start_ms, segment->end_ms, segment->no_speech_prob,
+             segment->text.substr(cut),
+             {tokens.begin() + static_cast<ptrdiff_t>(k), tokens.end()}};
+    for (meeting_whisper_token& moved : last->tokens) {
+      moved.text_offset -= token.text_offset;
+    }
+    segment->end_ms = tokens[k - 1].end_ms;
+    segment->text.resize(cut);
+    segment->tokens.resize(k);
+    return k;
+  }
+  return 0;
+}
+
+// Probes the language of the newest buffered audio if the current speech
+// region has not been probed yet and that audio is loud enough to tell. The
+// window may still start with the silence before the region.
+void ProbeLanguage(meeting_whisper_stream* stream) {
+  const size_t probe_samples =
+      std::min(stream->audio.size(),
+               static_cast<size_t>(kLanguageProbeMs) * kSamplesPerMs);
+  const float* probe = stream->audio.data() + stream->audio.size() -
+                       probe_samples;
+  if (Rms(probe, probe_samples) < kLanguageProbeMinRms) return;
+
+  std::vector<float> probs;
+  const int id =
+      DetectLanguage(stream->context, stream->state, probe,
+                     static_cast<int32_t>(probe_samples), stream->n_threads,
+                     &probs);
+  if (id < 0) return;
+  stream->probe_language = false;
+
+  const char* language = whisper_lang_str(id);
+  if (stream->language != language) {
+    // Text in the previous language would steer the decoder back to it.
+    stream->prompt.clear();
+    stream->language = language;
+  }
+}
+
+// Decodes the current window. Unless |flush|, the last segment is kept as
+// tentative and its audio stays buffered; when that would leave a full
+// window full, only its last word is.
+bool DecodeWindow(meeting_whisper_stream* stream, bool flush) {
+  const bool full = stream->audio.size() >= stream->window_samples;
+  stream->decoded_samples = stream->audio.size();
+  stream->has_tentative = false;
+  if (stream->audio.empty()) return true;
+
+  if (stream->probe_language) ProbeLanguage(stream);
+
+  whisper_full_params params = DecodeParams(
+      WHISPER_SAMPLING_GREEDY, stream->n_threads, stream->language.c_str());
+  params.audio_ctx = stream->audio_ctx;
+  params.prompt_tokens =
+      stream->prompt.empty() ? nullptr : stream->prompt.data();
+  params.prompt_n_tokens = static_cast<int>(stream->prompt.size());
+
+  if (whisper_full_with_state(stream->context, stream->state, params,
+                              stream->audio.data(),
+                              static_cast<int>(stream->audio.size())) != 0) {
+    return false;
+  }
+
+  const int n_segments = whisper_full_n_segments_from_state(stream->state);
+  if (stream->language.empty() && n_segments > 0) {
+    // Speech too quiet to probe; keep the language the decoder detected.
+    stream->language = DecodedLanguage(stream->state);
+  }
+  if (stream->auto_language && (n_segments == 0 || flush)) {
+    // The speech region is over; probe the next one afresh.
+    stream->probe_language = true;
+  }
+  const int n_commit = flush ? n_segments : std::max(0, n_segments - 1);
+  const int64_t offset_ms = stream->window_start / kSamplesPerMs;
+
+  for (int i = 0; i < n_commit; ++i) {
+    stream->committed.push_back(
+        ReadSegment(stream->context, stream->state, i, offset_ms));
+    AppendPrompt(stream, i);
+  }
+  if (n_commit < n_segments) {
+    stream->tentative =
+        ReadSegment(stream->context, stream->state, n_commit, offset_ms);
+    stream->has_tentative = true;
+    if (full && n_commit == 0) {
+      // One segment fills the window: commit all of it but the last word,
+      // whose audio goes on to the next window. A word reaching back past
+      // the window's middle is committed too, so each window still moves
+      // the stream on by half of one.
+      const int64_t window_ms =
+          static_cast<int64_t>(stream->window_samples / kSamplesPerMs);
+      Segment last;
+      const size_t kept = SplitLastWord(&stream->tentative,
+                                        offset_ms + window_ms / 2, &last);
+      if (kept > 0) {
+        stream->committed.push_back(std::move(stream->tentative));
+        AppendPrompt(stream, 0, kept);
+        stream->tentative = std::move(last);
+      }
+    }
+  }
+  if (stream->prompt.size() > kMaxPromptTokens) {
+    stream->prompt.erase(stream->prompt.begin(),
+                         stream->prompt.end() - kMaxPromptTokens);
+  }
+
+  if (flush) {
+    DropAudio(stream, stream->audio.size());
+  } else if (!stream->committed.empty() &&
+             stream->committed.back().end_ms > offset_ms) {
+    const int64_t end_ms = stream->committed.back().end_ms - offset_ms;
+    DropAudio(stream, static_cast<size_t>(end_ms) * kSamplesPerMs);
+  } else if (n_segments == 0 && full) {
+    // A full window without speech; keep only its tail.
+    const size_t carry = static_cast<size_t>(kSilenceCarryMs) * kSamplesPerMs;
+    DropAudio(stream, stream->audio.size() - carry);
+  }
+  if (stream->audio.size() >= stream->window_samples) {
+    // Still full, with no time to cut at: the tentative text is all there
+    // is of the window.
+    if (stream->has_tentative) {
+      stream->committed.push_back(std::move(stream->tentative));
+      stream->has_tentative = false;
+    }
+    DropAudio(stream, stream->audio.size());
+  }
+  stream->decoded_samples = stream->audio.size();
+  return true;
+}
+
+}  // namespace
+
+meeting_whisper_stream* meeting_whisper_stream_create(meeting_whisper* ctx,
+                                                      const char* language,
+                                                      int32_t n_threads,
+                                                      int32_t step_ms,
+                                                      int32_t window_ms) {
+  if (ctx == nullptr) return nullptr;
+  if (step_ms <= 0) step_ms = kDefaultStepMs;
+  if (window_ms <= 0) window_ms = kDefaultWindowMs;
+  if (step_ms > window_ms || window_ms <= kSilenceCarryMs) return nullptr;
+
+  whisper_state* state = whisper_init_state(ctx->context);
+  if (state == nullptr) return nullptr;
+
+  auto* stream = new (std::nothrow) meeting_whisper_stream();
+  if (stream == nullptr) {
+    whisper_free_state(state);
+    return nullptr;
+  }
+  stream->context = ctx->context;
+  stream->state = state;
+  stream->auto_language = IsAutoLanguage(language);
+  stream->probe_language = stream->auto_language;
+  stream->language = stream->auto_language ? "" : language;
+  stream->n_threads = n_threads;
+  stream->step_samples = static_cast<size_t>(step_ms) * kSamplesPerMs;
+  stream->window_samples = static_cast<size_t>(window_ms) * kSamplesPerMs;
+  stream->audio_ctx = std::min(
+      (window_ms + kMsPerAudioCtx - 1) / kMsPerAudioCtx,
+      whisper_model_n_audio_ctx(ctx->context));
+  stream->audio.reserve(stream->window_samples);
+  return stream;
+}
+
+void meeting_whisper_stream_free(meeting_whisper_stream* stream) {
+  if (stream == nullptr) return;
+  whisper_free_state(stream->state);
+  delete stream;
+}
+
+int32_t meeting_whisper_stream_push(meeting_whisper_stream* stream,
+                                    const float* samples,
+                                    int32_t count) {
+  if (stream == nullptr || (samples == nullptr && count > 0) || count < 0) {
+    return -1;
+  }
+  stream->committed.clear();
+
+  size_t offset = 0;
+  const size_t total = static_cast<size_t>(count);
+  while (offset < total) {
+    // Never let the window outgrow the encoder context.
+    const size_t room = stream->window_samples - stream->audio.size();
+    const size_t take = std::min(room, total - offset);
+    stream->audio.insert(stream->audio.end(), samples + offset,
+                         samples + offset + take);
+    offset += take;
+
+    const bool full = stream->audio.size() >= stream->window_samples;
+    const bool step =
+        stream->audio.size() - stream->decoded_samples >= stream->step_samples;
+    if ((full || step) && !DecodeWindow(stream, false)) return -1;
+  }
+  return static_cast<int32_t>(stream->committed.size());
+}
+
+int32_t meeting_whisper_stream_flush(meeting_whisper_stream* stream) {
+  if (stream == nullptr) return -1;
+  stream->committed.clear();
+  if (!DecodeWindow(stream, true)) return -1;
+  return static_cast<int32_t>(stream->committed.size());
+}
+
+int32_t meeting_whisper_stream_get_segment(const meeting_whisper_stream* stream,
+                                           int32_t index,
+                                           meeting_whisper_segment* segment) {
+  if (stream == nullptr || segment == nullptr || index < 0 ||
+      index >= static_cast<int32_t>(stream->committed.size())) {
+    return 0;
+  }
+  WriteSegment(stream->committed[index], segment);
+  return 1;
+}
+
+int32_t meeting_whisper_stream_tentative(const meeting_whisper_stream* stream,
+                                         meeting_whisper_segment* segment) {
+  if (stream == nullptr || segment == nullptr || !stream->has_tentative) {
+    return 0;
+  }
+  WriteSegment(stream->tentative, segment);
+  return 1;
+}
+
+const char* meeting_whisper_stream_language(
+    const meeting_whisper_stream* stream) {
+  return stream != nullptr ? stream->language.c_str() : "";
+}
+
+struct meeting_whisper_batch {
+  meeting_whisper* ctx = nullptr;
+  int32_t max_lanes = 0;
+  // One decoder state per lane, created on first use and kept.
+  std::vector<whisper_state*> states;
+
+  struct Window {
+    bool ok = false;
+    std::vector<Segment> segments;
+    std::string language;
+  };
+  std::vector<Window> windows;
+};
+
+namespace {
+
+// Threads per lane when the batch picks its own parallelism. Decoding one
+// window stops scaling at a handful of threads, so a wide machine gets more
+// throughput from more windows in flight than from more threads per window.
+constexpr int kThreadsPerLane = 2;
+
+}  // namespace
+
+meeting_whisper_batch* meeting_whisper_batch_create(meeting_whisper* ctx,
+                                                    int32_t lanes) {
+  if (ctx == nullptr) return nullptr;
+
+  auto* batch = new (std::nothrow) meeting_whisper_batch();
+  if (batch == nullptr) return nullptr;
+  batch->ctx = ctx;
+  if (lanes <= 0) {
+    const int32_t cores =
+        whisper_shim::EngineCores(whisper_shim::kEngineWhisper);
+    lanes = std::max(1, cores / kThreadsPerLane);
+  }
+  batch->max_lanes = lanes;
+  return batch;
+}
+
+void meeting_whisper_batch_free(meeting_whisper_batch* batch) {
+  if (batch == nullptr) return;
+  for (whisper_state* state : batch->states) whisper_free_state(state);
+  delete batch;
+}
+
+int32_t meeting_whisper_batch_transcribe(meeting_whisper_batch* batch,
+                                         const float* samples,
+                                         const int32_t* counts,
+                                         int32_t n_windows,
+                                         const char* language,
+                                         int32_t translate,
+                                         int32_t n_threads,
+                                         int32_t beam_size) {
+  if (batch == nullptr || samples == nullptr || counts == nullptr ||
+      n_windows <= 0) {
+    return -1;
+  }
+
+  std::vector<size_t> offsets(static_cast<size_t>(n_windows));
+  size_t total = 0;
+  for (int32_t i = 0; i < n_windows; ++i) {
+    if (counts[i] < 0) return -1;
+    offsets[i] = total;
+    total += static_cast<size_t>(counts[i]);
+  }
+
+  const size_t lanes =
+      static_cast<size_t>(std::min(batch->max_lanes, n_windows));
+  while (batch->states.size() < lanes) {
+    whisper_state* state = whisper_init_state(batch->ctx->context);
+    if (state == nullptr) break;
+    batch->states.push_back(state);
+  }
+  if (batch->states.empty()) return -1;
+  const size_t n_lanes = std::min(lanes, batch->states.size());
+
+  if (n_threads <= 0) {
+    const int32_t cores =
+        whisper_shim::EngineCores(whisper_shim::kEngineWhisper);
+    n_threads = std::max(1, cores / static_cast<int32_t>(n_lanes));
+  }
+  const whisper_full_params params =
+      TranscribeParams(language, translate, n_threads, beam_size);
+
+  batch->windows.assign(static_cast<size_t>(n_windows),
+                        meeting_whisper_batch::Window());
+  std::atomic<int32_t> next{0};
+  std::atomic<int32_t> decoded{0};
+  auto run_lane = [&](whisper_state* state) {
+    whisper_shim::PlaceCurrentThread(whisper_shim::kEngineWhisper);
+    for (int32_t i = next++; i < n_windows; i = next++) {
+      auto& window = batch->windows[i];
+      if (counts[i] == 0) {
+        window.ok = true;
+      } else {
+        window.ok = DecodeAll(batch->ctx->context, state, params,
+                              samples + offsets[i], counts[i],
+                              &window.segments, &window.language);
+      }
+      if (window.ok) ++decoded;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(n_lanes - 1);
+  for (size_t lane = 1; lane < n_lanes; ++lane) {
+    threads.emplace_back(run_lane, batch->states[lane]);
+  }
+  run_lane(batch->states[0]);
+  for (std::thread& thread : threads) thread.join();
+  return decoded;
+}
+
+int32_t meeting_whisper_batch_segment_count(const meeting_whisper_batch* batch,
+                                            int32_t window) {
+  if (batch == nullptr || window < 0 ||
+      window >= static_cast<int32_t>(batch->windows.size()) ||
+      !batch->windows[window].ok) {
+    return -1;
+  }
+  return static_cast<int32_t>(batch->windows[window].segments.size());
+}
+
+int32_t meeting_whisper_batch_get_segment(const meeting_whisper_batch* batch,
+                                          int32_t window,
+                                          int32_t index,
+                                          meeting_whisper_segment* segment) {
+  if (meeting_whisper_batch_segment_count(batch, window) <= index ||
+      segment == nullptr || index < 0) {
+    return 0;
+  }
+  WriteSegment(batch->windows[window].segments[index], segment);
+  return 1;
+}
+
+const char* meeting_whisper_batch_language(const meeting_whisper_batch* batch,
+                                           int32_t window) {
+  if (meeting_whisper_batch_segment_count(batch, window) < 0) return "";
+  return batch->windows[window].language.c_str();
+}
+
+void meeting_whisper_cpu_topology_get(meeting_whisper_cpu_topology* topology) {
+  if (topology == nullptr) return;
+  const whisper_shim::CpuTopology detected = whisper_shim::DetectedTopology();
+  topology->logical_cpus = detected.logical_cpus;
+  topology->physical_cores = detected.physical_cores;
+  topology->performance_cores = detected.performance_cores;
+  topology->numa_nodes = detected.numa_nodes;
+}
+
+void meeting_whisper_sched_set_active(int32_t engine, int32_t active) {
+  if (engine < 0 || engine >= whisper_shim::kEngineCount) return;
+  whisper_shim::SetEngineActive(static_cast<whisper_shim::Engine>(engine),
+                                active != 0);
+}
+
+int32_t meeting_whisper_sched_threads(int32_t engine) {
+  if (engine < 0 || engine >= whisper_shim::kEngineCount) return 1;
+  return whisper_shim::EngineThreads(static_cast<whisper_shim::Engine>(engine));
+}
+
+int32_t meeting_whisper_sched_cpus(int32_t engine,
+                                   int32_t* cpus,
+                                   int32_t capacity) {
+  if (engine < 0 || engine >= whisper_shim::kEngineCount) return 0;
+  const std::vector<int32_t> planned =
+      whisper_shim::EngineCpus(static_cast<whisper_shim::Engine>(engine));
+  const auto count = static_cast<int32_t>(planned.size());
+  if (cpus != nullptr) {
+    std::copy_n(planned.begin(), std::max(0, std::min(count, capacity)),
+                cpus);
+  }
+  return count;
+}
@@ -0,0 +1,417 @@
+#ifndef MEETING_NATIVE_WHISPER_MEETING_WHISPER_H_
+#define MEETING_NATIVE_WHISPER_MEETING_WHISPER_H_
+
+#include <stdint.h>
+
+#include "common/native_export.h"
+
+// Speech recognition on top of whisper.cpp (WhisperFFI).
+//
+// whisper.cpp's own API passes whisper_full_params by value and changes its
+// layout between releases, so it cannot be mirrored safely from Dart. This
+// shim exposes a small flat ABI instead: options are scalar arguments and
+// results are read back through plain structs. Bump
+// MEETING_WHISPER_ABI_VERSION whenever a function or struct below is added or
+// changed; WhisperFFI refuses to bind a library with a different version.
+
+#define MEETING_WHISPER_ABI_VERSION 9
+
+// A text token of a segment. Special and timestamp tokens are left out, so
+// the tokens of a segment spell out exactly its text.
+//
+// Mirrored by NativeWhisperToken in lib/core/ai/model_ffi.dart.
+typedef struct meeting_whisper_token {
+  // Same origin as the segment's times. Aligned with DTW when the context
+  // was initialized with MEETING_WHISPER_INIT_ALIGN_TOKENS, otherwise taken
+  // from the decoder's timestamp token probabilities.
+  int64_t start_ms;
+  int64_t end_ms;
+  // Log-probability the decoder gave the token.
+  float logprob;
+  // Byte range of the token within the segment's UTF-8 text.
+  int32_t text_offset;
+  int32_t text_length;
+} meeting_whisper_token;
+
+// Mirrored by NativeWhisperSegment in lib/core/ai/model_ffi.dart.
+typedef struct meeting_whisper_segment {
+  // Offsets from the first sample of the transcribed audio.
+  int64_t start_ms;
+  int64_t end_ms;
+  // Probability that the segment contains no speech.
+  float no_speech_prob;
+  // UTF-8, owned by the context and valid until the next transcribe/free.
+  const char* text;
+  // |n_tokens| tokens, owned and kept valid like |text|.
+  const meeting_whisper_token* tokens;
+  int32_t n_tokens;
+} meeting_whisper_segment;
+
+typedef struct meeting_whisper meeting_whisper;
+
+NATIVE_API int32_t meeting_whisper_abi_version(void);
+
+// Flags for meeting_whisper_init().
+#define MEETING_WHISPER_INIT_USE_GPU 1
+// Fault the whole model file in before parsing it rather than on demand.
+#define MEETING_WHISPER_INIT_PREFETCH 2
+// Align token times with DTW over the model's cross-attention alignment
+// heads. Costs some memory per decode, and disables flash attention.
+#define MEETING_WHISPER_INIT_ALIGN_TOKENS 4
+
+// Loads a ggml model file, a combination of MEETING_WHISPER_INIT_* |flags|.
+// Returns null on failure.
+//
+// The file is memory-mapped rather than read through a heap buffer, so
+// reloading a recently used model reads from the page cache. The weights
+// are still copied into whisper.cpp's own buffers, not mapped, so they are
+// private memory and another process loading the same file pays for its
+// own copy. Contexts initialized from the same path, GPU and alignment
+// flags reuse one loaded model, each with its own decoder state, and the
+// model is released with its last context.
+NATIVE_API meeting_whisper* meeting_whisper_init(const char* model_path,
+                                                 int32_t flags);
+
+NATIVE_API void meeting_whisper_free(meeting_whisper* ctx);
+
+// Transcribes |count| mono float samples at 16 kHz.
+//
+// |language| is an ISO 639-1 code, or null / "auto" to detect it.
+// |n_threads| <= 0 follows the scheduling plan (see below). |beam_size| <= 1
+// decodes greedily.
+// Returns the number of segments, or -1 on failure (see
+// meeting_whisper_last_error()).
+NATIVE_API int32_t meeting_whisper_transcribe(meeting_whisper* ctx,
+                                              const float* samples,
+                                              int32_t count,
+                                              const char* language,
+                                              int32_t translate,
+                                              int32_t n_threads,
+                                              int32_t beam_size);
+
+NATIVE_API int32_t meeting_whisper_segment_count(const meeting_whisper* ctx);
+
+// Fills |segment| and returns 1, or returns 0 when |index| is out of range.
+NATIVE_API int32_t meeting_whisper_get_segment(
+    const meeting_whisper* ctx,
+    int32_t index,
+    meeting_whisper_segment* segment);
+
+// Language of the last transcription (detected or requested), or "".
+NATIVE_API const char* meeting_whisper_language(const meeting_whisper* ctx);
+
+// Description of the last failure, or "".
+NATIVE_API const char* meeting_whisper_last_error(const meeting_whisper* ctx);
+
+// Weight type of the loaded model, as ggml's file type (0 f32, 1 f16,
+// 7 q8_0, 8 q5_0, 9 q5_1, ...). Quantized models run through ggml's
+// dequantizing SIMD kernels, so this is all callers need to pick a
+// variant; there is nothing to select at decode time.
+NATIVE_API int32_t meeting_whisper_model_ftype(const meeting_whisper* ctx);
+
+// Size class of the loaded model ("tiny", "base", ...), or "".
+NATIVE_API const char* meeting_whisper_model_type(const meeting_whisper* ctx);
+
+// Language detection.
+//
+// Runs the encoder over the first |count| samples (at most 30 s; a few
+// seconds of speech is enough) and a single decoder step that scores the
+// language tokens, without decoding any text. Much cheaper than letting a
+// transcription auto-detect, which runs the encoder twice.
+//
+// Fills |probs| with up to |capacity| probabilities indexed by language id
+// (see meeting_whisper_language_code()) and returns the id of the most
+// likely language, or -1 on failure. English-only models report English
+// without running anything. Uses |ctx|'s decoder state, so it must not run
+// concurrently with a transcription on |ctx|.
+NATIVE_API int32_t meeting_whisper_detect_language(meeting_whisper* ctx,
+                                                   const float* samples,
+                                                   int32_t count,
+                                                   int32_t n_threads,
+                                                   float* probs,
+                                                   int32_t capacity);
+
+// Number of language ids.
+NATIVE_API int32_t meeting_whisper_language_count(void);
+
+// ISO 639-1 code of language |id|, or "" when out of range.
+NATIVE_API const char* meeting_whisper_language_code(int32_t id);
+
+// Inference scheduling.
+//
+// The shim reads the CPU topology (SMT siblings, big.LITTLE or P/E core
+// classes, NUMA nodes) and plans where inference runs: one thread per fast
+// physical core, on a single node, keeping one core free for audio capture
+// and the UI when there are no efficiency cores to take them. While Whisper
+// and Llama are both active the cores are split between them, so neither
+// oversubscribes the other. Worker and batch threads are placed on the
+// Whisper cores; other libraries ask for their share here, and the Llama
+// shim's worker is pinned to it with meeting_llama_worker_set_cpus().
+//
+// A Whisper model counts as active while any context is loaded.
+
+#define MEETING_WHISPER_ENGINE_WHISPER 0
+#define MEETING_WHISPER_ENGINE_LLAMA 1
+
+// Mirrored by NativeCpuTopology in lib/core/ai/model_ffi.dart.
+typedef struct meeting_whisper_cpu_topology {
+  int32_t logical_cpus;
+  int32_t physical_cores;
+  // Cores in the fastest class; all of them on homogeneous CPUs.
+  int32_t performance_cores;
+  int32_t numa_nodes;
+} meeting_whisper_cpu_topology;
+
+NATIVE_API void meeting_whisper_cpu_topology_get(
+    meeting_whisper_cpu_topology* topology);
+
+NATIVE_API void meeting_whisper_sched_set_active(int32_t engine,
+                                                 int32_t active);
+
+// Threads |engine| should run inference with under the current plan.
+NATIVE_API int32_t meeting_whisper_sched_threads(int32_t engine);
+
+// Copies up to |capacity| logical CPU numbers |engine| should be pinned to
+// and returns how many there are; 0 where affinity is not supported.
+NATIVE_API int32_t meeting_whisper_sched_cpus(int32_t engine,
+                                              int32_t* cpus,
+                                              int32_t capacity);
+
+// Streaming transcription.
+//
+// A stream keeps only the audio that has not been finalized yet, at most
+// |window_ms| long, and decodes it every |step_ms| of new audio with a fixed
+// encoder context sized to the window. After each decode every segment but
+// the last is committed: its text is final, its audio is dropped and its
+// tokens become the decoder prompt for the next window. The last segment is
+// reported as tentative until a later decode splits it off. When it fills
+// the window alone, all of it but its last word, which the window's end
+// may cut, is committed and that word goes on to the next window. Segment
+// times are relative to the first sample pushed.
+//
+// Each stream owns its own decoder state, so streams on one context may be
+// used from different threads. The context must outlive its streams.
+typedef struct meeting_whisper_stream meeting_whisper_stream;
+
+// |language| as for meeting_whisper_transcribe(). When it is detected, each
+// speech region is probed with meeting_whisper_detect_language() once its
+// first seconds are buffered, and decoded in that language until the stream
+// hears a window without speech; speakers switching language between
+// regions are followed, and no window pays for auto-detection.
+// |step_ms| and |window_ms| <= 0 pick defaults (2 s and 10 s). Returns null
+// on invalid arguments.
+NATIVE_API meeting_whisper_stream* meeting_whisper_stream_create(
+    meeting_whisper* ctx,
+    const char* language,
+    int32_t n_threads,
+    int32_t step_ms,
+    int32_t window_ms);
+
+NATIVE_API void meeting_whisper_stream_free(meeting_whisper_stream* stream);
+
+// Feeds |count| mono float samples at 16 kHz, decoding as needed. Returns the
+// number of segments committed by this call, or -1 on failure.
+NATIVE_API int32_t meeting_whisper_stream_push(meeting_whisper_stream* stream,
+                                               const float* samples,
+                                               int32_t count);
+
+// Decodes and commits all buffered audio. Returns the number of segments
+// committed, or -1 on failure.
+NATIVE_API int32_t meeting_whisper_stream_flush(meeting_whisper_stream* stream);
+
+// Segment |index| of those committed by the last push/flush. Returns 1, or 0
+// when |index| is out of range.
+NATIVE_API int32_t meeting_whisper_stream_get_segment(
+    const meeting_whisper_stream* stream,
+    int32_t index,
+    meeting_whisper_segment* segment);
+
+// Fills |segment| with the current tentative segment and returns 1, or
+// returns 0 when there is none.
+NATIVE_API int32_t meeting_whisper_stream_tentative(
+    const meeting_whisper_stream* stream,
+    meeting_whisper_segment* segment);
+
+// Language the stream decodes in, or "" while still undetermined.
+NATIVE_API const char* meeting_whisper_stream_language(
+    const meeting_whisper_stream* stream);
+
+// Batch transcription.
+//
+// A batch decodes many independent windows, e.g. from different recorded
+// meetings, on one loaded model. Windows are spread over up to |lanes|
+// threads, each with its own decoder state, so throughput scales with cores
+// instead of being capped by how far a single decode parallelizes.
+typedef struct meeting_whisper_batch meeting_whisper_batch;
+
+// |lanes| <= 0 picks one lane per two of the cores scheduled for Whisper.
+// Decoder states are created on first use and reused by later calls. The
+// context must outlive the batch.
+NATIVE_API meeting_whisper_batch* meeting_whisper_batch_create(
+    meeting_whisper* ctx,
+    int32_t lanes);
+
+NATIVE_API void meeting_whisper_batch_free(meeting_whisper_batch* batch);
+
+// Transcribes |n_windows| windows of 16 kHz mono audio stored back to back in
+// |samples|, window i being |counts|[i] samples long. Other arguments are as
+// for meeting_whisper_transcribe(); |n_threads| is per lane, <= 0 dividing
+// the Whisper cores between lanes. Returns the number of windows decoded
+// successfully, or -1 on invalid arguments.
+NATIVE_API int32_t meeting_whisper_batch_transcribe(
+    meeting_whisper_batch* batch,
+    const float* samples,
+    const int32_t* counts,
+    int32_t n_windows,
+    const char* language,
+    int32_t translate,
+    int32_t n_threads,
+    int32_t beam_size);
+
+// Number of segments of |window| from the last batch_transcribe, or -1 when
+// that window failed or is out of range.
+NATIVE_API int32_t meeting_whisper_batch_segment_count(
+    const meeting_whisper_batch* batch,
+    int32_t window);
+
+NATIVE_API int32_t meeting_whisper_batch_get_segment(
+    const meeting_whisper_batch* batch,
+    int32_t window,
+    int32_t index,
+    meeting_whisper_segment* segment);
+
+NATIVE_API const char* meeting_whisper_batch_language(
+    const meeting_whisper_batch* batch,
+    int32_t window);
+
+// Inference worker.
+//
+// A worker owns one long-lived thread that runs transcription jobs in
+// submission order, so callers never block on decoding. Submission copies
+// the audio and returns immediately with a job id; the result is handed to
+// |callback| on the worker thread (from Dart, a NativeCallable.listener).
+// The receiver owns the result and releases it with
+// meeting_whisper_result_free(); a null result means the job failed for lack
+// of memory.
+//
+// The queue holds at most |queue_capacity| jobs. When it is full the oldest
+// job is completed with MEETING_WHISPER_JOB_DROPPED to make room; that
+// result too is handed over on the worker thread, before the next job
+// runs, so submitting never calls |callback| (and may be a leaf call from
+// Dart). With
+// MEETING_WHISPER_QUEUE_MERGE, audio pushed to a stream whose previous push
+// is still queued is appended to that job instead, and the call returns the
+// existing job id; its result covers both pushes.
+//
+// Contexts and streams used by queued jobs must stay alive until their
+// results arrive, and must not be used directly while jobs are in flight.
+
+#define MEETING_WHISPER_QUEUE_DROP_OLDEST 0
+#define MEETING_WHISPER_QUEUE_MERGE 1
+
+#define MEETING_WHISPER_JOB_OK 0
+#define MEETING_WHISPER_JOB_FAILED -1
+#define MEETING_WHISPER_JOB_DROPPED 1
+
+typedef struct meeting_whisper_worker meeting_whisper_worker;
+typedef struct meeting_whisper_result meeting_whisper_result;
+
+typedef void (*meeting_whisper_callback)(int64_t job_id,
+                                         meeting_whisper_result* result);
+
+// Returns null on invalid arguments.
+NATIVE_API meeting_whisper_worker* meeting_whisper_worker_create(
+    int32_t queue_capacity,
+    int32_t policy,
+    meeting_whisper_callback callback);
+
+// Runs the jobs still queued, then stops the thread.
+NATIVE_API void meeting_whisper_worker_free(meeting_whisper_worker* worker);
+
+// Queue jobs mirroring meeting_whisper_transcribe(),
+// meeting_whisper_stream_push() and meeting_whisper_stream_flush(). Return
+// the job id, or -1 on invalid arguments.
+NATIVE_API int64_t meeting_whisper_worker_transcribe(
+    meeting_whisper_worker* worker,
+    meeting_whisper* ctx,
+    const float* samples,
+    int32_t count,
+    const char* language,
+    int32_t translate,
+    int32_t n_threads,
+    int32_t beam_size);
+
+NATIVE_API int64_t meeting_whisper_worker_push(meeting_whisper_worker* worker,
+                                               meeting_whisper_stream* stream,
+                                               const float* samples,
+                                               int32_t count);
+
+NATIVE_API int64_t meeting_whisper_worker_flush(meeting_whisper_worker* worker,
+                                                meeting_whisper_stream* stream);
+
+// Queues meeting_whisper_detect_language(). The result carries the detected
+// language and its probabilities (see
+// meeting_whisper_result_language_probs()).
+NATIVE_API int64_t meeting_whisper_worker_detect_language(
+    meeting_whisper_worker* worker,
+    meeting_whisper* ctx,
+    const float* samples,
+    int32_t count,
+    int32_t n_threads);
+
+// Queues meeting_whisper_batch_transcribe(). The result carries one child
+// result per window (see meeting_whisper_result_window()).
+NATIVE_API int64_t meeting_whisper_worker_transcribe_batch(
+    meeting_whisper_worker* worker,
+    meeting_whisper_batch* batch,
+    const float* samples,
+    const int32_t* counts,
+    int32_t n_windows,
+    const char* language,
+    int32_t translate,
+    int32_t n_threads,
+    int32_t beam_size);
+
+// Number of jobs queued or running.
+NATIVE_API int32_t meeting_whisper_worker_pending(
+    const meeting_whisper_worker* worker);
+
+// One of MEETING_WHISPER_JOB_*.
+NATIVE_API int32_t meeting_whisper_result_status(
+    const meeting_whisper_result* result);
+
+// Committed segments for stream jobs, all segments for transcribe jobs.
+NATIVE_API int32_t meeting_whisper_result_segment_count(
+    const meeting_whisper_result* result);
+
+NATIVE_API int32_t meeting_whisper_result_get_segment(
+    const meeting_whisper_result* result,
+    int32_t index,
+    meeting_whisper_segment* segment);
+
+NATIVE_API int32_t meeting_whisper_result_tentative(
+    const meeting_whisper_result* result,
+    meeting_whisper_segment* segment);
+
+NATIVE_API const char* meeting_whisper_result_language(
+    const meeting_whisper_result* result);
+
+// Copies up to |capacity| language probabilities of a language detection
+// job into |probs| and returns how many there are; 0 for other jobs.
+NATIVE_API int32_t meeting_whisper_result_language_probs(
+    const meeting_whisper_result* result,
+    float* probs,
+    int32_t capacity);
+
+// Per-window results of a batch job, owned by |result|; 0 / null for other
+// jobs or out of range.
+NATIVE_API int32_t meeting_whisper_result_window_count(
+    const meeting_whisper_result* result);
+
+NATIVE_API const meeting_whisper_result* meeting_whisper_result_window(
+    const meeting_whisper_result* result,
+    int32_t index);
+
+NATIVE_API void meeting_whisper_result_free(meeting_whisper_result* result);
+
+#endif  // MEETING_NATIVE_WHISPER_MEETING_WHISPER_H_
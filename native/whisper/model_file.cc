@@ -0,0 +1,119 @@
+#include "whisper/model_file.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace whisper_shim {
+
+namespace {
+
+constexpr uint32_t kGgmlMagic = 0x67676d6c;
+
+// Text layers whose heads are all used for alignment when the model is not
+// one whisper.cpp has a head preset for.
+constexpr int kFallbackAlignmentLayers = 2;
+
+// The hyperparameters at the start of a ggml whisper file that identify the
+// model size.
+struct ModelHeader {
+  int32_t n_vocab;
+  int32_t n_audio_layer;
+  int32_t n_text_layer;
+  int32_t n_mels;
+};
+
+bool ReadHeader(const MappedFile& file, ModelHeader* header) {
+  // magic, n_vocab, n_audio_ctx, n_audio_state, n_audio_head,
+  // n_audio_layer, n_text_ctx, n_text_state, n_text_head, n_text_layer,
+  // n_mels
+  int32_t fields[11];
+  if (file.size() < sizeof(fields)) return false;
+  std::memcpy(fields, file.data(), sizeof(fields));
+  if (static_cast<uint32_t>(fields[0]) != kGgmlMagic) return false;
+  header->n_vocab = fields[1];
+  header->n_audio_layer = fields[5];
+  header->n_text_layer = fields[9];
+  header->n_mels = fields[10];
+  return true;
+}
+
+// Alignment heads preset for the model described by |header|. English-only
+// models have one token fewer than multilingual ones.
+whisper_alignment_heads_preset AlignmentHeads(const ModelHeader& header) {
+  const bool english = header.n_vocab == 51864;
+  switch (header.n_audio_layer) {
+    case 4:
+      return english ? WHISPER_AHEADS_TINY_EN : WHISPER_AHEADS_TINY;
+    case 6:
+      return english ? WHISPER_AHEADS_BASE_EN : WHISPER_AHEADS_BASE;
+    case 12:
+      return english ? WHISPER_AHEADS_SMALL_EN : WHISPER_AHEADS_SMALL;
+    case 24:
+      return english ? WHISPER_AHEADS_MEDIUM_EN : WHISPER_AHEADS_MEDIUM;
+    case 32:
+      // large-v1 and -v2 share their hyperparameters; v3 has 128 mel bins
+      // and turbo a 4-layer decoder.
+      if (header.n_mels != 128) break;
+      return header.n_text_layer == 4 ? WHISPER_AHEADS_LARGE_V3_TURBO
+                                      : WHISPER_AHEADS_LARGE_V3;
+  }
+  return WHISPER_AHEADS_N_TOP_MOST;
+}
+
+void EnableAlignment(const MappedFile* file, whisper_context_params* params) {
+  ModelHeader header;
+  params->dtw_token_timestamps = true;
+  params->dtw_aheads_preset = file != nullptr && ReadHeader(*file, &header)
+                                  ? AlignmentHeads(header)
+                                  : WHISPER_AHEADS_N_TOP_MOST;
+  params->dtw_n_top = kFallbackAlignmentLayers;
+  // whisper.cpp cannot read attention weights back out of the flash path.
+  params->flash_attn = false;
+}
+
+struct LoaderCursor {
+  const MappedFile* file;
+  size_t offset;
+};
+
+size_t ReadMapped(void* ctx, void* output, size_t read_size) {
+  auto* cursor = static_cast<LoaderCursor*>(ctx);
+  const size_t count =
+      std::min(read_size, cursor->file->size() - cursor->offset);
+  std::memcpy(output, cursor->file->data() + cursor->offset, count);
+  cursor->offset += count;
+  return count;
+}
+
+bool EofMapped(void* ctx) {
+  const auto* cursor = static_cast<const LoaderCursor*>(ctx);
+  return cursor->offset >= cursor->file->size();
+}
+
+void CloseMapped(void* ctx) {}
+
+}  // namespace
+
+whisper_context* LoadMappedModel(const char* path,
+                                 whisper_context_params params,
+                                 bool prefetch,
+                                 bool align_tokens) {
+  MappedFile file;
+  if (!file.Open(path, prefetch)) {
+    // Fall back to whisper.cpp's own reader, e.g. on filesystems that
+    // cannot be mapped.
+    if (align_tokens) EnableAlignment(nullptr, &params);
+    return whisper_init_from_file_with_params_no_state(path, params);
+  }
+  if (align_tokens) EnableAlignment(&file, &params);
+
+  LoaderCursor cursor{&file, 0};
+  whisper_model_loader loader;
+  loader.context = &cursor;
+  loader.read = ReadMapped;
+  loader.eof = EofMapped;
+  loader.close = CloseMapped;
+  return whisper_init_with_params_no_state(&loader, params);
+}
+
+}  // namespace whisper_shim
@@ -0,0 +1,36 @@
+#ifndef MEETING_NATIVE_WHISPER_MODEL_FILE_H_
+#define MEETING_NATIVE_WHISPER_MODEL_FILE_H_
+
+// Model file loading for the whisper shim. Not part of the C ABI.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "common/mapped_file.h"
+#include "whisper.h"
+
+namespace whisper_shim {
+
+using native_common::MappedFile;
+
+// Loads a whisper context from a mapped model file. Returns null on
+// failure.
+//
+// The mapping does not make the weights shared memory. whisper.cpp's loader
+// reads through callbacks, and each read is a memcpy from the mapping into
+// its own backend buffers. The loaded weights are therefore private to the
+// process, as with a plain read, and are not shared with other processes
+// through the page cache. The mapping is unmapped once the load finishes.
+// It only saves stdio's buffered read and its extra copy of the file.
+//
+// With |align_tokens|, DTW token alignment is enabled using the alignment
+// heads whisper.cpp ships for the model's size, identified from the file
+// header.
+whisper_context* LoadMappedModel(const char* path,
+                                 whisper_context_params params,
+                                 bool prefetch,
+                                 bool align_tokens);
+
+}  // namespace whisper_shim
+
+#endif  // MEETING_NATIVE_WHISPER_MODEL_FILE_H_
@@ -0,0 +1,91 @@
+#include "whisper/transcript_cache.h"
+
+#include <cstring>
+
+namespace whisper_shim {
+
+namespace {
+
+// Transcriptions kept by SharedTranscriptCache(). An entry is a few hundred
+// bytes of text, so this is bounded by the audio hashed, not by memory.
+constexpr size_t kSharedCapacity = 64;
+
+constexpr uint64_t kHashSeed = 0x9e3779b97f4a7c15ull;
+constexpr uint64_t kHashMultiplier = 0xff51afd7ed558ccdull;
+
+uint64_t Mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= kHashMultiplier;
+  h ^= h >> 33;
+  return h;
+}
+
+}  // namespace
+
+bool TranscriptKey::operator==(const TranscriptKey& other) const {
+  return model == other.model && audio_hash == other.audio_hash &&
+         count == other.count && language == other.language &&
+         translate == other.translate && beam_size == other.beam_size;
+}
+
+uint64_t HashSamples(const float* samples, int32_t count) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(samples);
+  const size_t size = static_cast<size_t>(count) * sizeof(float);
+
+  uint64_t h = kHashSeed ^ size;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    h = (h ^ Mix(word)) * kHashMultiplier;
+  }
+  if (i < size) {
+    uint64_t word = 0;
+    std::memcpy(&word, bytes + i, size - i);
+    h = (h ^ Mix(word)) * kHashMultiplier;
+  }
+  return Mix(h);
+}
+
+bool TranscriptCache::Lookup(const TranscriptKey& key,
+                             std::vector<Segment>* segments,
+                             std::string* language) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (!(it->key == key)) continue;
+    entries_.splice(entries_.begin(), entries_, it);
+    *segments = it->segments;
+    *language = it->language;
+    return true;
+  }
+  return false;
+}
+
+void TranscriptCache::Insert(const TranscriptKey& key,
+                             const std::vector<Segment>& segments,
+                             const std::string& language) {
+  if (capacity_ == 0) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (it->key == key) {
+      entries_.erase(it);
+      break;
+    }
+  }
+  entries_.push_front({key, segments, language});
+  if (entries_.size() > capacity_) entries_.pop_back();
+}
+
+void TranscriptCache::Forget(const whisper_context* model) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.remove_if([model](const Entry& entry) {
+    return entry.key.model == model;
+  });
+}
+
+TranscriptCache& SharedTranscriptCache() {
+  static TranscriptCache cache(kSharedCapacity);
+  return cache;
+}
+
+}  // namespace whisper_shim
@@ -0,0 +1,87 @@
+#ifndef MEETING_NATIVE_WHISPER_TRANSCRIPT_CACHE_H_
+#define MEETING_NATIVE_WHISPER_TRANSCRIPT_CACHE_H_
+
+// Cache of recent transcriptions for the whisper shim. Not part of the C ABI.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "whisper.h"
+#include "whisper/meeting_whisper.h"
+
+namespace whisper_shim {
+
+// A decoded segment as kept by the shim.
+struct Segment {
+  int64_t start_ms;
+  int64_t end_ms;
+  float no_speech_prob;
+  std::string text;
+  std::vector<meeting_whisper_token> tokens;
+};
+
+// Identifies one transcription: the model, the audio and every option that
+// changes the decoded text.
+struct TranscriptKey {
+  const whisper_context* model = nullptr;
+  uint64_t audio_hash = 0;
+  int32_t count = 0;
+  std::string language;
+  int32_t translate = 0;
+  int32_t beam_size = 0;
+
+  bool operator==(const TranscriptKey& other) const;
+};
+
+// 64-bit hash of |count| samples.
+uint64_t HashSamples(const float* samples, int32_t count);
+
+// Bounded LRU of whole transcriptions.
+//
+// whisper_full() always recomputes the mel spectrogram and reruns the
+// encoder, and whisper.cpp has no public way to read either back out of a
+// state, so the reusable unit is the finished transcription. A hit skips
+// the encoder and decoder entirely, which is what retries of the same audio
+// on the same model need. Thread-safe.
+class TranscriptCache {
+ public:
+  explicit TranscriptCache(size_t capacity) : capacity_(capacity) {}
+
+  // Copies the cached transcription for |key| out and marks it recently
+  // used. Returns false on a miss.
+  bool Lookup(const TranscriptKey& key,
+              std::vector<Segment>* segments,
+              std::string* language);
+
+  void Insert(const TranscriptKey& key,
+              const std::vector<Segment>& segments,
+              const std::string& language);
+
+  // Drops every entry for |model|, before it is freed and its address can
+  // be reused.
+  void Forget(const whisper_context* model);
+
+ private:
+  struct Entry {
+    TranscriptKey key;
+    std::vector<Segment> segments;
+    std::string language;
+  };
+
+  const size_t capacity_;
+  std::mutex mutex_;
+  // Most recently used first.
+  std::list<Entry> entries_;
+};
+
+// The process-wide cache shared by all contexts.
+TranscriptCache& SharedTranscriptCache();
+
+}  // namespace whisper_shim
+
+#endif  // MEETING_NATIVE_WHISPER_TRANSCRIPT_CACHE_H_
@@ -0,0 +1,498 @@
+#include "whisper/meeting_whisper.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "whisper/cpu_scheduler.h"
+
+namespace {
+
+// Upper bound on the audio a merged push may accumulate (30 s at 16 kHz);
+// beyond it pushes queue separately and become subject to dropping.
+constexpr size_t kMaxMergedSamples = 30 * 16000;
+
+enum class JobKind { kTranscribe, kPush, kFlush, kBatch, kDetectLanguage };
+
+struct Job {
+  int64_t id = 0;
+  JobKind kind = JobKind::kTranscribe;
+  meeting_whisper* ctx = nullptr;
+  meeting_whisper_stream* stream = nullptr;
+  meeting_whisper_batch* batch = nullptr;
+  std::vector<float> audio;
+  // Window lengths for kBatch, whose windows are stored back to back.
+  std::vector<int32_t> counts;
+  std::string language;
+  bool auto_language = true;
+  int32_t translate = 0;
+  int32_t n_threads = 0;
+  int32_t beam_size = 0;
+};
+
+struct OwnedSegment {
+  int64_t start_ms = 0;
+  int64_t end_ms = 0;
+  float no_speech_prob = 0.0f;
+  std::string text;
+  std::vector<meeting_whisper_token> tokens;
+};
+
+OwnedSegment CopySegment(const meeting_whisper_segment& segment) {
+  OwnedSegment owned;
+  owned.start_ms = segment.start_ms;
+  owned.end_ms = segment.end_ms;
+  owned.no_speech_prob = segment.no_speech_prob;
+  owned.text = segment.text != nullptr ? segment.text : "";
+  if (segment.tokens != nullptr && segment.n_tokens > 0) {
+    owned.tokens.assign(segment.tokens, segment.tokens + segment.n_tokens);
+  }
+  return owned;
+}
+
+void WriteSegment(const OwnedSegment& source,
+                  meeting_whisper_segment* segment) {
+  segment->start_ms = source.start_ms;
+  segment->end_ms = source.end_ms;
+  segment->no_speech_prob = source.no_speech_prob;
+  segment->text = source.text.c_str();
+  segment->tokens = source.tokens.data();
+  segment->n_tokens = static_cast<int32_t>(source.tokens.size());
+}
+
+}  // namespace
+
+struct meeting_whisper_result {
+  int32_t status = MEETING_WHISPER_JOB_OK;
+  std::vector<OwnedSegment> segments;
+  OwnedSegment tentative;
+  bool has_tentative = false;
+  std::string language;
+  // Indexed by language id, for language detection jobs.
+  std::vector<float> language_probs;
+  // One child result per window of a batch job.
+  std::vector<meeting_whisper_result> windows;
+};
+
+struct meeting_whisper_worker {
+  meeting_whisper_callback callback = nullptr;
+  size_t capacity = 0;
+  int32_t policy = MEETING_WHISPER_QUEUE_DROP_OLDEST;
+
+  mutable std::mutex mutex;
+  std::condition_variable wake;
+  std::deque<Job> queue;
+  // Jobs dropped from the queue, reported by the thread before it runs the
+  // next job: submitters never call |callback| themselves.
+  std::vector<int64_t> dropped;
+  bool running_job = false;
+  bool stopping = false;
+  int64_t next_id = 1;
+
+  std::thread thread;
+};
+
+namespace {
+
+meeting_whisper_result* RunTranscribe(const Job& job) {
+  auto* result = new (std::nothrow) meeting_whisper_result();
+  if (result == nullptr) return nullptr;
+  const int32_t count = meeting_whisper_transcribe(
+      job.ctx, job.audio.data(), static_cast<int32_t>(job.audio.size()),
+      job.auto_language ? nullptr : job.language.c_str(), job.translate,
+      job.n_threads, job.beam_size);
+  if (count < 0) {
+    result->status = MEETING_WHISPER_JOB_FAILED;
+    return result;
+  }
+
+  meeting_whisper_segment segment;
+  for (int32_t i = 0; i < count; ++i) {
+    if (meeting_whisper_get_segment(job.ctx, i, &segment) == 0) break;
+    result->segments.push_back(CopySegment(segment));
+  }
+  result->language = meeting_whisper_language(job.ctx);
+  return result;
+}
+
+meeting_whisper_result* RunStream(const Job& job) {
+  auto* result = new (std::nothrow) meeting_whisper_result();
+  if (result == nullptr) return nullptr;
+  const int32_t count =
+      job.kind == JobKind::kPush
+          ? meeting_whisper_stream_push(job.stream, job.audio.data(),
+                                        static_cast<int32_t>(job.audio.size()))
+          : meeting_whisper_stream_flush(job.stream);
+  if (count < 0) {
+    result->status = MEETING_WHISPER_JOB_FAILED;
+    return result;
+  }
+
+  meeting_whisper_segment segment;
+  for (int32_t i = 0; i < count; ++i) {
+    if (meeting_whisper_stream_get_segment(job.stream, i, &segment) == 0) {
+      break;
+    }
+    result->segments.push_back(CopySegment(segment));
+  }
+  if (meeting_whisper_stream_tentative(job.stream, &segment) != 0) {
+    result->tentative = CopySegment(segment);
+    result->has_tentative = true;
+  }
+  result->language = meeting_whisper_stream_language(job.stream);
+  return result;
+}
+
+meeting_whisper_result* RunBatch(const Job& job) {
+  auto* result = new (std::nothrow) meeting_whisper_result();
+  if (result == nullptr) return nullptr;
+  const int32_t n_windows = static_cast<int32_t>(job.counts.size());
+  if (meeting_whisper_batch_transcribe(
+          job.batch, job.audio.data(), job.counts.data(), n_windows,
+          job.auto_language ? nullptr : job.language.c_str(), job.translate,
+          job.n_threads, job.beam_size) < 0) {
+    result->status = MEETING_WHISPER_JOB_FAILED;
+    return result;
+  }
+
+  result->windows.resize(job.counts.size());
+  meeting_whisper_segment segment;
+  for (int32_t w = 0; w < n_windows; ++w) {
+    meeting_whisper_result& window = result->windows[w];
+    const int32_t count = meeting_whisper_batch_segment_count(job.batch, w);
+    if (count < 0) {
+      window.status = MEETING_WHISPER_JOB_FAILED;
+      continue;
+    }
+    for (int32_t i = 0; i < count; ++i) {
+      if (meeting_whisper_batch_get_segment(job.batch, w, i, &segment) == 0) {
+        break;
+      }
+      window.segments.push_back(CopySegment(segment));
+    }
+    window.language = meeting_whisper_batch_language(job.batch, w);
+  }
+  return result;
+}
+
+meeting_whisper_result* RunDetectLanguage(const Job& job) {
+  auto* result = new (std::nothrow) meeting_whisper_result();
+  if (result == nullptr) return nullptr;
+  result->language_probs.resize(
+      static_cast<size_t>(meeting_whisper_language_count()));
+  const int32_t id = meeting_whisper_detect_language(
+      job.ctx, job.audio.data(), static_cast<int32_t>(job.audio.size()),
+      job.n_threads, result->language_probs.data(),
+      static_cast<int32_t>(result->language_probs.size()));
+  if (id < 0) {
+    result->status = MEETING_WHISPER_JOB_FAILED;
+    result->language_probs.clear();
+    return result;
+  }
+  result->language = meeting_whisper_language_code(id);
+  return result;
+}
+
+meeting_whisper_result* RunJob(const Job& job) {
+  switch (job.kind) {
+    case JobKind::kTranscribe:
+      return RunTranscribe(job);
+    case JobKind::kBatch:
+      return RunBatch(job);
+    case JobKind::kDetectLanguage:
+      return RunDetectLanguage(job);
+    case JobKind::kPush:
+    case JobKind::kFlush:
+      break;
+  }
+  return RunStream(job);
+}
+
+void PostDropped(meeting_whisper_worker* worker, int64_t id) {
+  auto* dropped = new (std::nothrow) meeting_whisper_result();
+  if (dropped != nullptr) dropped->status = MEETING_WHISPER_JOB_DROPPED;
+  worker->callback(id, dropped);
+}
+
+void RunWorker(meeting_whisper_worker* worker) {
+  for (;;) {
+    Job job;
+    bool has_job = false;
+    bool stopping = false;
+    std::vector<int64_t> dropped;
+    {
+      std::unique_lock<std::mutex> lock(worker->mutex);
+      worker->wake.wait(lock, [worker] {
+        return worker->stopping || !worker->queue.empty() ||
+               !worker->dropped.empty();
+      });
+      stopping = worker->stopping;
+      dropped.swap(worker->dropped);
+      if (!worker->queue.empty()) {
+        job = std::move(worker->queue.front());
+        worker->queue.pop_front();
+        worker->running_job = true;
+        has_job = true;
+      }
+    }
+
+    // Dropped jobs were queued ahead of the next one
+    for (const int64_t id : dropped) PostDropped(worker, id);
+    if (!has_job) {
+      if (stopping) return;
+      continue;
+    }
+
+    // Follows the plan as engines come and go; a no-op while it is stable.
+    whisper_shim::PlaceCurrentThread(whisper_shim::kEngineWhisper);
+    meeting_whisper_result* result = RunJob(job);
+    {
+      std::lock_guard<std::mutex> lock(worker->mutex);
+      worker->running_job = false;
+    }
+    worker->callback(job.id, result);
+  }
+}
+
+int64_t Submit(meeting_whisper_worker* worker, Job job) {
+  int64_t id = 0;
+  {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    if (worker->stopping) return -1;
+
+    if (worker->policy == MEETING_WHISPER_QUEUE_MERGE &&
+        job.kind == JobKind::kPush && !worker->queue.empty()) {
+      Job& last = worker->queue.back();
+      if (last.kind == JobKind::kPush && last.stream == job.stream &&
+          last.audio.size() + job.audio.size() <= kMaxMergedSamples) {
+        last.audio.insert(last.audio.end(), job.audio.begin(),
+                          job.audio.end());
+        return last.id;
+      }
+    }
+
+    if (worker->queue.size() >= worker->capacity) {
+      worker->dropped.push_back(worker->queue.front().id);
+      worker->queue.pop_front();
+    }
+
+    id = worker->next_id++;
+    job.id = id;
+    worker->queue.push_back(std::move(job));
+  }
+  worker->wake.notify_one();
+  return id;
+}
+
+}  // namespace
+
+meeting_whisper_worker* meeting_whisper_worker_create(
+    int32_t queue_capacity,
+    int32_t policy,
+    meeting_whisper_callback callback) {
+  if (queue_capacity <= 0 || callback == nullptr ||
+      (policy != MEETING_WHISPER_QUEUE_DROP_OLDEST &&
+       policy != MEETING_WHISPER_QUEUE_MERGE)) {
+    return nullptr;
+  }
+
+  auto* worker = new (std::nothrow) meeting_whisper_worker();
+  if (worker == nullptr) return nullptr;
+  worker->callback = callback;
+  worker->capacity = static_cast<size_t>(queue_capacity);
+  worker->policy = policy;
+  worker->thread = std::thread(RunWorker, worker);
+  return worker;
+}
+
+void meeting_whisper_worker_free(meeting_whisper_worker* worker) {
+  if (worker == nullptr) return;
+  {
+    std::lock_guard<std::mutex> lock(worker->mutex);
+    worker->stopping = true;
+  }
+  worker->wake.notify_one();
+  worker->thread.join();
+  delete worker;
+}
+
+int64_t meeting_whisper_worker_transcribe(meeting_whisper_worker* worker,
+                                          meeting_whisper* ctx,
+                                          const float* samples,
+                                          int32_t count,
+                                          const char* language,
+                                          int32_t translate,
+                                          int32_t n_threads,
+                                          int32_t beam_size) {
+  if (worker == nullptr || ctx == nullptr || samples == nullptr ||
+      count <= 0) {
+    return -1;
+  }
+
+  Job job;
+  job.kind = JobKind::kTranscribe;
+  job.ctx = ctx;
+  job.audio.assign(samples, samples + count);
+  job.auto_language = language == nullptr;
+  if (language != nullptr) job.language = language;
+  job.translate = translate;
+  job.n_threads = n_threads;
+  job.beam_size = beam_size;
+  return Submit(worker, std::move(job));
+}
+
+int64_t meeting_whisper_worker_push(meeting_whisper_worker* worker,
+                                    meeting_whisper_stream* stream,
+                                    const float* samples,
+                                    int32_t count) {
+  if (worker == nullptr || stream == nullptr || samples == nullptr ||
+      count <= 0) {
+    return -1;
+  }
+
+  Job job;
+  job.kind = JobKind::kPush;
+  job.stream = stream;
+  job.audio.assign(samples, samples + count);
+  return Submit(worker, std::move(job));
+}
+
+int64_t meeting_whisper_worker_flush(meeting_whisper_worker* worker,
+                                     meeting_whisper_stream* stream) {
+  if (worker == nullptr || stream == nullptr) return -1;
+
+  Job job;
+  job.kind = JobKind::kFlush;
+  job.stream = stream;
+  return Submit(worker, std::move(job));
+}
+
+int64_t meeting_whisper_worker_detect_language(meeting_whisper_worker* worker,
+                                               meeting_whisper* ctx,
+                                               const float* samples,
+                                               int32_t count,
+                                               int32_t n_threads) {
+  if (worker == nullptr || ctx == nullptr || samples == nullptr ||
+      count <= 0) {
+    return -1;
+  }
+
+  Job job;
+  job.kind = JobKind::kDetectLanguage;
+  job.ctx = ctx;
+  job.audio.assign(samples, samples + count);
+  job.n_threads = n_threads;
+  return Submit(worker, std::move(job));
+}
+
+int64_t meeting_whisper_worker_transcribe_batch(meeting_whisper_worker* worker,
+                                                meeting_whisper_batch* batch,
+                                                const float* samples,
+                                                const int32_t* counts,
+                                                int32_t n_windows,
+                                                const char* language,
+                                                int32_t translate,
+                                                int32_t n_threads,
+                                                int32_t beam_size) {
+  if (worker == nullptr || batch == nullptr || samples == nullptr ||
+      counts == nullptr || n_windows <= 0) {
+    return -1;
+  }
+
+  Job job;
+  job.kind = JobKind::kBatch;
+  job.batch = batch;
+  job.counts.assign(counts, counts + n_windows);
+  size_t total = 0;
+  for (const int32_t count : job.counts) {
+    if (count < 0) return -1;
+    total += static_cast<size_t>(count);
+  }
+  job.audio.assign(samples, samples + total);
+  job.auto_language = language == nullptr;
+  if (language != nullptr) job.language = language;
+  job.translate = translate;
+  job.n_threads = n_threads;
+  job.beam_size = beam_size;
+  return Submit(worker, std::move(job));
+}
+
+int32_t meeting_whisper_worker_pending(const meeting_whisper_worker* worker) {
+  if (worker == nullptr) return 0;
+  std::lock_guard<std::mutex> lock(worker->mutex);
+  return static_cast<int32_t>(worker->queue.size()) +
+         (worker->running_job ? 1 : 0);
+}
+
+int32_t meeting_whisper_result_status(const meeting_whisper_result* result) {
+  return result != nullptr ? result->status : MEETING_WHISPER_JOB_FAILED;
+}
+
+int32_t meeting_whisper_result_segment_count(
+    const meeting_whisper_result* result) {
+  return result != nullptr ? static_cast<int32_t>(result->segments.size())
+                           : 0;
+}
+
+int32_t meeting_whisper_result_get_segment(const meeting_whisper_result* result,
+                                           int32_t index,
+                                           meeting_whisper_segment* segment) {
+  if (result == nullptr || segment == nullptr || index < 0 ||
+      index >= static_cast<int32_t>(result->segments.size())) {
+    return 0;
+  }
+  WriteSegment(result->segments[index], segment);
+  return 1;
+}
+
+int32_t meeting_whisper_result_tentative(const meeting_whisper_result* result,
+                                         meeting_whisper_segment* segment) {
+  if (result == nullptr || segment == nullptr || !result->has_tentative) {
+    return 0;
+  }
+  WriteSegment(result->tentative, segment);
+  return 1;
+}
+
+const char* meeting_whisper_result_language(
+    const meeting_whisper_result* result) {
+  return result != nullptr ? result->language.c_str() : "";
+}
+
+int32_t meeting_whisper_result_language_probs(
+    const meeting_whisper_result* result,
+    float* probs,
+    int32_t capacity) {
+  if (result == nullptr) return 0;
+  const auto count = static_cast<int32_t>(result->language_probs.size());
+  if (probs != nullptr && capacity > 0) {
+    std::copy_n(result->language_probs.begin(), std::min(count, capacity),
+                probs);
+  }
+  return count;
+}
+
+void meeting_whisper_result_free(meeting_whisper_result* result) {
+  delete result;
+}
+
+int32_t meeting_whisper_result_window_count(
+    const meeting_whisper_result* result) {
+  return result != nullptr ? static_cast<int32_t>(result->windows.size()) : 0;
+}
+
+const meeting_whisper_result* meeting_whisper_result_window(
+    const meeting_whisper_result* result,
+    int32_t index) {
+  if (result == nullptr || index < 0 ||
+      index >= static_cast<int32_t>(result->windows.size())) {
+    return nullptr;
+  }
+  return &result->windows[index];
+}
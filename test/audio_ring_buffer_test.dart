@@ -0,0 +1,56 @@
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:meeting_note_summarizer/core/audio/audio_ring_buffer.dart';
+
+Float32List _ramp(int start, int count) =>
+    Float32List.fromList(List.generate(count, (i) => (start + i).toDouble()));
+
+void main() {
+  group('AudioRingBuffer Tests', () {
+    test('should return contiguous views across the wrap point', () {
+      final ring = AudioRingBuffer(10);
+      ring.append(_ramp(0, 7));
+      ring.append(_ramp(7, 7));
+
+      expect(ring.length, 10);
+      expect(ring.startPosition, 4);
+      expect(ring.endPosition, 14);
+      expect(ring.view(), _ramp(4, 10));
+      expect(ring.view(3), _ramp(11, 3));
+    });
+
+    test('should keep only the newest samples of oversized appends', () {
+      final ring = AudioRingBuffer(4);
+      ring.append(_ramp(0, 9));
+
+      expect(ring.view(), _ramp(5, 4));
+      expect(ring.endPosition, 9);
+    });
+
+    test('should retain overlap by index and clear positions', () {
+      final ring = AudioRingBuffer(8);
+      ring.append(_ramp(0, 6));
+      ring.retainLast(2);
+
+      expect(ring.view(), _ramp(4, 2));
+      expect(ring.startPosition, 4);
+
+      ring.append(_ramp(6, 3));
+      expect(ring.view(), _ramp(4, 5));
+
+      ring.clear();
+      expect(ring.isEmpty, isTrue);
+      expect(ring.endPosition, 0);
+    });
+
+    test('should hold 16-bit PCM with the same semantics', () {
+      final ring = Pcm16RingBuffer(4);
+      ring.append(Int16List.fromList([1, 2, 3]));
+      ring.append(Int16List.fromList([-4, -5]));
+
+      expect(ring.view(), [2, 3, -4, -5]);
+      expect(ring.startPosition, 1);
+    });
+  });
+}
@@ -0,0 +1,44 @@
+import 'dart:math' as math;
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:meeting_note_summarizer/core/audio/noise_floor_estimator.dart';
+
+void main() {
+  group('NoiseFloorEstimator Tests', () {
+    test('should match sorted 10th percentile within one bin', () {
+      final random = math.Random(42);
+      final audio = Float32List(16000);
+      for (int i = 0; i < audio.length; i++) {
+        audio[i] = (random.nextDouble() * 2 - 1) * 0.05;
+      }
+
+      final sorted = audio.map((s) => s.abs()).toList()..sort();
+      final exact = sorted[(sorted.length * 0.1).round()];
+
+      final estimator = NoiseFloorEstimator()..addSamples(audio);
+      final estimate = estimator.noiseFloor;
+
+      // Bins are 1/8 octave wide, so the estimate is within ~9% of exact
+      expect(estimate, closeTo(exact, exact * 0.1));
+    });
+
+    test('should read sublist views and silence', () {
+      final backing = Float32List(101);
+      final view = Float32List.sublistView(backing, 1);
+
+      final estimator = NoiseFloorEstimator()..addSamples(view);
+      expect(estimator.sampleCount, 100);
+      expect(estimator.noiseFloor, 0.0);
+    });
+
+    test('should decay old audio when bounded', () {
+      final estimator = NoiseFloorEstimator(maxSamples: 1000);
+      estimator.addSamples(Float32List(800)..fillRange(0, 800, 0.5));
+      estimator.addSamples(Float32List(800)..fillRange(0, 800, 0.001));
+
+      expect(estimator.sampleCount, lessThanOrEqualTo(1000));
+      expect(estimator.noiseFloor, lessThan(0.01));
+    });
+  });
+}
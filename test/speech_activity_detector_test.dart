@@ -0,0 +1,110 @@
+import 'dart:math' as math;
+import 'dart:typed_data';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:meeting_note_summarizer/core/audio/audio_dsp_ffi.dart';
+import 'package:meeting_note_summarizer/core/audio/speech_activity_detector.dart';
+
+/// Low noise with tone bursts over [bursts] (start, end) seconds
+Float32List _synthesize(double seconds, List<List<double>> bursts) {
+  final random = math.Random(7);
+  final audio = Float32List((seconds * 16000).round());
+  for (int i = 0; i < audio.length; i++) {
+    audio[i] = (random.nextDouble() * 2 - 1) * 0.003;
+  }
+  for (final burst in bursts) {
+    final start = (burst[0] * 16000).round();
+    final end = (burst[1] * 16000).round();
+    for (int i = start; i < end; i++) {
+      audio[i] += 0.2 * math.sin(2 * math.pi * 220 * i / 16000);
+    }
+  }
+  return audio;
+}
+
+void main() {
+  group('SpeechActivityDetector Tests', () {
+    test('should find bursts across arbitrary chunk boundaries', () {
+      final audio = _synthesize(6, [
+        [1.0, 2.0],
+        [3.5, 4.5],
+      ]);
+      final detector = SpeechActivityDetector();
+
+      final regions = <VadRegion>[];
+      for (int i = 0; i < audio.length; i += 1234) {
+        final end = math.min(i + 1234, audio.length);
+        regions.addAll(
+            detector.addSamples(Float32List.sublistView(audio, i, end)));
+      }
+      regions.addAll(detector.flush());
+
+      expect(regions, hasLength(2));
+      expect(regions[0].startSample, closeTo(16000, 320));
+      expect(regions[0].endSample, closeTo(32000, 320));
+      expect(regions[1].startSample, closeTo(56000, 320));
+      expect(regions[1].endSample, closeTo(72000, 320));
+      expect(regions[0].confidence, greaterThan(0.9));
+    });
+
+    test('should bridge short gaps and drop short blips', () {
+      final audio = _synthesize(4, [
+        [0.5, 1.0],
+        [1.1, 1.6], // 100 ms gap, inside the hangover
+        [2.5, 2.6], // 100 ms blip, below the minimum duration
+      ]);
+      final detector = SpeechActivityDetector();
+
+      final regions = [...detector.addSamples(audio), ...detector.flush()];
+
+      expect(regions, hasLength(1));
+      expect(regions[0].startSample, closeTo(8000, 320));
+      expect(regions[0].endSample, closeTo(25600, 320));
+    });
+
+    test('should report the open region before it closes', () {
+      final audio = _synthesize(2, [
+        [1.0, 2.0],
+      ]);
+      final detector = SpeechActivityDetector();
+
+      expect(detector.addSamples(audio), isEmpty);
+      expect(detector.openRegion, isNotNull);
+      expect(detector.openRegion!.startSample, closeTo(16000, 320));
+      expect(detector.flush(), hasLength(1));
+      expect(detector.openRegion, isNull);
+    });
+
+    test('should not hold speech open through steady background noise', () {
+      // White noise with a mean level above offsetLevel, and a tone over it
+      final random = math.Random(7);
+      final audio = Float32List(60 * 16000);
+      for (int i = 0; i < audio.length; i++) {
+        final u = 1.0 - random.nextDouble();
+        audio[i] = 0.03 *
+            math.sqrt(-2 * math.log(u)) *
+            math.cos(2 * math.pi * random.nextDouble());
+      }
+      for (int i = 40 * 16000; i < 41 * 16000; i++) {
+        audio[i] += 0.3 * math.sin(2 * math.pi * 220 * i / 16000);
+      }
+      final detector = SpeechActivityDetector();
+
+      final regions = <VadRegion>[];
+      for (int i = 0; i < audio.length; i += 1600) {
+        regions.addAll(
+            detector.addSamples(Float32List.sublistView(audio, i, i + 1600)));
+      }
+
+      expect(detector.openRegion, isNull);
+      // At most the noise's own onset, closed once the floor caught up,
+      // and the tone
+      expect(regions.length, inInclusiveRange(1, 2));
+      expect(regions.last.startSample, closeTo(640000, 320));
+      expect(regions.last.endSample, closeTo(656000, 320));
+      if (regions.length == 2) {
+        expect(regions.first.endSample, lessThan(20 * 16000));
+      }
+    });
+  });
+}